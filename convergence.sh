@@ -0,0 +1,70 @@
+#!/bin/bash
+# Runs the dam break convergence study (config/convergence-*.yaml) with the first and the second order scheme,
+# and prints the run time and the RMS error of the station heights against the finest second order run,
+# followed by the run time, which each order needs to reach the same station error.
+# usage: ./convergence.sh [limiter: minmod|mc]
+
+LIMITER=${1:-minmod}
+PROGRAM=$(realpath ${PROGRAM:-./build/tsunami_lab})
+WORKDIR=$(mktemp -d)
+trap 'rm -rf "$WORKDIR"' EXIT
+
+for CONFIG in config/convergence-*.yaml; do
+  SIZE=$(basename "$CONFIG" .yaml | cut -d- -f2)
+  for ORDER in 1 2; do
+    mkdir -p "$WORKDIR/$SIZE-$ORDER"
+    # the stations record densely, such that the reference can be interpolated in time
+    { cat "$CONFIG"; echo; echo "order: $ORDER"; echo "limiter: $LIMITER"; echo "readCheckpoints: false"
+      echo "checkpointPeriod: 1e9"; echo "outputPeriod: 1e9"; echo "outputFile: output.nc"; echo "delayBetweenRecords: 0.1"; } > "$WORKDIR/$SIZE-$ORDER/config.yaml"
+    (cd "$WORKDIR/$SIZE-$ORDER" && "$PROGRAM" config.yaml > log.txt 2>&1)
+  done
+done
+
+# the finest grid is the one with the smallest cell size
+SIZES=$(ls config/convergence-*.yaml | sed 's/.*convergence-\(.*\)\.yaml/\1/' | sort -g)
+FINEST=$(echo "$SIZES" | head -n 1)
+REFERENCE=$(ls "$WORKDIR/$FINEST-2"/station_*.csv | head -n 1)
+
+printf "%-10s %-6s %-12s %-12s\n" "cellSize" "order" "time [s]" "rms error"
+for SIZE in $SIZES; do
+  for ORDER in 1 2; do
+    RUN="$WORKDIR/$SIZE-$ORDER"
+    TIME=$(grep -o "total simulation time: [0-9.e+-]*" "$RUN/log.txt" | awk '{ print $4 }')
+    STATION=$(ls "$RUN"/station_*.csv | head -n 1)
+    ERROR=-
+    if [ "$RUN" != "$WORKDIR/$FINEST-2" ]; then
+      # the stations of different grids record at different times, so the reference is interpolated linearly to the times of the station
+      ERROR=$(awk -F, '
+        /^#/ || !($1 ~ /^[0-9]/) { next }
+        NR == FNR { t[n] = $1; h[n] = $2; n++; next }
+        {
+          while( i + 1 < n && t[i + 1] < $1 ) i++
+          if( i + 1 >= n || $1 < t[i] ) next
+          w = t[i + 1] > t[i] ? ($1 - t[i]) / (t[i + 1] - t[i]) : 0
+          d = $2 - (h[i] + w * (h[i + 1] - h[i])); s += d * d; m++
+        }
+        END { if(m > 0) printf "%.6g", sqrt(s / m); else printf "-" }' "$REFERENCE" "$STATION")
+    fi
+    printf "%-10s %-6s %-12s %-12s\n" "$SIZE" "$ORDER" "$TIME" "$ERROR"
+    echo "$SIZE $ORDER $TIME $ERROR" >> "$WORKDIR/results.txt"
+  done
+done
+
+# time to solution at equal error: the run time of each order is interpolated log-log between the two grids, whose errors enclose the error of a run
+echo
+printf "%-12s %-16s %-16s\n" "rms error" "time order 1 [s]" "time order 2 [s]"
+awk '
+  $4 != "-" { n[$2]++; e[$2, n[$2]] = $4; t[$2, n[$2]] = $3; all[++m] = $4 }
+  function timeAt( o, x,   k, a, b, w ) {
+    # from the coarsest grid to the finest one, such that the cheapest run is found
+    for( k = n[o]; k > 1; k-- ) {
+      a = e[o, k]; b = e[o, k - 1]
+      if( (a - x) * (b - x) <= 0 && a != b && a > 0 && b > 0 && x > 0 ) {
+        w = (log(x) - log(a)) / (log(b) - log(a))
+        return sprintf( "%.4g", exp( log(t[o, k]) + w * (log(t[o, k - 1]) - log(t[o, k])) ) )
+      }
+    }
+    return "-"
+  }
+  END { for( k = 1; k <= m; k++ ) printf "%-12s %-16s %-16s\n", all[k], timeAt( 1, all[k] ), timeAt( 2, all[k] ) }
+' "$WORKDIR/results.txt" | sort -g | uniq
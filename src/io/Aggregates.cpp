@@ -0,0 +1,73 @@
+/**
+ * @author Antonio Noack
+ *
+ * @section DESCRIPTION
+ * Per-cell aggregates over the whole run for hazard maps.
+ **/
+#include "Aggregates.h"
+
+#include <algorithm> // std::max
+#include <cmath> // std::sqrt
+#include <limits> // lowest()
+
+char const * const tsunami_lab::io::Aggregates::m_names[m_nFields] = { "maxElevation", "maxMomentum", "arrivalTime" };
+
+tsunami_lab::io::Aggregates::Aggregates( t_idx  i_nx,
+                                         t_idx  i_ny,
+                                         t_real i_arrivalThreshold ):
+  m_nx(i_nx), m_ny(i_ny), m_hasGhostCells(i_ny > 1), m_arrivalThreshold(i_arrivalThreshold) {
+  m_fields[0].resize(m_nx * m_ny, std::numeric_limits<t_real>::lowest());
+  m_fields[1].resize(m_nx * m_ny, 0);
+  m_fields[2].resize(m_nx * m_ny, -1);
+}
+
+void tsunami_lab::io::Aggregates::update( tsunami_lab::patches::WavePropagation * i_waveProp,
+                                          double                                  i_time ) {
+  bool  l_isDense = i_waveProp->hasDenseStorage();
+  t_idx l_stride  = i_waveProp->getStride();
+  // like NetCDFWriter, rows of patches skip the ghost cells in 2d only
+  t_idx l_offset  = m_hasGhostCells ? 1 : 0;
+
+  // the getters decode a full copy for patches without dense storage, so those are read row by row
+  t_real const * l_dataIn[4] = { nullptr, nullptr, nullptr, nullptr };
+  if(l_isDense){
+    l_dataIn[0] = i_waveProp->getHeight();
+    l_dataIn[1] = i_waveProp->getMomentumX();
+    l_dataIn[2] = i_waveProp->getMomentumY();// nullptr in 1d
+    l_dataIn[3] = i_waveProp->getBathymetry();
+  }
+
+  t_real * l_maxElevation = m_fields[0].data();
+  t_real * l_maxMomentum  = m_fields[1].data();
+  t_real * l_arrivalTime  = m_fields[2].data();
+  t_real   l_time = (t_real) i_time;
+
+  #pragma omp parallel
+  {
+    std::vector<t_real> l_rows(l_isDense ? 0 : 4 * l_stride);
+    t_real const * l_row[4];
+    #pragma omp for
+    for(t_idx l_iy = 0; l_iy < m_ny; l_iy++){
+      for(unsigned short l_qu = 0; l_qu < 4; l_qu++){
+        if(l_isDense){
+          l_row[l_qu] = l_dataIn[l_qu] ? l_dataIn[l_qu] + l_iy * l_stride : nullptr;
+        } else {
+          i_waveProp->getRow(l_qu, l_iy + l_offset, l_rows.data() + l_qu * l_stride);
+          l_row[l_qu] = l_rows.data() + l_qu * l_stride + l_offset;
+        }
+      }
+      t_idx l_index = l_iy * m_nx;
+      for(t_idx l_ix = 0; l_ix < m_nx; l_ix++, l_index++){
+        t_real l_h  = l_row[0][l_ix];
+        t_real l_hu = l_row[1][l_ix];
+        t_real l_hv = l_row[2] ? l_row[2][l_ix] : 0;
+        t_real l_elevation = l_h + l_row[3][l_ix];
+        l_maxElevation[l_index] = std::max(l_maxElevation[l_index], l_elevation);
+        l_maxMomentum[l_index]  = std::max(l_maxMomentum[l_index], std::sqrt(l_hu * l_hu + l_hv * l_hv));
+        if(l_arrivalTime[l_index] < 0 && l_h > 0 && l_elevation > m_arrivalThreshold){
+          l_arrivalTime[l_index] = l_time;
+        }
+      }
+    }
+  }
+}
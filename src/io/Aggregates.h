@@ -0,0 +1,90 @@
+/**
+ * @author Antonio Noack
+ *
+ * @section DESCRIPTION
+ * Per-cell aggregates over the whole run for hazard maps: maximum surface elevation, maximum momentum and first arrival time.
+ * They are updated every time step, so the frames don't need to be written and post-processed for them.
+ **/
+#ifndef TSUNAMI_LAB_IO_AGGREGATES
+#define TSUNAMI_LAB_IO_AGGREGATES
+
+#include "../constants.h"
+#include "../patches/WavePropagation.h"
+
+#include <vector>
+
+namespace tsunami_lab {
+  namespace io {
+    class Aggregates;
+  }
+}
+
+class tsunami_lab::io::Aggregates {
+  public:
+    //! number of aggregated fields
+    static unsigned short constexpr m_nFields = 3;
+
+    //! names of the fields in the NetCDF files: maximum of height + bathymetry, maximum of |(hu, hv)|, first arrival time
+    static char const * const m_names[m_nFields];
+
+  private:
+    //! number of cells in x- and y-direction, without ghost cells
+    t_idx m_nx, m_ny;
+
+    //! true, if the rows of the patches have ghost cells, which is the case in 2d
+    bool m_hasGhostCells;
+
+    //! the wave has arrived at a wet cell, when its surface elevation exceeds this value
+    t_real m_arrivalThreshold;
+
+    //! fields without ghost cells, stride m_nx
+    std::vector<t_real> m_fields[m_nFields];
+
+  public:
+    /**
+     * Constructor.
+     *
+     * @param i_nx number of cells in x-direction.
+     * @param i_ny number of cells in y-direction.
+     * @param i_arrivalThreshold surface elevation in meters, which marks the arrival of the wave.
+     **/
+    Aggregates( t_idx  i_nx,
+                t_idx  i_ny,
+                t_real i_arrivalThreshold );
+
+    /**
+     * Updates the maxima and arrival times with the state of the patch.
+     *
+     * @param i_waveProp patch.
+     * @param i_time current simulation time in seconds.
+     **/
+    void update( tsunami_lab::patches::WavePropagation * i_waveProp,
+                 double                                  i_time );
+
+    /**
+     * Gets a field; arrival times are -1 for cells, which the wave hasn't reached.
+     *
+     * @param i_field 0 = max surface elevation, 1 = max momentum, 2 = arrival time.
+     * @return field of nx x ny values.
+     **/
+    t_real * getField( unsigned short i_field ) {
+      return m_fields[i_field].data();
+    }
+
+    /** self explanatory */
+    t_real const * getField( unsigned short i_field ) const {
+      return m_fields[i_field].data();
+    }
+
+    /** self explanatory */
+    t_idx getNx() const {
+      return m_nx;
+    }
+
+    /** self explanatory */
+    t_idx getNy() const {
+      return m_ny;
+    }
+};
+
+#endif
@@ -0,0 +1,92 @@
+/**
+ * @author Antonio Noack
+ *
+ * @section DESCRIPTION
+ * Unit tests for the per-cell aggregates.
+ **/
+#include <catch2/catch.hpp>
+#include "../constants.h"
+#include "../patches/WavePropagation2d.h"
+#include "../patches/WavePropagation2dSparse.h"
+#include "../setups/DamBreak2d.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "Aggregates.h"
+#include "NetCdf.h"
+
+#define t_idx  tsunami_lab::t_idx
+#define t_real tsunami_lab::t_real
+
+TEST_CASE( "Test the aggregates of a dam break.", "[Aggregates]" ) {
+
+  t_idx l_nx = 11, l_ny = 9, l_nt = 8;
+  // the surface is at 0 inside of the dam and at -5 outside
+  tsunami_lab::setups::DamBreak2d l_setup( 10, 5, 5, 4, 2, -10 );
+  t_real l_threshold = -4.5;
+
+  // the sparse patch has no dense storage, so it is read row by row
+  tsunami_lab::patches::WavePropagation2d       l_dense ( l_nx, l_ny, &l_setup, 1, 1 );
+  tsunami_lab::patches::WavePropagation2dSparse l_sparse( l_nx, l_ny, &l_setup, 1, 1, 4 );
+  tsunami_lab::io::Aggregates l_denseAggregates ( l_nx, l_ny, l_threshold );
+  tsunami_lab::io::Aggregates l_sparseAggregates( l_nx, l_ny, l_threshold );
+
+  std::vector<t_real> l_maxElevation( l_nx * l_ny, -1e9 ), l_maxMomentum( l_nx * l_ny, 0 ), l_arrivalTime( l_nx * l_ny, -1 );
+  for( t_idx l_it = 0; l_it < l_nt; l_it++ ) {
+    double l_time = l_it * 0.5;
+    l_denseAggregates.update( &l_dense, l_time );
+    l_sparseAggregates.update( &l_sparse, l_time );
+
+    t_real const * l_b = l_dense.getBathymetry();
+    for( t_idx l_iy = 0; l_iy < l_ny; l_iy++ ) {
+      for( t_idx l_ix = 0; l_ix < l_nx; l_ix++ ) {
+        t_real l_h, l_hu, l_hv;
+        l_dense.getCellState( l_ix, l_iy, l_h, l_hu, l_hv );
+        t_idx  l_index = l_ix + l_iy * l_nx;
+        t_real l_elevation = l_h + l_b[l_ix + l_iy * l_dense.getStride()];
+        l_maxElevation[l_index] = std::max( l_maxElevation[l_index], l_elevation );
+        l_maxMomentum[l_index]  = std::max( l_maxMomentum[l_index], std::sqrt( l_hu * l_hu + l_hv * l_hv ) );
+        if( l_arrivalTime[l_index] < 0 && l_elevation > l_threshold ) l_arrivalTime[l_index] = l_time;
+      }
+    }
+
+    l_dense.setGhostOutflow();
+    l_dense.timeStep( 0.1 );
+    l_sparse.setGhostOutflow();
+    l_sparse.timeStep( 0.1 );
+  }
+
+  t_real const * l_expected[3] = { l_maxElevation.data(), l_maxMomentum.data(), l_arrivalTime.data() };
+  for( unsigned short l_fi = 0; l_fi < tsunami_lab::io::Aggregates::m_nFields; l_fi++ ) {
+    for( t_idx l_ce = 0; l_ce < l_nx * l_ny; l_ce++ ) {
+      REQUIRE( l_denseAggregates.getField( l_fi )[l_ce]  == Approx( l_expected[l_fi][l_ce] ) );
+      REQUIRE( l_sparseAggregates.getField( l_fi )[l_ce] == Approx( l_expected[l_fi][l_ce] ).margin( 1e-4 ) );
+    }
+  }
+
+  // the wave starts in the dam, and spreads: the center arrived first, the corners later
+  REQUIRE( l_arrivalTime[5 + 4 * l_nx] == 0 );
+  REQUIRE( l_arrivalTime[0] > 0 );
+
+  // the aggregates survive a checkpoint
+  std::string l_fileName = "tmp-aggregates.nc";
+  std::vector<tsunami_lab::io::Station> l_stations;
+  REQUIRE( tsunami_lab::io::NetCDF::storeCheckpoint( l_fileName, l_nx, l_ny, 1, 0.5, 3.5, l_nt, l_stations, &l_dense, &l_denseAggregates ) == 0 );
+  tsunami_lab::io::Aggregates l_restored( l_nx, l_ny, l_threshold );
+  REQUIRE( tsunami_lab::io::NetCDF::loadAggregates( l_fileName, l_restored ) == 0 );
+  for( unsigned short l_fi = 0; l_fi < tsunami_lab::io::Aggregates::m_nFields; l_fi++ ) {
+    for( t_idx l_ce = 0; l_ce < l_nx * l_ny; l_ce++ ) {
+      REQUIRE( l_restored.getField( l_fi )[l_ce] == l_denseAggregates.getField( l_fi )[l_ce] );
+    }
+  }
+
+  // a checkpoint of another size is rejected
+  tsunami_lab::io::Aggregates l_other( l_nx + 1, l_ny, l_threshold );
+  REQUIRE( tsunami_lab::io::NetCDF::loadAggregates( l_fileName, l_other ) != 0 );
+
+  REQUIRE( tsunami_lab::io::NetCDF::storeAggregates( l_fileName, 2, 10, 20, 1, l_denseAggregates ) == 0 );
+  std::remove( l_fileName.c_str() );
+}
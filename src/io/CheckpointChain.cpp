@@ -0,0 +1,162 @@
+/**
+ * @author Antonio Noack
+ *
+ * @section DESCRIPTION
+ * Chain of raw checkpoints: full checkpoints and deltas of the changed blocks.
+ **/
+#include "CheckpointChain.h"
+
+#include <algorithm> // std::max
+#include <chrono> // std::chrono::system_clock
+#include <cstdio> // std::remove, std::rename
+#include <cstring> // memcpy
+#include <unistd.h> // link
+
+namespace {
+  // finalizer of SplitMix64: every input bit changes about half of the output bits
+  uint64_t mix( uint64_t i_value ){
+    i_value = (i_value ^ (i_value >> 30)) * 0xBF58476D1CE4E5B9ull;
+    i_value = (i_value ^ (i_value >> 27)) * 0x94D049BB133111EBull;
+    return i_value ^ (i_value >> 31);
+  }
+}
+
+tsunami_lab::io::CheckpointChain::CheckpointChain( std::string i_fileName,
+                                                   t_idx       i_deltasPerBase,
+                                                   t_idx       i_retention,
+                                                   t_idx       i_blockValues ):
+  m_fileName(i_fileName),
+  m_deltasPerBase(i_deltasPerBase),
+  m_retention(std::max<t_idx>(i_retention, 1)) {
+  m_delta.blockValues = std::max<t_idx>(i_blockValues, 1);
+}
+
+std::string tsunami_lab::io::CheckpointChain::generationFileName( std::string const & i_fileName,
+                                                                  t_idx               i_generation ) {
+  return i_generation == 0 ? i_fileName : i_fileName + "." + std::to_string(i_generation);
+}
+
+uint64_t tsunami_lab::io::CheckpointChain::hashBlock( char const * i_data,
+                                                      uint64_t     i_size ) {
+  // a sum of mixed (value, position) pairs: unlike a plain sum, changes don't cancel each other out
+  uint64_t l_hash = 0;
+  for(uint64_t l_wo = 0; l_wo < i_size / 4; l_wo++){
+    uint32_t l_word;
+    memcpy(&l_word, i_data + l_wo * 4, 4);
+    l_hash += mix((uint64_t(l_word) << 32) | l_wo);
+  }
+  return l_hash;
+}
+
+void tsunami_lab::io::CheckpointChain::removeChain( std::string const & i_fileName ) {
+  std::remove(i_fileName.c_str());
+  // the deltas are numbered without gaps
+  for(uint64_t l_de = 1; std::remove(RawCheckpoint::deltaFileName(i_fileName, l_de).c_str()) == 0; l_de++);
+}
+
+void tsunami_lab::io::CheckpointChain::rotate() const {
+  for(t_idx l_ge = m_retention - 1; l_ge > 0; l_ge--){
+    std::string l_older = generationFileName(m_fileName, l_ge);
+    std::string l_newer = generationFileName(m_fileName, l_ge - 1);
+    removeChain(l_older);
+    for(uint64_t l_de = 0;; l_de++){
+      std::string l_from = l_de == 0 ? l_newer : RawCheckpoint::deltaFileName(l_newer, l_de);
+      std::string l_to   = l_de == 0 ? l_older : RawCheckpoint::deltaFileName(l_older, l_de);
+      // a link keeps the current chain, until the new full checkpoint replaces it
+      int l_err = l_ge == 1 ? link(l_from.c_str(), l_to.c_str()) : std::rename(l_from.c_str(), l_to.c_str());
+      if(l_err) break;
+    }
+  }
+}
+
+void tsunami_lab::io::CheckpointChain::prepare( tsunami_lab::patches::WavePropagation * i_waveProp,
+                                                tsunami_lab::io::Aggregates     const * i_aggregates ) {
+  unsigned short const l_nSections = RawCheckpoint::m_nArraySections;
+  char const * l_data[l_nSections] = {};
+  uint64_t l_sizes[l_nSections] = {};
+  t_real * l_arrays[4];
+  t_idx l_nValues = i_waveProp->getRawStorage(l_arrays);
+  for(unsigned short l_qu = 0; l_qu < 4; l_qu++){
+    if(l_arrays[l_qu] == nullptr) continue;
+    l_data[l_qu]  = reinterpret_cast<char const*>(l_arrays[l_qu]);
+    l_sizes[l_qu] = l_nValues * sizeof(t_real);
+  }
+  if(i_aggregates){
+    for(unsigned short l_fi = 0; l_fi < Aggregates::m_nFields; l_fi++){
+      l_data[4 + l_fi]  = reinterpret_cast<char const*>(i_aggregates->getField(l_fi));
+      l_sizes[4 + l_fi] = i_aggregates->getNx() * i_aggregates->getNy() * sizeof(t_real);
+    }
+  }
+
+  bool l_full = m_needsFull || m_delta.index >= m_deltasPerBase;
+  std::vector<uint64_t> l_hashes[l_nSections];
+  if(m_deltasPerBase > 0){
+    uint64_t l_blockBytes = m_delta.blockValues * sizeof(t_real);
+    for(unsigned short l_se = 0; l_se < l_nSections; l_se++){
+      if(l_data[l_se] == nullptr) continue;
+      uint64_t l_nBlocks = (l_sizes[l_se] + l_blockBytes - 1) / l_blockBytes;
+      l_hashes[l_se].resize(l_nBlocks);
+      #pragma omp parallel for schedule(dynamic, 16)
+      for(uint64_t l_bl = 0; l_bl < l_nBlocks; l_bl++){
+        uint64_t l_begin = l_bl * l_blockBytes;
+        l_hashes[l_se][l_bl] = hashBlock(l_data[l_se] + l_begin, std::min(l_blockBytes, l_sizes[l_se] - l_begin));
+      }
+      // e.g. aggregates appeared
+      if(l_hashes[l_se].size() != m_hashes[l_se].size()) l_full = true;
+    }
+  }
+
+  for(unsigned short l_se = 0; l_se < l_nSections; l_se++) m_delta.blocks[l_se].clear();
+  if(l_full){
+    // a new id, so deltas of the previous chain aren't applied to the new full checkpoint
+    uint64_t l_time = std::chrono::system_clock::now().time_since_epoch().count();
+    m_delta.baseId = mix(l_time ^ m_delta.baseId) | 1;
+    m_delta.index  = 0;
+  } else {
+    m_delta.index++;
+    for(unsigned short l_se = 0; l_se < l_nSections; l_se++){
+      for(uint64_t l_bl = 0; l_bl < l_hashes[l_se].size(); l_bl++){
+        if(l_hashes[l_se][l_bl] != m_hashes[l_se][l_bl]) m_delta.blocks[l_se].push_back(l_bl);
+      }
+    }
+  }
+  for(unsigned short l_se = 0; l_se < l_nSections; l_se++) m_hashes[l_se].swap(l_hashes[l_se]);
+  m_needsFull = false;
+}
+
+void tsunami_lab::io::CheckpointChain::invalidate() {
+  m_needsFull = true;
+}
+
+int tsunami_lab::io::CheckpointChain::store( t_idx                                   i_nx,
+                                             t_idx                                   i_ny,
+                                             t_real                                  i_cellSizeMeters,
+                                             t_real                                  i_cflFactor,
+                                             double                                  i_simulationTime,
+                                             t_idx                                   i_timeStepIndex,
+                                             std::vector<tsunami_lab::io::Station> & i_stations,
+                                             tsunami_lab::patches::WavePropagation * i_waveProp,
+                                             tsunami_lab::io::Aggregates     const * i_aggregates ) const {
+  if(m_delta.index > 0){
+    return RawCheckpoint::store(RawCheckpoint::deltaFileName(m_fileName, m_delta.index), i_nx, i_ny, i_cellSizeMeters, i_cflFactor,
+                                i_simulationTime, i_timeStepIndex, i_stations, i_waveProp, i_aggregates, &m_delta);
+  }
+  rotate();
+  int l_err = RawCheckpoint::store(m_fileName, i_nx, i_ny, i_cellSizeMeters, i_cflFactor,
+                                   i_simulationTime, i_timeStepIndex, i_stations, i_waveProp, i_aggregates, &m_delta);
+  // the deltas of the replaced chain would be ignored because of their id, but they take space
+  if(!l_err) for(uint64_t l_de = 1; std::remove(RawCheckpoint::deltaFileName(m_fileName, l_de).c_str()) == 0; l_de++);
+  return l_err;
+}
+
+tsunami_lab::t_idx tsunami_lab::io::CheckpointChain::getChangedBlocks() const {
+  t_idx l_nBlocks = 0;
+  for(unsigned short l_se = 0; l_se < RawCheckpoint::m_nArraySections; l_se++) l_nBlocks += m_delta.blocks[l_se].size();
+  return l_nBlocks;
+}
+
+tsunami_lab::t_idx tsunami_lab::io::CheckpointChain::getTotalBlocks() const {
+  t_idx l_nBlocks = 0;
+  for(unsigned short l_se = 0; l_se < RawCheckpoint::m_nArraySections; l_se++) l_nBlocks += m_hashes[l_se].size();
+  return l_nBlocks;
+}
@@ -0,0 +1,143 @@
+/**
+ * @author Antonio Noack
+ *
+ * @section DESCRIPTION
+ * Chain of raw checkpoints: a full checkpoint every few checkpoints, and deltas of the blocks, which changed, in between.
+ * Changes are found by hashes of the blocks, so the patches don't need to track them.
+ **/
+#ifndef TSUNAMI_LAB_IO_CHECKPOINT_CHAIN_H
+#define TSUNAMI_LAB_IO_CHECKPOINT_CHAIN_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../constants.h"
+#include "../io/Aggregates.h"
+#include "../io/RawCheckpoint.h"
+#include "../io/Station.h"
+#include "../patches/WavePropagation.h"
+
+namespace tsunami_lab {
+  namespace io {
+    class CheckpointChain;
+  }
+}
+
+class tsunami_lab::io::CheckpointChain {
+  private:
+    //! file name of the full checkpoint of the current chain
+    std::string m_fileName;
+
+    //! deltas between two full checkpoints
+    t_idx m_deltasPerBase;
+
+    //! number of chains, which are kept, including the current one
+    t_idx m_retention;
+
+    //! the next checkpoint
+    RawCheckpoint::Delta m_delta;
+
+    //! hashes of the blocks at the previous checkpoint
+    std::vector<uint64_t> m_hashes[RawCheckpoint::m_nArraySections];
+
+    //! the next checkpoint must be a full one, e.g. because the previous one failed
+    bool m_needsFull = true;
+
+    /**
+     * Computes the hash of a block.
+     *
+     * @param i_data values of the block.
+     * @param i_size size in bytes; a multiple of 4.
+     * @return hash.
+     **/
+    static uint64_t hashBlock( char const * i_data,
+                               uint64_t     i_size );
+
+    /**
+     * Removes the files of a chain: the full checkpoint and its deltas.
+     *
+     * @param i_fileName file name of the full checkpoint.
+     **/
+    static void removeChain( std::string const & i_fileName );
+
+    /**
+     * Renames the chains to the next older generation, before a new full checkpoint replaces the current one.
+     * The current chain is linked, so it stays valid until the new full checkpoint is complete.
+     **/
+    void rotate() const;
+
+  public:
+    /**
+     * Constructs the chain.
+     *
+     * @param i_fileName file name of the full checkpoint.
+     * @param i_deltasPerBase deltas between two full checkpoints; 0 for full checkpoints only.
+     * @param i_retention number of chains, which are kept; older chains are called <fileName>.1, <fileName>.2, ...
+     * @param i_blockValues values per block.
+     **/
+    CheckpointChain( std::string i_fileName,
+                     t_idx       i_deltasPerBase,
+                     t_idx       i_retention,
+                     t_idx       i_blockValues = 16384 );
+
+    /**
+     * Gets the file name of the full checkpoint of an older chain.
+     *
+     * @param i_fileName file name of the current full checkpoint.
+     * @param i_generation 0 for the current chain, n for the n-th older one.
+     * @return file name.
+     **/
+    static std::string generationFileName( std::string const & i_fileName,
+                                           t_idx               i_generation );
+
+    /**
+     * Decides, whether the next checkpoint is a full one or a delta, and finds the changed blocks.
+     * Must be called by the process, which continues the simulation, because the hashes are kept for the next checkpoint.
+     *
+     * @param i_waveProp wave propagation instance; see RawCheckpoint::isSupported().
+     * @param i_aggregates aggregates; nullptr if there are none.
+     **/
+    void prepare( tsunami_lab::patches::WavePropagation * i_waveProp,
+                  tsunami_lab::io::Aggregates     const * i_aggregates );
+
+    /**
+     * Forces a full checkpoint next, e.g. if the previous one couldn't be written.
+     **/
+    void invalidate();
+
+    /**
+     * Writes the checkpoint, which was prepared; doesn't change the chain, so it can run in a forked child.
+     * See RawCheckpoint::store() for the parameters.
+     *
+     * @return 0 if successful, -1 else.
+     **/
+    int store( t_idx                                   i_nx,
+               t_idx                                   i_ny,
+               t_real                                  i_cellSizeMeters,
+               t_real                                  i_cflFactor,
+               double                                  i_simulationTime,
+               t_idx                                   i_timeStepIndex,
+               std::vector<tsunami_lab::io::Station> & i_stations,
+               tsunami_lab::patches::WavePropagation * i_waveProp,
+               tsunami_lab::io::Aggregates     const * i_aggregates ) const;
+
+    /** self explanatory */
+    t_idx getDeltaIndex() const { return m_delta.index; }
+
+    /**
+     * Gets the number of changed blocks of the prepared delta.
+     *
+     * @return changed blocks; 0 for a full checkpoint.
+     **/
+    t_idx getChangedBlocks() const;
+
+    /**
+     * Gets the number of blocks of all arrays.
+     *
+     * @return number of blocks at the last prepare().
+     **/
+    t_idx getTotalBlocks() const;
+};
+
+#endif
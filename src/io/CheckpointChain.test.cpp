@@ -0,0 +1,145 @@
+/**
+ * @author Antonio Noack
+ *
+ * @section DESCRIPTION
+ * Unit tests for the chain of raw checkpoints.
+ **/
+#include <catch2/catch.hpp>
+#include "../constants.h"
+#include "../patches/WavePropagation2d.h"
+#include "../setups/DamBreak2d.h"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "CheckpointChain.h"
+
+#define t_idx  tsunami_lab::t_idx
+#define t_real tsunami_lab::t_real
+
+namespace {
+  bool exists( std::string const & i_fileName ) {
+    return std::ifstream( i_fileName ).good();
+  }
+
+  void requireSameState( std::string const & i_fileName,
+                         tsunami_lab::patches::WavePropagation2d & i_waveProp,
+                         tsunami_lab::io::Aggregates & i_aggregates ) {
+    tsunami_lab::patches::WavePropagation2d l_restored( i_aggregates.getNx(), i_aggregates.getNy() );
+    REQUIRE( tsunami_lab::io::RawCheckpoint::loadPatch( i_fileName, &l_restored ) == 0 );
+    t_real * l_arrays[4], * l_restoredArrays[4];
+    t_idx l_nValues = i_waveProp.getRawStorage( l_arrays );
+    REQUIRE( l_restored.getRawStorage( l_restoredArrays ) == l_nValues );
+    for( unsigned short l_qu = 0; l_qu < 4; l_qu++ ) {
+      for( t_idx l_ce = 0; l_ce < l_nValues; l_ce++ ) {
+        REQUIRE( l_restoredArrays[l_qu][l_ce] == l_arrays[l_qu][l_ce] );
+      }
+    }
+    tsunami_lab::io::Aggregates l_restoredAggregates( i_aggregates.getNx(), i_aggregates.getNy(), 0.1 );
+    REQUIRE( tsunami_lab::io::RawCheckpoint::loadAggregates( i_fileName, l_restoredAggregates ) == 0 );
+    for( unsigned short l_fi = 0; l_fi < tsunami_lab::io::Aggregates::m_nFields; l_fi++ ) {
+      for( t_idx l_ce = 0; l_ce < i_aggregates.getNx() * i_aggregates.getNy(); l_ce++ ) {
+        REQUIRE( l_restoredAggregates.getField( l_fi )[l_ce] == i_aggregates.getField( l_fi )[l_ce] );
+      }
+    }
+  }
+}
+
+TEST_CASE( "Test that a chain of raw checkpoints restores the state of its last delta.", "[CheckpointChain]" ) {
+
+  t_idx l_nx = 20, l_ny = 9;
+  tsunami_lab::setups::DamBreak2d l_setup( 10, 5, 3, 4, 2, -10 );
+  tsunami_lab::patches::WavePropagation2d l_waveProp( l_nx, l_ny, &l_setup, 1, 1 );
+  tsunami_lab::io::Aggregates l_aggregates( l_nx, l_ny, 0.1 );
+  std::vector<tsunami_lab::io::Station> l_stations;
+  l_stations.push_back( tsunami_lab::io::Station( 2, 5, "Bikini Bottom", 0.17 ) );
+
+  std::string l_fileName = "tmp-chain.raw";
+  std::string l_olderFileName = tsunami_lab::io::CheckpointChain::generationFileName( l_fileName, 1 );
+  REQUIRE( l_olderFileName == "tmp-chain.raw.1" );
+  REQUIRE( tsunami_lab::io::RawCheckpoint::deltaFileName( l_fileName, 2 ) == "tmp-chain.raw.delta2" );
+
+  // two deltas per full checkpoint, the previous chain is kept; small blocks, so the wave doesn't reach all of them
+  tsunami_lab::io::CheckpointChain l_chain( l_fileName, 2, 2, 16 );
+  std::vector<t_real> l_heightsOfSecondDelta;
+  for( t_idx l_cp = 0; l_cp < 4; l_cp++ ) {
+    l_aggregates.update( &l_waveProp, l_cp * 0.1 );
+    l_waveProp.setGhostOutflow();
+    l_waveProp.timeStep( 0.1 );
+
+    l_chain.prepare( &l_waveProp, &l_aggregates );
+    REQUIRE( l_chain.getDeltaIndex() == l_cp % 3 );
+    if( l_cp % 3 == 0 ) {
+      REQUIRE( l_chain.getChangedBlocks() == 0 );
+    } else {
+      // at least the bathymetry didn't change
+      REQUIRE( l_chain.getChangedBlocks() > 0 );
+      REQUIRE( l_chain.getChangedBlocks() < l_chain.getTotalBlocks() );
+    }
+    REQUIRE( l_chain.store( l_nx, l_ny, 1, 0.5, l_cp * 0.1, l_cp, l_stations, &l_waveProp, &l_aggregates ) == 0 );
+
+    if( l_cp == 2 ) {
+      // the state of the last delta
+      REQUIRE( exists( l_fileName + ".delta2" ) );
+      t_idx l_nx2, l_ny2, l_timeStepIndex2;
+      t_real l_cellSizeMeters2, l_cflFactor2;
+      double l_simulationTime2;
+      std::vector<tsunami_lab::io::Station> l_stations2;
+      REQUIRE( tsunami_lab::io::RawCheckpoint::load( l_fileName, l_nx2, l_ny2, l_cellSizeMeters2, l_cflFactor2, l_simulationTime2, l_timeStepIndex2, l_stations2 ) == 0 );
+      REQUIRE( l_timeStepIndex2 == 2 );
+      REQUIRE( l_simulationTime2 == Approx( 0.2 ) );
+      REQUIRE( l_stations2.size() == 1 );
+      requireSameState( l_fileName, l_waveProp, l_aggregates );
+      t_real * l_arrays[4];
+      t_idx l_nValues = l_waveProp.getRawStorage( l_arrays );
+      l_heightsOfSecondDelta.assign( l_arrays[0], l_arrays[0] + l_nValues );
+    }
+  }
+
+  // the new full checkpoint replaced the chain, the old one is kept as generation 1
+  REQUIRE( !exists( l_fileName + ".delta1" ) );
+  REQUIRE( exists( l_olderFileName ) );
+  REQUIRE( exists( l_olderFileName + ".delta2" ) );
+  requireSameState( l_fileName, l_waveProp, l_aggregates );
+  tsunami_lab::patches::WavePropagation2d l_older( l_nx, l_ny );
+  REQUIRE( tsunami_lab::io::RawCheckpoint::loadPatch( l_olderFileName, &l_older ) == 0 );
+  t_real * l_olderArrays[4];
+  REQUIRE( l_older.getRawStorage( l_olderArrays ) == l_heightsOfSecondDelta.size() );
+  for( t_idx l_ce = 0; l_ce < l_heightsOfSecondDelta.size(); l_ce++ ) {
+    REQUIRE( l_olderArrays[0][l_ce] == l_heightsOfSecondDelta[l_ce] );
+  }
+
+  // a delta of another chain is ignored
+  REQUIRE( std::rename( ( l_olderFileName + ".delta1" ).c_str(), ( l_fileName + ".delta1" ).c_str() ) == 0 );
+  requireSameState( l_fileName, l_waveProp, l_aggregates );
+  std::remove( ( l_fileName + ".delta1" ).c_str() );
+
+  // a delta with a damaged value is detected by the checksum
+  l_waveProp.setGhostOutflow();
+  l_waveProp.timeStep( 0.1 );
+  l_chain.prepare( &l_waveProp, &l_aggregates );
+  REQUIRE( l_chain.getDeltaIndex() == 1 );
+  REQUIRE( l_chain.store( l_nx, l_ny, 1, 0.5, 0.4, 4, l_stations, &l_waveProp, &l_aggregates ) == 0 );
+  requireSameState( l_fileName, l_waveProp, l_aggregates );
+  {
+    std::fstream l_file( l_fileName + ".delta1", std::ios::in | std::ios::out | std::ios::binary );
+    l_file.seekp( tsunami_lab::io::RawCheckpoint::m_pageSize + 40 );
+    l_file.put( 'x' );
+  }
+  tsunami_lab::patches::WavePropagation2d l_damaged( l_nx, l_ny );
+  REQUIRE( tsunami_lab::io::RawCheckpoint::loadPatch( l_fileName, &l_damaged ) != 0 );
+
+  // e.g. after a failed checkpoint, the next one is a full one
+  l_chain.invalidate();
+  l_chain.prepare( &l_waveProp, &l_aggregates );
+  REQUIRE( l_chain.getDeltaIndex() == 0 );
+  REQUIRE( l_chain.store( l_nx, l_ny, 1, 0.5, 0.4, 4, l_stations, &l_waveProp, &l_aggregates ) == 0 );
+  requireSameState( l_fileName, l_waveProp, l_aggregates );
+
+  for( std::string const & l_name : { l_fileName, l_olderFileName } ) {
+    std::remove( l_name.c_str() );
+    for( t_idx l_de = 1; l_de <= 2; l_de++ ) std::remove( tsunami_lab::io::RawCheckpoint::deltaFileName( l_name, l_de ).c_str() );
+  }
+}
@@ -18,8 +18,285 @@
 
 #include "Csv.h"
 
+#include <algorithm> // std::max, std::min
+#include <cmath> // std::abs
+#include <cstdint>
+#include <cstdio> // snprintf
+#include <cstdlib> // std::strtof
+#include <functional>
+#include <iterator> // std::istreambuf_iterator
+#include <limits>
 #include <sstream>
 #include <fstream>
+#include <type_traits> // std::is_same
+#include <fcntl.h> // open
+#include <omp.h> // omp_get_max_threads
+#include <sys/mman.h> // mmap
+#include <sys/stat.h> // fstat
+#include <unistd.h> // close
+
+namespace {
+  double const c_powersOfTen[23] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                     1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+  //! significant digits, which are needed for every value to survive a round trip through text
+  int const c_maxDigits = std::numeric_limits<tsunami_lab::t_real>::max_digits10;
+
+  //! upper limit for the characters of a formatted value, e.g. -1.2345678901234567e-308
+  tsunami_lab::t_idx const c_maxTextSize = 32;
+
+  /**
+   * Converts i_mantissa * 10^i_exponent to the closest value. Up to 15 significant digits and powers of ten up to 22 are exact in double precision,
+   * so a single multiplication or division is rounded correctly. Doubles exactly between two floats would be rounded twice.
+   *
+   * @return false, if the conversion would not be correctly rounded; the C library is needed then.
+   **/
+  bool decimalToReal( uint64_t             i_mantissa,
+                      int                  i_exponent,
+                      bool                 i_negative,
+                      tsunami_lab::t_real & o_value ){
+    if(i_mantissa >= (1ull << 53) || i_exponent < -22 || i_exponent > 22) return false;
+    double l_value = i_exponent < 0 ? i_mantissa / c_powersOfTen[-i_exponent] : i_mantissa * c_powersOfTen[i_exponent];
+    if(i_negative) l_value = -l_value;
+    if(std::is_same<tsunami_lab::t_real, float>::value && l_value != 0){
+      // rounding the double to float again is only ambiguous, if it is exactly in the middle of two floats
+      uint64_t l_bits;
+      memcpy(&l_bits, &l_value, sizeof(l_bits));
+      double l_magnitude = std::abs(l_value);
+      if((l_bits & 0x1FFFFFFFull) == 0x10000000ull ||
+         l_magnitude < std::numeric_limits<float>::min() || l_magnitude > std::numeric_limits<float>::max()) return false;
+    }
+    o_value = (tsunami_lab::t_real) l_value;
+    return true;
+  }
+
+  /**
+   * Writes i_digits * 10^i_exponent like printf's %g does, but with all significant digits.
+   *
+   * @return end of the text.
+   **/
+  char * formatDecimal( bool     i_negative,
+                        uint64_t i_digits,
+                        int      i_exponent,
+                        char   * o_text ){
+    while(i_digits >= 10 && i_digits % 10 == 0){
+      i_digits /= 10;
+      i_exponent++;
+    }
+    char l_digits[20];
+    int l_numDigits = 0;
+    for(uint64_t l_rest = i_digits; l_numDigits == 0 || l_rest > 0; l_rest /= 10) l_digits[l_numDigits++] = '0' + l_rest % 10;
+    std::reverse(l_digits, l_digits + l_numDigits);
+    // exponent of the first digit
+    int l_e10 = i_exponent + l_numDigits - 1;
+
+    if(i_negative) *o_text++ = '-';
+    if(l_e10 < -4 || l_e10 >= c_maxDigits){
+      *o_text++ = l_digits[0];
+      if(l_numDigits > 1){
+        *o_text++ = '.';
+        for(int l_di = 1; l_di < l_numDigits; l_di++) *o_text++ = l_digits[l_di];
+      }
+      *o_text++ = 'e';
+      *o_text++ = l_e10 < 0 ? '-' : '+';
+      int l_e10Abs = std::abs(l_e10);
+      if(l_e10Abs >= 100) *o_text++ = '0' + l_e10Abs / 100;
+      *o_text++ = '0' + l_e10Abs / 10 % 10;
+      *o_text++ = '0' + l_e10Abs % 10;
+    } else if(l_e10 < 0){
+      *o_text++ = '0';
+      *o_text++ = '.';
+      for(int l_ze = -1; l_ze > l_e10; l_ze--) *o_text++ = '0';
+      for(int l_di = 0; l_di < l_numDigits; l_di++) *o_text++ = l_digits[l_di];
+    } else {
+      for(int l_di = 0; l_di <= l_e10 || l_di < l_numDigits; l_di++){
+        if(l_di == l_e10 + 1) *o_text++ = '.';
+        *o_text++ = l_di < l_numDigits ? l_digits[l_di] : '0';
+      }
+    }
+    return o_text;
+  }
+
+  /**
+   * Writes the shortest text, which is read as the same value again, e.g. 0.1 instead of 0.100000001.
+   * The digits are found with a binary search over the number of significant digits, where each guess is checked with decimalToReal().
+   * Values, which can't be checked that way, use printf and strtof.
+   *
+   * @param i_value value, which is formatted.
+   * @param o_text buffer with space for at least c_maxTextSize characters.
+   * @return end of the text.
+   **/
+  char * formatReal( tsunami_lab::t_real i_value, char * o_text ){
+    if(std::isnan(i_value)){
+      memcpy(o_text, "nan", 3);
+      return o_text + 3;
+    }
+    bool l_negative = std::signbit(i_value);
+    if(l_negative) *o_text++ = '-';
+    if(std::isinf(i_value)){
+      memcpy(o_text, "inf", 3);
+      return o_text + 3;
+    }
+    if(i_value == 0){
+      *o_text++ = '0';
+      return o_text;
+    }
+
+    double l_abs = std::abs((double) i_value);
+    int l_e10 = (int) std::floor(std::log10(l_abs));
+    // the scales of all guesses must be exact powers of ten
+    if(c_maxDigits <= 15 && l_e10 >= -13 && l_e10 <= 21){
+      uint64_t l_bestDigits = 0;
+      int l_bestExponent = 0, l_bestNumDigits = 0;
+      int l_lo = 1, l_hi = c_maxDigits;
+      bool l_checked = true;
+      while(l_lo <= l_hi && l_checked){
+        int l_numDigits = (l_lo + l_hi) / 2;
+        int l_scale = l_numDigits - 1 - l_e10;
+        double l_scaled = l_scale < 0 ? l_abs / c_powersOfTen[-l_scale] : l_abs * c_powersOfTen[l_scale];
+        uint64_t l_digits = (uint64_t) std::llround(l_scaled);
+        tsunami_lab::t_real l_value;
+        // e.g. 1.5e10 is exactly between two floats
+        l_checked = decimalToReal(l_digits, -l_scale, false, l_value);
+        if(l_checked && l_value == (tsunami_lab::t_real) l_abs){
+          l_bestDigits = l_digits;
+          l_bestExponent = -l_scale;
+          l_bestNumDigits = l_numDigits;
+          l_hi = l_numDigits - 1;
+        } else {
+          l_lo = l_numDigits + 1;
+        }
+      }
+      if(l_checked && l_bestNumDigits > 0) return formatDecimal(false, l_bestDigits, l_bestExponent, o_text);
+    }
+
+    // e.g. 1.5e-30, 1.5e10 or doubles
+    char l_buffer[c_maxTextSize];
+    for(int l_numDigits = 1; l_numDigits <= c_maxDigits; l_numDigits++){
+      snprintf(l_buffer, sizeof(l_buffer), "%.*e", l_numDigits - 1, l_abs);
+      tsunami_lab::t_real l_value = std::is_same<tsunami_lab::t_real, float>::value ? std::strtof(l_buffer, nullptr) : std::strtod(l_buffer, nullptr);
+      if(l_value != (tsunami_lab::t_real) l_abs && l_numDigits < c_maxDigits) continue;
+      // d.ddde-XX
+      uint64_t l_digits = 0;
+      char * l_ch = l_buffer;
+      for(; *l_ch != 'e'; l_ch++) if(*l_ch != '.') l_digits = l_digits * 10 + (*l_ch - '0');
+      return formatDecimal(false, l_digits, std::atoi(l_ch + 1) - (l_numDigits - 1), o_text);
+    }
+    return o_text;
+  }
+
+  //! column of the written frames; its values are i_values[l_id] + i_addend[l_id], if there is an addend
+  struct Column {
+    char                const * name;
+    tsunami_lab::t_real const * values;
+    tsunami_lab::t_real const * addend;
+  };
+
+  //! the columns, which are given, in the order of the CSV files
+  std::vector<Column> getColumns( tsunami_lab::t_real const * i_h,
+                                  tsunami_lab::t_real const * i_hu,
+                                  tsunami_lab::t_real const * i_hv,
+                                  tsunami_lab::t_real const * i_b ){
+    std::vector<Column> l_columns;
+    if( i_h  != nullptr ) l_columns.push_back({ "height", i_h, nullptr });
+    // total height how it would be seen on the surface
+    if( i_h  != nullptr && i_b != nullptr )
+                          l_columns.push_back({ "surface", i_h, i_b });
+    if( i_b  != nullptr ) l_columns.push_back({ "bathymetry", i_b, nullptr });
+    if( i_hu != nullptr ) l_columns.push_back({ "momentum_x", i_hu, nullptr });
+    if( i_hv != nullptr ) l_columns.push_back({ "momentum_y", i_hv, nullptr });
+    return l_columns;
+  }
+
+  /**
+   * Formats the cells as CSV. Blocks of rows are formatted in parallel into a buffer per thread, and are passed to io_write in order.
+   *
+   * @param i_columns columns after the coordinates.
+   * @param io_write writes a block of text; returns false on errors.
+   * @return false, if io_write failed.
+   **/
+  bool formatCells( tsunami_lab::t_real                               i_dxy,
+                    tsunami_lab::t_idx                                i_nx,
+                    tsunami_lab::t_idx                                i_ny,
+                    tsunami_lab::t_idx                                i_step,
+                    tsunami_lab::t_idx                                i_stride,
+                    std::vector<Column>                       const & i_columns,
+                    std::function<bool(char const *, std::size_t)>    io_write ){
+    typedef tsunami_lab::t_idx t_idx;
+    typedef tsunami_lab::t_real t_real;
+
+    std::string l_header = "x,y";
+    for(Column const & l_column : i_columns) l_header += std::string(",") + l_column.name;
+    l_header += "\n";
+    if(!io_write(l_header.data(), l_header.size())) return false;
+
+    // the x-coordinates are the same in all rows
+    t_idx l_nxOut = (i_nx + i_step - 1) / i_step;
+    t_idx l_nyOut = (i_ny + i_step - 1) / i_step;
+    std::vector<char> l_xTexts(l_nxOut * c_maxTextSize);
+    std::vector<t_idx> l_xEnds(l_nxOut + 1, 0);
+    char * l_xEnd = l_xTexts.data();
+    for( t_idx l_ox = 0; l_ox < l_nxOut; l_ox++ ) {
+      t_idx l_ix = l_ox * i_step;
+      // derive coordinates of cell center
+      t_real l_posX = i_nx > 1 ? (l_ix + 0.5) * i_dxy : 0;
+      l_xEnd = formatReal(l_posX, l_xEnd);
+      l_xEnds[l_ox+1] = l_xEnd - l_xTexts.data();
+    }
+
+    // blocks of about 1 MB, which are written at once
+    t_idx l_rowSize = l_xEnds[l_nxOut] + l_nxOut * ((i_columns.size() + 1) * (c_maxTextSize + 1) + 1);
+    t_idx l_blockRows = std::max<t_idx>(1, (1 << 20) / std::max<t_idx>(l_rowSize, 1));
+    t_idx l_numBlocks = (l_nyOut + l_blockRows - 1) / l_blockRows;
+    bool l_failed = false;
+
+    #pragma omp parallel
+    {
+      std::vector<char> l_buffer(l_blockRows * l_rowSize);
+      #pragma omp for ordered schedule(static, 1)
+      for( t_idx l_bl = 0; l_bl < l_numBlocks; l_bl++ ) {
+        char * l_text = l_buffer.data();
+        for( t_idx l_oy = l_bl * l_blockRows; l_oy < std::min((l_bl + 1) * l_blockRows, l_nyOut); l_oy++ ) {
+          t_idx l_iy = l_oy * i_step;
+          t_real l_posY = i_ny > 1 ? (l_iy + 0.5) * i_dxy : 0;
+          char l_yText[c_maxTextSize];
+          t_idx l_ySize = formatReal(l_posY, l_yText) - l_yText;
+
+          for( t_idx l_ox = 0; l_ox < l_nxOut; l_ox++ ) {
+            t_idx l_id = l_iy * i_stride + l_ox * i_step;
+            memcpy(l_text, l_xTexts.data() + l_xEnds[l_ox], l_xEnds[l_ox+1] - l_xEnds[l_ox]);
+            l_text += l_xEnds[l_ox+1] - l_xEnds[l_ox];
+            *l_text++ = ',';
+            memcpy(l_text, l_yText, l_ySize);
+            l_text += l_ySize;
+            for(Column const & l_column : i_columns){
+              *l_text++ = ',';
+              t_real l_value = l_column.values[l_id];
+              if(l_column.addend != nullptr) l_value += l_column.addend[l_id];
+              l_text = formatReal(l_value, l_text);
+            }
+            *l_text++ = '\n';
+          }
+        }
+        #pragma omp ordered
+        {
+          if(!l_failed && !io_write(l_buffer.data(), l_text - l_buffer.data())) l_failed = true;
+        }
+      }
+    }
+    return !l_failed;
+  }
+
+  //! writes all bytes to the file; returns false on errors
+  bool writeFully( int i_fd, char const * i_data, std::size_t i_size ){
+    for(std::size_t l_done = 0; l_done < i_size;){
+      ssize_t l_n = ::write(i_fd, i_data + l_done, i_size - l_done);
+      if(l_n <= 0) return false;
+      l_done += l_n;
+    }
+    return true;
+  }
+}
 
 void tsunami_lab::io::Csv::write( t_real               i_dxy,
                                   t_idx                i_nx,
@@ -30,30 +307,8 @@ void tsunami_lab::io::Csv::write( t_real               i_dxy,
                                   t_real       const * i_hu,
                                   t_real       const * i_hv,
                                   std::ostream       & io_stream ) {
-  // write the CSV header
-  io_stream << "x,y";
-  if( i_h  != nullptr ) io_stream << ",height";
-  if( i_hu != nullptr ) io_stream << ",momentum_x";
-  if( i_hv != nullptr ) io_stream << ",momentum_y";
-  io_stream << "\n";
-
-  // iterate over all cells
-  for( t_idx l_iy = 0; l_iy < i_ny; l_iy += i_step ) {
-    for( t_idx l_ix = 0; l_ix < i_nx; l_ix += i_step ) {
-      // derive coordinates of cell center
-      t_real l_posX = i_nx > 1 ? (l_ix + 0.5) * i_dxy : 0;
-      t_real l_posY = i_ny > 1 ? (l_iy + 0.5) * i_dxy : 0;
-
-      t_idx l_id = l_iy * i_stride + l_ix;
-
-      // write data
-      io_stream << l_posX << "," << l_posY;
-      if( i_h  != nullptr ) io_stream << "," << i_h[l_id];
-      if( i_hu != nullptr ) io_stream << "," << i_hu[l_id];
-      if( i_hv != nullptr ) io_stream << "," << i_hv[l_id];
-      io_stream << "\n";
-    }
-  }
+  formatCells( i_dxy, i_nx, i_ny, i_step, i_stride, getColumns(i_h, i_hu, i_hv, nullptr),
+               [&io_stream]( char const * i_text, std::size_t i_size ) { return (bool) io_stream.write(i_text, i_size); } );
   io_stream << std::flush;
 }
 
@@ -65,102 +320,298 @@ void tsunami_lab::io::Csv::write( t_real                i_dxy,
                                   t_real        const * i_h,
                                   t_real        const * i_hu,
                                   t_real        const * i_hv,
-								  t_real        const * i_b,
+                                  t_real        const * i_b,
                                   std::ostream        & io_stream ) {
-  // write the CSV header
-  io_stream << "x,y";
-  if( i_h  != nullptr ) io_stream << ",height";
-  if( i_h  != nullptr && i_b != nullptr )
-                        io_stream << ",surface";
-  if( i_b  != nullptr)  io_stream << ",bathymetry";
-  if( i_hu != nullptr ) io_stream << ",momentum_x";
-  if( i_hv != nullptr ) io_stream << ",momentum_y";
-  io_stream << "\n";
-  
-  if(i_h == nullptr || i_b == nullptr){}
-
-  // iterate over all cells
-  for( t_idx l_iy = 0; l_iy < i_ny; l_iy += i_step ) {
-    for( t_idx l_ix = 0; l_ix < i_nx; l_ix += i_step ) {
+  formatCells( i_dxy, i_nx, i_ny, i_step, i_stride, getColumns(i_h, i_hu, i_hv, i_b),
+               [&io_stream]( char const * i_text, std::size_t i_size ) { return (bool) io_stream.write(i_text, i_size); } );
+  io_stream << std::flush;
+}
 
-      // derive coordinates of cell center
-      t_real l_posX = i_nx > 1 ? (l_ix + 0.5) * i_dxy : 0;
-      t_real l_posY = i_ny > 1 ? (l_iy + 0.5) * i_dxy : 0;
+int tsunami_lab::io::Csv::write( std::string           i_fileName,
+                                 t_real                i_dxy,
+                                 t_idx                 i_nx,
+                                 t_idx                 i_ny,
+                                 t_idx                 i_step,
+                                 t_idx                 i_stride,
+                                 t_real        const * i_h,
+                                 t_real        const * i_hu,
+                                 t_real        const * i_hv,
+                                 t_real        const * i_b ) {
+  int l_fd = open(i_fileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if(l_fd < 0){
+    std::cerr << "could not create " << i_fileName << std::endl;
+    return -1;
+  }
+  bool l_failed = !formatCells( i_dxy, i_nx, i_ny, i_step, i_stride, getColumns(i_h, i_hu, i_hv, i_b),
+                                [l_fd]( char const * i_text, std::size_t i_size ) { return writeFully(l_fd, i_text, i_size); } );
+  if(close(l_fd)) l_failed = true;
+  if(l_failed){
+    std::cerr << "could not write " << i_fileName << std::endl;
+    return -1;
+  }
+  return 0;
+}
 
-      t_idx l_id = l_iy * i_stride + l_ix;
+int tsunami_lab::io::Csv::writeBinary( std::string           i_fileName,
+                                       t_real                i_dxy,
+                                       t_idx                 i_nx,
+                                       t_idx                 i_ny,
+                                       t_idx                 i_step,
+                                       t_idx                 i_stride,
+                                       t_real        const * i_h,
+                                       t_real        const * i_hu,
+                                       t_real        const * i_hv,
+                                       t_real        const * i_b ) {
+  std::vector<Column> l_columns = getColumns(i_h, i_hu, i_hv, i_b);
+  t_idx l_nxOut = (i_nx + i_step - 1) / i_step;
+  t_idx l_nyOut = (i_ny + i_step - 1) / i_step;
 
-      // write data
-      io_stream << l_posX;
-	  io_stream << "," << l_posY;
-      if( i_h  != nullptr ) io_stream << "," << i_h[l_id]; // water height
-      if( i_h  != nullptr && i_b != nullptr ) // total height how it would be seen on the surface
-	                        io_stream << "," << (i_h[l_id] + i_b[l_id]); 
-	  if( i_b  != nullptr ) io_stream << "," << i_b[l_id]; // bathymetry
-      if( i_hu != nullptr ) io_stream << "," << i_hu[l_id];
-      if( i_hv != nullptr ) io_stream << "," << i_hv[l_id];
-      io_stream << "\n";
+  BinaryHeader l_header = {};
+  memcpy(l_header.magic, "TSUNCSVB", sizeof(l_header.magic));
+  l_header.version    = 1;
+  l_header.realSize   = sizeof(t_real);
+  l_header.nx         = l_nxOut;
+  l_header.ny         = l_nyOut;
+  l_header.step       = i_step;
+  l_header.numColumns = l_columns.size();
+  l_header.dxy        = i_dxy;
+  std::vector<char> l_names(l_columns.size() * sizeof(BinaryHeader::name_t), 0);
+  for(t_idx l_co = 0; l_co < l_columns.size(); l_co++){
+    strncpy(l_names.data() + l_co * sizeof(BinaryHeader::name_t), l_columns[l_co].name, sizeof(BinaryHeader::name_t) - 1);
+  }
+
+  int l_fd = open(i_fileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if(l_fd < 0){
+    std::cerr << "could not create " << i_fileName << std::endl;
+    return -1;
+  }
+  bool l_failed = !writeFully(l_fd, reinterpret_cast<char const*>(&l_header), sizeof(l_header)) ||
+                  !writeFully(l_fd, l_names.data(), l_names.size());
+
+  // one column at a time, without the ghost cells
+  std::vector<t_real> l_values(l_nxOut * l_nyOut);
+  for(t_idx l_co = 0; l_co < l_columns.size() && !l_failed; l_co++){
+    Column const & l_column = l_columns[l_co];
+    #pragma omp parallel for
+    for( t_idx l_oy = 0; l_oy < l_nyOut; l_oy++ ) {
+      t_real * l_row = l_values.data() + l_oy * l_nxOut;
+      t_idx l_id = l_oy * i_step * i_stride;
+      for( t_idx l_ox = 0; l_ox < l_nxOut; l_ox++, l_id += i_step ) {
+        l_row[l_ox] = l_column.values[l_id];
+        if(l_column.addend != nullptr) l_row[l_ox] += l_column.addend[l_id];
+      }
     }
+    l_failed = !writeFully(l_fd, reinterpret_cast<char const*>(l_values.data()), l_values.size() * sizeof(t_real));
   }
-  io_stream << std::flush;
+  if(close(l_fd)) l_failed = true;
+  if(l_failed){
+    std::cerr << "could not write " << i_fileName << std::endl;
+    return -1;
+  }
+  return 0;
 }
 
-std::vector<std::pair<std::string, std::vector<tsunami_lab::t_real>>> tsunami_lab::io::Csv::read( std::istream &io_stream ){
-  
+namespace {
+  //! separators between values, besides commas and semicolons
+  bool isBlank( char i_char ){
+    return i_char == ' ' || i_char == '\t' || i_char == '\r' || i_char == '\v' || i_char == '\f';
+  }
+
+  bool isSeparator( char i_char ){
+    return isBlank(i_char) || i_char == ',' || i_char == ';' || i_char == '\n';
+  }
+
+  //! end of the line, which starts at i_line, excluding the line break
+  char const * lineEnd( char const * i_line, char const * i_end ){
+    char const * l_end = static_cast<char const*>(memchr(i_line, '\n', i_end - i_line));
+    return l_end ? l_end : i_end;
+  }
+
+  //! lines, which are neither empty nor comments
+  bool isDataLine( char const * i_line, char const * i_lineEnd ){
+    if(i_line == i_lineEnd || *i_line == '#') return false;
+    for(; i_line < i_lineEnd; i_line++) if(!isBlank(*i_line)) return true;
+    return false;
+  }
+
+  //! parses a value with strtof/strtod, which needs a terminated copy
+  tsunami_lab::t_real parseSlowly( char const * i_begin, char const * i_end ){
+    char l_buffer[64];
+    std::string l_longToken;
+    char const * l_token = l_buffer;
+    if(i_end - i_begin < (std::ptrdiff_t) sizeof(l_buffer)){
+      memcpy(l_buffer, i_begin, i_end - i_begin);
+      l_buffer[i_end - i_begin] = 0;
+    } else {
+      l_longToken.assign(i_begin, i_end);
+      l_token = l_longToken.c_str();
+    }
+    return std::is_same<tsunami_lab::t_real, float>::value ? std::strtof(l_token, nullptr) : std::strtod(l_token, nullptr);
+  }
+
+  /**
+   * Parses a decimal number like 141.0277 or -4.99e+05 with decimalToReal().
+   * Everything else is parsed by the C library, so the result is the same as with strtof().
+   **/
+  tsunami_lab::t_real parseReal( char const * i_begin, char const * i_end ){
+    char const * l_ch = i_begin;
+    bool l_negative = l_ch < i_end && *l_ch == '-';
+    if(l_ch < i_end && (*l_ch == '-' || *l_ch == '+')) l_ch++;
+
+    // up to 19 digits fit into the mantissa; leading zeros are skipped
+    uint64_t l_mantissa = 0;
+    int l_numDigits = 0, l_exponent = 0;
+    bool l_hasDigits = false;
+    for(; l_ch < i_end && *l_ch >= '0' && *l_ch <= '9'; l_ch++){
+      l_hasDigits = true;
+      if(l_mantissa == 0 && *l_ch == '0') continue;
+      if(++l_numDigits > 19) return parseSlowly(i_begin, i_end);
+      l_mantissa = l_mantissa * 10 + (*l_ch - '0');
+    }
+    if(l_ch < i_end && *l_ch == '.'){
+      for(l_ch++; l_ch < i_end && *l_ch >= '0' && *l_ch <= '9'; l_ch++){
+        l_hasDigits = true;
+        l_exponent--;
+        if(l_mantissa == 0 && *l_ch == '0') continue;
+        if(++l_numDigits > 19) return parseSlowly(i_begin, i_end);
+        l_mantissa = l_mantissa * 10 + (*l_ch - '0');
+      }
+    }
+    // trailing zeros, e.g. of 7500.250000, aren't significant
+    while(l_numDigits > 15 && l_mantissa % 10 == 0){
+      l_mantissa /= 10;
+      l_exponent++;
+      l_numDigits--;
+    }
+    if(l_numDigits > 15) return parseSlowly(i_begin, i_end);
+    if(!l_hasDigits) return parseSlowly(i_begin, i_end);
+    if(l_ch < i_end && (*l_ch == 'e' || *l_ch == 'E')){
+      l_ch++;
+      bool l_negativeExponent = l_ch < i_end && *l_ch == '-';
+      if(l_ch < i_end && (*l_ch == '-' || *l_ch == '+')) l_ch++;
+      int l_value = 0;
+      char const * l_digits = l_ch;
+      for(; l_ch < i_end && *l_ch >= '0' && *l_ch <= '9' && l_value < 1000; l_ch++) l_value = l_value * 10 + (*l_ch - '0');
+      if(l_ch == l_digits) return parseSlowly(i_begin, i_end);
+      l_exponent += l_negativeExponent ? -l_value : l_value;
+    }
+    tsunami_lab::t_real l_value;
+    if(l_ch != i_end || !decimalToReal(l_mantissa, l_exponent, l_negative, l_value)) return parseSlowly(i_begin, i_end);
+    return l_value;
+  }
+
+  /**
+   * Parses the values of a line.
+   *
+   * @param i_line first character of the line; i_lineEnd end of the line.
+   * @param i_numColumns number of columns.
+   * @param i_row row of the values.
+   * @param o_columns columns, which get the values; missing values are 0.
+   **/
+  void parseLine( char const                                                              * i_line,
+                  char const                                                              * i_lineEnd,
+                  tsunami_lab::t_idx                                                        i_row,
+                  std::vector<std::pair<std::string, std::vector<tsunami_lab::t_real>>> & o_columns ){
+    char const * l_ch = i_line;
+    for(auto & l_column : o_columns){
+      while(l_ch < i_lineEnd && isBlank(*l_ch)) l_ch++;
+      char const * l_token = l_ch;
+      while(l_ch < i_lineEnd && !isSeparator(*l_ch)) l_ch++;
+      l_column.second[i_row] = l_ch > l_token ? parseReal(l_token, l_ch) : 0;
+      while(l_ch < i_lineEnd && isBlank(*l_ch)) l_ch++;
+      if(l_ch < i_lineEnd && (*l_ch == ',' || *l_ch == ';')) l_ch++;
+    }
+  }
+}
+
+std::vector<std::pair<std::string, std::vector<tsunami_lab::t_real>>> tsunami_lab::io::Csv::parse( char const * i_data,
+                                                                                                    std::size_t  i_size ){
+
   std::vector<std::pair<std::string, std::vector<tsunami_lab::t_real>>> l_result;
-  
-  char l_comma;
-  
+  char const * l_end = i_data + i_size;
+
   // first find the header and define all properties
-  std::string l_line;
-  while(getline(io_stream, l_line)){
-    if(!l_line.empty() && l_line[0] != '#'){
-      // read column names, separated by whitespace
-      for(t_idx l_startIndex = 0, l_currentIndex = 0, l_size = l_line.size(); l_currentIndex <= l_size; l_currentIndex++){
-        char l_currentChar = l_currentIndex < l_size ? l_line[l_currentIndex] : ' ';
-        if(isspace(l_currentChar) || l_currentChar == ',' || l_currentChar == ';'){
-          if(l_currentIndex > l_startIndex){
-            // add new column to result
-            std::string l_columnName = l_line.substr(l_startIndex, l_currentIndex-l_startIndex);
-            l_result.push_back(std::pair<std::string, std::vector<t_real>>(l_columnName, std::vector<t_real>()));
-          }
-          l_startIndex = l_currentIndex + 1;
-        }
-      }
-      break;
-    }
-  }
-  
-  t_idx l_numProperties = l_result.size();
-  
-  // read all data
-  while(getline(io_stream, l_line)){
-    if(!l_line.empty() && l_line[0] != '#'){
-      std::stringstream l_splitter(l_line);
-      // split data by comma
-      // not really ideal or secure, probably only works if all fields have values,
-      // and there are no additional spaces
-      for(t_idx l_i=0;l_i<l_numProperties;l_i++){
-        t_real l_value = 0;
-        l_splitter >> l_value;
-        l_splitter >> l_comma;
-        l_result[l_i].second.push_back(l_value);
-      }
+  char const * l_line = i_data;
+  for(; l_line < l_end; l_line = lineEnd(l_line, l_end) + 1){
+    char const * l_lineEnd = lineEnd(l_line, l_end);
+    if(!isDataLine(l_line, l_lineEnd)) continue;
+    // read column names, separated by whitespace
+    for(char const * l_ch = l_line; l_ch < l_lineEnd;){
+      while(l_ch < l_lineEnd && isSeparator(*l_ch)) l_ch++;
+      char const * l_name = l_ch;
+      while(l_ch < l_lineEnd && !isSeparator(*l_ch)) l_ch++;
+      if(l_ch > l_name) l_result.push_back(std::pair<std::string, std::vector<t_real>>(std::string(l_name, l_ch), std::vector<t_real>()));
+    }
+    l_line = l_lineEnd + 1;
+    break;
+  }
+  if(l_line >= l_end || l_result.empty()) return l_result;
+
+  // chunks of at least 1 MB, which start after a line break
+  t_idx l_size = l_end - l_line;
+  t_idx l_numChunks = std::max<t_idx>(1, std::min<t_idx>(l_size >> 20, 4 * omp_get_max_threads()));
+  std::vector<char const*> l_chunks(l_numChunks + 1, l_end);
+  l_chunks[0] = l_line;
+  for(t_idx l_chunk = 1; l_chunk < l_numChunks; l_chunk++){
+    char const * l_start = std::max(l_line + l_size * l_chunk / l_numChunks, l_chunks[l_chunk-1]);
+    // the previous chunk ends with the line, which contains the start
+    l_chunks[l_chunk] = std::min(lineEnd(l_start, l_end) + 1, l_end);
+  }
+
+  // count the rows, so each chunk knows where its values go
+  std::vector<t_idx> l_firstRows(l_numChunks + 1, 0);
+  #pragma omp parallel for
+  for(t_idx l_chunk = 0; l_chunk < l_numChunks; l_chunk++){
+    t_idx l_numRows = 0;
+    for(char const * l_ch = l_chunks[l_chunk]; l_ch < l_chunks[l_chunk+1];){
+      char const * l_lineEnd = lineEnd(l_ch, l_chunks[l_chunk+1]);
+      if(isDataLine(l_ch, l_lineEnd)) l_numRows++;
+      l_ch = l_lineEnd + 1;
+    }
+    l_firstRows[l_chunk+1] = l_numRows;
+  }
+  for(t_idx l_chunk = 0; l_chunk < l_numChunks; l_chunk++) l_firstRows[l_chunk+1] += l_firstRows[l_chunk];
+  for(auto & l_column : l_result) l_column.second.resize(l_firstRows[l_numChunks]);
+
+  #pragma omp parallel for
+  for(t_idx l_chunk = 0; l_chunk < l_numChunks; l_chunk++){
+    t_idx l_row = l_firstRows[l_chunk];
+    for(char const * l_ch = l_chunks[l_chunk]; l_ch < l_chunks[l_chunk+1];){
+      char const * l_lineEnd = lineEnd(l_ch, l_chunks[l_chunk+1]);
+      if(isDataLine(l_ch, l_lineEnd)) parseLine(l_ch, l_lineEnd, l_row++, l_result);
+      l_ch = l_lineEnd + 1;
     }
   }
-  
+
   return l_result;
-  
+
+}
+
+std::vector<std::pair<std::string, std::vector<tsunami_lab::t_real>>> tsunami_lab::io::Csv::read( std::istream &io_stream ){
+  std::string l_text((std::istreambuf_iterator<char>(io_stream)), std::istreambuf_iterator<char>());
+  return parse(l_text.data(), l_text.size());
 }
 
 std::vector<std::pair<std::string, std::vector<tsunami_lab::t_real>>> tsunami_lab::io::Csv::read( std::string i_fileName ){
-  std::ifstream l_stream(i_fileName, std::ios::in);
-  if(!l_stream.is_open()){
+  std::vector<std::pair<std::string, std::vector<tsunami_lab::t_real>>> l_result;
+  int l_fd = open(i_fileName.c_str(), O_RDONLY);
+  struct stat l_stat;
+  if(l_fd < 0 || fstat(l_fd, &l_stat) != 0){
     std::cerr << "file \"" << i_fileName << "\" could not be opened" << std::endl;
-    std::vector<std::pair<std::string, std::vector<tsunami_lab::t_real>>> empty;
-    return empty;
+    if(l_fd >= 0) close(l_fd);
+    return l_result;
+  }
+  if(l_stat.st_size > 0){
+    void * l_mapping = mmap(nullptr, l_stat.st_size, PROT_READ, MAP_PRIVATE, l_fd, 0);
+    if(l_mapping == MAP_FAILED){
+      std::cerr << "file \"" << i_fileName << "\" could not be mapped" << std::endl;
+    } else {
+      madvise(l_mapping, l_stat.st_size, MADV_SEQUENTIAL);
+      l_result = parse(static_cast<char const*>(l_mapping), l_stat.st_size);
+      munmap(l_mapping, l_stat.st_size);
+    }
   }
-  auto l_result = read(l_stream);
-  l_stream.close();
+  close(l_fd);
   return l_result;
 }
 
@@ -173,3 +624,13 @@ std::vector<tsunami_lab::t_real> tsunami_lab::io::Csv::findColumn(
   }
   return std::vector<t_real>();
 }
+
+std::vector<tsunami_lab::t_real> tsunami_lab::io::Csv::takeColumn(
+  std::vector<std::pair<std::string, std::vector<tsunami_lab::t_real>>> &io_csvData,
+  std::string i_columnName
+){
+  for(auto & l_column : io_csvData){
+    if(l_column.first == i_columnName) return std::move(l_column.second);
+  }
+  return std::vector<t_real>();
+}
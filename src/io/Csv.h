@@ -19,8 +19,10 @@
 #define TSUNAMI_LAB_IO_CSV
 
 #include "../constants.h"
+#include <cstdint>
 #include <cstring>
 #include <iostream>
+#include <string>
 #include <vector>
 
 namespace tsunami_lab {
@@ -31,6 +33,28 @@ namespace tsunami_lab {
 
 class tsunami_lab::io::Csv {
   public:
+    /**
+     * Header of the binary alternative to the CSV files, see writeBinary().
+     * It is followed by numColumns names, and then by numColumns arrays of nx * ny values, row by row.
+     **/
+    struct BinaryHeader {
+      //! zero padded name of a column
+      typedef char name_t[16];
+
+      //! "TSUNCSVB"
+      char     magic[8];
+      uint32_t version;
+      //! sizeof(t_real) of the writer
+      uint32_t realSize;
+      //! written values per row and rows
+      uint64_t nx, ny;
+      //! only every step-th cell was written; value (i, j) belongs to the cell (i * step, j * step)
+      uint64_t step;
+      uint64_t numColumns;
+      //! cell width in x- and y-direction
+      double   dxy;
+    };
+
     /**
      * Writes the data as CSV to the given stream.
      *
@@ -78,6 +102,62 @@ class tsunami_lab::io::Csv {
                        t_real              const * i_b,
                        std::ostream              & io_stream );
     
+    /**
+     * Writes the data as CSV to a file; the same as writing to a stream, but with large writes to the file.
+     * The rows are formatted in parallel, and every value is written with the fewest digits, which are read as the same value again.
+     *
+     * @param i_fileName name of the file, which is created or overwritten.
+     * @param i_dxy cell width in x- and y-direction.
+     * @param i_nx number of cells in x-direction.
+     * @param i_ny number of cells in y-direction.
+     * @param i_step only every step-th cell is written.
+     * @param i_stride stride of the data arrays in y-direction (x is assumed to be stride-1).
+     * @param i_h water height of the cells; optional: use nullptr if not required.
+     * @param i_hu momentum in x-direction of the cells; optional: use nullptr if not required.
+     * @param i_hv momentum in y-direction of the cells; optional: use nullptr if not required.
+     * @param i_b bathymetry data of the cells; optional: use nullptr if not required.
+     * @return 0 on success, -1 if the file could not be written.
+     **/
+    static int write( std::string           i_fileName,
+                      t_real                i_dxy,
+                      t_idx                 i_nx,
+                      t_idx                 i_ny,
+                      t_idx                 i_step,
+                      t_idx                 i_stride,
+                      t_real        const * i_h,
+                      t_real        const * i_hu,
+                      t_real        const * i_hv,
+                      t_real        const * i_b );
+
+    /**
+     * Writes the same columns as the CSV files, but without the coordinates, as binary values after a BinaryHeader.
+     * The parameters are the same as the ones of write() with a file name.
+     *
+     * @return 0 on success, -1 if the file could not be written.
+     **/
+    static int writeBinary( std::string           i_fileName,
+                            t_real                i_dxy,
+                            t_idx                 i_nx,
+                            t_idx                 i_ny,
+                            t_idx                 i_step,
+                            t_idx                 i_stride,
+                            t_real        const * i_h,
+                            t_real        const * i_hu,
+                            t_real        const * i_hv,
+                            t_real        const * i_b );
+
+    /**
+     * Parses numeric data in CSV format.
+     * The first line, which is neither empty nor a comment (#), names the columns; they are separated by commas, semicolons or whitespace.
+     * The lines are split into chunks, which are parsed in parallel directly into the columns; missing values are 0.
+     *
+     * @param i_data CSV text, which doesn't need to be null terminated.
+     * @param i_size number of characters.
+     * @return vector of attributes: first the name of the column, then all values.
+     **/
+    static std::vector<std::pair<std::string, std::vector<tsunami_lab::t_real>>> parse( char const * i_data,
+                                                                                        std::size_t  i_size );
+
     /**
      * Reads numeric data in CSV format from a given stream.
      *
@@ -87,7 +167,7 @@ class tsunami_lab::io::Csv {
     static std::vector<std::pair<std::string, std::vector<tsunami_lab::t_real>>> read( std::istream& io_stream );
     
     /**
-     * Reads numeric data in CSV format from a given file by name.
+     * Reads numeric data in CSV format from a given file by name; the file is mapped and parsed without copies, see parse().
      *
      * @param i_fileName name of the file to read from.
      * @return vector of attributes: first the name of the column, then all values.
@@ -104,6 +184,17 @@ class tsunami_lab::io::Csv {
     static std::vector<tsunami_lab::t_real> findColumn(
       std::vector<std::pair<std::string, std::vector<tsunami_lab::t_real>>> &i_csvData, std::string i_columnName
     );
+
+    /**
+     * Moves a column out of the csv data without a copy; the column stays in the data, but its values are empty afterwards.
+     *
+     * @param io_csvData the csv to search in.
+     * @param i_columnName the name of the column.
+     * @return the data vector, if found; else an empty vector.
+     **/
+    static std::vector<tsunami_lab::t_real> takeColumn(
+      std::vector<std::pair<std::string, std::vector<tsunami_lab::t_real>>> &io_csvData, std::string i_columnName
+    );
 };
 
 #endif
\ No newline at end of file
@@ -17,7 +17,15 @@
  **/
 #include <catch2/catch.hpp>
 #include "../constants.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <sstream>
+#include <string>
+#include <vector>
 #define private public
 #include "Csv.h"
 #undef public
@@ -132,3 +140,189 @@ TEST_CASE( "Test the CSV Reader", "[CSVReader]" ) {
   }
   
 }
+
+TEST_CASE( "Test the CSV Reader with comments, other separators and missing values", "[CSVReader]" ) {
+  
+  std::string l_source = "# comment\r\n\r\n  \nx; y  height\r\n1.5;2 3\r\n# 7,7,7\n\n-4e2 ;  5.25\n6,,8\n9";
+  auto l_read = tsunami_lab::io::Csv::parse(l_source.data(), l_source.size());
+  
+  REQUIRE( l_read.size() == 3 );
+  REQUIRE( l_read[0].first == "x" );
+  REQUIRE( l_read[1].first == "y" );
+  REQUIRE( l_read[2].first == "height" );
+  
+  std::vector<t_real> l_expected[3] = { { 1.5, -400, 6, 9 }, { 2, 5.25, 0, 0 }, { 3, 0, 8, 0 } };
+  for(t_idx l_j=0;l_j<3;l_j++){
+    REQUIRE( l_read[l_j].second == l_expected[l_j] );
+  }
+  
+  // the column is moved out
+  std::vector<t_real> l_y = tsunami_lab::io::Csv::takeColumn(l_read, "y");
+  REQUIRE( l_y == l_expected[1] );
+  REQUIRE( l_read[1].second.empty() );
+  REQUIRE( tsunami_lab::io::Csv::takeColumn(l_read, "z").empty() );
+  
+}
+
+TEST_CASE( "Test that the CSV Reader parses large files in chunks like strtof", "[CSVReader]" ) {
+  
+  // more than 4 MB, so the lines are split into several chunks
+  std::string l_source = "track_location,height\n";
+  std::vector<std::string> l_tokens;
+  uint64_t l_random = 12345;
+  char const* l_special[] = { "16777217", "0.1", "-0", "1e-40", "3.4028235e38", "123456789012345678", "0.000000000000000000000000001", "7.", ".5", "+2e+3" };
+  for(t_idx l_i = 0; l_i < 300000; l_i++){
+    for(unsigned short l_co = 0; l_co < 2; l_co++){
+      l_random = l_random * 6364136223846793005ull + 1442695040888963407ull;
+      std::string l_token;
+      if(l_random % 97 == 0){
+        l_token = l_special[(l_random >> 33) % 10];
+      } else {
+        // random digits with a random decimal point and exponent
+        l_token = std::to_string((l_random >> 20) % 100000000000ull);
+        l_token.insert((l_random >> 8) % l_token.size(), ".");
+        if((l_random >> 60) == 0) l_token += "e" + std::to_string((int) ((l_random >> 50) % 20) - 10);
+        if(l_random & 1) l_token = "-" + l_token;
+      }
+      l_tokens.push_back(l_token);
+      l_source += l_token + (l_co == 0 ? "," : "\n");
+    }
+  }
+  REQUIRE( l_source.size() > (4u << 20) );
+  
+  std::stringstream l_inputStream(l_source);
+  auto l_read = tsunami_lab::io::Csv::read(l_inputStream);
+  REQUIRE( l_read.size() == 2 );
+  REQUIRE( l_read[0].second.size() == 300000 );
+  REQUIRE( l_read[1].second.size() == 300000 );
+  for(t_idx l_i = 0; l_i < l_tokens.size(); l_i++){
+    // bitwise the same
+    REQUIRE( l_read[l_i % 2].second[l_i / 2] == std::strtof(l_tokens[l_i].c_str(), nullptr) );
+  }
+  
+  // the mapped file gives the same result
+  std::string l_fileName = "tmp-csv-reader.csv";
+  {
+    std::ofstream l_file(l_fileName);
+    l_file << l_source;
+  }
+  auto l_mapped = tsunami_lab::io::Csv::read(l_fileName);
+  REQUIRE( l_mapped == l_read );
+  std::remove(l_fileName.c_str());
+  
+}
+
+TEST_CASE( "Test the CSV-writer with the shortest values, which are read back exactly.", "[CsvWriteShortest]" ) {
+  t_real l_h[6] = { 0.1f, 1e-7f, 123456792.f, 1.5e10f, -0.000123f, 1.5e-30f };
+  t_real l_hu[6] = { 0.f, -0.f, 2.5f, 1e-45f, 3.4028235e38f, 100.f };
+
+  std::stringstream l_stream;
+  tsunami_lab::io::Csv::write( 2, 6, 1, 1, 6, l_h, l_hu, nullptr, l_stream );
+
+  std::string l_ref = R"V0G0N(x,y,height,momentum_x
+1,0,0.1,0
+3,0,1e-07,-0
+5,0,123456790,2.5
+7,0,1.5e+10,1e-45
+9,0,-0.000123,3.4028235e+38
+11,0,1.5e-30,100
+)V0G0N";
+
+  REQUIRE( l_stream.str() == l_ref );
+
+  // random values of all magnitudes
+  t_idx l_nx = 300, l_ny = 200, l_stride = l_nx + 2;
+  std::vector<t_real> l_values(4 * l_stride * l_ny);
+  srand(11);
+  for(t_real & l_value : l_values){
+    uint32_t l_bits = ((uint32_t) rand() << 16) ^ (uint32_t) rand();
+    memcpy(&l_value, &l_bits, sizeof(l_value));
+    if(!std::isfinite(l_value)) l_value = (t_real) rand() / RAND_MAX;
+  }
+  t_real const * l_b  = l_values.data();
+  t_real const * l_hs = l_b + l_stride * l_ny;
+  std::string l_fileName = "tmp-csv-writer.csv";
+  REQUIRE( tsunami_lab::io::Csv::write( l_fileName, 0.25, l_nx, l_ny, 1, l_stride, l_hs, l_hs + l_stride * l_ny, l_hs + 2 * l_stride * l_ny, l_b ) == 0 );
+  auto l_read = tsunami_lab::io::Csv::read( l_fileName );
+  std::remove(l_fileName.c_str());
+
+  REQUIRE( l_read.size() == 7 );
+  REQUIRE( l_read[3].first == "surface" );
+  REQUIRE( l_read[5].first == "momentum_x" );
+  t_idx l_numWrong = 0, l_numLonger = 0;
+  for(t_idx l_iy = 0; l_iy < l_ny; l_iy++){
+    for(t_idx l_ix = 0; l_ix < l_nx; l_ix++){
+      t_idx l_row = l_ix + l_iy * l_nx, l_id = l_ix + l_iy * l_stride;
+      t_real l_expected[7] = { (t_real) ((l_ix + 0.5) * 0.25), (t_real) ((l_iy + 0.5) * 0.25), l_hs[l_id], l_hs[l_id] + l_b[l_id], l_b[l_id],
+                               l_hs[l_id + l_stride * l_ny], l_hs[l_id + 2 * l_stride * l_ny] };
+      for(t_idx l_co = 0; l_co < 7; l_co++){
+        if(memcmp(&l_read[l_co].second[l_row], &l_expected[l_co], sizeof(t_real)) != 0) l_numWrong++;
+      }
+    }
+  }
+  REQUIRE( l_numWrong == 0 );
+
+  // no value needs fewer significant digits than the ones, which were written
+  std::stringstream l_stream2;
+  tsunami_lab::io::Csv::write( 1, 1000, 1, 1, 1000, l_hs, nullptr, nullptr, l_stream2 );
+  std::string l_line;
+  std::getline(l_stream2, l_line);
+  for(t_idx l_ix = 0; l_ix < 1000 && std::getline(l_stream2, l_line); l_ix++){
+    std::string l_text = l_line.substr(l_line.rfind(',') + 1);
+    std::string l_mantissa = l_text.substr(0, l_text.find('e'));
+    l_mantissa.erase(std::remove(l_mantissa.begin(), l_mantissa.end(), '.'), l_mantissa.end());
+    l_mantissa.erase(std::remove(l_mantissa.begin(), l_mantissa.end(), '-'), l_mantissa.end());
+    l_mantissa.erase(0, l_mantissa.find_first_not_of('0'));
+    l_mantissa.erase(l_mantissa.find_last_not_of('0') + 1);
+    int l_numDigits = 1;
+    char l_buffer[64];
+    for(; l_numDigits < 9; l_numDigits++){
+      snprintf(l_buffer, sizeof(l_buffer), "%.*e", l_numDigits - 1, (double) l_hs[l_ix]);
+      if(std::strtof(l_buffer, nullptr) == l_hs[l_ix]) break;
+    }
+    if((int) l_mantissa.size() > l_numDigits) l_numLonger++;
+  }
+  REQUIRE( l_numLonger == 0 );
+}
+
+TEST_CASE( "Test the binary alternative to the CSV-writer.", "[CsvWriteBinary]" ) {
+  t_real l_h[12]  = {  0,  1,  2,  3,
+                       4,  5,  6,  7,
+                       8,  9, 10, 11 };
+  t_real l_b[12]  = { -1, -2, -3, -4,
+                      -5, -6, -7, -8,
+                      -9, -10, -11, -12 };
+
+  std::string l_fileName = "tmp-csv-writer.bin";
+  REQUIRE( tsunami_lab::io::Csv::writeBinary( l_fileName, 10, 3, 3, 2, 4, l_h, nullptr, l_b, l_b ) == 0 );
+
+  std::ifstream l_file(l_fileName, std::ios::binary);
+  tsunami_lab::io::Csv::BinaryHeader l_header;
+  l_file.read(reinterpret_cast<char*>(&l_header), sizeof(l_header));
+  REQUIRE( std::string(l_header.magic, 8) == "TSUNCSVB" );
+  REQUIRE( l_header.realSize == sizeof(t_real) );
+  REQUIRE( l_header.nx == 2 );
+  REQUIRE( l_header.ny == 2 );
+  REQUIRE( l_header.step == 2 );
+  REQUIRE( l_header.dxy == 10 );
+  REQUIRE( l_header.numColumns == 4 );
+
+  std::string l_names[4] = { "height", "surface", "bathymetry", "momentum_y" };
+  for(t_idx l_co = 0; l_co < 4; l_co++){
+    tsunami_lab::io::Csv::BinaryHeader::name_t l_name;
+    l_file.read(l_name, sizeof(l_name));
+    REQUIRE( std::string(l_name) == l_names[l_co] );
+  }
+  t_real l_values[16];
+  l_file.read(reinterpret_cast<char*>(l_values), sizeof(l_values));
+  REQUIRE( l_file.gcount() == sizeof(l_values) );
+  REQUIRE( l_file.peek() == EOF );
+  l_file.close();
+  std::remove(l_fileName.c_str());
+
+  t_real l_expected[16] = {  0,  2,  8, 10,
+                            -1, -1, -1, -1,
+                            -1, -3, -9, -11,
+                            -1, -3, -9, -11 };
+  for(t_idx l_va = 0; l_va < 16; l_va++) REQUIRE( l_values[l_va] == l_expected[l_va] );
+}
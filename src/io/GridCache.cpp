@@ -0,0 +1,167 @@
+/**
+ * @author Antonio Noack
+ *
+ * @section DESCRIPTION
+ * Cache of prepared grids.
+ **/
+#include "GridCache.h"
+
+#include <cerrno> // errno
+#include <cstdio> // std::rename, std::remove, snprintf
+#include <cstring> // memcmp, memcpy
+#include <iostream> // std::cerr
+#include <fcntl.h> // open
+#include <sys/mman.h> // mmap
+#include <sys/stat.h> // stat, mkdir
+#include <unistd.h> // write, close
+
+namespace {
+  char const c_magic[8] = { 'T', 'S', 'U', 'N', 'G', 'R', 'I', 'D' };
+  // part of the key, so changes of the sampling invalidate older grids
+  uint32_t const c_version = 2;
+
+  // FNV-1a
+  uint64_t hash( uint64_t i_hash, void const * i_data, uint64_t i_size ){
+    unsigned char const * l_data = static_cast<unsigned char const*>(i_data);
+    for(uint64_t l_by = 0; l_by < i_size; l_by++){
+      i_hash = (i_hash ^ l_data[l_by]) * 0x100000001B3ull;
+    }
+    return i_hash;
+  }
+}
+
+tsunami_lab::io::GridCache::GridCache( std::string i_directory ):
+  m_directory(i_directory) {
+}
+
+tsunami_lab::io::GridCache::~GridCache() {
+  unload();
+}
+
+void tsunami_lab::io::GridCache::unload() {
+  if(m_mapping) munmap(m_mapping, m_mappingSize);
+  m_mapping     = nullptr;
+  m_mappingSize = 0;
+}
+
+int tsunami_lab::io::GridCache::key( std::vector<std::string> const & i_fileNames,
+                                     std::string              const & i_parameters,
+                                     uint64_t                       & o_key ) {
+  uint64_t l_key = 0xCBF29CE484222325ull;
+  l_key = hash(l_key, &c_version, sizeof(c_version));
+  for(std::string const & l_fileName : i_fileNames){
+    struct stat l_stat;
+    if(stat(l_fileName.c_str(), &l_stat)){
+      std::cerr << "could not find '" << l_fileName << "' for the key of the grid" << std::endl;
+      return -1;
+    }
+    int64_t l_metadata[3] = { (int64_t) l_stat.st_size, (int64_t) l_stat.st_mtim.tv_sec, (int64_t) l_stat.st_mtim.tv_nsec };
+    l_key = hash(l_key, l_fileName.c_str(), l_fileName.size() + 1);
+    l_key = hash(l_key, l_metadata, sizeof(l_metadata));
+  }
+  o_key = hash(l_key, i_parameters.c_str(), i_parameters.size());
+  return 0;
+}
+
+std::string tsunami_lab::io::GridCache::fileName( uint64_t i_key ) const {
+  char l_name[32];
+  snprintf(l_name, sizeof(l_name), "grid-%016llx.raw", (unsigned long long) i_key);
+  return m_directory + "/" + l_name;
+}
+
+tsunami_lab::setups::PreparedGrid2d * tsunami_lab::io::GridCache::load( uint64_t   i_key,
+                                                                        t_idx    & o_nx,
+                                                                        t_idx    & o_ny,
+                                                                        t_real   & o_cellSizeMeters,
+                                                                        t_real   & o_gridOffsetX,
+                                                                        t_real   & o_gridOffsetY ) {
+  if(!isEnabled()) return nullptr;
+  int l_fd = open(fileName(i_key).c_str(), O_RDONLY);
+  if(l_fd < 0) return nullptr;
+  struct stat l_stat;
+  void * l_mapping = MAP_FAILED;
+  if(fstat(l_fd, &l_stat) == 0 && (uint64_t) l_stat.st_size >= sizeof(Header)){
+    l_mapping = mmap(nullptr, l_stat.st_size, PROT_READ, MAP_PRIVATE, l_fd, 0);
+  }
+  // the mapping stays valid without the descriptor
+  close(l_fd);
+  if(l_mapping == MAP_FAILED) return nullptr;
+
+  Header l_header;
+  memcpy(&l_header, l_mapping, sizeof(Header));
+  uint64_t l_nValues = 3 * (l_header.nx + 2) * (l_header.ny + 2);
+  if(memcmp(l_header.magic, c_magic, sizeof(c_magic)) != 0 || l_header.version != c_version || l_header.realSize != sizeof(t_real) ||
+     l_header.key != i_key || (uint64_t) l_stat.st_size != sizeof(Header) + l_nValues * sizeof(t_real)){
+    std::cerr << "ignoring the invalid grid " << fileName(i_key) << std::endl;
+    munmap(l_mapping, l_stat.st_size);
+    return nullptr;
+  }
+  // the patches read the grid row by row
+  madvise(l_mapping, l_stat.st_size, MADV_SEQUENTIAL);
+
+  unload();
+  m_mapping     = l_mapping;
+  m_mappingSize = l_stat.st_size;
+
+  o_nx             = l_header.nx;
+  o_ny             = l_header.ny;
+  o_cellSizeMeters = l_header.cellSizeMeters;
+  o_gridOffsetX    = l_header.gridOffsetX;
+  o_gridOffsetY    = l_header.gridOffsetY;
+  t_real const * l_values = reinterpret_cast<t_real const*>(static_cast<char const*>(m_mapping) + sizeof(Header));
+  return new tsunami_lab::setups::PreparedGrid2d(l_values, l_header.nx, l_header.ny, l_header.scaleX, l_header.scaleY);
+}
+
+int tsunami_lab::io::GridCache::store( uint64_t                                    i_key,
+                                       tsunami_lab::setups::PreparedGrid2d const & i_grid,
+                                       t_real                                      i_cellSizeMeters,
+                                       t_real                                      i_gridOffsetX,
+                                       t_real                                      i_gridOffsetY ) const {
+  if(!isEnabled()) return -1;
+  if(mkdir(m_directory.c_str(), 0755) && errno != EEXIST){
+    std::cerr << "could not create the grid cache '" << m_directory << "'" << std::endl;
+    return -1;
+  }
+
+  Header l_header = {};
+  memcpy(l_header.magic, c_magic, sizeof(c_magic));
+  l_header.version        = c_version;
+  l_header.realSize       = sizeof(t_real);
+  l_header.key            = i_key;
+  l_header.nx             = i_grid.getNx();
+  l_header.ny             = i_grid.getNy();
+  l_header.scaleX         = i_grid.getScaleX();
+  l_header.scaleY         = i_grid.getScaleY();
+  l_header.cellSizeMeters = i_cellSizeMeters;
+  l_header.gridOffsetX    = i_gridOffsetX;
+  l_header.gridOffsetY    = i_gridOffsetY;
+
+  std::string l_fileName = fileName(i_key);
+  // unique per process, if several runs prepare the same grid
+  std::string l_tmpFileName = l_fileName + ".tmp" + std::to_string(getpid());
+  int l_fd = open(l_tmpFileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if(l_fd < 0){
+    std::cerr << "could not create " << l_tmpFileName << std::endl;
+    return -1;
+  }
+  char const * l_parts[2] = { reinterpret_cast<char const*>(&l_header), reinterpret_cast<char const*>(i_grid.getValues()) };
+  uint64_t l_sizes[2] = { sizeof(Header), i_grid.getNumValues() * sizeof(t_real) };
+  bool l_failed = false;
+  for(unsigned short l_pa = 0; l_pa < 2 && !l_failed; l_pa++){
+    for(uint64_t l_done = 0; l_done < l_sizes[l_pa];){
+      ssize_t l_n = write(l_fd, l_parts[l_pa] + l_done, l_sizes[l_pa] - l_done);
+      if(l_n <= 0){
+        l_failed = true;
+        break;
+      }
+      l_done += l_n;
+    }
+  }
+  if(close(l_fd)) l_failed = true;
+  if(l_failed || std::rename(l_tmpFileName.c_str(), l_fileName.c_str())){
+    std::cerr << "could not write the grid " << l_fileName << std::endl;
+    std::remove(l_tmpFileName.c_str());
+    return -1;
+  }
+  return 0;
+}
@@ -0,0 +1,124 @@
+/**
+ * @author Antonio Noack
+ *
+ * @section DESCRIPTION
+ * Cache of prepared grids: the setup of the input files, sampled at the resolution of the simulation.
+ * A grid is stored in a raw file, whose name is a key of the input files' size and modification time, and the
+ * parameters, which change the grid. Later runs with the same key map the file instead of reading and resampling the inputs.
+ **/
+#ifndef TSUNAMI_LAB_IO_GRID_CACHE_H
+#define TSUNAMI_LAB_IO_GRID_CACHE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../constants.h"
+#include "../setups/PreparedGrid2d.h"
+
+namespace tsunami_lab {
+  namespace io {
+    class GridCache;
+  }
+}
+
+class tsunami_lab::io::GridCache {
+  private:
+    //! header of a cache file; the values follow directly
+    struct Header {
+      //! "TSUNGRID"
+      char     magic[8];
+      uint32_t version;
+      //! sizeof(t_real) of the writer
+      uint32_t realSize;
+      uint64_t key;
+      //! cells without the ghost cells
+      uint64_t nx, ny;
+      double   scaleX, scaleY;
+      double   cellSizeMeters, gridOffsetX, gridOffsetY;
+    };
+
+    //! directory of the cache files; empty if the cache is disabled
+    std::string m_directory;
+
+    //! mapped file of the grid, which was loaded
+    void * m_mapping = nullptr;
+    uint64_t m_mappingSize = 0;
+
+  public:
+    /**
+     * Constructs the cache.
+     *
+     * @param i_directory directory of the cache files, which is created when a grid is stored; empty to disable the cache.
+     **/
+    explicit GridCache( std::string i_directory );
+
+    /**
+     * Unmaps the loaded grid; setups, which were returned by load(), must not be used anymore.
+     **/
+    ~GridCache();
+
+    /**
+     * Unmaps the loaded grid, e.g. after the patch was initialized; the setup, which was returned by load(), must not be used anymore.
+     **/
+    void unload();
+
+    GridCache( GridCache const & ) = delete;
+    GridCache & operator=( GridCache const & ) = delete;
+
+    /** self explanatory */
+    bool isEnabled() const { return !m_directory.empty(); }
+
+    /**
+     * Computes the key of a grid.
+     *
+     * @param i_fileNames input files; their path, size and modification time are part of the key.
+     * @param i_parameters all parameters, which change the grid, e.g. the scale.
+     * @param o_key key.
+     * @return 0 if successful, -1 if an input file is missing.
+     **/
+    static int key( std::vector<std::string> const & i_fileNames,
+                    std::string              const & i_parameters,
+                    uint64_t                       & o_key );
+
+    /**
+     * Gets the file name of a grid.
+     *
+     * @param i_key key.
+     * @return file name in the cache directory.
+     **/
+    std::string fileName( uint64_t i_key ) const;
+
+    /**
+     * Maps a cached grid; the values are read, when they are used the first time.
+     *
+     * @param i_key key.
+     * @param o_nx, o_ny cells without the ghost cells.
+     * @param o_cellSizeMeters cell size of the input files, before the scale was applied.
+     * @param o_gridOffsetX, o_gridOffsetY coordinates of the input files, see NetCDF::load2dArray().
+     * @return setup, which is valid while this cache exists and until the next load(); nullptr, if there is no valid grid.
+     **/
+    tsunami_lab::setups::PreparedGrid2d * load( uint64_t   i_key,
+                                                t_idx    & o_nx,
+                                                t_idx    & o_ny,
+                                                t_real   & o_cellSizeMeters,
+                                                t_real   & o_gridOffsetX,
+                                                t_real   & o_gridOffsetY );
+
+    /**
+     * Stores a grid; a temporary file is renamed at the end, so other runs never see an incomplete grid.
+     *
+     * @param i_key key.
+     * @param i_grid grid.
+     * @param i_cellSizeMeters cell size of the input files, before the scale was applied.
+     * @param i_gridOffsetX, i_gridOffsetY coordinates of the input files, see NetCDF::load2dArray().
+     * @return 0 if successful, -1 else.
+     **/
+    int store( uint64_t                                    i_key,
+               tsunami_lab::setups::PreparedGrid2d const & i_grid,
+               t_real                                      i_cellSizeMeters,
+               t_real                                      i_gridOffsetX,
+               t_real                                      i_gridOffsetY ) const;
+};
+
+#endif
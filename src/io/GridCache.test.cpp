@@ -0,0 +1,87 @@
+/**
+ * @author Antonio Noack
+ *
+ * @section DESCRIPTION
+ * Unit tests for the cache of prepared grids.
+ **/
+#include <catch2/catch.hpp>
+#include "../constants.h"
+#include "../setups/DamBreak2d.h"
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+
+#include "GridCache.h"
+
+#define t_idx  tsunami_lab::t_idx
+#define t_real tsunami_lab::t_real
+
+TEST_CASE( "Test storing and loading prepared grids.", "[GridCache]" ) {
+
+  std::string l_inputFileName = "tmp-grid-input.nc";
+  {
+    std::ofstream l_input( l_inputFileName );
+    l_input << "bathymetry";
+  }
+
+  uint64_t l_key, l_otherKey;
+  REQUIRE( tsunami_lab::io::GridCache::key( { l_inputFileName }, "scale: 2\n", l_key ) == 0 );
+  REQUIRE( tsunami_lab::io::GridCache::key( { l_inputFileName }, "scale: 2\n", l_otherKey ) == 0 );
+  REQUIRE( l_otherKey == l_key );
+  REQUIRE( tsunami_lab::io::GridCache::key( { l_inputFileName }, "scale: 3\n", l_otherKey ) == 0 );
+  REQUIRE( l_otherKey != l_key );
+  REQUIRE( tsunami_lab::io::GridCache::key( { "tmp-grid-missing.nc" }, "scale: 2\n", l_otherKey ) != 0 );
+
+  t_idx l_nx = 7, l_ny = 5;
+  tsunami_lab::setups::DamBreak2d l_setup( 10, 5, 3, 2, 2, -10 );
+  tsunami_lab::setups::PreparedGrid2d l_grid( &l_setup, l_nx, l_ny, 0.5, 0.5 );
+
+  // a disabled cache neither stores nor loads
+  t_idx l_nx2 = 0, l_ny2 = 0;
+  t_real l_cellSizeMeters = 0, l_gridOffsetX = 0, l_gridOffsetY = 0;
+  tsunami_lab::io::GridCache l_disabled( "" );
+  REQUIRE( !l_disabled.isEnabled() );
+  REQUIRE( l_disabled.store( l_key, l_grid, 250, 10, 20 ) != 0 );
+  REQUIRE( l_disabled.load( l_key, l_nx2, l_ny2, l_cellSizeMeters, l_gridOffsetX, l_gridOffsetY ) == nullptr );
+
+  tsunami_lab::io::GridCache l_cache( "tmp-grid-cache" );
+  REQUIRE( l_cache.load( l_key, l_nx2, l_ny2, l_cellSizeMeters, l_gridOffsetX, l_gridOffsetY ) == nullptr );
+  REQUIRE( l_cache.store( l_key, l_grid, 250, 10, 20 ) == 0 );
+  {
+    std::unique_ptr<tsunami_lab::setups::PreparedGrid2d> l_loaded( l_cache.load( l_key, l_nx2, l_ny2, l_cellSizeMeters, l_gridOffsetX, l_gridOffsetY ) );
+    REQUIRE( l_loaded );
+    REQUIRE( l_nx2 == l_nx );
+    REQUIRE( l_ny2 == l_ny );
+    REQUIRE( l_cellSizeMeters == 250 );
+    REQUIRE( l_gridOffsetX == 10 );
+    REQUIRE( l_gridOffsetY == 20 );
+    REQUIRE( l_loaded->getScaleX() == 0.5 );
+    REQUIRE( l_loaded->getNumValues() == l_grid.getNumValues() );
+    for( t_idx l_va = 0; l_va < l_grid.getNumValues(); l_va++ ) {
+      REQUIRE( l_loaded->getValues()[l_va] == l_grid.getValues()[l_va] );
+    }
+  }
+
+  // changed input files have another key
+  {
+    std::ofstream l_input( l_inputFileName, std::ios::app );
+    l_input << " and more";
+  }
+  REQUIRE( tsunami_lab::io::GridCache::key( { l_inputFileName }, "scale: 2\n", l_otherKey ) == 0 );
+  REQUIRE( l_otherKey != l_key );
+  REQUIRE( l_cache.load( l_otherKey, l_nx2, l_ny2, l_cellSizeMeters, l_gridOffsetX, l_gridOffsetY ) == nullptr );
+
+  // a truncated grid is ignored
+  std::string l_fileName = l_cache.fileName( l_key );
+  {
+    std::ofstream l_truncated( l_fileName, std::ios::binary );
+    l_truncated << "TSUNGRID";
+  }
+  REQUIRE( l_cache.load( l_key, l_nx2, l_ny2, l_cellSizeMeters, l_gridOffsetX, l_gridOffsetY ) == nullptr );
+
+  std::remove( l_fileName.c_str() );
+  std::remove( "tmp-grid-cache" );
+  std::remove( l_inputFileName.c_str() );
+}
@@ -5,13 +5,21 @@
  * IO-routines for writing a snapshot as a NetCDF file.
  **/
 
+#include <algorithm> // std::min
+#include <chrono> // read times
 #include <cmath> // isnan
 #include <iostream> // std::cerr
 #include <fstream>
 #include <cstdio> // std::rename
+#include <cstring> // strlen
 #include <stdexcept>
 #include <netcdf.h>
+#include <netcdf_filter.h> // zstandard
+#include <sys/mman.h> // shared memory of the reading processes
 #include <sys/stat.h> // check whether a file exists
+#include <sys/wait.h> // waitpid
+#include <unistd.h> // fork
+#include <omp.h> // omp_set_num_threads
 
 #include "NetCdf.h"
 #include "../setups/CheckPoint.h"
@@ -54,6 +62,9 @@
 #define get_vara(handle, varId, start, count, data)\
   sizeof(t_real) == 4 ? nc_get_vara_float(handle, varId, start, count, (float*) data) : nc_get_vara_double(handle, varId, start, count, (double*) data)
 
+#define get_vars(handle, varId, start, count, stride, data)\
+  sizeof(t_real) == 4 ? nc_get_vars_float(handle, varId, start, count, stride, (float*) data) : nc_get_vars_double(handle, varId, start, count, stride, (double*) data)
+
 #define put_var1(handle, varId, start, data)\
   sizeof(t_real) == 4 ? nc_put_var1_float(handle, varId, start, (float*) data) : nc_put_var1_double(handle, varId, start, (double*) data)
 
@@ -64,6 +75,66 @@
 #define CEIL_DIV(a,div) (a+div-1)/(div)
 #endif
 
+tsunami_lab::io::NetCDF::Codec tsunami_lab::io::NetCDF::m_codec = tsunami_lab::io::NetCDF::DEFLATE;
+tsunami_lab::t_idx tsunami_lab::io::NetCDF::m_chunkRows = 0;
+int tsunami_lab::io::NetCDF::m_significantBits[3] = { 0, 0, 0 };
+
+void tsunami_lab::io::NetCDF::setCompression( Codec i_codec,
+                                              t_idx i_chunkRows ){
+  m_codec = i_codec;
+  m_chunkRows = i_chunkRows;
+}
+
+void tsunami_lab::io::NetCDF::setSignificantBits( unsigned short i_quantity,
+                                                  int            i_bits ){
+  m_significantBits[i_quantity] = std::min(std::max(i_bits, 0), 23);
+}
+
+bool tsunami_lab::io::NetCDF::parseCodec( std::string const & i_name,
+                                          Codec             & o_codec ){
+  if(i_name == "deflate"){ o_codec = DEFLATE; return true; }
+  if(i_name == "zstd"){ o_codec = ZSTD; return true; }
+  if(i_name == "none"){ o_codec = NONE; return true; }
+  return false;
+}
+
+int tsunami_lab::io::NetCDF::defineCompression( int   i_handle,
+                                                int   i_varId,
+                                                int   i_nDims,
+                                                t_idx i_nx,
+                                                t_idx i_ny,
+                                                int   i_level ){
+  int l_err = NC_NOERR;
+  if(m_chunkRows > 0 && i_nDims > 1){
+    // one time step, and full rows: a frame is written in whole chunks, which are compressed independently
+    size_t l_chunks[3] = { 1, std::min(m_chunkRows, i_ny), i_nx };
+    l_err = nc_def_var_chunking(i_handle, i_varId, NC_CHUNKED, i_nDims == 3 ? l_chunks : l_chunks + 1);
+    if(l_err != NC_NOERR) return l_err;
+  }
+  if(i_level <= 0 || m_codec == NONE) return l_err;
+  
+  if(m_codec == ZSTD && nc_inq_filter_avail(i_handle, H5Z_FILTER_ZSTD) != NC_NOERR){
+    std::cerr << "zstd filter isn't available, check HDF5_PLUGIN_PATH; using deflate" << std::endl;
+    m_codec = DEFLATE;
+  }
+  
+  // reorders high and low bytes such that first all high bytes are written, then the low bytes.
+  // is said to be useless for deflate level = 9. In my test, testing config/tsunami2d-tohoku.yaml, this was incorrect
+  if(m_codec == ZSTD){
+    l_err = nc_def_var_deflate(i_handle, i_varId, 1, 0, 0);
+    if(l_err != NC_NOERR) return l_err;
+    return nc_def_var_zstandard(i_handle, i_varId, i_level);
+  }
+  return nc_def_var_deflate(i_handle, i_varId, 1, 1, i_level);
+}
+
+int tsunami_lab::io::NetCDF::defineQuantization( int            i_handle,
+                                                 int            i_varId,
+                                                 unsigned short i_quantity ){
+  if(m_significantBits[i_quantity] <= 0) return NC_NOERR;
+  return nc_def_var_quantize(i_handle, i_varId, NC_QUANTIZE_BITROUND, m_significantBits[i_quantity]);
+}
+
 int tsunami_lab::io::NetCDF::storeRow( int l_handle,
                                        int i_varId,
                                        int i_timeIndex,
@@ -187,82 +258,105 @@ int tsunami_lab::io::NetCDF::downsample( int l_handle,
   return l_err;
 }
 
-tsunami_lab::setups::Setup* tsunami_lab::io::NetCDF::loadCheckpoint( std::string i_fileName, t_idx &o_nx, t_idx &o_ny, t_real &o_cellSizeMeters, t_real &o_cflFactor, double &o_simulationTime, t_idx &o_timeStepIndex, std::vector<tsunami_lab::io::Station> &o_stations ){
+int tsunami_lab::io::NetCDF::downsampleRows( int                                    i_handle,
+                                             int                                    i_varId,
+                                             int                                    i_timeIndex,
+                                             t_idx                                  i_sizeXIn,
+                                             t_idx                                  i_sizeYIn,
+                                             t_idx                                  i_offsetIn,
+                                             tsunami_lab::patches::WavePropagation* i_waveProp,
+                                             unsigned short                         i_quantity,
+                                             t_idx                                  i_sizeXOut,
+                                             t_idx                                  i_sizeYOut,
+                                             t_idx                                  i_step ){
+  int l_err = 0;
+  std::cout << "    writing " << i_sizeXIn << " x " << i_sizeYIn << " -> " << i_sizeXOut << " x " << i_sizeYOut << " from rows" << std::endl;
+  t_idx l_strideIn = i_waveProp->getStride();
+  std::vector<t_real> l_rows(i_step * l_strideIn);
+  std::vector<t_real> l_dataOut(i_sizeXOut);
+  for(t_idx l_yOut=0;l_yOut<i_sizeYOut;l_yOut++){
+    const t_idx l_yIn0 = l_yOut * i_step;
+    const t_idx l_yIn1 = std::min(l_yIn0 + i_step, i_sizeYIn);
+    for(t_idx l_yIn=l_yIn0;l_yIn<l_yIn1;l_yIn++){
+      i_waveProp->getRow(i_quantity, l_yIn + i_offsetIn, l_rows.data() + (l_yIn - l_yIn0) * l_strideIn);
+    }
+    t_real const* l_rowsIn = l_rows.data() + i_offsetIn;
+    #pragma omp parallel for
+    for(t_idx l_xOut=0;l_xOut<i_sizeXOut;l_xOut++){
+      const t_idx l_xIn0 = l_xOut * i_step;
+      const t_idx l_xIn1 = std::min(l_xIn0 + i_step, i_sizeXIn);
+      t_real l_sum = 0;
+      for(t_idx l_yIn=0;l_yIn<l_yIn1-l_yIn0;l_yIn++){
+        t_idx l_indexIn = l_xIn0 + l_yIn * l_strideIn;
+        for(t_idx l_xIn=l_xIn0;l_xIn<l_xIn1;l_xIn++){
+          l_sum += l_rowsIn[l_indexIn++];
+        }
+      }
+      l_dataOut[l_xOut] = l_sum / (t_real)((l_xIn1-l_xIn0)*(l_yIn1-l_yIn0));
+    }
+    l_err = storeRow(i_handle, i_varId, i_timeIndex, l_yOut, i_sizeXOut, l_dataOut.data());
+    if(l_err) return l_err;
+  }
+  std::cout << "    done writing chunk of memory" << std::endl;
+  return l_err;
+}
+
+int tsunami_lab::io::NetCDF::loadCheckpointInfo( std::string                             i_fileName,
+                                                 t_idx                                 & o_nx,
+                                                 t_idx                                 & o_ny,
+                                                 t_real                                & o_cellSizeMeters,
+                                                 t_real                                & o_cflFactor,
+                                                 double                                & o_simulationTime,
+                                                 t_idx                                 & o_timeStepIndex,
+                                                 std::vector<tsunami_lab::io::Station> & o_stations ){
   
   bool f = sizeof(t_real) == 4;
 
   int l_err, l_handle;
-  check2(nc_open(i_fileName.c_str(), NC_NOWRITE, &l_handle));
+  check(nc_open(i_fileName.c_str(), NC_NOWRITE, &l_handle));
   
   // query the dimension ids
   int l_xDimId, l_yDimId, l_iDimId;
-  check2(nc_inq_dimid(l_handle, "x", &l_xDimId));
-  check2(nc_inq_dimid(l_handle, "y", &l_yDimId));
-  check2(nc_inq_dimid(l_handle, "i", &l_iDimId));
+  check(nc_inq_dimid(l_handle, "x", &l_xDimId));
+  check(nc_inq_dimid(l_handle, "y", &l_yDimId));
+  check(nc_inq_dimid(l_handle, "i", &l_iDimId));
   
   // query dimension sizes
   char l_tmpDimName[NC_MAX_NAME+1];// name, ignored
-  check2(nc_inq_dim(l_handle, l_xDimId, l_tmpDimName, &o_nx));
-  check2(nc_inq_dim(l_handle, l_yDimId, l_tmpDimName, &o_ny));
+  check(nc_inq_dim(l_handle, l_xDimId, l_tmpDimName, &o_nx));
+  check(nc_inq_dim(l_handle, l_yDimId, l_tmpDimName, &o_ny));
   
-  // query the variable ids, for which the values are vectors
-  int l_hVarId, l_bVarId, l_huVarId, l_hvVarId;
-  check2(nc_inq_varid(l_handle, "height",     &l_hVarId));
-  check2(nc_inq_varid(l_handle, "bathymetry", &l_bVarId));
-  check2(nc_inq_varid(l_handle, "momentumX",  &l_huVarId));
-  if(o_ny > 1) check2(nc_inq_varid(l_handle, "momentumY",  &l_hvVarId));
-
   // query the variable ids, for which the values are scalars
   int l_simTimeVarId, l_simIdxVarId, l_cellSizeVarId, l_cflFactorVarId;
-  check2(nc_inq_varid(l_handle, "simulationTime",  &l_simTimeVarId));
-  check2(nc_inq_varid(l_handle, "timeStepIndex",   &l_simIdxVarId));
-  check2(nc_inq_varid(l_handle, "cflFactor",       &l_cflFactorVarId));
-  check2(nc_inq_varid(l_handle, "cellSizeMeters",  &l_cellSizeVarId));
+  check(nc_inq_varid(l_handle, "simulationTime",  &l_simTimeVarId));
+  check(nc_inq_varid(l_handle, "timeStepIndex",   &l_simIdxVarId));
+  check(nc_inq_varid(l_handle, "cflFactor",       &l_cflFactorVarId));
+  check(nc_inq_varid(l_handle, "cellSizeMeters",  &l_cellSizeVarId));
   
   long long int o_timeStepIndex2;
-  check2(nc_get_var1_double(  l_handle, l_simTimeVarId, nullptr, (double*)        &o_simulationTime));
-  check2(nc_get_var1_longlong(l_handle, l_simIdxVarId,  nullptr, (long long int*) &o_timeStepIndex2));
+  check(nc_get_var1_double(  l_handle, l_simTimeVarId, nullptr, (double*)        &o_simulationTime));
+  check(nc_get_var1_longlong(l_handle, l_simIdxVarId,  nullptr, (long long int*) &o_timeStepIndex2));
   o_timeStepIndex = o_timeStepIndex2;// just in case the size is different
   
   // read all scalar properties
   if(f){
-    check2(nc_get_var1_float( l_handle, l_cflFactorVarId, nullptr, (float*)  &o_cflFactor));
-    check2(nc_get_var1_float( l_handle, l_cellSizeVarId,  nullptr, (float*)  &o_cellSizeMeters));
+    check(nc_get_var1_float( l_handle, l_cflFactorVarId, nullptr, (float*)  &o_cflFactor));
+    check(nc_get_var1_float( l_handle, l_cellSizeVarId,  nullptr, (float*)  &o_cellSizeMeters));
   } else {
-    check2(nc_get_var1_double(l_handle, l_cflFactorVarId, nullptr, (double*) &o_cflFactor));
-    check2(nc_get_var1_double(l_handle, l_cellSizeVarId,  nullptr, (double*) &o_cellSizeMeters));
+    check(nc_get_var1_double(l_handle, l_cflFactorVarId, nullptr, (double*) &o_cflFactor));
+    check(nc_get_var1_double(l_handle, l_cellSizeVarId,  nullptr, (double*) &o_cellSizeMeters));
   }
   
-  size_t l_size = sizeof(t_real) * o_nx * o_ny;
-  t_real* l_h  = new t_real[l_size];
-  t_real* l_b  = new t_real[l_size];
-  t_real* l_hu = new t_real[l_size];
-  t_real* l_hv = new t_real[l_size];
-  
-  // we cannot use check() in this section, because we would leak memory; therefore just collect the errors,
-  // and hope that it's the same error, and then print it
-  
-  // read all vector values
-  size_t l_startVec[2] = { 0, 0 };
-  size_t l_countVec[2] = { o_ny, o_nx };// fastest dimensions are last
-  check2(get_vara(l_handle, l_hVarId,  l_startVec, l_countVec, l_h));
-  check2(get_vara(l_handle, l_bVarId,  l_startVec, l_countVec, l_b));
-  check2(get_vara(l_handle, l_huVarId, l_startVec, l_countVec, l_hu));
-  if(o_ny > 1)
-    check2(get_vara( l_handle, l_hvVarId, l_startVec, l_countVec, l_hv));
-  
-  // todo query stations:
-  // todo query all variables starting with "station-", then read in their values
+  // query all variables starting with "station-", then read in their values
   // for better serialization, we could use netcdf compounds in the future
-  (void) o_stations;
   int l_numVariables;
-  check2(nc_inq(l_handle, nullptr, &l_numVariables, nullptr, nullptr));
+  check(nc_inq(l_handle, nullptr, &l_numVariables, nullptr, nullptr));
   size_t l_dimILength;
-  check2(nc_inq_dimlen(l_handle, l_iDimId, &l_dimILength));
+  check(nc_inq_dimlen(l_handle, l_iDimId, &l_dimILength));
   std::vector<t_real> l_stationData(l_dimILength);
   for(int l_var=0;l_var<l_numVariables;l_var++){
     char l_name[NC_MAX_NAME+1];
-    check2(nc_inq_var(l_handle, l_var, l_name, nullptr, nullptr, nullptr, nullptr));
+    check(nc_inq_var(l_handle, l_var, l_name, nullptr, nullptr, nullptr, nullptr));
     if(strncmp(l_name, "station-", strlen("station-")) == 0){// starts with "station-", so it's a station
       
       std::string l_stationName(l_name + strlen("station-"));// variable name without prefix
@@ -270,12 +364,13 @@ tsunami_lab::setups::Setup* tsunami_lab::io::NetCDF::loadCheckpoint( std::string
       // read in all station data
       size_t l_startVec0[1] = { 0 };
       size_t l_countVec0[1] = { l_dimILength };
-      check2(get_vara(l_handle, l_var, l_startVec0, l_countVec0, l_stationData.data()));
+      check(get_vara(l_handle, l_var, l_startVec0, l_countVec0, l_stationData.data()));
       
       t_real l_delayBetweenRecords = l_stationData[0];
       t_idx  l_x = (t_idx) l_stationData[1];
       t_idx  l_y = (t_idx) l_stationData[2];
       tsunami_lab::io::Station l_station(l_x, l_y, l_stationName, l_delayBetweenRecords);
+      l_station.setSubcellOffset(l_stationData[1] - l_x, l_stationData[2] - l_y);
       for(size_t i=3,l=l_dimILength-3;i<l;){
         t_real l_t  = l_stationData[i++];
         t_real l_h  = l_stationData[i++];
@@ -283,11 +378,58 @@ tsunami_lab::setups::Setup* tsunami_lab::io::NetCDF::loadCheckpoint( std::string
         t_real l_hv = l_stationData[i++];
         l_station.recordState(l_t, l_h, l_hu, l_hv);
       }
+      // checkpoints of streaming stations know, how much of the CSV file was written
+      long long int l_fileOffset;
+      double l_nextRecordTime;
+      if(nc_get_att_longlong(l_handle, l_var, "fileOffset",     &l_fileOffset)     == NC_NOERR &&
+         nc_get_att_double(  l_handle, l_var, "nextRecordTime", &l_nextRecordTime) == NC_NOERR){
+        l_station.setStreamState((t_idx) l_fileOffset, (t_real) l_nextRecordTime);
+      }
       o_stations.push_back(l_station);
       
     }
   }
   
+  check(nc_close(l_handle));
+  return 0;
+}
+
+tsunami_lab::setups::Setup* tsunami_lab::io::NetCDF::loadCheckpointSetup( std::string i_fileName ){
+  
+  int l_err, l_handle;
+  check2(nc_open(i_fileName.c_str(), NC_NOWRITE, &l_handle));
+  
+  size_t l_nx, l_ny;
+  int l_xDimId, l_yDimId;
+  check2(nc_inq_dimid(l_handle, "x", &l_xDimId));
+  check2(nc_inq_dimid(l_handle, "y", &l_yDimId));
+  check2(nc_inq_dimlen(l_handle, l_xDimId, &l_nx));
+  check2(nc_inq_dimlen(l_handle, l_yDimId, &l_ny));
+  
+  // query the variable ids, for which the values are vectors
+  int l_hVarId, l_bVarId, l_huVarId, l_hvVarId;
+  check2(nc_inq_varid(l_handle, "height",     &l_hVarId));
+  check2(nc_inq_varid(l_handle, "bathymetry", &l_bVarId));
+  check2(nc_inq_varid(l_handle, "momentumX",  &l_huVarId));
+  if(l_ny > 1) check2(nc_inq_varid(l_handle, "momentumY",  &l_hvVarId));
+  
+  size_t l_size = l_nx * l_ny;
+  t_real* l_h  = new t_real[l_size];
+  t_real* l_b  = new t_real[l_size];
+  t_real* l_hu = new t_real[l_size];
+  t_real* l_hv = new t_real[l_size];
+  
+  // we cannot use check() in this section, because we would leak memory; therefore just collect the errors,
+  // and hope that it's the same error, and then print it
+  
+  // read all vector values
+  size_t l_startVec[2] = { 0, 0 };
+  size_t l_countVec[2] = { l_ny, l_nx };// fastest dimensions are last
+  l_err = get_vara(l_handle, l_hVarId,  l_startVec, l_countVec, l_h);
+  if(!l_err) l_err = get_vara(l_handle, l_bVarId,  l_startVec, l_countVec, l_b);
+  if(!l_err) l_err = get_vara(l_handle, l_huVarId, l_startVec, l_countVec, l_hu);
+  if(!l_err && l_ny > 1) l_err = get_vara(l_handle, l_hvVarId, l_startVec, l_countVec, l_hv);
+  
   if(l_err){
     delete[] l_h;
     delete[] l_b;
@@ -298,19 +440,62 @@ tsunami_lab::setups::Setup* tsunami_lab::io::NetCDF::loadCheckpoint( std::string
   
   check2(nc_close(l_handle));
   
-  return new tsunami_lab::setups::CheckPoint(l_h, l_b, l_hu, l_hv, o_nx, o_ny, o_nx);
+  return new tsunami_lab::setups::CheckPoint(l_h, l_b, l_hu, l_hv, l_nx, l_ny, l_nx);
   
 }
 
-int tsunami_lab::io::NetCDF::storeCheckpoint( std::string i_fileName, t_idx i_nx, t_idx i_ny, t_real i_cellSizeMeters, t_real i_cflFactor, double i_simulationTime, t_idx i_timeStepIndex, std::vector<tsunami_lab::io::Station> &i_stations, tsunami_lab::patches::WavePropagation* i_waveProp ){
+int tsunami_lab::io::NetCDF::loadCheckpointFields( std::string                             i_fileName,
+                                                   tsunami_lab::patches::WavePropagation * io_waveProp ){
+  
+  t_real * l_arrays[4];
+  t_idx l_nValues = io_waveProp->getRawStorage(l_arrays);
+  if(l_nValues == 0){
+    std::cerr << "The patch has no arrays, which the checkpoint could be read into" << std::endl;
+    return -1;
+  }
+  
+  int l_err, l_handle;
+  check(nc_open(i_fileName.c_str(), NC_NOWRITE, &l_handle));
+  
+  // checkpoints include the ghost cells, and have no padding, just like the patches
+  size_t l_nx, l_ny;
+  int l_xDimId, l_yDimId;
+  check(nc_inq_dimid(l_handle, "x", &l_xDimId));
+  check(nc_inq_dimid(l_handle, "y", &l_yDimId));
+  check(nc_inq_dimlen(l_handle, l_xDimId, &l_nx));
+  check(nc_inq_dimlen(l_handle, l_yDimId, &l_ny));
+  if(l_nx != io_waveProp->getStride() || l_nx * l_ny != l_nValues){
+    std::cerr << "Checkpoint has " << l_nx << " x " << l_ny << " cells, the patch has " << l_nValues << " cells with stride " << io_waveProp->getStride() << std::endl;
+    nc_close(l_handle);
+    return -1;
+  }
+  
+  char const * l_names[4] = { "height", "momentumX", "momentumY", "bathymetry" };
+  size_t l_startVec[2] = { 0, 0 };
+  size_t l_countVec[2] = { l_ny, l_nx };// fastest dimensions are last
+  for(unsigned short l_qu = 0; l_qu < 4; l_qu++){
+    if(l_arrays[l_qu] == nullptr) continue;
+    int l_varId;
+    check(nc_inq_varid(l_handle, l_names[l_qu], &l_varId));
+    check(get_vara(l_handle, l_varId, l_startVec, l_countVec, l_arrays[l_qu]));
+  }
+  
+  check(nc_close(l_handle));
+  return 0;
+}
+
+tsunami_lab::setups::Setup* tsunami_lab::io::NetCDF::loadCheckpoint( std::string i_fileName, t_idx &o_nx, t_idx &o_ny, t_real &o_cellSizeMeters, t_real &o_cflFactor, double &o_simulationTime, t_idx &o_timeStepIndex, std::vector<tsunami_lab::io::Station> &o_stations ){
+  if(loadCheckpointInfo(i_fileName, o_nx, o_ny, o_cellSizeMeters, o_cflFactor, o_simulationTime, o_timeStepIndex, o_stations)) return nullptr;
+  return loadCheckpointSetup(i_fileName);
+}
+
+int tsunami_lab::io::NetCDF::storeCheckpoint( std::string i_fileName, t_idx i_nx, t_idx i_ny, t_real i_cellSizeMeters, t_real i_cflFactor, double i_simulationTime, t_idx i_timeStepIndex, std::vector<tsunami_lab::io::Station> &i_stations, tsunami_lab::patches::WavePropagation* i_waveProp, tsunami_lab::io::Aggregates const * i_aggregates ){
   
   #ifdef MEMORY_IS_SCARCE
   int l_deflateLevel = 0;
   #else
   int l_deflateLevel = 2;
   #endif
-  bool l_deflate = l_deflateLevel > 0;
-  bool l_shuffle = l_deflate;
   
   // for the ghost cells
   size_t offset;
@@ -350,17 +535,19 @@ int tsunami_lab::io::NetCDF::storeCheckpoint( std::string i_fileName, t_idx i_nx
   int l_hVarId, l_bVarId, l_huVarId, l_hvVarId = 0;
   
   check(nc_def_var(l_handle, "height",     l_type, 2, dims2, &l_hVarId));
-  check(nc_def_var_deflate(l_handle, l_hVarId,  l_shuffle, l_deflate, l_deflateLevel));
+  check(defineCompression(l_handle, l_hVarId,  2, i_nx, i_ny, l_deflateLevel));
   
   check(nc_def_var(l_handle, "bathymetry", l_type, 2, dims2, &l_bVarId));
-  check(nc_def_var_deflate(l_handle, l_bVarId,  l_shuffle, l_deflate, l_deflateLevel));
+  check(defineCompression(l_handle, l_bVarId,  2, i_nx, i_ny, l_deflateLevel));
   
   check(nc_def_var(l_handle, "momentumX",  l_type, 2, dims2, &l_huVarId));
-  check(nc_def_var_deflate(l_handle, l_huVarId, l_shuffle, l_deflate, l_deflateLevel));
+  check(defineCompression(l_handle, l_huVarId, 2, i_nx, i_ny, l_deflateLevel));
   
-  if(i_waveProp->getMomentumY()){
+  // getMomentumY() would decode a full copy for patches without dense storage
+  bool l_hasMomentumY = i_ny > 1;
+  if(l_hasMomentumY){
     check(nc_def_var(l_handle, "momentumY",  l_type, 2, dims2, &l_hvVarId));
-    check(nc_def_var_deflate(l_handle, l_hvVarId, l_shuffle, l_deflate, l_deflateLevel));
+    check(defineCompression(l_handle, l_hvVarId, 2, i_nx, i_ny, l_deflateLevel));
   }
   
   // für die 0d-Variablen hingegen bringt es nichts
@@ -377,19 +564,46 @@ int tsunami_lab::io::NetCDF::storeCheckpoint( std::string i_fileName, t_idx i_nx
     int l_stationVarId;
     std::string l_joinedName = "station-" + l_station.getName();// station prefix, in case there is a station called like a variable
     check(nc_def_var(l_handle, l_joinedName.c_str(), l_type, 1, &l_iDimId, &l_stationVarId));
+    // the written records are in the CSV file of the station; a restart continues it at this size
+    long long int l_fileOffset = l_station.getFileOffset();
+    double l_nextRecordTime = l_station.getNextRecordTime();
+    check(nc_put_att_longlong(l_handle, l_stationVarId, "fileOffset", NC_INT64, 1, &l_fileOffset));
+    check(nc_put_att_double(l_handle, l_stationVarId, "nextRecordTime", NC_DOUBLE, 1, &l_nextRecordTime));
     l_stationVarIds[l_i++] = l_stationVarId;
   }
   
+  // aggregates don't have ghost cells
+  int l_aggregateVarIds[Aggregates::m_nFields];
+  if(i_aggregates){
+    int l_aggregateDims[2];
+    check(nc_def_dim(l_handle, "aggregateY", i_aggregates->getNy(), &l_aggregateDims[0]));
+    check(nc_def_dim(l_handle, "aggregateX", i_aggregates->getNx(), &l_aggregateDims[1]));
+    for(unsigned short l_fi = 0; l_fi < Aggregates::m_nFields; l_fi++){
+      check(nc_def_var(l_handle, Aggregates::m_names[l_fi], l_type, 2, l_aggregateDims, &l_aggregateVarIds[l_fi]));
+      check(defineCompression(l_handle, l_aggregateVarIds[l_fi], 2, i_aggregates->getNx(), i_aggregates->getNy(), l_deflateLevel));
+    }
+  }
+  
   check(nc_enddef(l_handle));
   
   t_idx l_stride = i_waveProp->getStride();
   
   // 2d-Variablen
-  check(downsample(l_handle,   l_hVarId,  -1, i_nx, i_ny, l_stride, i_waveProp->getHeight()     - offset, i_nx, i_ny, nullptr, 1));
-  check(downsample(l_handle,   l_bVarId,  -1, i_nx, i_ny, l_stride, i_waveProp->getBathymetry() - offset, i_nx, i_ny, nullptr, 1));
-  check(downsample(l_handle,   l_huVarId, -1, i_nx, i_ny, l_stride, i_waveProp->getMomentumX()  - offset, i_nx, i_ny, nullptr, 1));
-  if(i_waveProp->getMomentumY()){
-    check(downsample(l_handle, l_hvVarId, -1, i_nx, i_ny, l_stride, i_waveProp->getMomentumY()  - offset, i_nx, i_ny, nullptr, 1));
+  if(i_waveProp->hasDenseStorage()){
+    check(downsample(l_handle,   l_hVarId,  -1, i_nx, i_ny, l_stride, i_waveProp->getHeight()     - offset, i_nx, i_ny, nullptr, 1));
+    check(downsample(l_handle,   l_bVarId,  -1, i_nx, i_ny, l_stride, i_waveProp->getBathymetry() - offset, i_nx, i_ny, nullptr, 1));
+    check(downsample(l_handle,   l_huVarId, -1, i_nx, i_ny, l_stride, i_waveProp->getMomentumX()  - offset, i_nx, i_ny, nullptr, 1));
+    if(l_hasMomentumY){
+      check(downsample(l_handle, l_hvVarId, -1, i_nx, i_ny, l_stride, i_waveProp->getMomentumY()  - offset, i_nx, i_ny, nullptr, 1));
+    }
+  } else {
+    // the ghost cells are part of the checkpoint
+    check(downsampleRows(l_handle,   l_hVarId,  -1, i_nx, i_ny, 0, i_waveProp, 0, i_nx, i_ny, 1));
+    check(downsampleRows(l_handle,   l_bVarId,  -1, i_nx, i_ny, 0, i_waveProp, 3, i_nx, i_ny, 1));
+    check(downsampleRows(l_handle,   l_huVarId, -1, i_nx, i_ny, 0, i_waveProp, 1, i_nx, i_ny, 1));
+    if(l_hasMomentumY){
+      check(downsampleRows(l_handle, l_hvVarId, -1, i_nx, i_ny, 0, i_waveProp, 2, i_nx, i_ny, 1));
+    }
   }
   
   // 0d-Variablen
@@ -400,6 +614,14 @@ int tsunami_lab::io::NetCDF::storeCheckpoint( std::string i_fileName, t_idx i_nx
   check(put_var1(l_handle, l_cellSizeVarId,  nullptr, &i_cellSizeMeters));
   check(put_var1(l_handle, l_cflFactorVarId, nullptr, &i_cflFactor));
   
+  if(i_aggregates){
+    size_t l_start[2] = { 0, 0 };
+    size_t l_count[2] = { i_aggregates->getNy(), i_aggregates->getNx() };
+    for(unsigned short l_fi = 0; l_fi < Aggregates::m_nFields; l_fi++){
+      check(put_vara(l_handle, l_aggregateVarIds[l_fi], l_start, l_count, i_aggregates->getField(l_fi)));
+    }
+  }
+  
   // write stations as heterogenous arrays
   // (could be done with multiple variables per station, but I'm lazy for this one)
   l_i = 0;
@@ -416,10 +638,13 @@ int tsunami_lab::io::NetCDF::storeCheckpoint( std::string i_fileName, t_idx i_nx
     
     putValue(l_station.getDelayBetweenRecords());
     
-    t_idx l_posX, l_posY;
+    // the position includes the offset inside of the cell
+    t_idx  l_posX, l_posY;
+    t_real l_offsetX, l_offsetY;
     l_station.getPosition(l_posX, l_posY);
-    putValue(l_posX);
-    putValue(l_posY);
+    l_station.getSubcellOffset(l_offsetX, l_offsetY);
+    putValue(l_posX + l_offsetX);
+    putValue(l_posY + l_offsetY);
     
     auto l_records = l_station.getRecords();
     for(auto &l_record : l_records){
@@ -444,7 +669,144 @@ int tsunami_lab::io::NetCDF::storeCheckpoint( std::string i_fileName, t_idx i_nx
   return 0;
 }
 
-// inspect a file: ncdump -h fileName, -h to only see the header, -c to see header + axis data
+int tsunami_lab::io::NetCDF::storeCheckpointAsync( std::string                             i_fileName,
+                                                   t_idx                                   i_nx,
+                                                   t_idx                                   i_ny,
+                                                   t_real                                  i_cellSizeMeters,
+                                                   t_real                                  i_cflFactor,
+                                                   double                                  i_simulationTime,
+                                                   t_idx                                   i_timeStepIndex,
+                                                   std::vector<tsunami_lab::io::Station> & i_stations,
+                                                   tsunami_lab::patches::WavePropagation * i_waveProp,
+                                                   tsunami_lab::io::Aggregates     const * i_aggregates,
+                                                   pid_t                                 & io_childId ){
+  return forkCheckpoint([&](){
+    return storeCheckpoint(i_fileName, i_nx, i_ny, i_cellSizeMeters, i_cflFactor, i_simulationTime, i_timeStepIndex, i_stations, i_waveProp, i_aggregates);
+  }, io_childId);
+}
+
+int tsunami_lab::io::NetCDF::forkCheckpoint( std::function<int()> const & i_store,
+                                             pid_t                      & io_childId ){
+  
+  // both would write the same tmp file
+  if(waitForCheckpoint(io_childId)) std::cerr << "The previous checkpoint failed" << std::endl;
+  
+  // the child would print the buffered output a second time
+  std::cout.flush();
+  std::cerr.flush();
+  
+  pid_t l_childId = fork();
+  if(l_childId < 0){
+    std::cerr << "Fork failed, writing the checkpoint synchronously" << std::endl;
+    return i_store();
+  }
+  
+  if(l_childId == 0){
+    // the OpenMP threads of the parent don't exist in the child; a team of one doesn't need them
+    omp_set_num_threads(1);
+    int l_err = i_store();
+    // _exit() skips the destructors and atexit handlers, which would close the output files of the parent
+    _exit(l_err ? 1 : 0);
+  }
+  
+  io_childId = l_childId;
+  return 0;
+}
+
+int tsunami_lab::io::NetCDF::waitForCheckpoint( pid_t & io_childId ){
+  if(io_childId <= 0) return 0;
+  int l_status = 0;
+  pid_t l_result = waitpid(io_childId, &l_status, 0);
+  io_childId = 0;
+  if(l_result < 0 || !WIFEXITED(l_status) || WEXITSTATUS(l_status) != 0) return -1;
+  return 0;
+}
+
+int tsunami_lab::io::NetCDF::loadAggregates( std::string                   i_fileName,
+                                             tsunami_lab::io::Aggregates & io_aggregates ){
+  
+  int l_err, l_handle;
+  check(nc_open(i_fileName.c_str(), NC_NOWRITE, &l_handle));
+  
+  int l_yDimId, l_xDimId;
+  if(nc_inq_dimid(l_handle, "aggregateY", &l_yDimId) != NC_NOERR ||
+     nc_inq_dimid(l_handle, "aggregateX", &l_xDimId) != NC_NOERR){
+    std::cout << "  checkpoint has no aggregates, starting new ones" << std::endl;
+    check(nc_close(l_handle));
+    return EXIT_SUCCESS;
+  }
+  
+  size_t l_ny, l_nx;
+  check(nc_inq_dimlen(l_handle, l_yDimId, &l_ny));
+  check(nc_inq_dimlen(l_handle, l_xDimId, &l_nx));
+  if(l_nx != io_aggregates.getNx() || l_ny != io_aggregates.getNy()){
+    std::cerr << "aggregates of " << i_fileName << " have " << l_nx << " x " << l_ny << " cells, expected " << io_aggregates.getNx() << " x " << io_aggregates.getNy() << std::endl;
+    check(nc_close(l_handle));
+    return -1;
+  }
+  
+  size_t l_start[2] = { 0, 0 };
+  size_t l_count[2] = { l_ny, l_nx };
+  for(unsigned short l_fi = 0; l_fi < Aggregates::m_nFields; l_fi++){
+    int l_varId;
+    check(nc_inq_varid(l_handle, Aggregates::m_names[l_fi], &l_varId));
+    check(get_vara(l_handle, l_varId, l_start, l_count, io_aggregates.getField(l_fi)));
+  }
+  
+  check(nc_close(l_handle));
+  return EXIT_SUCCESS;
+}
+
+int tsunami_lab::io::NetCDF::storeAggregates( std::string                         i_fileName,
+                                              t_real                              i_cellSizeMeters,
+                                              t_real                              i_gridOffsetX,
+                                              t_real                              i_gridOffsetY,
+                                              int                                 i_deflateLevel,
+                                              tsunami_lab::io::Aggregates const & i_aggregates ){
+  
+  int l_err, l_handle;
+  t_idx l_nx = i_aggregates.getNx(), l_ny = i_aggregates.getNy();
+  check(nc_create(i_fileName.c_str(), NC_CLOBBER | NC_NETCDF4, &l_handle));
+  check(nc_put_att_text(l_handle, NC_GLOBAL, "Conventions", 6, "COARDS"));
+  
+  int l_xDimId, l_yDimId, l_xVarId, l_yVarId;
+  check(nc_def_dim(l_handle, "x", l_nx, &l_xDimId));
+  check(nc_def_dim(l_handle, "y", l_ny, &l_yDimId));
+  check(nc_def_var(l_handle, "x", NC_FLOAT, 1, &l_xDimId, &l_xVarId));
+  check(nc_def_var(l_handle, "y", NC_FLOAT, 1, &l_yDimId, &l_yVarId));
+  check(nc_put_att_text(l_handle, l_xVarId, "units", 1, "m"));
+  check(nc_put_att_text(l_handle, l_yVarId, "units", 1, "m"));
+  
+  // the maxima are written in full precision, because the hazard maps are derived from them
+  char const * l_units[Aggregates::m_nFields] = { "m", "m*m/s", "s" };
+  int l_dims2[2] = { l_yDimId, l_xDimId };// fastest dimensions are last
+  int l_varIds[Aggregates::m_nFields];
+  for(unsigned short l_fi = 0; l_fi < Aggregates::m_nFields; l_fi++){
+    check(nc_def_var(l_handle, Aggregates::m_names[l_fi], NC_FLOAT, 2, l_dims2, &l_varIds[l_fi]));
+    check(nc_put_att_text(l_handle, l_varIds[l_fi], "units", strlen(l_units[l_fi]), l_units[l_fi]));
+    check(defineCompression(l_handle, l_varIds[l_fi], 2, l_nx, l_ny, i_deflateLevel));
+  }
+  float l_notArrived = -1;
+  check(nc_put_att_float(l_handle, l_varIds[2], "_FillValue", NC_FLOAT, 1, &l_notArrived));
+  check(nc_enddef(l_handle));
+  
+  // like appendTimeframe(), the coordinates are the ones of the input files
+  std::vector<float> l_data(std::max(l_nx, l_ny));
+  for(t_idx l_ix = 0; l_ix < l_nx; l_ix++) l_data[l_ix] = l_ix * i_cellSizeMeters + i_gridOffsetX;
+  check(nc_put_var_float(l_handle, l_xVarId, l_data.data()));
+  for(t_idx l_iy = 0; l_iy < l_ny; l_iy++) l_data[l_iy] = l_iy * i_cellSizeMeters + i_gridOffsetY;
+  check(nc_put_var_float(l_handle, l_yVarId, l_data.data()));
+  
+  size_t l_start[2] = { 0, 0 };
+  size_t l_count[2] = { l_ny, l_nx };
+  for(unsigned short l_fi = 0; l_fi < Aggregates::m_nFields; l_fi++){
+    check(put_vara(l_handle, l_varIds[l_fi], l_start, l_count, i_aggregates.getField(l_fi)));
+  }
+  
+  check(nc_close(l_handle));
+  return EXIT_SUCCESS;
+}
+
 int tsunami_lab::io::NetCDF::appendTimeframe( t_real                       i_cellSizeMeters,
                                               t_idx                        i_nx,
                                               t_idx                        i_ny,
@@ -460,14 +822,56 @@ int tsunami_lab::io::NetCDF::appendTimeframe( t_real                       i_cel
                                               t_real                       i_time,
                                               int                          i_deflateLevel,
                                               std::string                  i_fileName ) {
+  return appendTimeframe( i_cellSizeMeters, i_nx, i_ny, i_gridOffsetX, i_gridOffsetY, i_step, i_stride, i_h, i_hu, i_hv, i_b, nullptr, i_setup, i_time, i_deflateLevel, i_fileName );
+}
+
+int tsunami_lab::io::NetCDF::appendTimeframe( t_real                                 i_cellSizeMeters,
+                                              t_idx                                  i_nx,
+                                              t_idx                                  i_ny,
+                                              t_real                                 i_gridOffsetX,
+                                              t_real                                 i_gridOffsetY,
+                                              t_idx                                  i_step,
+                                              tsunami_lab::patches::WavePropagation* i_waveProp,
+                                              tsunami_lab::setups::Setup           * i_setup,
+                                              t_real                                 i_time,
+                                              int                                    i_deflateLevel,
+                                              std::string                            i_fileName ) {
+  if(i_waveProp->hasDenseStorage()){
+    return appendTimeframe( i_cellSizeMeters, i_nx, i_ny, i_gridOffsetX, i_gridOffsetY, i_step, i_waveProp->getStride(),
+                            i_waveProp->getHeight(), i_waveProp->getMomentumX(), i_waveProp->getMomentumY(), i_waveProp->getBathymetry(),
+                            nullptr, i_setup, i_time, i_deflateLevel, i_fileName );
+  } else {
+    return appendTimeframe( i_cellSizeMeters, i_nx, i_ny, i_gridOffsetX, i_gridOffsetY, i_step, i_waveProp->getStride(),
+                            nullptr, nullptr, nullptr, nullptr,
+                            i_waveProp, i_setup, i_time, i_deflateLevel, i_fileName );
+  }
+}
+
+// inspect a file: ncdump -h fileName, -h to only see the header, -c to see header + axis data
+int tsunami_lab::io::NetCDF::appendTimeframe( t_real                                 i_cellSizeMeters,
+                                              t_idx                                  i_nx,
+                                              t_idx                                  i_ny,
+                                              t_real                                 i_gridOffsetX,
+                                              t_real                                 i_gridOffsetY,
+                                              t_idx                                  i_step,
+                                              t_idx                                  i_stride,
+                                              t_real                         const * i_h,
+                                              t_real                         const * i_hu,
+                                              t_real                         const * i_hv,
+                                              t_real                         const * i_b,
+                                              tsunami_lab::patches::WavePropagation* i_rowSource,
+                                              tsunami_lab::setups::Setup           * i_setup,
+                                              t_real                                 i_time,
+                                              int                                    i_deflateLevel,
+                                              std::string                            i_fileName ) {
 
   int l_err;
   
-  bool l_deflate = i_deflateLevel > 0;
-  
-  // reorders high and low bytes such that first all high bytes are written, then the low bytes.
-  // is said to be useless for deflate level = 9. In my test, testing config/tsunami2d-tohoku.yaml, this was incorrect
-  bool l_shuffle = l_deflate;
+  // which quantities are written; a row source has all of them, momentumY in 2d only
+  bool l_hasH  = i_h  || i_rowSource;
+  bool l_hasHu = i_hu || i_rowSource;
+  bool l_hasHv = i_hv || (i_rowSource && i_ny > 1);
+  bool l_hasB  = i_b  || i_rowSource;
   
   bool l_isFirstFrame = i_time <= 0;
   
@@ -512,9 +916,9 @@ int tsunami_lab::io::NetCDF::appendTimeframe( t_real                       i_cel
     check(nc_def_var(l_handle, "y",    NC_FLOAT, 1, &l_yDimId, &l_yVarId));
     check(nc_def_var(l_handle, "time", NC_FLOAT, 1, &l_tDimId, &l_tVarId));
     
-    check(nc_def_var_deflate(l_handle, l_xVarId, l_shuffle, l_deflate, i_deflateLevel));
-    check(nc_def_var_deflate(l_handle, l_yVarId, l_shuffle, l_deflate, i_deflateLevel));
-    check(nc_def_var_deflate(l_handle, l_tVarId, l_shuffle, l_deflate, i_deflateLevel));
+    check(defineCompression(l_handle, l_xVarId, 1, l_nx, l_ny, i_deflateLevel));
+    check(defineCompression(l_handle, l_yVarId, 1, l_nx, l_ny, i_deflateLevel));
+    check(defineCompression(l_handle, l_tVarId, 1, l_nx, l_ny, i_deflateLevel));
     
     check(nc_put_att_text(l_handle, l_xVarId, "units", 1, "m"));// strlen(DEGREES_NORTH), DEGREES_NORTH
     check(nc_put_att_text(l_handle, l_yVarId, "units", 1, "m"));
@@ -524,30 +928,33 @@ int tsunami_lab::io::NetCDF::appendTimeframe( t_real                       i_cel
     int dims3[3] = { l_tDimId, l_yDimId, l_xDimId };// fastest dimensions are last
     int dims2[2] = { l_yDimId, l_xDimId };// fastest dimensions are last
     
-    if(i_h){
+    if(l_hasH){
       check(nc_def_var(l_handle, "height",     NC_FLOAT, 3, dims3, &l_heightId));
       check(nc_put_att_text(l_handle, l_heightId, "units", 1, "m"));
-      check(nc_def_var_deflate(l_handle, l_heightId, l_shuffle, l_deflate, i_deflateLevel));
+      check(defineCompression(l_handle, l_heightId, 3, l_nx, l_ny, i_deflateLevel));
+      check(defineQuantization(l_handle, l_heightId, 0));
     }
-    if(i_hu){
+    if(l_hasHu){
       check(nc_def_var(l_handle, "momentumX",  NC_FLOAT, 3, dims3, &l_momentumXId));
       check(nc_put_att_text(l_handle, l_momentumXId, "units", 5, "m*m/s"));// height * velocity
-      check(nc_def_var_deflate(l_handle, l_momentumXId, l_shuffle, l_deflate, i_deflateLevel));
+      check(defineCompression(l_handle, l_momentumXId, 3, l_nx, l_ny, i_deflateLevel));
+      check(defineQuantization(l_handle, l_momentumXId, 1));
     }
-    if(i_hv){
+    if(l_hasHv){
       check(nc_def_var(l_handle, "momentumY",  NC_FLOAT, 3, dims3, &l_momentumYId));
       check(nc_put_att_text(l_handle, l_momentumYId, "units", 5, "m*m/s"));
-      check(nc_def_var_deflate(l_handle, l_momentumYId, l_shuffle, l_deflate, i_deflateLevel));
+      check(defineCompression(l_handle, l_momentumYId, 3, l_nx, l_ny, i_deflateLevel));
+      check(defineQuantization(l_handle, l_momentumYId, 2));
     }
-    if(i_b){
+    if(l_hasB){
       check(nc_def_var(l_handle, "bathymetry", NC_FLOAT, 2, dims2, &l_bathymetryId));
       check(nc_put_att_text(l_handle, l_bathymetryId, "units", 1, "m"));
-      check(nc_def_var_deflate(l_handle, l_bathymetryId, l_shuffle, l_deflate, i_deflateLevel));
+      check(defineCompression(l_handle, l_bathymetryId, 2, l_nx, l_ny, i_deflateLevel));
     }
     if(i_setup){
       check(nc_def_var(l_handle, "displacement", NC_FLOAT, 2, dims2, &l_displacementId));
       check(nc_put_att_text(l_handle, l_displacementId, "units", 1, "m"));
-      check(nc_def_var_deflate(l_handle, l_displacementId, l_shuffle, l_deflate, i_deflateLevel));
+      check(defineCompression(l_handle, l_displacementId, 2, l_nx, l_ny, i_deflateLevel));
     }
     
     // end definition mode
@@ -583,9 +990,9 @@ int tsunami_lab::io::NetCDF::appendTimeframe( t_real                       i_cel
       return EXIT_SUCCESS;
     }
     
-    if(i_h ) check(nc_inq_varid(l_handle, "height",     &l_heightId));
-    if(i_hu) check(nc_inq_varid(l_handle, "momentumX",  &l_momentumXId));
-    if(i_hv) check(nc_inq_varid(l_handle, "momentumY",  &l_momentumYId));
+    if(l_hasH ) check(nc_inq_varid(l_handle, "height",     &l_heightId));
+    if(l_hasHu) check(nc_inq_varid(l_handle, "momentumX",  &l_momentumXId));
+    if(l_hasHv) check(nc_inq_varid(l_handle, "momentumY",  &l_momentumYId));
     
   }
   
@@ -593,12 +1000,21 @@ int tsunami_lab::io::NetCDF::appendTimeframe( t_real                       i_cel
   float l_floatTime = (float) i_time;// time may be a double
   check(nc_put_var1_float(l_handle, l_tVarId, &l_timeStepIndex, &l_floatTime));
   
-  if(i_h){  check(downsample(l_handle, l_heightId,    i_timeStepIndex, i_nx, i_ny, i_stride, i_h,  l_nx, l_ny, l_dataWithoutStride.data(), i_step)); }
-  if(i_hu){ check(downsample(l_handle, l_momentumXId, i_timeStepIndex, i_nx, i_ny, i_stride, i_hu, l_nx, l_ny, l_dataWithoutStride.data(), i_step)); }
-  if(i_hv){ check(downsample(l_handle, l_momentumYId, i_timeStepIndex, i_nx, i_ny, i_stride, i_hv, l_nx, l_ny, l_dataWithoutStride.data(), i_step)); }
+  if(i_rowSource){
+    // skip the ghost cells in 2d
+    t_idx l_offset = i_ny > 1 ? 1 : 0;
+    if(l_hasH){  check(downsampleRows(l_handle, l_heightId,    i_timeStepIndex, i_nx, i_ny, l_offset, i_rowSource, 0, l_nx, l_ny, i_step)); }
+    if(l_hasHu){ check(downsampleRows(l_handle, l_momentumXId, i_timeStepIndex, i_nx, i_ny, l_offset, i_rowSource, 1, l_nx, l_ny, i_step)); }
+    if(l_hasHv){ check(downsampleRows(l_handle, l_momentumYId, i_timeStepIndex, i_nx, i_ny, l_offset, i_rowSource, 2, l_nx, l_ny, i_step)); }
+    if(l_isFirstFrame && l_hasB){ check(downsampleRows(l_handle, l_bathymetryId, -1, i_nx, i_ny, l_offset, i_rowSource, 3, l_nx, l_ny, i_step)); }
+  } else {
+    if(i_h){  check(downsample(l_handle, l_heightId,    i_timeStepIndex, i_nx, i_ny, i_stride, i_h,  l_nx, l_ny, l_dataWithoutStride.data(), i_step)); }
+    if(i_hu){ check(downsample(l_handle, l_momentumXId, i_timeStepIndex, i_nx, i_ny, i_stride, i_hu, l_nx, l_ny, l_dataWithoutStride.data(), i_step)); }
+    if(i_hv){ check(downsample(l_handle, l_momentumYId, i_timeStepIndex, i_nx, i_ny, i_stride, i_hv, l_nx, l_ny, l_dataWithoutStride.data(), i_step)); }
+    if(l_isFirstFrame && i_b){ check(downsample(l_handle, l_bathymetryId, -1, i_nx, i_ny, i_stride, i_b, l_nx, l_ny, l_dataWithoutStride.data(), i_step)); }
+  }
   
   if(l_isFirstFrame){
-    if(i_b){ check(downsample(l_handle, l_bathymetryId, -1, i_nx, i_ny, i_stride, i_b, l_nx, l_ny, l_dataWithoutStride.data(), i_step)); }
     if(i_setup){
       // this is sub-ideal, and would ideally require downsampling
       // however, for that we'd need to allocate a new, large buffer
@@ -641,6 +1057,62 @@ int tsunami_lab::io::NetCDF::appendTimeframe( t_real                       i_cel
   
 }
 
+int tsunami_lab::io::NetCDF::load2dRows( int              i_handle,
+                                         int              i_varId,
+                                         Region   const & i_region,
+                                         size_t           i_beginX,
+                                         size_t           i_beginY,
+                                         t_idx            i_sizeX,
+                                         t_idx            i_rowBegin,
+                                         t_idx            i_rowEnd,
+                                         t_real         * o_data ) {
+  
+  t_idx l_stride = std::max<t_idx>(i_region.stride, 1);
+  t_idx l_nRows = i_rowEnd - i_rowBegin;
+  
+  // fastest dimensions are last
+  if(l_stride == 1){
+    size_t l_startVec[2] = { i_beginY + i_rowBegin, i_beginX };
+    size_t l_countVec[2] = { l_nRows, i_sizeX };
+    return get_vara(i_handle, i_varId, l_startVec, l_countVec, o_data);
+  }
+  if(!i_region.average){
+    size_t    l_startVec[2]  = { i_beginY + i_rowBegin * l_stride, i_beginX };
+    size_t    l_countVec[2]  = { l_nRows, i_sizeX };
+    ptrdiff_t l_strideVec[2] = { (ptrdiff_t) l_stride, (ptrdiff_t) l_stride };
+    return get_vars(i_handle, i_varId, l_startVec, l_countVec, l_strideVec, o_data);
+  }
+  
+  // bands of rows of up to 4M values, so the memory scales with the coarsened region
+  t_idx l_rowSize = i_sizeX * l_stride;
+  t_idx l_rowsPerBand = std::min(std::max<t_idx>((t_idx(1) << 22) / (l_rowSize * l_stride), 1), l_nRows);
+  std::vector<t_real> l_band(l_rowsPerBand * l_stride * l_rowSize);
+  for(t_idx l_by = 0; l_by < l_nRows; l_by += l_rowsPerBand){
+    t_idx l_nBandRows = std::min(l_rowsPerBand, l_nRows - l_by);
+    size_t l_startVec[2] = { i_beginY + (i_rowBegin + l_by) * l_stride, i_beginX };
+    size_t l_countVec[2] = { l_nBandRows * l_stride, l_rowSize };
+    int l_err = get_vara(i_handle, i_varId, l_startVec, l_countVec, l_band.data());
+    if(l_err != NC_NOERR) return l_err;
+    #pragma omp parallel for collapse(2)
+    for(t_idx l_iy = 0; l_iy < l_nBandRows; l_iy++){
+      for(t_idx l_ix = 0; l_ix < i_sizeX; l_ix++){
+        t_real l_sum = 0;
+        t_idx  l_nValid = 0;
+        for(t_idx l_dy = 0; l_dy < l_stride; l_dy++){
+          t_real const * l_row = l_band.data() + (l_iy * l_stride + l_dy) * l_rowSize + l_ix * l_stride;
+          for(t_idx l_dx = 0; l_dx < l_stride; l_dx++){
+            if(std::isnan(l_row[l_dx])) continue;
+            l_sum += l_row[l_dx];
+            l_nValid++;
+          }
+        }
+        o_data[(l_by + l_iy) * i_sizeX + l_ix] = l_nValid > 0 ? l_sum / l_nValid : NAN;
+      }
+    }
+  }
+  return NC_NOERR;
+}
+
 int tsunami_lab::io::NetCDF::load2dArray( std::string           i_fileName,
                                           std::string           i_variableName,
                                           t_idx               & o_sizeX,
@@ -648,7 +1120,8 @@ int tsunami_lab::io::NetCDF::load2dArray( std::string           i_fileName,
                                           t_real              & o_cellSizeMeters,
                                           t_real              & o_gridOffsetX,
                                           t_real              & o_gridOffsetY,
-                                          std::vector<t_real> & o_data ) {
+                                          std::vector<t_real> & o_data,
+                                          Region        const & i_region ) {
   
   int l_err;
   
@@ -669,45 +1142,173 @@ int tsunami_lab::io::NetCDF::load2dArray( std::string           i_fileName,
   
   // query dimension sizes
   char l_tmpDimName[NC_MAX_NAME+1];// name, ignored
-  check(nc_inq_dim(l_handle, l_xDimId, l_tmpDimName, &o_sizeX));
-  check(nc_inq_dim(l_handle, l_yDimId, l_tmpDimName, &o_sizeY));
+  size_t l_fileSizeX, l_fileSizeY;
+  check(nc_inq_dim(l_handle, l_xDimId, l_tmpDimName, &l_fileSizeX));
+  check(nc_inq_dim(l_handle, l_yDimId, l_tmpDimName, &l_fileSizeY));
   
-  // allocate space for data
-  o_data.resize(o_sizeX * o_sizeY);
+  // the axes are small even for global grids, and they are needed to find a region in meters
+  std::vector<t_real> l_xs(l_fileSizeX), l_ys(l_fileSizeY);
+  size_t l_startVec0[1] = { 0 };
+  size_t l_countVec0[1] = { l_fileSizeX };
+  check(get_vara(l_handle, l_xVarId, l_startVec0, l_countVec0, l_xs.data()));
+  l_countVec0[0] = l_fileSizeY;
+  check(get_vara(l_handle, l_yVarId, l_startVec0, l_countVec0, l_ys.data()));
+  
+  // cells of the file, which are covered by the region
+  auto l_range = [&](std::vector<t_real> const & i_axis, double i_min, double i_max, size_t & o_begin, size_t & o_end){
+    size_t l_size = i_axis.size();
+    if(i_region.inMeters){
+      o_begin = std::lower_bound(i_axis.begin(), i_axis.end(), i_min) - i_axis.begin();
+      o_end   = i_max > i_min ? std::lower_bound(i_axis.begin(), i_axis.end(), i_max) - i_axis.begin() : l_size;
+    } else {
+      o_begin = std::min<size_t>(std::max(i_min, 0.0), l_size);
+      o_end   = i_max > i_min ? std::min<size_t>(i_max, l_size) : l_size;
+    }
+  };
+  size_t l_beginX, l_endX, l_beginY, l_endY;
+  l_range(l_xs, i_region.x0, i_region.x1, l_beginX, l_endX);
+  l_range(l_ys, i_region.y0, i_region.y1, l_beginY, l_endY);
+  
+  t_idx l_stride = std::max<t_idx>(i_region.stride, 1);
+  o_sizeX = l_endX > l_beginX ? (l_endX - l_beginX) / l_stride : 0;
+  o_sizeY = l_endY > l_beginY ? (l_endY - l_beginY) / l_stride : 0;
+  if(o_sizeX == 0 || o_sizeY == 0){
+    std::cerr << "region [" << i_region.x0 << ", " << i_region.x1 << ") x [" << i_region.y0 << ", " << i_region.y1 << ") of " << i_fileName
+              << " with stride " << l_stride << " contains no cells" << std::endl;
+    nc_close(l_handle);
+    return -1;
+  }
   
   // compute the cell size by using the values in the x variable
   // non-square cells are not supported currently
-  size_t l_startVec0[1] = { 0 };
-  size_t l_countVec0[1] = { o_sizeX };
-  check(nc_get_vara_float(l_handle, l_xVarId, l_startVec0, l_countVec0, (float*) o_data.data()));
-  
-  o_cellSizeMeters = (o_data[o_sizeX-1] - o_data[0]) / (o_sizeX - 1);
-  o_gridOffsetX = o_data[1];// the first one is used as ghost zone
-  
-  l_countVec0[0] = 2;
-  check(nc_get_vara_float(l_handle, l_yVarId, l_startVec0, l_countVec0, (float*) o_data.data()));
-  o_gridOffsetY = o_data[1];// the first one is used as ghost zone
-  
-  // read in the main variable
-  size_t l_startVec[2] = { 0, 0 };
-  size_t l_countVec[2] = { o_sizeY, o_sizeX };// fastest dimensions are last
-  if(sizeof(t_real) == 4){// this check may be doable in the precompiler somehow as well
-    check(nc_get_vara_float( l_handle, l_zVarId, l_startVec, l_countVec, (float*)  o_data.data()));
+  o_cellSizeMeters = (l_xs[l_fileSizeX-1] - l_xs[0]) / (l_fileSizeX - 1) * l_stride;
+  
+  // the first one is used as ghost zone; an averaged cell is at the center of its cells
+  t_idx l_window = i_region.average ? l_stride : 1;
+  auto l_center = [&](std::vector<t_real> const & i_axis, size_t i_begin, t_idx i_index) -> t_real {
+    double l_sum = 0;
+    for(t_idx l_wi = 0; l_wi < l_window; l_wi++) l_sum += i_axis[i_begin + i_index * l_stride + l_wi];
+    return l_sum / l_window;
+  };
+  o_gridOffsetX = l_center(l_xs, l_beginX, o_sizeX > 1 ? 1 : 0);
+  o_gridOffsetY = l_center(l_ys, l_beginY, o_sizeY > 1 ? 1 : 0);
+  
+  // chunks are decompressed as a whole, so each process reads whole chunks
+  int l_storage = NC_CONTIGUOUS;
+  size_t l_chunkSizes[2] = { 1, 1 };
+  check(nc_inq_var_chunking(l_handle, l_zVarId, &l_storage, l_chunkSizes));
+  t_idx l_unitRows = l_storage == NC_CHUNKED ? CEIL_DIV(l_chunkSizes[0], l_stride) : 1;
+  t_idx l_nUnits = CEIL_DIV(o_sizeY, l_unitRows);
+  // values of the file in the region; a process is worth it for 4M of them
+  t_idx l_nValuesIn = o_sizeX * l_stride * o_sizeY * l_stride;
+  t_idx l_nProcesses = std::min<t_idx>(std::min<t_idx>(omp_get_max_threads(), l_nUnits), std::max<t_idx>(l_nValuesIn >> 22, 1));
+  t_idx l_nValues = o_sizeX * o_sizeY;
+  
+  auto l_time0 = std::chrono::high_resolution_clock::now();
+  size_t l_bytes = l_nValues * sizeof(t_real);
+  void * l_map = MAP_FAILED;
+  if(l_nProcesses > 1){
+    l_map = mmap(nullptr, l_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if(l_map == MAP_FAILED){
+      std::cerr << "could not map " << l_bytes << " bytes for reading " << i_fileName << " in " << l_nProcesses << " processes, reading it serially" << std::endl;
+      l_nProcesses = 1;
+    }
+  }
+  if(l_nProcesses <= 1){
+    o_data.resize(l_nValues);
+    check(load2dRows(l_handle, l_zVarId, i_region, l_beginX, l_beginY, o_sizeX, 0, o_sizeY, o_data.data()));
+    check(nc_close(l_handle));
   } else {
-    check(nc_get_vara_double(l_handle, l_zVarId, l_startVec, l_countVec, (double*) o_data.data()));
+    // each child opens the file itself, so they don't share the state of the library, and writes its band into shared memory
+    l_err = nc_close(l_handle);
+    if(l_err != NC_NOERR) munmap(l_map, l_bytes);
+    check(l_err);
+    t_real * l_shared = static_cast<t_real*>(l_map);
+    // first row of the band of a process
+    auto l_bandRow = [&](t_idx i_process){ return std::min(o_sizeY, l_nUnits * i_process / l_nProcesses * l_unitRows); };
+    
+    // the children would print the buffered output a second time
+    std::cout.flush();
+    std::cerr.flush();
+    
+    // processes, which couldn't be started, keep the id 0
+    std::vector<pid_t> l_children(l_nProcesses, 0);
+    for(t_idx l_pr = 0; l_pr < l_nProcesses; l_pr++){
+      t_idx l_rowBegin = l_bandRow(l_pr), l_rowEnd = l_bandRow(l_pr + 1);
+      pid_t l_childId = fork();
+      if(l_childId < 0) break;
+      if(l_childId == 0){
+        // the OpenMP threads of the parent don't exist in the child
+        omp_set_num_threads(1);
+        int l_childHandle;
+        int l_childErr = nc_open(i_fileName.c_str(), NC_NOWRITE, &l_childHandle);
+        if(l_childErr == NC_NOERR){
+          l_childErr = load2dRows(l_childHandle, l_zVarId, i_region, l_beginX, l_beginY, o_sizeX, l_rowBegin, l_rowEnd, l_shared + l_rowBegin * o_sizeX);
+          nc_close(l_childHandle);
+        }
+        if(l_childErr != NC_NOERR){
+          std::cerr << "NetCDF-Error occurred: " << nc_strerror(l_childErr) << " (Code " << l_childErr << "), rows " << l_rowBegin << " to " << l_rowEnd << " of " << i_fileName << std::endl;
+        }
+        // _exit() skips the destructors and atexit handlers of the parent's objects
+        _exit(l_childErr == NC_NOERR ? 0 : 1);
+      }
+      l_children[l_pr] = l_childId;
+    }
+    
+    // like forkCheckpoint(), the parent does the work itself, if a fork fails; also the bands of failed children are read again
+    std::vector<t_idx> l_missing;
+    for(t_idx l_pr = 0; l_pr < l_nProcesses; l_pr++){
+      int l_status = 0;
+      if(l_children[l_pr] <= 0 || waitpid(l_children[l_pr], &l_status, 0) < 0 || !WIFEXITED(l_status) || WEXITSTATUS(l_status) != 0){
+        l_missing.push_back(l_pr);
+      }
+    }
+    if(!l_missing.empty()){
+      std::cerr << l_missing.size() << " of " << l_nProcesses << " processes for reading " << i_fileName << " couldn't be started or failed, reading their rows serially" << std::endl;
+      l_err = nc_open(i_fileName.c_str(), NC_NOWRITE, &l_handle);
+      if(l_err == NC_NOERR){
+        for(size_t l_mi = 0; l_mi < l_missing.size() && l_err == NC_NOERR; l_mi++){
+          t_idx l_pr = l_missing[l_mi];
+          l_err = load2dRows(l_handle, l_zVarId, i_region, l_beginX, l_beginY, o_sizeX, l_bandRow(l_pr), l_bandRow(l_pr + 1), l_shared + l_bandRow(l_pr) * o_sizeX);
+        }
+        nc_close(l_handle);
+      }
+      if(l_err != NC_NOERR){
+        std::cerr << "NetCDF-Error occurred: " << nc_strerror(l_err) << " (Code " << l_err << "), reading " << i_fileName << " failed" << std::endl;
+        munmap(l_map, l_bytes);
+        return -1;
+      }
+    }
+    
+    // pieces of 64 MiB, a multiple of the page size, are released, once they are copied, so the data isn't in memory twice
+    o_data.clear();
+    o_data.shrink_to_fit();
+    o_data.reserve(l_nValues);
+    size_t l_pieceValues = (size_t(1) << 26) / sizeof(t_real);
+    for(size_t l_va = 0; l_va < l_nValues; l_va += l_pieceValues){
+      size_t l_n = std::min(l_pieceValues, l_nValues - l_va);
+      o_data.insert(o_data.end(), l_shared + l_va, l_shared + l_va + l_n);
+      munmap(l_shared + l_va, l_n * sizeof(t_real));
+    }
   }
-  
-  // check for NaNs, just so we know what's up
-  for(t_idx i=0,l=o_sizeX*o_sizeY;i<l;i++){
-    if(std::isnan(o_data[i])){
-      t_idx j=i+1;
-      for(;j<l && std::isnan(o_data[j]);j++){}
-      std::cerr << "data contains NaN from " << i << " to " << j << " from 0 .. " << l << " in field of size " << o_sizeX << " x " << o_sizeY << std::endl;
-      i = j-1;
+  double l_seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - l_time0).count();
+  double l_megabytes = l_nValuesIn * sizeof(t_real) * 1e-6;
+  std::cout << "  read " << l_megabytes << " MB of " << i_variableName << " from " << i_fileName << " in " << l_seconds << "s ("
+            << l_megabytes / l_seconds << " MB/s, " << l_nProcesses << (l_nProcesses == 1 ? " process)" : " processes)") << std::endl;
+  
+  // fill the NaNs, e.g. of missing data, and report them, just so we know what's up
+  t_idx l_nNaNs = 0;
+  t_real l_fillValue = i_region.fillValue;
+  #pragma omp parallel for reduction(+:l_nNaNs)
+  for(t_idx l_va = 0; l_va < l_nValues; l_va++){
+    if(std::isnan(o_data[l_va])){
+      o_data[l_va] = l_fillValue;
+      l_nNaNs++;
     }
   }
-  
-  check(nc_close(l_handle));
+  if(l_nNaNs > 0){
+    std::cerr << "data contains " << l_nNaNs << " NaNs in field of size " << o_sizeX << " x " << o_sizeY << ", replaced them by " << l_fillValue << std::endl;
+  }
   
   return EXIT_SUCCESS;
   
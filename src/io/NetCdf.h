@@ -7,10 +7,13 @@
 #ifndef TSUNAMI_LAB_IO_NETCDF_H
 #define TSUNAMI_LAB_IO_NETCDF_H
 
+#include <functional> // std::function
 #include <string>
+#include <sys/types.h> // pid_t
 #include <vector>
 
 #include "../constants.h"
+#include "../io/Aggregates.h"
 #include "../io/Station.h"
 #include "../patches/WavePropagation.h"
 #include "../setups/Setup.h"
@@ -19,12 +22,82 @@
 namespace tsunami_lab {
   namespace io {
     class NetCDF;
+    class NetCDFWriter;
   }
 }
 
 class tsunami_lab::io::NetCDF {
+  public:
+    //! compression codecs of the NetCDF-4 variables
+    enum Codec {
+      //! zlib, the NetCDF default
+      DEFLATE = 0,
+      //! zstandard; much faster at similar ratios, needs the HDF5 filter plugin to write and to read the file
+      ZSTD = 1,
+      //! no compression
+      NONE = 2
+    };
+    
+    //! part of a 2d array, which load2dArray() reads, and how it is coarsened
+    struct Region {
+      //! bounding box [x0, x1) x [y0, y1) in cells, or in meters of the ascending x and y variables; x1 <= x0: up to the end
+      double x0, y0, x1, y1;
+      bool inMeters;
+      //! cells of the file per loaded cell in each direction
+      t_idx stride;
+      //! true: mean of the stride x stride cells without the NaNs; false: every stride-th cell
+      bool average;
+      //! replaces NaNs, e.g. of missing data
+      t_real fillValue;
+      
+      //! the whole array without coarsening
+      Region(): x0(0), y0(0), x1(0), y1(0), inMeters(false), stride(1), average(true), fillValue(0) {}
+    };
+    
   private:
     
+    //! defines its files with the same compression
+    friend class tsunami_lab::io::NetCDFWriter;
+    
+    //! codec for output files and checkpoints
+    static Codec m_codec;
+    
+    //! number of rows per chunk of the 2d and 3d variables; 0 for the library default
+    static t_idx m_chunkRows;
+    
+    //! significant bits of height, momentum x and momentum y in the output frames; 0 for lossless output
+    static int m_significantBits[3];
+    
+    /**
+     * Defines the chunk shape and the compression of a variable.
+     *
+     * @param i_handle file handle.
+     * @param i_varId variable.
+     * @param i_nDims number of dimensions: 1 = axis, 2 = y, x, 3 = time, y, x.
+     * @param i_nx size in x-direction.
+     * @param i_ny size in y-direction.
+     * @param i_level compression level; 0 disables the compression.
+     * @return NetCDF error code.
+     **/
+    static int defineCompression( int   i_handle,
+                                  int   i_varId,
+                                  int   i_nDims,
+                                  t_idx i_nx,
+                                  t_idx i_ny,
+                                  int   i_level );
+    
+    /**
+     * Defines the quantization of a time dependent variable, see setSignificantBits().
+     *
+     * @param i_handle file handle.
+     * @param i_varId variable.
+     * @param i_quantity 0 = height, 1 = momentum x, 2 = momentum y.
+     * @return NetCDF error code.
+     **/
+    static int defineQuantization( int            i_handle,
+                                   int            i_varId,
+                                   unsigned short i_quantity );
+    
     static int storeRow( int           i_handle,
                          int           i_varId,
                          int           i_timeIndex,
@@ -43,7 +116,101 @@ class tsunami_lab::io::NetCDF {
                            t_idx         i_sizeOutY,
                            t_real*       i_dataOut,
                            t_idx         i_step );
+    
+    /**
+     * Like downsample(), but reads the input row by row from a patch, so patches without dense storage don't need a full copy.
+     * The output is written row by row.
+     *
+     * @param i_offsetIn 0 to include the ghost cells, 1 to skip them.
+     * @param i_waveProp patch, which provides the rows.
+     * @param i_quantity quantity id for WavePropagation::getRow().
+     **/
+    static int downsampleRows( int                                    i_handle,
+                               int                                    i_varId,
+                               int                                    i_timeIndex,
+                               t_idx                                  i_sizeInX,
+                               t_idx                                  i_sizeInY,
+                               t_idx                                  i_offsetIn,
+                               tsunami_lab::patches::WavePropagation* i_waveProp,
+                               unsigned short                         i_quantity,
+                               t_idx                                  i_sizeOutX,
+                               t_idx                                  i_sizeOutY,
+                               t_idx                                  i_step );
+    
+    /**
+     * Implementation of appendTimeframe(); the quantities are read from i_rowSource, if it isn't nullptr.
+     **/
+    static int appendTimeframe( t_real                                 i_cellSizeMeters,
+                                t_idx                                  i_nx,
+                                t_idx                                  i_ny,
+                                t_real                                 i_gridOffsetX,
+                                t_real                                 i_gridOffsetY,
+                                t_idx                                  i_step,
+                                t_idx                                  i_stride,
+                                t_real                         const * i_h,
+                                t_real                         const * i_hu,
+                                t_real                         const * i_hv,
+                                t_real                         const * i_b,
+                                tsunami_lab::patches::WavePropagation* i_rowSource,
+                                tsunami_lab::setups::Setup           * i_setup,
+                                t_real                                 i_time,
+                                int                                    i_deflateLevel,
+                                std::string                            i_fileName );
+    
+    /**
+     * Reads rows of a region of a 2d variable; see load2dArray().
+     *
+     * @param i_handle file handle.
+     * @param i_varId variable.
+     * @param i_region stride and averaging.
+     * @param i_beginX first column of the region in the file.
+     * @param i_beginY first row of the region in the file.
+     * @param i_sizeX loaded cells per row.
+     * @param i_rowBegin first loaded row.
+     * @param i_rowEnd end of the loaded rows.
+     * @param o_data values of the rows.
+     * @return NetCDF error code.
+     **/
+    static int load2dRows( int              i_handle,
+                           int              i_varId,
+                           Region   const & i_region,
+                           size_t           i_beginX,
+                           size_t           i_beginY,
+                           t_idx            i_sizeX,
+                           t_idx            i_rowBegin,
+                           t_idx            i_rowEnd,
+                           t_real         * o_data );
   public:
+    /**
+     * Sets the compression of the following output files and checkpoints.
+     *
+     * @param i_codec codec.
+     * @param i_chunkRows number of rows per chunk of the 2d and 3d variables; 0 for the library default.
+     **/
+    static void setCompression( Codec i_codec,
+                                t_idx i_chunkRows );
+    
+    /**
+     * Sets the lossy quantization of a quantity in the following output files: the mantissa is rounded to a number of significant bits,
+     * such that the frames compress better. The library records it in the attribute _QuantizeBitRoundNumberOfSignificantBits;
+     * the values stay plain floats for the readers. Checkpoints are always lossless.
+     *
+     * @param i_quantity 0 = height, 1 = momentum x, 2 = momentum y.
+     * @param i_bits significant bits, 1 to 23; 0 for lossless output.
+     **/
+    static void setSignificantBits( unsigned short i_quantity,
+                                    int            i_bits );
+    
+    /**
+     * Parses the name of a codec.
+     *
+     * @param i_name deflate, zstd or none.
+     * @param o_codec parsed codec.
+     * @return true, if the name is known.
+     **/
+    static bool parseCodec( std::string const & i_name,
+                            Codec             & o_codec );
+    
     /**
      * Writes the data as a NetCDF file.
      *
@@ -82,7 +249,36 @@ class tsunami_lab::io::NetCDF {
                                 std::string                  i_fileName );
     
     /**
-     * Reads a checkpint from a file.
+     * Writes the state of a patch as a NetCDF file.
+     * Patches without dense storage are read row by row.
+     *
+     * @param i_cellSizeMeters cell size in x- and y-direction.
+     * @param i_nx number of cells in x-direction.
+     * @param i_ny number of cells in y-direction.
+     * @param i_gridOffsetX x-coordinate in meters of first cell, excluding the ghost cells.
+     * @param i_gridOffsetY y-coordinate in meters of first cell, excluding the ghost cells.
+     * @param i_step only every step-th cell is written.
+     * @param i_waveProp patch with height, momenta and bathymetry.
+     * @param i_setup setup for displacement data.
+     * @param i_time time in seconds of the current frame.
+     * @param i_deflateLevel compression level, 0 = large/fastest, 9 = compact/slowest, 5 is recommended
+     * @param i_fileName target file, where the data is written to.
+     * @return 0 if the function was successful, -1 or error code else.
+     **/
+    static int appendTimeframe( t_real                                 i_cellSizeMeters,
+                                t_idx                                  i_nx,
+                                t_idx                                  i_ny,
+                                t_real                                 i_gridOffsetX,
+                                t_real                                 i_gridOffsetY,
+                                t_idx                                  i_step,
+                                tsunami_lab::patches::WavePropagation* i_waveProp,
+                                tsunami_lab::setups::Setup           * i_setup,
+                                t_real                                 i_time,
+                                int                                    i_deflateLevel,
+                                std::string                            i_fileName );
+    
+    /**
+     * Reads a checkpint from a file; see loadCheckpointInfo() and loadCheckpointSetup().
      *
      * @param i_fileName input file name.
      * @param o_nx field size on x axis.
@@ -103,6 +299,48 @@ class tsunami_lab::io::NetCDF {
                                                        t_idx                                 & o_timeStepIndex,
                                                        std::vector<tsunami_lab::io::Station> & o_stations );
     
+    /**
+     * Reads the sizes, the time and the stations of a checkpoint without its fields.
+     * The fields are read by loadCheckpointFields() into a patch afterwards, or by loadCheckpointSetup() for patches without t_real arrays.
+     *
+     * @param i_fileName input file name.
+     * @param o_nx field size on x axis including the ghost cells.
+     * @param o_ny field size on y axis including the ghost cells; 1 in 1d.
+     * @param o_cellSizeMeters cell size in meters.
+     * @param o_cflFactor cfl factor for 2d simulations, 0.5 else.
+     * @param o_simulationTime last computed simulation time in seconds.
+     * @param o_timeStepIndex last time step index.
+     * @param o_stations stations with previously collected values.
+     * @return 0 if successful, -1 else.
+     **/
+    static int loadCheckpointInfo( std::string                             i_fileName,
+                                   t_idx                                 & o_nx,
+                                   t_idx                                 & o_ny,
+                                   t_real                                & o_cellSizeMeters,
+                                   t_real                                & o_cflFactor,
+                                   double                                & o_simulationTime,
+                                   t_idx                                 & o_timeStepIndex,
+                                   std::vector<tsunami_lab::io::Station> & o_stations );
+    
+    /**
+     * Reads the fields of a checkpoint into a setup, which holds a copy of them until it is deleted.
+     *
+     * @param i_fileName input file name.
+     * @return a setup with height, bathymetry and impulse data; nullptr on error.
+     **/
+    static tsunami_lab::setups::Setup* loadCheckpointSetup( std::string i_fileName );
+    
+    /**
+     * Reads the fields of a checkpoint directly into the arrays of a patch of the same size, see WavePropagation::getRawStorage();
+     * unlike loadCheckpointSetup(), there is no copy of the fields, and no initialization cell by cell.
+     *
+     * @param i_fileName input file name.
+     * @param io_waveProp patch with t_real arrays.
+     * @return 0 if successful, -1 else.
+     **/
+    static int loadCheckpointFields( std::string                             i_fileName,
+                                     tsunami_lab::patches::WavePropagation * io_waveProp );
+    
     /**
      * Writes the current simulation data as a NetCDF file / checkpoint.
      *
@@ -115,6 +353,7 @@ class tsunami_lab::io::NetCDF {
      * @param i_timeStepIndex n for the n-th time step.
      * @param i_stations stations.
      * @param i_waveProp wave propagation instance.
+     * @param i_aggregates aggregates, which shall survive a restart; nullptr if there are none.
      * @return 0 if successful, error code else
      **/
     static int storeCheckpoint( std::string                             i_fileName,
@@ -125,10 +364,81 @@ class tsunami_lab::io::NetCDF {
                                 double                                  i_simulationTime,
                                 t_idx                                   i_timeStepIndex,
                                 std::vector<tsunami_lab::io::Station> & i_stations,
-                                tsunami_lab::patches::WavePropagation * i_waveProp );
+                                tsunami_lab::patches::WavePropagation * i_waveProp,
+                                tsunami_lab::io::Aggregates     const * i_aggregates = nullptr );
+    
+    /**
+     * Like storeCheckpoint(), but a forked child process writes the copy-on-write snapshot of the process, while the caller continues stepping.
+     * The child writes and renames the file like storeCheckpoint(); at most one child runs at a time, so the previous one is waited for first.
+     * If fork() fails, the checkpoint is written synchronously.
+     * Other NetCDF files must not be in use by another thread, while fork() is called, e.g. sync the writers first.
+     *
+     * @param io_childId process id of the running child, 0 if there is none; it is replaced by the id of the new child.
+     * @return 0 if the child was started or the checkpoint was written, -1 or error code else.
+     **/
+    static int storeCheckpointAsync( std::string                             i_fileName,
+                                     t_idx                                   i_nx,
+                                     t_idx                                   i_ny,
+                                     t_real                                  i_cellSizeMeters,
+                                     t_real                                  i_cflFactor,
+                                     double                                  i_simulationTime,
+                                     t_idx                                   i_timeStepIndex,
+                                     std::vector<tsunami_lab::io::Station> & i_stations,
+                                     tsunami_lab::patches::WavePropagation * i_waveProp,
+                                     tsunami_lab::io::Aggregates     const * i_aggregates,
+                                     pid_t                                 & io_childId );
+    
+    /**
+     * Runs a function, which writes a checkpoint, in a forked child process; see storeCheckpointAsync().
+     *
+     * @param i_store function, which writes the checkpoint, and returns 0 if successful.
+     * @param io_childId process id of the running child, 0 if there is none; it is replaced by the id of the new child.
+     * @return 0 if the child was started or the checkpoint was written, -1 or error code else.
+     **/
+    static int forkCheckpoint( std::function<int()> const & i_store,
+                               pid_t                      & io_childId );
+    
+    /**
+     * Waits for the child process of storeCheckpointAsync() or forkCheckpoint().
+     *
+     * @param io_childId process id of the child, 0 if there is none; it is reset to 0.
+     * @return 0 if the checkpoint was written or there is no child, -1 else.
+     **/
+    static int waitForCheckpoint( pid_t & io_childId );
+    
+    /**
+     * Reads the aggregates from a checkpoint; keeps them, if the checkpoint has none, e.g. because it was written without aggregates.
+     *
+     * @param i_fileName checkpoint file name.
+     * @param io_aggregates aggregates of the same size as the checkpoint.
+     * @return 0 if successful or if there are no aggregates, -1 or error code else.
+     **/
+    static int loadAggregates( std::string                   i_fileName,
+                               tsunami_lab::io::Aggregates & io_aggregates );
+    
+    /**
+     * Writes the aggregates at full resolution into a new file, e.g. at the end of a run.
+     *
+     * @param i_fileName output file name.
+     * @param i_cellSizeMeters cell size in meters.
+     * @param i_gridOffsetX x-coordinate in meters of first cell, excluding the ghost cells.
+     * @param i_gridOffsetY y-coordinate in meters of first cell, excluding the ghost cells.
+     * @param i_deflateLevel compression level, 0 = large/fastest, 9 = compact/slowest.
+     * @param i_aggregates aggregates.
+     * @return 0 if successful, -1 or error code else.
+     **/
+    static int storeAggregates( std::string                         i_fileName,
+                                t_real                              i_cellSizeMeters,
+                                t_real                              i_gridOffsetX,
+                                t_real                              i_gridOffsetY,
+                                int                                 i_deflateLevel,
+                                tsunami_lab::io::Aggregates const & i_aggregates );
     
     /**
-     * Reads a 2d array of data from a NetCDF file.
+     * Reads a 2d array of data from a NetCDF file; only the region is read from the file, so the memory scales with it.
+     * Partial blocks of a coarsened region at its upper bounds are left out.
+     * Large regions are read by forked child processes, one band of chunks each, because the NetCDF library isn't thread safe.
+     * Bands, whose process can't be forked or fails, are read by the calling process.
      *
      * @param i_fileName file name for the file to be loaded.
      * @param i_variableName name of the variable to be loaded; default value for GMT data: z.
@@ -138,6 +448,7 @@ class tsunami_lab::io::NetCDF {
      * @param o_gridOffsetX x-coordinate in meters of first cell, excluding the ghost cells.
      * @param o_gridOffsetY y-coordinate in meters of first cell, excluding the ghost cells.
      * @param o_data data vector, where the data is written to.
+     * @param i_region part of the array and coarsening; the whole array by default.
      * @return 0 if the function was successful, -1 or error code else.
      **/
     static int load2dArray( std::string           i_fileName,
@@ -147,7 +458,8 @@ class tsunami_lab::io::NetCDF {
                             t_real              & o_cellSizeMeters,
                             t_real              & o_gridOffsetX,
                             t_real              & o_gridOffsetY,
-                            std::vector<t_real> & o_data );
+                            std::vector<t_real> & o_data,
+                            Region        const & i_region = Region() );
 };
 
 #endif // TSUNAMI_LAB_IO_NETCDF_H
\ No newline at end of file
@@ -7,11 +7,16 @@
 #include <catch2/catch.hpp>
 #include "../constants.h"
 #include "../patches/WavePropagation1d.h"
+#include "../patches/WavePropagation2d.h"
+#include "../setups/DamBreak2d.h"
 
 #include <sstream>
 #include <iostream>
 #include <cstdio>
+#include <cmath>
+#include <vector>
 #include <netcdf.h>
+#include <omp.h>
 
 #define private public
 #include "NetCdf.h"
@@ -93,6 +98,96 @@ TEST_CASE( "Test the NetCDF-writer to append data.", "[NetCDF][AppendData]" ) {
   
 }
 
+TEST_CASE( "Test the chunk shape and the codec of the NetCDF output.", "[NetCDF][Compression]" ) {
+  
+  tsunami_lab::io::NetCDF::Codec l_codec = tsunami_lab::io::NetCDF::DEFLATE;
+  REQUIRE(tsunami_lab::io::NetCDF::parseCodec("none", l_codec));
+  REQUIRE(l_codec == tsunami_lab::io::NetCDF::NONE);
+  REQUIRE(tsunami_lab::io::NetCDF::parseCodec("zstd", l_codec));
+  REQUIRE(l_codec == tsunami_lab::io::NetCDF::ZSTD);
+  REQUIRE_FALSE(tsunami_lab::io::NetCDF::parseCodec("lz4", l_codec));
+  
+  t_idx l_nx = 5, l_ny = 7;
+  std::vector<t_real> l_h(l_nx * l_ny), l_b(l_nx * l_ny);
+  for(t_idx i=0;i<l_nx*l_ny;i++){
+    l_h[i] = (t_real) i;
+    l_b[i] = -(t_real) (i % 3);
+  }
+  
+  std::string l_fileName = "tmp-chunks.nc";
+  int l_err, l_handle, l_varId, l_storage, l_shuffle, l_deflate, l_level;
+  size_t l_chunks[3];
+  for(int l_co = 0; l_co < 2; l_co++){
+    
+    // deflate with 3 rows per chunk, then no compression
+    tsunami_lab::io::NetCDF::setCompression(l_co == 0 ? tsunami_lab::io::NetCDF::DEFLATE : tsunami_lab::io::NetCDF::NONE, 3);
+    REQUIRE(tsunami_lab::io::NetCDF::appendTimeframe(1, l_nx, l_ny, 0, 0, 1, l_nx, l_h.data(), nullptr, nullptr, l_b.data(), nullptr, 0, 5, l_fileName) == 0);
+    
+    check(nc_open(l_fileName.c_str(), NC_NOWRITE, &l_handle));
+    check(nc_inq_varid(l_handle, "height", &l_varId));
+    check(nc_inq_var_chunking(l_handle, l_varId, &l_storage, l_chunks));
+    REQUIRE(l_storage == NC_CHUNKED);
+    REQUIRE(l_chunks[0] == 1);
+    REQUIRE(l_chunks[1] == 3);
+    REQUIRE(l_chunks[2] == l_nx);
+    check(nc_inq_var_deflate(l_handle, l_varId, &l_shuffle, &l_deflate, &l_level));
+    REQUIRE(l_deflate == (l_co == 0 ? 1 : 0));
+    
+    std::vector<float> l_data(l_nx * l_ny);
+    check(nc_get_var_float(l_handle, l_varId, l_data.data()));
+    for(t_idx i=0;i<l_nx*l_ny;i++) REQUIRE(l_data[i] == l_h[i]);
+    
+    check(nc_inq_varid(l_handle, "bathymetry", &l_varId));
+    check(nc_inq_var_chunking(l_handle, l_varId, &l_storage, l_chunks));
+    REQUIRE(l_chunks[0] == 3);
+    REQUIRE(l_chunks[1] == l_nx);
+    check(nc_close(l_handle));
+  }
+  
+  tsunami_lab::io::NetCDF::setCompression(tsunami_lab::io::NetCDF::DEFLATE, 0);
+  std::remove(l_fileName.c_str());
+}
+
+TEST_CASE( "Test the lossy quantization of the NetCDF output.", "[NetCDF][Quantization]" ) {
+  
+  t_idx l_nx = 6, l_ny = 4;
+  std::vector<t_real> l_h(l_nx * l_ny), l_hu(l_nx * l_ny), l_b(l_nx * l_ny, -1);
+  for(t_idx i=0;i<l_nx*l_ny;i++){
+    l_h[i]  = 100 + (t_real) i * 1.2345f;
+    l_hu[i] = (t_real) i * 0.789f;
+  }
+  
+  // height with 8 significant bits, the momentum stays lossless
+  std::string l_fileName = "tmp-quantized.nc";
+  tsunami_lab::io::NetCDF::setSignificantBits(0, 8);
+  REQUIRE(tsunami_lab::io::NetCDF::appendTimeframe(1, l_nx, l_ny, 0, 0, 1, l_nx, l_h.data(), l_hu.data(), nullptr, l_b.data(), nullptr, 0, 5, l_fileName) == 0);
+  tsunami_lab::io::NetCDF::setSignificantBits(0, 0);
+  
+  int l_err, l_handle, l_hId, l_huId, l_mode, l_bits;
+  check(nc_open(l_fileName.c_str(), NC_NOWRITE, &l_handle));
+  check(nc_inq_varid(l_handle, "height",    &l_hId));
+  check(nc_inq_varid(l_handle, "momentumX", &l_huId));
+  check(nc_inq_var_quantize(l_handle, l_hId, &l_mode, &l_bits));
+  REQUIRE(l_mode == NC_QUANTIZE_BITROUND);
+  REQUIRE(l_bits == 8);
+  check(nc_inq_var_quantize(l_handle, l_huId, &l_mode, &l_bits));
+  REQUIRE(l_mode == NC_QUANTIZE_NOQUANTIZE);
+  
+  std::vector<float> l_data(l_nx * l_ny);
+  check(nc_get_var_float(l_handle, l_hId, l_data.data()));
+  bool l_isRounded = false;
+  for(t_idx i=0;i<l_nx*l_ny;i++){
+    REQUIRE(std::abs(l_data[i] - l_h[i]) <= l_h[i] / 256);
+    l_isRounded |= l_data[i] != l_h[i];
+  }
+  REQUIRE(l_isRounded);
+  check(nc_get_var_float(l_handle, l_huId, l_data.data()));
+  for(t_idx i=0;i<l_nx*l_ny;i++) REQUIRE(l_data[i] == l_hu[i]);
+  check(nc_close(l_handle));
+  
+  std::remove(l_fileName.c_str());
+}
+
 TEST_CASE( "Test the NetCDF-reading functionality for a 2d field named z.", "[NetCDF][Read2d]" ) {
   // for the baseline see the file ../../data/netcdf-test.nc
   t_idx l_sizeX = 0, l_sizeY = 0;
@@ -107,6 +202,147 @@ TEST_CASE( "Test the NetCDF-reading functionality for a 2d field named z.", "[Ne
   for(int i=0;i<12;i++) REQUIRE(l_data[i] == i);
 }
 
+TEST_CASE( "Test reading a region of a 2d field, and coarsening it.", "[NetCDF][Read2d]" ) {
+  // x = 6, 8, 10, 12; y = 2, 4, 6; z = 0 .. 11
+  t_idx l_sizeX = 0, l_sizeY = 0;
+  t_real l_cellSizeMeters = 0, l_offsetX = 0, l_offsetY = 0;
+  std::vector<t_real> l_data;
+  
+  tsunami_lab::io::NetCDF::Region l_region;
+  l_region.x0 = 1;
+  l_region.x1 = 3;
+  l_region.y0 = 1;
+  REQUIRE(tsunami_lab::io::NetCDF::load2dArray("data/netcdf-test.nc", "z", l_sizeX, l_sizeY, l_cellSizeMeters, l_offsetX, l_offsetY, l_data, l_region) == 0);
+  REQUIRE(l_sizeX == 2);
+  REQUIRE(l_sizeY == 2);
+  REQUIRE(l_cellSizeMeters == Approx(2.0));
+  REQUIRE(l_offsetX == Approx(10));
+  REQUIRE(l_offsetY == Approx(6));
+  REQUIRE(l_data == std::vector<t_real>({ 5, 6, 9, 10 }));
+  
+  // the same cells in meters
+  l_region.inMeters = true;
+  l_region.x0 = 7;
+  l_region.x1 = 11;
+  l_region.y0 = 3;
+  l_region.y1 = 100;
+  l_data.clear();
+  REQUIRE(tsunami_lab::io::NetCDF::load2dArray("data/netcdf-test.nc", "z", l_sizeX, l_sizeY, l_cellSizeMeters, l_offsetX, l_offsetY, l_data, l_region) == 0);
+  REQUIRE(l_data == std::vector<t_real>({ 5, 6, 9, 10 }));
+  
+  // 2 x 2 cells as one; the last row is a partial block
+  tsunami_lab::io::NetCDF::Region l_coarse;
+  l_coarse.stride = 2;
+  REQUIRE(tsunami_lab::io::NetCDF::load2dArray("data/netcdf-test.nc", "z", l_sizeX, l_sizeY, l_cellSizeMeters, l_offsetX, l_offsetY, l_data, l_coarse) == 0);
+  REQUIRE(l_sizeX == 2);
+  REQUIRE(l_sizeY == 1);
+  REQUIRE(l_cellSizeMeters == Approx(4.0));
+  REQUIRE(l_offsetX == Approx(11));
+  REQUIRE(l_offsetY == Approx(3));
+  REQUIRE(l_data == std::vector<t_real>({ 2.5, 4.5 }));
+  
+  l_coarse.average = false;
+  REQUIRE(tsunami_lab::io::NetCDF::load2dArray("data/netcdf-test.nc", "z", l_sizeX, l_sizeY, l_cellSizeMeters, l_offsetX, l_offsetY, l_data, l_coarse) == 0);
+  REQUIRE(l_offsetX == Approx(10));
+  REQUIRE(l_offsetY == Approx(2));
+  REQUIRE(l_data == std::vector<t_real>({ 0, 2 }));
+  
+  // a region without cells
+  l_region.x0 = 100;
+  l_region.x1 = 200;
+  REQUIRE(tsunami_lab::io::NetCDF::load2dArray("data/netcdf-test.nc", "z", l_sizeX, l_sizeY, l_cellSizeMeters, l_offsetX, l_offsetY, l_data, l_region) != 0);
+}
+
+TEST_CASE( "Test reading a large 2d field in several processes.", "[NetCDF][Read2d]" ) {
+  // 9M values, so the field is split into bands of chunks
+  std::string l_fileName = "tmp-large.nc";
+  size_t l_nx = 3000, l_ny = 3000;
+  std::vector<float> l_xs(l_nx), l_ys(l_ny), l_zs(l_nx * l_ny);
+  for(size_t l_ix = 0; l_ix < l_nx; l_ix++) l_xs[l_ix] = l_ix;
+  for(size_t l_iy = 0; l_iy < l_ny; l_iy++) l_ys[l_iy] = l_iy;
+  for(size_t l_va = 0; l_va < l_nx * l_ny; l_va++) l_zs[l_va] = l_va;
+  int l_handle, l_err, l_dimIds[2], l_xId, l_yId, l_zId;
+  size_t l_chunks[2] = { 100, 1000 };
+  check(nc_create(l_fileName.c_str(), NC_CLOBBER | NC_NETCDF4, &l_handle));
+  check(nc_def_dim(l_handle, "y", l_ny, &l_dimIds[0]));
+  check(nc_def_dim(l_handle, "x", l_nx, &l_dimIds[1]));
+  check(nc_def_var(l_handle, "x", NC_FLOAT, 1, &l_dimIds[1], &l_xId));
+  check(nc_def_var(l_handle, "y", NC_FLOAT, 1, &l_dimIds[0], &l_yId));
+  check(nc_def_var(l_handle, "z", NC_FLOAT, 2, l_dimIds, &l_zId));
+  check(nc_def_var_chunking(l_handle, l_zId, NC_CHUNKED, l_chunks));
+  check(nc_enddef(l_handle));
+  check(nc_put_var_float(l_handle, l_xId, l_xs.data()));
+  check(nc_put_var_float(l_handle, l_yId, l_ys.data()));
+  check(nc_put_var_float(l_handle, l_zId, l_zs.data()));
+  check(nc_close(l_handle));
+  
+  // the number of processes follows the number of threads
+  int l_nThreads = omp_get_max_threads();
+  omp_set_num_threads(4);
+  t_idx l_sizeX, l_sizeY;
+  t_real l_cellSizeMeters, l_offsetX, l_offsetY;
+  std::vector<t_real> l_data;
+  tsunami_lab::io::NetCDF::Region l_region;
+  l_region.y0 = 1;
+  int l_result = tsunami_lab::io::NetCDF::load2dArray(l_fileName, "z", l_sizeX, l_sizeY, l_cellSizeMeters, l_offsetX, l_offsetY, l_data, l_region);
+  l_region.y0 = 0;
+  l_region.stride = 2;
+  std::vector<t_real> l_coarse;
+  int l_coarseResult = tsunami_lab::io::NetCDF::load2dArray(l_fileName, "z", l_sizeX, l_sizeY, l_cellSizeMeters, l_offsetX, l_offsetY, l_coarse, l_region);
+  omp_set_num_threads(l_nThreads);
+  std::remove(l_fileName.c_str());
+  
+  REQUIRE(l_result == 0);
+  REQUIRE(l_data.size() == l_nx * (l_ny - 1));
+  bool l_same = true;
+  for(size_t l_va = 0; l_va < l_data.size(); l_va++) l_same = l_same && l_data[l_va] == l_zs[l_va + l_nx];
+  REQUIRE(l_same);
+  
+  REQUIRE(l_coarseResult == 0);
+  REQUIRE(l_sizeX == l_nx / 2);
+  REQUIRE(l_sizeY == l_ny / 2);
+  for(size_t l_iy = 0; l_iy < l_sizeY; l_iy++){
+    for(size_t l_ix = 0; l_ix < l_sizeX; l_ix++){
+      l_same = l_same && l_coarse[l_iy * l_sizeX + l_ix] == Approx(2 * l_ix + 0.5 + (2 * l_iy + 0.5) * l_nx);
+    }
+  }
+  REQUIRE(l_same);
+}
+
+TEST_CASE( "Test that NaNs are left out of the averages, and filled.", "[NetCDF][Read2d]" ) {
+  std::string l_fileName = "tmp-nan.nc";
+  float l_nan = NAN;
+  float l_xs[4] = { 0, 1, 2, 3 };
+  float l_ys[2] = { 0, 1 };
+  float l_zs[8] = { 1,     3,     l_nan, l_nan,
+                    l_nan, l_nan, l_nan, l_nan };
+  int l_handle, l_err, l_dimIds[2], l_xId, l_yId, l_zId;
+  check(nc_create(l_fileName.c_str(), NC_CLOBBER, &l_handle));
+  check(nc_def_dim(l_handle, "y", 2, &l_dimIds[0]));
+  check(nc_def_dim(l_handle, "x", 4, &l_dimIds[1]));
+  check(nc_def_var(l_handle, "x", NC_FLOAT, 1, &l_dimIds[1], &l_xId));
+  check(nc_def_var(l_handle, "y", NC_FLOAT, 1, &l_dimIds[0], &l_yId));
+  check(nc_def_var(l_handle, "z", NC_FLOAT, 2, l_dimIds, &l_zId));
+  check(nc_enddef(l_handle));
+  check(nc_put_var_float(l_handle, l_xId, l_xs));
+  check(nc_put_var_float(l_handle, l_yId, l_ys));
+  check(nc_put_var_float(l_handle, l_zId, l_zs));
+  check(nc_close(l_handle));
+  
+  t_idx l_sizeX, l_sizeY;
+  t_real l_cellSizeMeters, l_offsetX, l_offsetY;
+  std::vector<t_real> l_data;
+  tsunami_lab::io::NetCDF::Region l_region;
+  l_region.fillValue = -7;
+  REQUIRE(tsunami_lab::io::NetCDF::load2dArray(l_fileName, "z", l_sizeX, l_sizeY, l_cellSizeMeters, l_offsetX, l_offsetY, l_data, l_region) == 0);
+  REQUIRE(l_data == std::vector<t_real>({ 1, 3, -7, -7, -7, -7, -7, -7 }));
+  
+  l_region.stride = 2;
+  REQUIRE(tsunami_lab::io::NetCDF::load2dArray(l_fileName, "z", l_sizeX, l_sizeY, l_cellSizeMeters, l_offsetX, l_offsetY, l_data, l_region) == 0);
+  REQUIRE(l_data == std::vector<t_real>({ 2, -7 }));
+  std::remove(l_fileName.c_str());
+}
+
 // this test is no longer supported this way, because now we write directly to NetCDF;
 // we could read the result from a temporary file...
 /*TEST_CASE( "Test sampling down an image for coarse output", "[NetCDF][downsample]" ) {
@@ -257,3 +493,107 @@ TEST_CASE( "Test checkpointing", "[NetCDF][Checkpointing]" ) {
   delete l_setup;
   
 }
+
+TEST_CASE( "Test asynchronous checkpointing", "[NetCDF][Checkpointing]" ) {
+  
+  t_idx l_nx = 20, l_ny = 1;
+  tsunami_lab::patches::WavePropagation1d l_waveProp(l_nx);
+  for( std::size_t l_ce = 0; l_ce < l_nx; l_ce++ ) {
+    l_waveProp.setHeight( l_ce, 0, 1 + l_ce );
+    l_waveProp.setMomentumX( l_ce, 0, 0 );
+  }
+  
+  std::vector<tsunami_lab::io::Station> l_stations;
+  std::string l_fileName = "tmp-cp-async.nc";
+  std::remove(l_fileName.c_str());
+  
+  // the child writes the state at the time of the fork
+  pid_t l_child = 0;
+  REQUIRE( tsunami_lab::io::NetCDF::storeCheckpointAsync( l_fileName, l_nx, l_ny, 1, 0.5, 1, 10, l_stations, &l_waveProp, nullptr, l_child ) == 0 );
+  for( std::size_t l_ce = 0; l_ce < l_nx; l_ce++ ) l_waveProp.setHeight( l_ce, 0, 100 );
+  
+  // the second child waits for the first one, and replaces its file
+  REQUIRE( tsunami_lab::io::NetCDF::storeCheckpointAsync( l_fileName, l_nx, l_ny, 1, 0.5, 2, 20, l_stations, &l_waveProp, nullptr, l_child ) == 0 );
+  for( std::size_t l_ce = 0; l_ce < l_nx; l_ce++ ) l_waveProp.setHeight( l_ce, 0, 200 );
+  REQUIRE( tsunami_lab::io::NetCDF::waitForCheckpoint( l_child ) == 0 );
+  REQUIRE( l_child == 0 );
+  REQUIRE( tsunami_lab::io::NetCDF::waitForCheckpoint( l_child ) == 0 );
+  
+  t_idx l_nx2, l_ny2, l_timeStepIndex2;
+  t_real l_cellSizeMeters2, l_cflFactor2;
+  double l_simulationTime2;
+  std::vector<tsunami_lab::io::Station> l_stations2;
+  auto l_setup = tsunami_lab::io::NetCDF::loadCheckpoint( l_fileName, l_nx2, l_ny2, l_cellSizeMeters2,
+                                                          l_cflFactor2, l_simulationTime2, l_timeStepIndex2,
+                                                          l_stations2 );
+  REQUIRE( l_setup != nullptr );
+  REQUIRE( l_timeStepIndex2 == 20 );
+  REQUIRE( l_simulationTime2 == 2 );
+  
+  tsunami_lab::patches::WavePropagation1d l_waveProp2(l_nx);
+  l_waveProp2.initWithSetup(l_setup, 1.0);
+  for( std::size_t l_ce = 0; l_ce < l_nx; l_ce++ ) {
+    REQUIRE( l_waveProp2.getHeight()[l_ce] == Approx(100) );
+  }
+  
+  delete l_setup;
+  std::remove(l_fileName.c_str());
+  std::remove((l_fileName + ".tmp").c_str());
+}
+
+TEST_CASE( "Test reading a checkpoint directly into a patch", "[NetCDF][Checkpointing]" ) {
+  
+  t_idx l_nx = 15, l_ny = 9;
+  tsunami_lab::setups::DamBreak2d l_setup( 10, 5, 7, 4, 3, -10 );
+  tsunami_lab::patches::WavePropagation2d l_waveProp( l_nx, l_ny, &l_setup, 1, 1 );
+  for( t_idx l_it = 0; l_it < 3; l_it++ ) {
+    l_waveProp.setGhostOutflow();
+    l_waveProp.timeStep( 0.1 );
+  }
+  
+  std::vector<tsunami_lab::io::Station> l_stations;
+  l_stations.push_back(tsunami_lab::io::Station(2, 5, "Atlantis", 0.5));
+  std::string l_fileName = "tmp-cp-fields.nc";
+  std::remove(l_fileName.c_str());
+  REQUIRE( tsunami_lab::io::NetCDF::storeCheckpoint( l_fileName, l_nx, l_ny, 1, 0.45, 0.3, 3, l_stations, &l_waveProp ) == 0 );
+  
+  // the sizes include the ghost cells
+  t_idx l_nx2, l_ny2, l_timeStepIndex2;
+  t_real l_cellSizeMeters2, l_cflFactor2;
+  double l_simulationTime2;
+  std::vector<tsunami_lab::io::Station> l_stations2;
+  REQUIRE( tsunami_lab::io::NetCDF::loadCheckpointInfo( l_fileName, l_nx2, l_ny2, l_cellSizeMeters2, l_cflFactor2,
+                                                        l_simulationTime2, l_timeStepIndex2, l_stations2 ) == 0 );
+  REQUIRE( l_nx2 == l_nx + 2 );
+  REQUIRE( l_ny2 == l_ny + 2 );
+  REQUIRE( l_timeStepIndex2 == 3 );
+  REQUIRE( l_stations2.size() == 1 );
+  REQUIRE( l_stations2[0].getName() == "Atlantis" );
+  
+  tsunami_lab::patches::WavePropagation2d l_restored( l_nx, l_ny );
+  REQUIRE( tsunami_lab::io::NetCDF::loadCheckpointFields( l_fileName, &l_restored ) == 0 );
+  t_real * l_arrays[4], * l_restoredArrays[4];
+  t_idx l_nValues = l_waveProp.getRawStorage( l_arrays );
+  REQUIRE( l_restored.getRawStorage( l_restoredArrays ) == l_nValues );
+  for( unsigned short l_qu = 0; l_qu < 4; l_qu++ ) {
+    for( t_idx l_ce = 0; l_ce < l_nValues; l_ce++ ) {
+      REQUIRE( l_restoredArrays[l_qu][l_ce] == l_arrays[l_qu][l_ce] );
+    }
+  }
+  
+  // the setup of the same checkpoint initializes a patch the same way
+  tsunami_lab::setups::Setup * l_checkpoint = tsunami_lab::io::NetCDF::loadCheckpointSetup( l_fileName );
+  REQUIRE( l_checkpoint != nullptr );
+  tsunami_lab::patches::WavePropagation2d l_fromSetup( l_nx, l_ny, l_checkpoint, 1, 1 );
+  for( t_idx l_ce = 0; l_ce < l_nx * l_ny; l_ce++ ) {
+    REQUIRE( l_fromSetup.getHeight()[l_ce]    == l_restored.getHeight()[l_ce] );
+    REQUIRE( l_fromSetup.getMomentumY()[l_ce] == l_restored.getMomentumY()[l_ce] );
+  }
+  delete l_checkpoint;
+  
+  // a patch of another size is rejected
+  tsunami_lab::patches::WavePropagation2d l_other( l_nx, l_ny + 1 );
+  REQUIRE( tsunami_lab::io::NetCDF::loadCheckpointFields( l_fileName, &l_other ) != 0 );
+  
+  std::remove(l_fileName.c_str());
+}
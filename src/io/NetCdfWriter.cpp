@@ -0,0 +1,398 @@
+/**
+ * @author Antonio Noack
+ *
+ * @section DESCRIPTION
+ * Output stream of time frames into a NetCDF file, which stays open for the whole run.
+ **/
+#include "NetCdfWriter.h"
+#include "NetCdf.h"
+
+#include <algorithm> // std::min, std::max
+#include <chrono>
+#include <cstdlib> // EXIT_SUCCESS
+#include <iostream> // std::cerr
+#include <netcdf.h>
+#include <sys/stat.h> // check whether a file exists
+
+#ifdef check
+#error "already defined check()"
+#endif
+
+#define check(error) {\
+  int l_err = error;\
+  if(l_err != NC_NOERR){\
+    std::cerr << "NetCDF-Error occurred: " << nc_strerror(l_err) << " (Code " << l_err << "), line " << __LINE__ << std::endl;\
+    close();\
+    return -1;\
+  }\
+}
+
+#ifndef CEIL_DIV
+#define CEIL_DIV(a,div) (a+div-1)/(div)
+#endif
+
+//! names of the variables by quantity id
+static char const * const s_names[4] = { "height", "momentumX", "momentumY", "bathymetry" };
+
+std::recursive_mutex tsunami_lab::io::NetCDFWriter::m_libraryMutex;
+
+tsunami_lab::io::NetCDFWriter::NetCDFWriter( t_real      i_cellSizeMeters,
+                                             t_idx       i_nx,
+                                             t_idx       i_ny,
+                                             t_real      i_gridOffsetX,
+                                             t_real      i_gridOffsetY,
+                                             t_idx       i_step,
+                                             int         i_deflateLevel,
+                                             std::string i_fileName,
+                                             t_idx       i_queueDepth ):
+  NetCDFWriter( i_cellSizeMeters, i_nx, i_ny, i_gridOffsetX, i_gridOffsetY, 0, 0, i_nx, i_ny, i_step, m_allQuantities, i_deflateLevel, i_fileName, i_queueDepth ) {}
+
+tsunami_lab::io::NetCDFWriter::NetCDFWriter( t_real         i_cellSizeMeters,
+                                             t_idx          i_nx,
+                                             t_idx          i_ny,
+                                             t_real         i_gridOffsetX,
+                                             t_real         i_gridOffsetY,
+                                             t_idx          i_x0,
+                                             t_idx          i_y0,
+                                             t_idx          i_x1,
+                                             t_idx          i_y1,
+                                             t_idx          i_step,
+                                             unsigned short i_quantities,
+                                             int            i_deflateLevel,
+                                             std::string    i_fileName,
+                                             t_idx          i_queueDepth ):
+  m_cellSizeMeters(i_cellSizeMeters), m_hasGhostCells(i_ny > 1), m_gridOffsetX(i_gridOffsetX), m_gridOffsetY(i_gridOffsetY),
+  m_step(std::max(i_step, (t_idx) 1)), m_quantities(i_quantities), m_deflateLevel(i_deflateLevel), m_fileName(i_fileName) {
+
+  // the region contains at least one cell of the domain
+  i_x1 = std::min(i_x1, i_nx);
+  i_y1 = std::min(i_y1, i_ny);
+  m_x0 = std::min(i_x0, i_x1 - 1);
+  m_y0 = std::min(i_y0, i_y1 - 1);
+  m_nx = i_x1 - m_x0;
+  m_ny = i_y1 - m_y0;
+  m_nxOut = CEIL_DIV(m_nx, m_step);
+  m_nyOut = CEIL_DIV(m_ny, m_step);
+
+  // momentumY doesn't exist in 1d
+  if(i_ny <= 1) m_quantities &= ~(1 << 2);
+
+  // the buffers are allocated on first use, so unused queue slots cost no memory
+  m_frames.resize(std::max(i_queueDepth, (t_idx) 1));
+  for(t_idx l_fr = 0; l_fr < m_frames.size(); l_fr++) m_free.push_back(l_fr);
+
+  if(i_queueDepth > 0) m_writer = std::thread(&NetCDFWriter::run, this);
+}
+
+tsunami_lab::io::NetCDFWriter::~NetCDFWriter() {
+  {
+    std::unique_lock<std::mutex> l_lock(m_mutex);
+    m_stop = true;
+  }
+  m_queuedSignal.notify_all();
+  if(m_writer.joinable()) m_writer.join();
+  close();
+}
+
+void tsunami_lab::io::NetCDFWriter::run() {
+  std::unique_lock<std::mutex> l_lock(m_mutex);
+  while(true) {
+    m_queuedSignal.wait(l_lock, [this]{ return m_stop || !m_queued.empty(); });
+    if(m_queued.empty()) return;// stopped, and everything is written
+
+    t_idx l_fr = m_queued.front();
+    m_queued.pop_front();
+    m_writing = true;
+    l_lock.unlock();
+
+    auto l_time0 = std::chrono::high_resolution_clock::now();
+    int l_error = write(m_frames[l_fr]);
+    auto l_time1 = std::chrono::high_resolution_clock::now();
+
+    l_lock.lock();
+    m_writeTime += std::chrono::duration<double>(l_time1-l_time0).count();
+    if(l_error && !m_error) m_error = l_error;
+    m_writing = false;
+    m_free.push_back(l_fr);
+    m_freed.notify_all();
+  }
+}
+
+int tsunami_lab::io::NetCDFWriter::create( tsunami_lab::patches::WavePropagation * i_waveProp ) {
+  std::lock_guard<std::recursive_mutex> l_libraryLock(m_libraryMutex);
+  int l_err = nc_create(m_fileName.c_str(), NC_CLOBBER | NC_NETCDF4, &m_handle);
+  if(l_err != NC_NOERR){
+    std::cerr << "NetCDF-Error occurred: " << nc_strerror(l_err) << " (Code " << l_err << "), creating " << m_fileName << std::endl;
+    m_handle = -1;
+    return -1;
+  }
+
+  check(nc_put_att_text(m_handle, NC_GLOBAL, "Conventions", 6, "COARDS"));
+
+  int l_xDimId, l_yDimId, l_tDimId, l_xVarId, l_yVarId;
+  check(nc_def_dim(m_handle, "x",    m_nxOut,      &l_xDimId));
+  check(nc_def_dim(m_handle, "y",    m_nyOut,      &l_yDimId));
+  check(nc_def_dim(m_handle, "time", NC_UNLIMITED, &l_tDimId));
+
+  check(nc_def_var(m_handle, "x",    NC_FLOAT, 1, &l_xDimId, &l_xVarId));
+  check(nc_def_var(m_handle, "y",    NC_FLOAT, 1, &l_yDimId, &l_yVarId));
+  check(nc_def_var(m_handle, "time", NC_FLOAT, 1, &l_tDimId, &m_timeId));
+  check(NetCDF::defineCompression(m_handle, l_xVarId, 1, m_nxOut, m_nyOut, m_deflateLevel));
+  check(NetCDF::defineCompression(m_handle, l_yVarId, 1, m_nxOut, m_nyOut, m_deflateLevel));
+  check(NetCDF::defineCompression(m_handle, m_timeId, 1, m_nxOut, m_nyOut, m_deflateLevel));
+  check(nc_put_att_text(m_handle, l_xVarId, "units", 1, "m"));
+  check(nc_put_att_text(m_handle, l_yVarId, "units", 1, "m"));
+  check(nc_put_att_text(m_handle, m_timeId, "units", 1, "s"));
+
+  int l_dims3[3] = { l_tDimId, l_yDimId, l_xDimId };// fastest dimensions are last
+  int l_dims2[2] = { l_yDimId, l_xDimId };
+  for(unsigned short l_qu = 0; l_qu < 3; l_qu++){
+    m_varIds[l_qu] = -1;
+    if(!(m_quantities & (1 << l_qu))) continue;
+    check(nc_def_var(m_handle, s_names[l_qu], NC_FLOAT, 3, l_dims3, &m_varIds[l_qu]));
+    if(l_qu == 0) check(nc_put_att_text(m_handle, m_varIds[l_qu], "units", 1, "m"))
+    else          check(nc_put_att_text(m_handle, m_varIds[l_qu], "units", 5, "m*m/s"))// height * velocity
+    check(NetCDF::defineCompression(m_handle, m_varIds[l_qu], 3, m_nxOut, m_nyOut, m_deflateLevel));
+    check(NetCDF::defineQuantization(m_handle, m_varIds[l_qu], l_qu));
+  }
+  int l_bathymetryId = -1, l_displacementId = -1;
+  if(m_quantities & (1 << 3)){
+    check(nc_def_var(m_handle, s_names[3], NC_FLOAT, 2, l_dims2, &l_bathymetryId));
+    check(nc_put_att_text(m_handle, l_bathymetryId, "units", 1, "m"));
+    check(NetCDF::defineCompression(m_handle, l_bathymetryId, 2, m_nxOut, m_nyOut, m_deflateLevel));
+  }
+  if(!m_displacement.empty()){
+    check(nc_def_var(m_handle, "displacement", NC_FLOAT, 2, l_dims2, &l_displacementId));
+    check(nc_put_att_text(m_handle, l_displacementId, "units", 1, "m"));
+    check(NetCDF::defineCompression(m_handle, l_displacementId, 2, m_nxOut, m_nyOut, m_deflateLevel));
+  }
+  check(nc_enddef(m_handle));
+
+  // like NetCDF::appendTimeframe(), the coordinates are the ones of the input files
+  std::vector<float> l_data(std::max(m_nxOut, m_nyOut));
+  for(t_idx l_ix = 0; l_ix < m_nxOut; l_ix++) l_data[l_ix] = (m_x0 + l_ix * m_step) * m_cellSizeMeters + m_gridOffsetX;
+  check(nc_put_var_float(m_handle, l_xVarId, l_data.data()));
+  for(t_idx l_iy = 0; l_iy < m_nyOut; l_iy++) l_data[l_iy] = (m_y0 + l_iy * m_step) * m_cellSizeMeters + m_gridOffsetY;
+  check(nc_put_var_float(m_handle, l_yVarId, l_data.data()));
+
+  if(l_bathymetryId >= 0){
+    stage(i_waveProp, 3, l_data);
+    check(nc_put_var_float(m_handle, l_bathymetryId, l_data.data()));
+  }
+  if(!m_displacement.empty()){
+    check(nc_put_var_float(m_handle, l_displacementId, m_displacement.data()));
+  }
+
+  m_timeIndex = 0;
+  return EXIT_SUCCESS;
+}
+
+void tsunami_lab::io::NetCDFWriter::sampleDisplacement( tsunami_lab::setups::Setup * i_setup ) {
+  if(i_setup == nullptr){
+    std::vector<float>().swap(m_displacement);
+    return;
+  }
+  // sampled at the first cell of each step x step block
+  t_real l_scaleX, l_scaleY;
+  i_setup->getInitScale(l_scaleX, l_scaleY);
+  m_displacement.resize(m_nxOut * m_nyOut);
+  #pragma omp parallel for
+  for(t_idx l_iy = 0; l_iy < m_nyOut; l_iy++){
+    t_real l_y = ((m_y0 + l_iy * m_step) + (t_real) 0.5) * l_scaleY;
+    for(t_idx l_ix = 0; l_ix < m_nxOut; l_ix++){
+      t_real l_x = ((m_x0 + l_ix * m_step) + (t_real) 0.5) * l_scaleX;
+      m_displacement[l_ix + l_iy * m_nxOut] = i_setup->getDisplacement(l_x, l_y);
+    }
+  }
+}
+
+int tsunami_lab::io::NetCDFWriter::open( t_real i_time ) {
+  int l_err = nc_open(m_fileName.c_str(), NC_WRITE, &m_handle);
+  if(l_err != NC_NOERR){
+    std::cerr << "NetCDF-Error occurred: " << nc_strerror(l_err) << " (Code " << l_err << "), opening " << m_fileName << std::endl;
+    m_handle = -1;
+    return -1;
+  }
+
+  int l_tDimId;
+  check(nc_inq_dimid(m_handle, "time", &l_tDimId));
+  check(nc_inq_varid(m_handle, "time", &m_timeId));
+  for(unsigned short l_qu = 0; l_qu < 3; l_qu++){
+    m_varIds[l_qu] = -1;
+    if(m_quantities & (1 << l_qu)) check(nc_inq_varid(m_handle, s_names[l_qu], &m_varIds[l_qu]));
+  }
+
+  // continue after the last frame, which is older than the new one
+  size_t l_nFrames;
+  check(nc_inq_dimlen(m_handle, l_tDimId, &l_nFrames));
+  std::vector<float> l_times(l_nFrames);
+  if(l_nFrames > 0) check(nc_get_var_float(m_handle, m_timeId, l_times.data()));
+  m_timeIndex = 0;
+  while(m_timeIndex < l_nFrames && l_times[m_timeIndex] < (float) i_time) m_timeIndex++;
+  if(m_timeIndex < l_nFrames){
+    std::cout << "  output: overwriting " << (l_nFrames - m_timeIndex) << " frames from t = " << l_times[m_timeIndex] << " s in " << m_fileName << std::endl;
+  }
+  return EXIT_SUCCESS;
+}
+
+int tsunami_lab::io::NetCDFWriter::write( Frame const & i_frame ) {
+  std::lock_guard<std::recursive_mutex> l_libraryLock(m_libraryMutex);
+  if(m_handle < 0){
+    int l_error = open(i_frame.time);
+    if(l_error) return l_error;
+  }
+
+  size_t l_timeIndex = m_timeIndex;
+  float  l_time = (float) i_frame.time;
+  check(nc_put_var1_float(m_handle, m_timeId, &l_timeIndex, &l_time));
+
+  size_t l_start[3] = { m_timeIndex, 0, 0 };
+  size_t l_count[3] = { 1, m_nyOut, m_nxOut };
+  for(unsigned short l_qu = 0; l_qu < 3; l_qu++){
+    if(m_varIds[l_qu] >= 0 && !i_frame.data[l_qu].empty()){
+      check(nc_put_vara_float(m_handle, m_varIds[l_qu], l_start, l_count, i_frame.data[l_qu].data()));
+    }
+  }
+  m_timeIndex++;
+  return EXIT_SUCCESS;
+}
+
+int tsunami_lab::io::NetCDFWriter::close() {
+  if(m_handle < 0) return EXIT_SUCCESS;
+  std::lock_guard<std::recursive_mutex> l_libraryLock(m_libraryMutex);
+  int l_err = nc_close(m_handle);
+  m_handle = -1;
+  return l_err;
+}
+
+void tsunami_lab::io::NetCDFWriter::stage( tsunami_lab::patches::WavePropagation * i_waveProp,
+                                           unsigned short                          i_quantity,
+                                           std::vector<float>                    & o_data ) const {
+  o_data.resize(m_nxOut * m_nyOut);
+  bool l_isDense = i_waveProp->hasDenseStorage();
+  t_real const * l_dataIn = nullptr;
+  if(l_isDense){
+    l_dataIn = i_quantity == 0 ? i_waveProp->getHeight() : i_quantity == 1 ? i_waveProp->getMomentumX() : i_quantity == 2 ? i_waveProp->getMomentumY() : i_waveProp->getBathymetry();
+  }
+  t_idx l_strideIn = i_waveProp->getStride();
+  // like NetCDF::appendTimeframe(), rows of patches skip the ghost cells in 2d only
+  t_idx l_offset = m_hasGhostCells ? 1 : 0;
+
+  #pragma omp parallel
+  {
+    std::vector<t_real> l_rows(l_isDense ? 0 : m_step * l_strideIn);
+    #pragma omp for
+    for(t_idx l_yOut = 0; l_yOut < m_nyOut; l_yOut++) {
+      const t_idx l_yIn0 = l_yOut * m_step;
+      const t_idx l_yIn1 = std::min(l_yIn0 + m_step, m_ny);
+      if(!l_isDense) {
+        for(t_idx l_yIn = l_yIn0; l_yIn < l_yIn1; l_yIn++) {
+          i_waveProp->getRow(i_quantity, m_y0 + l_yIn + l_offset, l_rows.data() + (l_yIn - l_yIn0) * l_strideIn);
+        }
+      }
+      t_real const * l_rowsIn = l_isDense ? l_dataIn + m_x0 + (m_y0 + l_yIn0) * l_strideIn : l_rows.data() + l_offset + m_x0;
+      for(t_idx l_xOut = 0; l_xOut < m_nxOut; l_xOut++) {
+        const t_idx l_xIn0 = l_xOut * m_step;
+        const t_idx l_xIn1 = std::min(l_xIn0 + m_step, m_nx);
+        t_real l_sum = 0;
+        for(t_idx l_yIn = 0; l_yIn < l_yIn1-l_yIn0; l_yIn++) {
+          t_idx l_indexIn = l_xIn0 + l_yIn * l_strideIn;
+          for(t_idx l_xIn = l_xIn0; l_xIn < l_xIn1; l_xIn++) {
+            l_sum += l_rowsIn[l_indexIn++];
+          }
+        }
+        o_data[l_xOut + l_yOut * m_nxOut] = l_sum / (t_real)((l_xIn1-l_xIn0)*(l_yIn1-l_yIn0));
+      }
+    }
+  }
+}
+
+bool tsunami_lab::io::NetCDFWriter::needsOutput( double i_time,
+                                                 bool   i_isFirstStep ) {
+  // if there are more frames requested than simulated, some are skipped
+  t_idx l_outputIndex = (t_idx) (i_time / m_period);
+  if(!i_isFirstStep && l_outputIndex == m_lastOutputIndex) return false;
+  m_lastOutputIndex = l_outputIndex;
+  return true;
+}
+
+int tsunami_lab::io::NetCDFWriter::append( tsunami_lab::patches::WavePropagation * i_waveProp,
+                                           t_real                                  i_time ) {
+
+  // the first frame creates the file, and writes the bathymetry and the displacement once;
+  // after a restart, streams, which were added to the config, start a new file
+  struct stat l_buffer;
+  if(i_time <= 0 || (m_nFrames == 0 && stat(m_fileName.c_str(), &l_buffer) != 0)) {
+    int l_error = flush();
+    if(l_error) return l_error;
+    close();
+    l_error = create(i_waveProp);
+    if(l_error) return l_error;
+  }
+
+  // back-pressure: wait for a free staging buffer
+  auto l_time0 = std::chrono::high_resolution_clock::now();
+  std::unique_lock<std::mutex> l_lock(m_mutex);
+  if(m_free.empty()) {
+    m_nStalls++;
+    m_freed.wait(l_lock, [this]{ return !m_free.empty(); });
+  }
+  if(m_error) return m_error;
+  t_idx l_fr = m_free.front();
+  m_free.pop_front();
+  l_lock.unlock();
+  auto l_time1 = std::chrono::high_resolution_clock::now();
+
+  Frame & l_frame = m_frames[l_fr];
+  l_frame.time = i_time;
+  double l_bytes = 0;
+  for(unsigned short l_qu = 0; l_qu < 3; l_qu++){
+    if(m_quantities & (1 << l_qu)) stage(i_waveProp, l_qu, l_frame.data[l_qu]);
+    else l_frame.data[l_qu].clear();
+    l_bytes += (double) sizeof(float) * l_frame.data[l_qu].size();
+  }
+  auto l_time2 = std::chrono::high_resolution_clock::now();
+
+  l_lock.lock();
+  m_nFrames++;
+  m_bytes += l_bytes;
+  m_stallTime += std::chrono::duration<double>(l_time1-l_time0).count();
+  m_copyTime  += std::chrono::duration<double>(l_time2-l_time1).count();
+  if(m_writer.joinable()){
+    m_queued.push_back(l_fr);
+    m_queuedSignal.notify_one();
+    return EXIT_SUCCESS;
+  }
+
+  // without a writer thread, the frame is written right away
+  int l_error = write(l_frame);
+  m_writeTime += std::chrono::duration<double>(std::chrono::high_resolution_clock::now()-l_time2).count();
+  m_free.push_back(l_fr);
+  if(l_error && !m_error) m_error = l_error;
+  return m_error;
+}
+
+int tsunami_lab::io::NetCDFWriter::flush() {
+  std::unique_lock<std::mutex> l_lock(m_mutex);
+  m_freed.wait(l_lock, [this]{ return m_queued.empty() && !m_writing; });
+  return m_error;
+}
+
+int tsunami_lab::io::NetCDFWriter::sync() {
+  int l_error = flush();
+  if(l_error || m_handle < 0) return l_error;
+  std::lock_guard<std::recursive_mutex> l_libraryLock(m_libraryMutex);
+  int l_err = nc_sync(m_handle);
+  if(l_err != NC_NOERR){
+    std::cerr << "NetCDF-Error occurred: " << nc_strerror(l_err) << " (Code " << l_err << "), syncing " << m_fileName << std::endl;
+    return -1;
+  }
+  return EXIT_SUCCESS;
+}
+
+void tsunami_lab::io::NetCDFWriter::printStatistics( std::ostream & io_stream ) {
+  std::unique_lock<std::mutex> l_lock(m_mutex);
+  io_stream << "output " << m_fileName << ": " << m_nFrames << " frames, " << m_frames.size() << " staging buffers of " << m_nxOut << " x " << m_nyOut << " cells" << std::endl;
+  io_stream << "  solver waited for the writer " << m_nStalls << " times, " << m_stallTime << " s; copying took " << m_copyTime << " s" << std::endl;
+  io_stream << "  writing: " << m_writeTime << " s, " << (m_writeTime > 0 ? m_bytes / m_writeTime * 1e-6 : 0) << " MB/s uncompressed" << std::endl;
+}
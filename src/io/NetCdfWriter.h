@@ -0,0 +1,300 @@
+/**
+ * @author Antonio Noack
+ *
+ * @section DESCRIPTION
+ * Output stream of time frames into a NetCDF file, which stays open for the whole run.
+ * A stream covers a rectangular region of the domain with its own downsampling step, period, quantities and compression.
+ * The solver copies (and downsamples) a frame into a staging buffer, and a writer thread compresses and writes it,
+ * while the time stepping continues. If all staging buffers are in use, the solver waits for the writer (back-pressure).
+ * The NetCDF calls of all streams are serialized by one lock, so several streams can be written at the same time.
+ * The file handle and the variable ids are kept, so a frame costs no open, lookup and close; sync() flushes the file at checkpoints.
+ **/
+#ifndef TSUNAMI_LAB_IO_NETCDF_WRITER_H
+#define TSUNAMI_LAB_IO_NETCDF_WRITER_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../constants.h"
+#include "../patches/WavePropagation.h"
+#include "../setups/Setup.h"
+
+namespace tsunami_lab {
+  namespace io {
+    class NetCDFWriter;
+  }
+}
+
+class tsunami_lab::io::NetCDFWriter {
+  public:
+    //! all quantities: bit i stands for quantity i of WavePropagation::getRow(), i.e. height, momentum x, momentum y, bathymetry
+    static unsigned short constexpr m_allQuantities = 15;
+
+  private:
+    //! downsampled copy of a frame
+    struct Frame {
+      //! heights, momenta in x and y direction; empty, if the quantity isn't written
+      std::vector<float> data[3];
+      //! simulation time in seconds
+      t_real time;
+    };
+
+    //! cell size in x- and y-direction
+    t_real m_cellSizeMeters;
+
+    //! first cell and number of cells of the region in x- and y-direction
+    t_idx m_x0, m_y0, m_nx, m_ny;
+
+    //! true, if the rows of the patches have ghost cells, which is the case in 2d
+    bool m_hasGhostCells;
+
+    //! coordinates in meters of the first cell of the domain
+    t_real m_gridOffsetX, m_gridOffsetY;
+
+    //! only every step-th cell is written, the others are averaged
+    t_idx m_step;
+
+    //! number of written cells in x- and y-direction
+    t_idx m_nxOut, m_nyOut;
+
+    //! written quantities, see m_allQuantities
+    unsigned short m_quantities;
+
+    //! compression level
+    int m_deflateLevel;
+
+    //! target file
+    std::string m_fileName;
+
+    //! a frame is written every m_period seconds of simulation time
+    t_real m_period = 1;
+
+    //! index of the last written period
+    t_idx m_lastOutputIndex = 0;
+
+    //! handle of the open file, -1 if it isn't open
+    int m_handle = -1;
+
+    //! ids of the time, height and momentum variables; -1 if a quantity isn't written
+    int m_timeId = 0, m_varIds[3] = { -1, -1, -1 };
+
+    //! index of the next frame on the time axis
+    t_idx m_timeIndex = 0;
+
+    //! staging buffers
+    std::vector<Frame> m_frames;
+
+    //! displacement at the resolution of the file, see sampleDisplacement(); empty, if it isn't written
+    std::vector<float> m_displacement;
+
+    //! ids of the staging buffers, which can be filled, and which wait for the writer
+    std::deque<t_idx> m_free, m_queued;
+
+    //! true, while the writer writes a frame
+    bool m_writing = false;
+
+    //! true, if the writer thread shall finish
+    bool m_stop = false;
+
+    //! first error of the writer thread, 0 if there was none
+    int m_error = 0;
+
+    //! statistics: number of frames, number of frames, which had to wait for a free staging buffer
+    t_idx m_nFrames = 0, m_nStalls = 0;
+
+    //! statistics: number of written bytes before compression
+    double m_bytes = 0;
+
+    //! statistics: time in seconds waiting for a free staging buffer, copying into the staging buffers, and writing in the writer thread
+    double m_stallTime = 0, m_copyTime = 0, m_writeTime = 0;
+
+    std::mutex m_mutex;
+
+    //! NetCDF and HDF5 aren't thread safe, so the calls of all writers and of the solver thread are serialized; recursive, because errors close the file
+    static std::recursive_mutex m_libraryMutex;
+
+    //! signals free staging buffers and finished writes to the solver, and queued frames to the writer
+    std::condition_variable m_freed, m_queuedSignal;
+
+    //! writer thread; not started without a queue
+    std::thread m_writer;
+
+    /**
+     * Loop of the writer thread.
+     **/
+    void run();
+
+    /**
+     * Creates the file, defines the variables, and writes the axes, the bathymetry and the sampled displacement.
+     *
+     * @param i_waveProp patch with the bathymetry.
+     * @return 0 if successful, -1 or error code else.
+     **/
+    int create( tsunami_lab::patches::WavePropagation * i_waveProp );
+
+    /**
+     * Opens the file, which was created by the first frame, or by a previous run, and looks up the variables.
+     * After a restart, the frames at and after i_time are overwritten, because the previous run may have written them after its last checkpoint.
+     *
+     * @param i_time time in seconds of the first frame, which will be written.
+     * @return 0 if successful, -1 or error code else.
+     **/
+    int open( t_real i_time );
+
+    /**
+     * Writes a staged frame at the next index on the time axis; opens the file if necessary.
+     *
+     * @param i_frame staged frame.
+     * @return 0 if successful, -1 or error code else.
+     **/
+    int write( Frame const & i_frame );
+
+    /**
+     * Closes the file, if it is open.
+     *
+     * @return 0 if successful, error code else.
+     **/
+    int close();
+
+    /**
+     * Copies a quantity of the region of a patch into a staging buffer, averaging step x step cells.
+     *
+     * @param i_waveProp patch.
+     * @param i_quantity 0 = height, 1 = momentum x, 2 = momentum y, 3 = bathymetry.
+     * @param o_data buffer for m_nxOut x m_nyOut values.
+     **/
+    void stage( tsunami_lab::patches::WavePropagation * i_waveProp,
+                unsigned short                          i_quantity,
+                std::vector<float>                    & o_data ) const;
+
+  public:
+    /**
+     * Starts the writer thread for a stream of the whole domain with all quantities.
+     *
+     * @param i_cellSizeMeters cell size in x- and y-direction.
+     * @param i_nx number of cells in x-direction.
+     * @param i_ny number of cells in y-direction.
+     * @param i_gridOffsetX x-coordinate in meters of first cell, excluding the ghost cells.
+     * @param i_gridOffsetY y-coordinate in meters of first cell, excluding the ghost cells.
+     * @param i_step only every step-th cell is written.
+     * @param i_deflateLevel compression level, 0 = large/fastest, 9 = compact/slowest.
+     * @param i_fileName target file.
+     * @param i_queueDepth number of staging buffers; 0 writes synchronously without a writer thread.
+     **/
+    NetCDFWriter( t_real      i_cellSizeMeters,
+                  t_idx       i_nx,
+                  t_idx       i_ny,
+                  t_real      i_gridOffsetX,
+                  t_real      i_gridOffsetY,
+                  t_idx       i_step,
+                  int         i_deflateLevel,
+                  std::string i_fileName,
+                  t_idx       i_queueDepth );
+
+    /**
+     * Starts the writer thread for a stream of a region. The file is created by the first frame at time 0, or opened by the first frame after a restart.
+     *
+     * @param i_cellSizeMeters cell size in x- and y-direction.
+     * @param i_nx number of cells of the domain in x-direction.
+     * @param i_ny number of cells of the domain in y-direction.
+     * @param i_gridOffsetX x-coordinate in meters of first cell of the domain, excluding the ghost cells.
+     * @param i_gridOffsetY y-coordinate in meters of first cell of the domain, excluding the ghost cells.
+     * @param i_x0 first cell of the region in x-direction.
+     * @param i_y0 first cell of the region in y-direction.
+     * @param i_x1 end (exclusive) of the region in x-direction; clamped to the domain.
+     * @param i_y1 end (exclusive) of the region in y-direction; clamped to the domain.
+     * @param i_step only every step-th cell is written.
+     * @param i_quantities written quantities, see m_allQuantities.
+     * @param i_deflateLevel compression level, 0 = large/fastest, 9 = compact/slowest.
+     * @param i_fileName target file.
+     * @param i_queueDepth number of staging buffers; 0 writes synchronously without a writer thread.
+     **/
+    NetCDFWriter( t_real         i_cellSizeMeters,
+                  t_idx          i_nx,
+                  t_idx          i_ny,
+                  t_real         i_gridOffsetX,
+                  t_real         i_gridOffsetY,
+                  t_idx          i_x0,
+                  t_idx          i_y0,
+                  t_idx          i_x1,
+                  t_idx          i_y1,
+                  t_idx          i_step,
+                  unsigned short i_quantities,
+                  int            i_deflateLevel,
+                  std::string    i_fileName,
+                  t_idx          i_queueDepth );
+
+    /**
+     * Writes the queued frames, stops the writer thread, and closes the file.
+     **/
+    ~NetCDFWriter();
+
+    /**
+     * Sets the period of the stream.
+     *
+     * @param i_period a frame is written every i_period seconds of simulation time.
+     **/
+    void setPeriod( t_real i_period ) {
+      m_period = i_period;
+    }
+
+    /**
+     * Samples the displacement at the resolution of the file, so the setup can be freed before the time loop;
+     * the file, which is created by the first frame, contains it.
+     *
+     * @param i_setup setup, which initialized the patch; nullptr to skip the displacement.
+     **/
+    void sampleDisplacement( tsunami_lab::setups::Setup * i_setup );
+
+    /**
+     * Checks whether a frame is due, because a new period has begun.
+     *
+     * @param i_time current simulation time in seconds.
+     * @param i_isFirstStep true in the first time step, which is always written.
+     * @return true, if a frame shall be appended.
+     **/
+    bool needsOutput( double i_time,
+                      bool   i_isFirstStep );
+
+    /**
+     * Appends the state of a patch as a time frame.
+     * The first frame (time <= 0), or the first frame of a file, which doesn't exist yet, creates the file synchronously;
+     * later frames are copied into a staging buffer and written by the writer thread.
+     * Frames must be appended in increasing time.
+     * Blocks, while all staging buffers are in use.
+     *
+     * @param i_waveProp patch with height, momenta and bathymetry; it may change after the call.
+     * @param i_time time in seconds of the frame.
+     * @return 0 if the frame was queued or written, and all previous frames were written successfully, -1 or error code else.
+     **/
+    int append( tsunami_lab::patches::WavePropagation * i_waveProp,
+                t_real                                  i_time );
+
+    /**
+     * Waits until all queued frames are written, e.g. before the NetCDF library is used by another thread; the file stays open.
+     *
+     * @return 0 if all frames were written successfully, -1 or error code else.
+     **/
+    int flush();
+
+    /**
+     * Writes the queued frames, and flushes the file to disk, e.g. at a checkpoint, so a restart finds all frames until then.
+     *
+     * @return 0 if successful, -1 or error code else.
+     **/
+    int sync();
+
+    /**
+     * Prints the number of frames and how long the solver and the writer spent on the output.
+     *
+     * @param io_stream stream, where the statistics are written to.
+     **/
+    void printStatistics( std::ostream & io_stream );
+};
+
+#endif
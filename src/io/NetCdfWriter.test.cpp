@@ -0,0 +1,277 @@
+/**
+ * @author Antonio Noack
+ *
+ * @section DESCRIPTION
+ * Unit tests for the asynchronous NetCDF writer.
+ **/
+#include <catch2/catch.hpp>
+#include "../constants.h"
+#include "../patches/WavePropagation2d.h"
+#include "../patches/WavePropagation2dSparse.h"
+#include "../setups/DamBreak2d.h"
+#include "../setups/TsunamiEvent2d.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+#include <netcdf.h>
+
+#include "NetCdf.h"
+#include "NetCdfWriter.h"
+
+#define t_idx  tsunami_lab::t_idx
+#define t_real tsunami_lab::t_real
+
+/**
+ * Reads a float variable of a NetCDF file completely.
+ *
+ * @param i_fileName NetCDF file.
+ * @param i_variableName name of the variable.
+ * @return values of the variable.
+ **/
+static std::vector<float> readVariable( std::string i_fileName,
+                                        std::string i_variableName ) {
+  int l_handle, l_varId, l_nDims, l_dimIds[NC_MAX_VAR_DIMS];
+  REQUIRE( nc_open( i_fileName.c_str(), NC_NOWRITE, &l_handle ) == NC_NOERR );
+  REQUIRE( nc_inq_varid( l_handle, i_variableName.c_str(), &l_varId ) == NC_NOERR );
+  REQUIRE( nc_inq_var( l_handle, l_varId, nullptr, nullptr, &l_nDims, l_dimIds, nullptr ) == NC_NOERR );
+  size_t l_size = 1;
+  for( int l_di = 0; l_di < l_nDims; l_di++ ) {
+    size_t l_length;
+    REQUIRE( nc_inq_dimlen( l_handle, l_dimIds[l_di], &l_length ) == NC_NOERR );
+    l_size *= l_length;
+  }
+  std::vector<float> l_data( l_size );
+  REQUIRE( nc_get_var_float( l_handle, l_varId, l_data.data() ) == NC_NOERR );
+  nc_close( l_handle );
+  return l_data;
+}
+
+TEST_CASE( "Test that the asynchronous NetCDF-writer writes the same frames as the synchronous one.", "[NetCDFWriter]" ) {
+
+  t_idx l_nx = 13, l_ny = 10, l_step = 3, l_nt = 6;
+  tsunami_lab::setups::DamBreak2d l_setup( 10, 5, 6, 4, 3, -10 );
+
+  // the sparse patch has no dense storage, so its frames are staged row by row
+  tsunami_lab::patches::WavePropagation2d       l_dense ( l_nx, l_ny, &l_setup, 1, 1 );
+  tsunami_lab::patches::WavePropagation2dSparse l_sparse( l_nx, l_ny, &l_setup, 1, 1, 4 );
+
+  std::string l_syncFile = "tmp-sync.nc", l_asyncFile = "tmp-async.nc";
+  std::remove( l_asyncFile.c_str() );
+
+  // HDF5 isn't thread safe, so the synchronous file is written after the writer has finished
+  {
+    // a single staging buffer, such that the solver has to wait for the writer
+    tsunami_lab::io::NetCDFWriter l_writer( 2, l_nx, l_ny, 1, 1, l_step, 1, l_asyncFile, 1 );
+    for( t_idx l_fr = 0; l_fr < l_nt; l_fr++ ) {
+      REQUIRE( l_writer.append( &l_sparse, (t_real) l_fr ) == 0 );
+
+      // the staged copy must be independent of the patch
+      l_sparse.setGhostOutflow();
+      l_sparse.timeStep( 0.05 );
+    }
+    REQUIRE( l_writer.flush() == 0 );
+  }
+
+  for( t_idx l_fr = 0; l_fr < l_nt; l_fr++ ) {
+    REQUIRE( tsunami_lab::io::NetCDF::appendTimeframe( 2, l_nx, l_ny, 1, 1, l_step, &l_dense, nullptr, (t_real) l_fr, 1, l_syncFile ) == 0 );
+    l_dense.setGhostOutflow();
+    l_dense.timeStep( 0.05 );
+  }
+
+  std::vector<std::string> l_variables = { "x", "y", "time", "height", "momentumX", "momentumY", "bathymetry" };
+  for( std::string const & l_variable : l_variables ) {
+    std::vector<float> l_sync  = readVariable( l_syncFile,  l_variable );
+    std::vector<float> l_async = readVariable( l_asyncFile, l_variable );
+    REQUIRE( l_sync.size() == l_async.size() );
+    for( t_idx l_i = 0; l_i < l_sync.size(); l_i++ ) {
+      REQUIRE( l_async[l_i] == Approx( l_sync[l_i] ) );
+    }
+  }
+  REQUIRE( readVariable( l_asyncFile, "time" ).size() == l_nt );
+  REQUIRE( readVariable( l_asyncFile, "height" ).size() == l_nt * 5 * 4 );
+
+  std::remove( l_syncFile.c_str() );
+  std::remove( l_asyncFile.c_str() );
+}
+
+TEST_CASE( "Test that the NetCDF-writer continues a file after a restart.", "[NetCDFWriter]" ) {
+
+  t_idx l_nx = 8, l_ny = 6;
+  tsunami_lab::setups::DamBreak2d l_setup( 10, 5, 4, 3, 2, -10 );
+  tsunami_lab::patches::WavePropagation2d l_waveProp( l_nx, l_ny, &l_setup, 1, 1 );
+
+  std::string l_fileName = "tmp-restart.nc";
+  {
+    // synchronous writer
+    tsunami_lab::io::NetCDFWriter l_writer( 1, l_nx, l_ny, 0, 0, 1, 1, l_fileName, 0 );
+    for( t_idx l_fr = 0; l_fr < 4; l_fr++ ) {
+      REQUIRE( l_writer.append( &l_waveProp, (t_real) l_fr ) == 0 );
+      REQUIRE( l_writer.sync() == 0 );
+      l_waveProp.setGhostOutflow();
+      l_waveProp.timeStep( 0.1 );
+    }
+  }
+
+  // the restarted run continues at t = 2, e.g. from a checkpoint, which is older than the last frame
+  tsunami_lab::patches::WavePropagation2d l_restarted( l_nx, l_ny, &l_setup, 1, 1 );
+  {
+    tsunami_lab::io::NetCDFWriter l_writer( 1, l_nx, l_ny, 0, 0, 1, 1, l_fileName, 2 );
+    REQUIRE( l_writer.append( &l_restarted, 2 ) == 0 );
+    REQUIRE( l_writer.append( &l_restarted, 3 ) == 0 );
+  }
+
+  std::vector<float> l_time = readVariable( l_fileName, "time" );
+  REQUIRE( l_time.size() == 4 );
+  for( t_idx l_fr = 0; l_fr < 4; l_fr++ ) REQUIRE( l_time[l_fr] == l_fr );
+
+  // the frames at t = 2 and t = 3 were overwritten with the initial state
+  std::vector<float> l_height = readVariable( l_fileName, "height" );
+  t_idx l_frameSize = l_nx * l_ny;
+  bool l_hasChanged = false;
+  for( t_idx l_i = 0; l_i < l_frameSize; l_i++ ) {
+    REQUIRE( l_height[2 * l_frameSize + l_i] == l_height[l_i] );
+    REQUIRE( l_height[3 * l_frameSize + l_i] == l_height[l_i] );
+    l_hasChanged |= l_height[l_frameSize + l_i] != l_height[l_i];
+  }
+  REQUIRE( l_hasChanged );
+
+  std::remove( l_fileName.c_str() );
+}
+
+TEST_CASE( "Test that the NetCDF-writer writes a region of interest with selected variables.", "[NetCDFWriter]" ) {
+
+  t_idx l_nx = 12, l_ny = 9, l_step = 2;
+  t_idx l_x0 = 3, l_y0 = 1, l_x1 = 8, l_y1 = 20;// the end in y-direction is clamped to the domain
+  tsunami_lab::setups::DamBreak2d l_setup( 10, 5, 5, 4, 3, -10 );
+  tsunami_lab::patches::WavePropagation2d l_waveProp( l_nx, l_ny, &l_setup, 1, 1 );
+  for( t_idx l_it = 0; l_it < 3; l_it++ ) {
+    l_waveProp.setGhostOutflow();
+    l_waveProp.timeStep( 0.1 );
+  }
+
+  std::string l_fileName = "tmp-region.nc";
+  {
+    unsigned short l_quantities = 1 << 0;// height only
+    tsunami_lab::io::NetCDFWriter l_writer( 2, l_nx, l_ny, 10, 20, l_x0, l_y0, l_x1, l_y1, l_step, l_quantities, 1, l_fileName, 1 );
+    l_writer.setPeriod( 5 );
+    REQUIRE(  l_writer.needsOutput( 0, true ) );
+    REQUIRE( l_writer.append( &l_waveProp, 0 ) == 0 );
+    REQUIRE( !l_writer.needsOutput( 4.9, false ) );
+    REQUIRE(  l_writer.needsOutput( 5.1, false ) );
+    REQUIRE( l_writer.append( &l_waveProp, 5.1 ) == 0 );
+  }
+
+  // 5 x 8 cells of the region are averaged in blocks of 2 x 2
+  t_idx l_nxOut = 3, l_nyOut = 4;
+  std::vector<float> l_x = readVariable( l_fileName, "x" );
+  std::vector<float> l_y = readVariable( l_fileName, "y" );
+  REQUIRE( l_x.size() == l_nxOut );
+  REQUIRE( l_y.size() == l_nyOut );
+  for( t_idx l_ix = 0; l_ix < l_nxOut; l_ix++ ) REQUIRE( l_x[l_ix] == Approx( (l_x0 + l_ix * l_step) * 2 + 10 ) );
+  for( t_idx l_iy = 0; l_iy < l_nyOut; l_iy++ ) REQUIRE( l_y[l_iy] == Approx( (l_y0 + l_iy * l_step) * 2 + 20 ) );
+
+  std::vector<float> l_height = readVariable( l_fileName, "height" );
+  REQUIRE( l_height.size() == 2 * l_nxOut * l_nyOut );
+  for( t_idx l_yOut = 0; l_yOut < l_nyOut; l_yOut++ ) {
+    for( t_idx l_xOut = 0; l_xOut < l_nxOut; l_xOut++ ) {
+      t_real l_sum = 0;
+      t_idx  l_count = 0;
+      for( t_idx l_y = l_y0 + l_yOut * l_step; l_y < std::min( l_y0 + (l_yOut+1) * l_step, l_ny ); l_y++ ) {
+        for( t_idx l_x = l_x0 + l_xOut * l_step; l_x < std::min( l_x0 + (l_xOut+1) * l_step, l_x1 ); l_x++ ) {
+          t_real l_h, l_hu, l_hv;
+          l_waveProp.getCellState( l_x, l_y, l_h, l_hu, l_hv );
+          l_sum += l_h;
+          l_count++;
+        }
+      }
+      REQUIRE( l_height[l_xOut + l_yOut * l_nxOut] == Approx( l_sum / l_count ) );
+      REQUIRE( l_height[l_nxOut * l_nyOut + l_xOut + l_yOut * l_nxOut] == Approx( l_sum / l_count ) );
+    }
+  }
+
+  // the other quantities aren't written
+  int l_handle, l_varId;
+  REQUIRE( nc_open( l_fileName.c_str(), NC_NOWRITE, &l_handle ) == NC_NOERR );
+  REQUIRE( nc_inq_varid( l_handle, "momentumX",  &l_varId ) != NC_NOERR );
+  REQUIRE( nc_inq_varid( l_handle, "momentumY",  &l_varId ) != NC_NOERR );
+  REQUIRE( nc_inq_varid( l_handle, "bathymetry", &l_varId ) != NC_NOERR );
+  nc_close( l_handle );
+
+  std::remove( l_fileName.c_str() );
+}
+
+TEST_CASE( "Test that the NetCDF-writer keeps the displacement after the setup was freed.", "[NetCDFWriter]" ) {
+
+  t_idx l_nx = 8, l_ny = 6, l_step = 2;
+  t_idx l_nxOut = 4, l_nyOut = 3;
+  std::string l_fileName = "tmp-displacement.nc";
+  std::vector<float> l_expected( l_nxOut * l_nyOut );
+  {
+    tsunami_lab::io::NetCDFWriter l_writer( 1, l_nx, l_ny, 0, 0, l_step, 1, l_fileName, 1 );
+    tsunami_lab::patches::WavePropagation2d* l_waveProp;
+    {
+      std::vector<t_real> l_bath( 10 * 8, -100 ), l_disp( 10 * 8 );
+      for( t_idx l_ce = 0; l_ce < l_disp.size(); l_ce++ ) l_disp[l_ce] = (t_real) ( l_ce % 7 ) - 3;
+      auto l_setup = new tsunami_lab::setups::TsunamiEvent2d( l_bath.data(), 10, 8, 10, 1, l_disp.data(), 10, 8, 10, 1 );
+      l_waveProp = new tsunami_lab::patches::WavePropagation2d( l_nx, l_ny, l_setup, 1, 1 );
+      l_writer.sampleDisplacement( l_setup );
+      for( t_idx l_iy = 0; l_iy < l_nyOut; l_iy++ ) {
+        for( t_idx l_ix = 0; l_ix < l_nxOut; l_ix++ ) {
+          l_expected[l_ix + l_iy * l_nxOut] = l_setup->getDisplacement( l_ix * l_step + (t_real) 0.5, l_iy * l_step + (t_real) 0.5 );
+        }
+      }
+      // the inputs and the setup are freed before the first frame
+      delete l_setup;
+    }
+    REQUIRE( l_writer.append( l_waveProp, 0 ) == 0 );
+    REQUIRE( l_writer.sync() == 0 );
+    delete l_waveProp;
+  }
+
+  std::vector<float> l_displacement = readVariable( l_fileName, "displacement" );
+  REQUIRE( l_displacement == l_expected );
+  bool l_hasDisplacement = false;
+  for( float l_value : l_displacement ) l_hasDisplacement |= l_value != 0;
+  REQUIRE( l_hasDisplacement );
+
+  std::remove( l_fileName.c_str() );
+}
+
+TEST_CASE( "Test that several NetCDF-writers with writer threads write at the same time.", "[NetCDFWriter]" ) {
+
+  t_idx l_nx = 400, l_ny = 400, l_nt = 20, l_nStreams = 3;
+  tsunami_lab::setups::DamBreak2d l_setup( 100, 5, 6, 60, 40, -10 );
+  tsunami_lab::patches::WavePropagation2d l_waveProp( l_nx, l_ny, &l_setup, 1, 1 );
+
+  // the later streams are created by the solver thread, while the writer threads of the earlier ones write
+  std::vector<std::string> l_fileNames;
+  {
+    std::vector<std::unique_ptr<tsunami_lab::io::NetCDFWriter>> l_writers;
+    for( t_idx l_st = 0; l_st < l_nStreams; l_st++ ) {
+      l_fileNames.push_back( "tmp-threaded-" + std::to_string( l_st ) + ".nc" );
+      l_writers.emplace_back( new tsunami_lab::io::NetCDFWriter( 1, l_nx, l_ny, 0, 0, 1, 1, l_fileNames.back(), 2 ) );
+    }
+    for( t_idx l_fr = 0; l_fr < l_nt; l_fr++ ) {
+      for( t_idx l_st = 0; l_st < l_nStreams && l_st <= l_fr; l_st++ ) {
+        REQUIRE( l_writers[l_st]->append( &l_waveProp, (t_real) (l_fr - l_st) ) == 0 );
+      }
+      l_waveProp.setGhostOutflow();
+      l_waveProp.timeStep( 0.01 );
+    }
+    for( auto & l_writer : l_writers ) REQUIRE( l_writer->sync() == 0 );
+  }
+
+  // stream l_st starts l_st frames later
+  std::vector<float> l_height0 = readVariable( l_fileNames[0], "height" );
+  REQUIRE( l_height0.size() == l_nt * l_nx * l_ny );
+  for( t_idx l_st = 1; l_st < l_nStreams; l_st++ ) {
+    std::vector<float> l_height = readVariable( l_fileNames[l_st], "height" );
+    REQUIRE( l_height.size() == (l_nt - l_st) * l_nx * l_ny );
+    REQUIRE( std::equal( l_height.begin(), l_height.end(), l_height0.begin() + l_st * l_nx * l_ny ) );
+    REQUIRE( readVariable( l_fileNames[l_st], "time" ).size() == l_nt - l_st );
+  }
+  for( std::string const & l_fileName : l_fileNames ) std::remove( l_fileName.c_str() );
+}
@@ -0,0 +1,463 @@
+/**
+ * @author Antonio Noack
+ *
+ * @section DESCRIPTION
+ * Checkpoints as raw arrays in the in-memory layout of the patches.
+ **/
+#include "RawCheckpoint.h"
+
+#include <algorithm> // std::min
+#include <cstddef> // offsetof
+#include <cstdio> // std::rename
+#include <cstring> // memcpy
+#include <iostream> // std::cerr
+#include <memory> // std::unique_ptr
+#include <fcntl.h> // open
+#include <unistd.h> // pread, pwrite
+
+static_assert(sizeof(tsunami_lab::t_real) % 4 == 0, "the checksums need whole 32 bit words");
+
+namespace {
+  char const c_magic[8] = { 'T', 'S', 'U', 'N', 'R', 'A', 'W', 0 };
+  uint32_t const c_version = 2;
+  // the stations are the last section
+  unsigned short const c_stationSection = tsunami_lab::io::RawCheckpoint::m_nSections - 1;
+
+  uint64_t roundToPages( uint64_t i_size ){
+    uint64_t l_pageSize = tsunami_lab::io::RawCheckpoint::m_pageSize;
+    return (i_size + l_pageSize - 1) / l_pageSize * l_pageSize;
+  }
+}
+
+uint64_t tsunami_lab::io::RawCheckpoint::checksum( Header const & i_header ) {
+  // same sums as transfer(), but serially, because the header is small
+  char const * l_data = reinterpret_cast<char const*>(&i_header);
+  uint64_t l_nWords = offsetof(Header, headerChecksum) / 4;
+  uint64_t l_sum1 = 0, l_sum2 = 0;
+  for(uint64_t l_wo = 0; l_wo < l_nWords; l_wo++){
+    uint32_t l_word;
+    memcpy(&l_word, l_data + l_wo * 4, 4);
+    l_sum1 += l_word;
+    l_sum2 += (l_wo + 1) * l_word;
+  }
+  return l_sum1 * 0x9E3779B97F4A7C15ull + l_sum2;
+}
+
+int tsunami_lab::io::RawCheckpoint::transfer( int        i_fd,
+                                              bool       i_write,
+                                              uint64_t   i_offset,
+                                              uint64_t   i_size,
+                                              char     * io_data,
+                                              uint64_t & o_checksum ) {
+  // chunks of 16 MiB are large enough for the disk, and small enough to balance the threads
+  uint64_t l_chunkSize = 1 << 24;
+  uint64_t l_nChunks = (i_size + l_chunkSize - 1) / l_chunkSize;
+  // Fletcher-like sums over 32 bit words; the weights detect swapped words
+  uint64_t l_sum1 = 0, l_sum2 = 0;
+  int l_failed = 0;
+  #pragma omp parallel for schedule(dynamic) reduction(+:l_sum1,l_sum2) reduction(|:l_failed)
+  for(uint64_t l_ch = 0; l_ch < l_nChunks; l_ch++){
+    uint64_t l_begin = l_ch * l_chunkSize;
+    uint64_t l_end   = std::min(l_begin + l_chunkSize, i_size);
+    for(uint64_t l_done = l_begin; l_done < l_end;){
+      ssize_t l_n = i_write ? pwrite(i_fd, io_data + l_done, l_end - l_done, i_offset + l_done)
+                            : pread (i_fd, io_data + l_done, l_end - l_done, i_offset + l_done);
+      if(l_n <= 0){// 0 = end of a truncated file
+        l_failed = 1;
+        break;
+      }
+      l_done += l_n;
+    }
+    for(uint64_t l_wo = l_begin / 4; l_wo < l_end / 4; l_wo++){
+      uint32_t l_word;
+      memcpy(&l_word, io_data + l_wo * 4, 4);
+      l_sum1 += l_word;
+      l_sum2 += (l_wo + 1) * l_word;
+    }
+  }
+  o_checksum = l_sum1 * 0x9E3779B97F4A7C15ull + l_sum2;
+  return l_failed ? -1 : 0;
+}
+
+int tsunami_lab::io::RawCheckpoint::readHeader( int      i_fd,
+                                                Header & o_header ) {
+  if(pread(i_fd, &o_header, sizeof(Header), 0) != (ssize_t) sizeof(Header) || memcmp(o_header.magic, c_magic, sizeof(c_magic)) != 0){
+    std::cerr << "Not a raw checkpoint" << std::endl;
+    return -1;
+  }
+  if(o_header.version != c_version || o_header.realSize != sizeof(t_real)){
+    std::cerr << "Raw checkpoint has version " << o_header.version << " with " << o_header.realSize << " byte values, expected version "
+              << c_version << " with " << sizeof(t_real) << " byte values" << std::endl;
+    return -1;
+  }
+  if(o_header.headerChecksum != checksum(o_header)){
+    std::cerr << "Header of the raw checkpoint is damaged" << std::endl;
+    return -1;
+  }
+  return 0;
+}
+
+bool tsunami_lab::io::RawCheckpoint::isRawCheckpoint( std::string const & i_fileName ) {
+  int l_fd = open(i_fileName.c_str(), O_RDONLY);
+  if(l_fd < 0) return false;
+  char l_magic[sizeof(c_magic)];
+  bool l_isRaw = pread(l_fd, l_magic, sizeof(l_magic), 0) == (ssize_t) sizeof(l_magic) && memcmp(l_magic, c_magic, sizeof(c_magic)) == 0;
+  close(l_fd);
+  return l_isRaw;
+}
+
+bool tsunami_lab::io::RawCheckpoint::isSupported( tsunami_lab::patches::WavePropagation * i_waveProp ) {
+  t_real * l_arrays[4];
+  return i_waveProp->getRawStorage(l_arrays) > 0;
+}
+
+std::string tsunami_lab::io::RawCheckpoint::deltaFileName( std::string const & i_fileName,
+                                                           uint64_t            i_index ) {
+  return i_fileName + ".delta" + std::to_string(i_index);
+}
+
+int tsunami_lab::io::RawCheckpoint::readChain( std::string const        & i_fileName,
+                                               std::vector<std::string> & o_files,
+                                               std::vector<Header>      & o_headers ) {
+  o_files.clear();
+  o_headers.clear();
+  for(uint64_t l_de = 0;; l_de++){
+    std::string l_fileName = l_de == 0 ? i_fileName : deltaFileName(i_fileName, l_de);
+    int l_fd = open(l_fileName.c_str(), O_RDONLY);
+    if(l_fd < 0) return l_de == 0 ? -1 : 0;
+    Header l_header;
+    int l_err = readHeader(l_fd, l_header);
+    close(l_fd);
+    if(l_de == 0){
+      if(l_err) return -1;
+      if(l_header.deltaIndex != 0){
+        std::cerr << l_fileName << " is a delta, the chain starts with its full checkpoint" << std::endl;
+        return -1;
+      }
+    } else {
+      if(l_err) std::cerr << "Ignoring " << l_fileName << " and the deltas after it" << std::endl;
+      // e.g. left over from the previous chain; a full checkpoint without chain has no id
+      if(l_err || o_headers[0].baseId == 0 || l_header.baseId != o_headers[0].baseId || l_header.deltaIndex != l_de ||
+         l_header.nValues != o_headers[0].nValues || l_header.nx != o_headers[0].nx || l_header.ny != o_headers[0].ny) return 0;
+    }
+    o_files.push_back(l_fileName);
+    o_headers.push_back(l_header);
+  }
+}
+
+int tsunami_lab::io::RawCheckpoint::loadArrays( std::vector<std::string> const &       i_files,
+                                                std::vector<Header>      const &       i_headers,
+                                                unsigned short                         i_first,
+                                                unsigned short                         i_count,
+                                                char                           * const * i_data,
+                                                uint64_t                               i_size ) {
+  uint64_t l_nValues = i_size / sizeof(t_real);
+  for(size_t l_fi = 0; l_fi < i_files.size(); l_fi++){
+    Header const & l_header = i_headers[l_fi];
+    int l_fd = open(i_files[l_fi].c_str(), O_RDONLY);
+    if(l_fd < 0) return -1;
+    bool l_valid = true;
+    for(unsigned short l_se = i_first; l_se < i_first + i_count && l_valid; l_se++){
+      char * l_data = i_data[l_se - i_first];
+      if(l_data == nullptr) continue;
+      uint64_t l_checksum = 0;
+      if(l_fi == 0){
+        l_valid = l_header.sizes[l_se] == i_size &&
+                  !transfer(l_fd, false, l_header.offsets[l_se], i_size, l_data, l_checksum) &&
+                  l_checksum == l_header.checksums[l_se];
+      } else if(l_header.sizes[l_se] > 0){// else unchanged
+        // the number of blocks, their ids, and their values
+        uint64_t l_size = l_header.sizes[l_se];
+        std::unique_ptr<char[]> l_buffer(new char[l_size]);
+        l_valid = !transfer(l_fd, false, l_header.offsets[l_se], l_size, l_buffer.get(), l_checksum) &&
+                  l_checksum == l_header.checksums[l_se] && l_size >= sizeof(uint64_t) && l_header.blockValues > 0;
+        uint64_t l_nBlocks = 0;
+        if(l_valid) memcpy(&l_nBlocks, l_buffer.get(), sizeof(uint64_t));
+        l_valid = l_valid && l_nBlocks < l_size / sizeof(uint64_t);
+        uint64_t l_position = (1 + l_nBlocks) * sizeof(uint64_t);
+        for(uint64_t l_bl = 0; l_bl < l_nBlocks && l_valid; l_bl++){
+          uint64_t l_id;
+          memcpy(&l_id, l_buffer.get() + (1 + l_bl) * sizeof(uint64_t), sizeof(uint64_t));
+          l_valid = l_nValues > 0 && l_id <= (l_nValues - 1) / l_header.blockValues;
+          if(!l_valid) break;
+          uint64_t l_begin = l_id * l_header.blockValues;
+          uint64_t l_bytes = std::min<uint64_t>(l_header.blockValues, l_nValues - l_begin) * sizeof(t_real);
+          l_valid = l_position + l_bytes <= l_size;
+          if(l_valid) memcpy(l_data + l_begin * sizeof(t_real), l_buffer.get() + l_position, l_bytes);
+          l_position += l_bytes;
+        }
+        l_valid = l_valid && l_position == l_size;
+      }
+      if(!l_valid) std::cerr << "Section " << l_se << " of " << i_files[l_fi] << " is missing or damaged" << std::endl;
+    }
+    close(l_fd);
+    if(!l_valid) return -1;
+  }
+  return 0;
+}
+
+int tsunami_lab::io::RawCheckpoint::store( std::string                             i_fileName,
+                                           t_idx                                   i_nx,
+                                           t_idx                                   i_ny,
+                                           t_real                                  i_cellSizeMeters,
+                                           t_real                                  i_cflFactor,
+                                           double                                  i_simulationTime,
+                                           t_idx                                   i_timeStepIndex,
+                                           std::vector<tsunami_lab::io::Station> & i_stations,
+                                           tsunami_lab::patches::WavePropagation * i_waveProp,
+                                           tsunami_lab::io::Aggregates     const * i_aggregates,
+                                           Delta                           const * i_delta ) {
+  static_assert(sizeof(Header) <= m_pageSize, "the header must fit into the first page");
+
+  t_real * l_arrays[4];
+  t_idx l_nValues = i_waveProp->getRawStorage(l_arrays);
+  if(l_nValues == 0){
+    std::cerr << "The patch doesn't support raw checkpoints" << std::endl;
+    return -1;
+  }
+
+  Header l_header;
+  memset(&l_header, 0, sizeof(Header));
+  memcpy(l_header.magic, c_magic, sizeof(c_magic));
+  l_header.version        = c_version;
+  l_header.realSize       = sizeof(t_real);
+  l_header.nx             = i_nx;
+  l_header.ny             = i_ny;
+  l_header.nValues        = l_nValues;
+  l_header.cellSizeMeters = i_cellSizeMeters;
+  l_header.cflFactor      = i_cflFactor;
+  l_header.simulationTime = i_simulationTime;
+  l_header.timeStepIndex  = i_timeStepIndex;
+  l_header.nStations      = i_stations.size();
+  if(i_delta){
+    l_header.baseId      = i_delta->baseId;
+    l_header.deltaIndex  = i_delta->index;
+    l_header.blockValues = i_delta->blockValues;
+  }
+
+  // the stations are small, so they are serialized into a buffer
+  std::string l_stationData;
+  auto l_putU64 = [&](uint64_t i_value){ l_stationData.append(reinterpret_cast<char const*>(&i_value), sizeof(i_value)); };
+  auto l_putF64 = [&](double   i_value){ l_stationData.append(reinterpret_cast<char const*>(&i_value), sizeof(i_value)); };
+  for(Station & l_station : i_stations){
+    std::string l_name = l_station.getName();
+    t_idx  l_x, l_y;
+    t_real l_offsetX, l_offsetY;
+    l_station.getPosition(l_x, l_y);
+    l_station.getSubcellOffset(l_offsetX, l_offsetY);
+    l_putU64(l_name.size());
+    l_stationData.append(l_name);
+    l_putU64(l_x);
+    l_putU64(l_y);
+    l_putF64(l_offsetX);
+    l_putF64(l_offsetY);
+    l_putF64(l_station.getDelayBetweenRecords());
+    l_putF64(l_station.getNextRecordTime());
+    l_putU64(l_station.getFileOffset());
+    l_putU64(l_station.getRecords().size());
+    for(RecordedValue const & l_record : l_station.getRecords()){
+      l_putF64(l_record.time);
+      l_putF64(l_record.height);
+      l_putF64(l_record.momentumX);
+      l_putF64(l_record.momentumY);
+    }
+  }
+  l_stationData.resize((l_stationData.size() + 3) / 4 * 4, 0);
+
+  char * l_data[m_nSections] = {};
+  for(unsigned short l_qu = 0; l_qu < 4; l_qu++){
+    if(l_arrays[l_qu] == nullptr) continue;
+    l_data[l_qu] = reinterpret_cast<char*>(l_arrays[l_qu]);
+    l_header.sizes[l_qu] = l_nValues * sizeof(t_real);
+  }
+  if(i_aggregates){
+    for(unsigned short l_fi = 0; l_fi < Aggregates::m_nFields; l_fi++){
+      l_data[4 + l_fi] = reinterpret_cast<char*>(const_cast<t_real*>(i_aggregates->getField(l_fi)));
+      l_header.sizes[4 + l_fi] = i_aggregates->getNx() * i_aggregates->getNy() * sizeof(t_real);
+    }
+  }
+
+  // a delta only contains the changed blocks, which are collected into buffers
+  std::vector<char> l_deltaData[m_nArraySections];
+  if(i_delta && i_delta->index > 0){
+    for(unsigned short l_se = 0; l_se < m_nArraySections; l_se++){
+      std::vector<uint64_t> const & l_blocks = i_delta->blocks[l_se];
+      if(l_data[l_se] == nullptr || l_blocks.empty()){
+        l_header.sizes[l_se] = 0;
+        continue;
+      }
+      uint64_t l_nValues = l_header.sizes[l_se] / sizeof(t_real);
+      uint64_t l_blockBytes = i_delta->blockValues * sizeof(t_real);
+      uint64_t l_nBlocks = l_blocks.size();
+      uint64_t l_indexBytes = (1 + l_nBlocks) * sizeof(uint64_t);
+      // only the last block of an array can be shorter
+      uint64_t l_lastBegin = l_blocks.back() * i_delta->blockValues;
+      uint64_t l_lastBytes = std::min<uint64_t>(i_delta->blockValues, l_nValues - l_lastBegin) * sizeof(t_real);
+      std::vector<char> & l_buffer = l_deltaData[l_se];
+      l_buffer.resize(l_indexBytes + (l_nBlocks - 1) * l_blockBytes + l_lastBytes);
+      memcpy(&l_buffer[0], &l_nBlocks, sizeof(uint64_t));
+      memcpy(&l_buffer[sizeof(uint64_t)], l_blocks.data(), l_nBlocks * sizeof(uint64_t));
+      char const * l_source = l_data[l_se];
+      #pragma omp parallel for
+      for(uint64_t l_bl = 0; l_bl < l_nBlocks; l_bl++){
+        memcpy(&l_buffer[l_indexBytes + l_bl * l_blockBytes], l_source + l_blocks[l_bl] * l_blockBytes, l_bl + 1 < l_nBlocks ? l_blockBytes : l_lastBytes);
+      }
+      l_data[l_se] = &l_buffer[0];
+      l_header.sizes[l_se] = l_buffer.size();
+    }
+  }
+
+  l_data[c_stationSection] = &l_stationData[0];
+  l_header.sizes[c_stationSection] = l_stationData.size();
+
+  uint64_t l_offset = m_pageSize;
+  for(unsigned short l_se = 0; l_se < m_nSections; l_se++){
+    if(l_header.sizes[l_se] == 0) continue;
+    l_header.offsets[l_se] = l_offset;
+    l_offset += roundToPages(l_header.sizes[l_se]);
+  }
+
+  // unlike NetCDF checkpoints, new files are written as tmp file, too: a file without header isn't a checkpoint
+  std::string l_tmpFileName = i_fileName + ".tmp";
+  int l_fd = open(l_tmpFileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if(l_fd < 0){
+    std::cerr << "Could not create " << l_tmpFileName << std::endl;
+    return -1;
+  }
+  int l_err = ftruncate(l_fd, l_offset);
+  for(unsigned short l_se = 0; l_se < m_nSections && !l_err; l_se++){
+    if(l_header.sizes[l_se] == 0) continue;
+    l_err = transfer(l_fd, true, l_header.offsets[l_se], l_header.sizes[l_se], l_data[l_se], l_header.checksums[l_se]);
+  }
+  // the header is written last, so an interrupted write leaves an invalid file
+  l_header.headerChecksum = checksum(l_header);
+  if(!l_err && pwrite(l_fd, &l_header, sizeof(Header), 0) != (ssize_t) sizeof(Header)) l_err = -1;
+  if(close(l_fd) != 0) l_err = -1;
+  if(l_err){
+    std::cerr << "Writing " << l_tmpFileName << " failed!" << std::endl;
+    std::remove(l_tmpFileName.c_str());
+    return -1;
+  }
+
+  // rename replaces the previous checkpoint at once
+  if(std::rename(l_tmpFileName.c_str(), i_fileName.c_str())){
+    std::cerr << "Rename from " << l_tmpFileName << " to " << i_fileName << " failed!" << std::endl;
+    return -1;
+  }
+  return 0;
+}
+
+int tsunami_lab::io::RawCheckpoint::load( std::string                             i_fileName,
+                                          t_idx                                 & o_nx,
+                                          t_idx                                 & o_ny,
+                                          t_real                                & o_cellSizeMeters,
+                                          t_real                                & o_cflFactor,
+                                          double                                & o_simulationTime,
+                                          t_idx                                 & o_timeStepIndex,
+                                          std::vector<tsunami_lab::io::Station> & o_stations ) {
+  std::vector<std::string> l_files;
+  std::vector<Header> l_headers;
+  if(readChain(i_fileName, l_files, l_headers)) return -1;
+  // the state of the last delta
+  Header const & l_header = l_headers.back();
+  int l_fd = open(l_files.back().c_str(), O_RDONLY);
+  if(l_fd < 0) return -1;
+
+  std::string l_stationData(l_header.sizes[c_stationSection], 0);
+  uint64_t l_checksum = 0;
+  int l_err = l_stationData.empty() ? 0 : transfer(l_fd, false, l_header.offsets[c_stationSection], l_stationData.size(), &l_stationData[0], l_checksum);
+  close(l_fd);
+  if(l_err || l_checksum != l_header.checksums[c_stationSection]){
+    std::cerr << "Stations of the raw checkpoint are damaged" << std::endl;
+    return -1;
+  }
+
+  // every read is checked against the end of the buffer
+  size_t l_position = 0;
+  bool   l_valid = true;
+  auto l_get = [&](void * o_value, size_t i_size){
+    if(!l_valid || l_position + i_size > l_stationData.size()){
+      l_valid = false;
+      return;
+    }
+    memcpy(o_value, l_stationData.data() + l_position, i_size);
+    l_position += i_size;
+  };
+  auto l_getU64 = [&]() -> uint64_t { uint64_t l_value = 0; l_get(&l_value, sizeof(l_value)); return l_value; };
+  auto l_getF64 = [&]() -> double { double   l_value = 0; l_get(&l_value, sizeof(l_value)); return l_value; };
+
+  std::vector<Station> l_stations;
+  for(uint64_t l_st = 0; l_st < l_header.nStations && l_valid; l_st++){
+    std::string l_name(std::min<uint64_t>(l_getU64(), l_stationData.size()), 0);
+    l_get(&l_name[0], l_name.size());
+    t_idx  l_x = l_getU64(), l_y = l_getU64();
+    t_real l_offsetX = l_getF64(), l_offsetY = l_getF64();
+    t_real l_delay = l_getF64();
+    t_real l_nextRecordTime = l_getF64();
+    t_idx  l_fileOffset = l_getU64();
+    uint64_t l_nRecords = l_getU64();
+    Station l_station(l_x, l_y, l_name, l_delay);
+    l_station.setSubcellOffset(l_offsetX, l_offsetY);
+    for(uint64_t l_re = 0; l_re < l_nRecords && l_valid; l_re++){
+      t_real l_time = l_getF64(), l_height = l_getF64(), l_momentumX = l_getF64(), l_momentumY = l_getF64();
+      l_station.recordState(l_time, l_height, l_momentumX, l_momentumY);
+    }
+    // after the records, which advance the time of the next record
+    l_station.setStreamState(l_fileOffset, l_nextRecordTime);
+    l_stations.push_back(l_station);
+  }
+  if(!l_valid){
+    std::cerr << "Stations of the raw checkpoint are incomplete" << std::endl;
+    return -1;
+  }
+
+  o_nx             = l_header.nx;
+  o_ny             = l_header.ny;
+  o_cellSizeMeters = l_header.cellSizeMeters;
+  o_cflFactor      = l_header.cflFactor;
+  o_simulationTime = l_header.simulationTime;
+  o_timeStepIndex  = l_header.timeStepIndex;
+  o_stations       = l_stations;
+  return 0;
+}
+
+int tsunami_lab::io::RawCheckpoint::loadPatch( std::string                             i_fileName,
+                                               tsunami_lab::patches::WavePropagation * io_waveProp ) {
+  t_real * l_arrays[4];
+  t_idx l_nValues = io_waveProp->getRawStorage(l_arrays);
+  if(l_nValues == 0){
+    std::cerr << "The patch doesn't support raw checkpoints" << std::endl;
+    return -1;
+  }
+
+  std::vector<std::string> l_files;
+  std::vector<Header> l_headers;
+  if(readChain(i_fileName, l_files, l_headers)) return -1;
+  if(l_headers[0].nValues != l_nValues){
+    std::cerr << "Raw checkpoint has " << l_headers[0].nValues << " values per array, the patch has " << l_nValues << std::endl;
+    return -1;
+  }
+
+  char * l_data[4];
+  for(unsigned short l_qu = 0; l_qu < 4; l_qu++) l_data[l_qu] = reinterpret_cast<char*>(l_arrays[l_qu]);
+  return loadArrays(l_files, l_headers, 0, 4, l_data, l_nValues * sizeof(t_real));
+}
+
+int tsunami_lab::io::RawCheckpoint::loadAggregates( std::string                   i_fileName,
+                                                    tsunami_lab::io::Aggregates & io_aggregates ) {
+  std::vector<std::string> l_files;
+  std::vector<Header> l_headers;
+  if(readChain(i_fileName, l_files, l_headers)) return -1;
+  Header const & l_header = l_headers[0];
+  // e.g. written without aggregates
+  if(l_header.sizes[4] == 0) return 0;
+  if(l_header.nx != io_aggregates.getNx() || l_header.ny != io_aggregates.getNy()){
+    std::cerr << "aggregates of " << i_fileName << " have " << l_header.nx << " x " << l_header.ny << " cells, expected "
+              << io_aggregates.getNx() << " x " << io_aggregates.getNy() << std::endl;
+    return -1;
+  }
+
+  char * l_data[Aggregates::m_nFields];
+  for(unsigned short l_fi = 0; l_fi < Aggregates::m_nFields; l_fi++) l_data[l_fi] = reinterpret_cast<char*>(io_aggregates.getField(l_fi));
+  return loadArrays(l_files, l_headers, 4, Aggregates::m_nFields, l_data, io_aggregates.getNx() * io_aggregates.getNy() * sizeof(t_real));
+}
@@ -0,0 +1,244 @@
+/**
+ * @author Antonio Noack
+ *
+ * @section DESCRIPTION
+ * Checkpoints as raw arrays in the in-memory layout of the patches: a header page, followed by page-aligned arrays
+ * including the ghost cells, the aggregates and the stations. Writing and restoring are a copy without a codec,
+ * so they are bound by the bandwidth of the disk; checksums protect against truncated or damaged files.
+ * A full checkpoint can be followed by delta checkpoints <fileName>.delta1, .delta2, ..., which only contain the blocks
+ * of the arrays, that changed since the previous checkpoint of the chain; the loaders replay them in order.
+ **/
+#ifndef TSUNAMI_LAB_IO_RAW_CHECKPOINT_H
+#define TSUNAMI_LAB_IO_RAW_CHECKPOINT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../constants.h"
+#include "../io/Aggregates.h"
+#include "../io/Station.h"
+#include "../patches/WavePropagation.h"
+
+namespace tsunami_lab {
+  namespace io {
+    class RawCheckpoint;
+  }
+}
+
+class tsunami_lab::io::RawCheckpoint {
+  public:
+    //! alignment of the arrays in the file
+    static t_idx constexpr m_pageSize = 4096;
+
+    //! sections of the file: height, momentum x, momentum y, bathymetry, the aggregates and the stations
+    static unsigned short constexpr m_nSections = 4 + Aggregates::m_nFields + 1;
+
+    //! sections, which are arrays and can be stored as changed blocks
+    static unsigned short constexpr m_nArraySections = m_nSections - 1;
+
+    //! position of a checkpoint in its chain, and the changed blocks of a delta checkpoint
+    struct Delta {
+      //! id of the full checkpoint of the chain
+      uint64_t baseId = 0;
+      //! 0 for the full checkpoint, n for the n-th delta
+      uint64_t index = 0;
+      //! values per block of the arrays
+      uint64_t blockValues = 0;
+      //! ascending ids of the changed blocks per array section
+      std::vector<uint64_t> blocks[m_nArraySections];
+    };
+
+  private:
+    //! first page of the file
+    struct Header {
+      //! "TSUNRAW" and a zero
+      char     magic[8];
+      uint32_t version;
+      //! sizeof(t_real) of the writer
+      uint32_t realSize;
+      //! cells without the ghost cells; ny is 1 in 1d
+      uint64_t nx, ny;
+      //! values per array of the patch, including the ghost cells
+      uint64_t nValues;
+      double   cellSizeMeters, cflFactor, simulationTime;
+      uint64_t timeStepIndex;
+      uint64_t nStations;
+      //! see Delta; a delta stores its array sections as the number of blocks, their ids and their values
+      uint64_t baseId, deltaIndex, blockValues;
+      //! position and size in bytes of each section; 0 if the section doesn't exist
+      uint64_t offsets[m_nSections], sizes[m_nSections];
+      uint64_t checksums[m_nSections];
+      //! checksum of the header up to this field
+      uint64_t headerChecksum;
+    };
+
+    /**
+     * Computes the checksum of the header.
+     *
+     * @param i_header header.
+     * @return checksum.
+     **/
+    static uint64_t checksum( Header const & i_header );
+
+    /**
+     * Writes or reads a section in parallel chunks, and computes its checksum on the way.
+     *
+     * @param i_fd file descriptor.
+     * @param i_write true to write the data, false to read it.
+     * @param i_offset position in the file in bytes.
+     * @param i_size size in bytes; a multiple of 4.
+     * @param io_data data, which is written or overwritten.
+     * @param o_checksum checksum of the data.
+     * @return 0 if successful, -1 else.
+     **/
+    static int transfer( int        i_fd,
+                         bool       i_write,
+                         uint64_t   i_offset,
+                         uint64_t   i_size,
+                         char     * io_data,
+                         uint64_t & o_checksum );
+
+    /**
+     * Reads and validates the header.
+     *
+     * @param i_fd file descriptor.
+     * @param o_header header.
+     * @return 0 if successful, -1 else.
+     **/
+    static int readHeader( int      i_fd,
+                           Header & o_header );
+
+    /**
+     * Finds the full checkpoint and the deltas, which belong to it: the chain ends before the first missing,
+     * damaged or foreign delta.
+     *
+     * @param i_fileName file name of the full checkpoint.
+     * @param o_files file names of the chain, starting with the full checkpoint.
+     * @param o_headers headers of the files.
+     * @return 0 if successful, -1 else.
+     **/
+    static int readChain( std::string const        & i_fileName,
+                          std::vector<std::string> & o_files,
+                          std::vector<Header>      & o_headers );
+
+    /**
+     * Reads array sections of a chain: the full checkpoint, and then the changed blocks of each delta.
+     *
+     * @param i_files file names of the chain; see readChain().
+     * @param i_headers headers of the files.
+     * @param i_first first section.
+     * @param i_count number of sections.
+     * @param i_data arrays of the sections; nullptr to skip a section.
+     * @param i_size size of each array in bytes.
+     * @return 0 if successful, -1 else.
+     **/
+    static int loadArrays( std::vector<std::string> const &       i_files,
+                           std::vector<Header>      const &       i_headers,
+                           unsigned short                         i_first,
+                           unsigned short                         i_count,
+                           char                           * const * i_data,
+                           uint64_t                               i_size );
+
+  public:
+    /**
+     * Checks whether a file starts like a raw checkpoint, e.g. to choose the loader.
+     *
+     * @param i_fileName file name.
+     * @return true, if the file is a raw checkpoint.
+     **/
+    static bool isRawCheckpoint( std::string const & i_fileName );
+
+    /**
+     * Checks whether a patch can be written as raw checkpoint.
+     *
+     * @param i_waveProp patch.
+     * @return true, if the patch stores its state as t_real arrays.
+     **/
+    static bool isSupported( tsunami_lab::patches::WavePropagation * i_waveProp );
+
+    /**
+     * Gets the file name of a delta checkpoint.
+     *
+     * @param i_fileName file name of the full checkpoint.
+     * @param i_index n for the n-th delta.
+     * @return file name.
+     **/
+    static std::string deltaFileName( std::string const & i_fileName,
+                                      uint64_t            i_index );
+
+    /**
+     * Writes the current simulation data as raw checkpoint.
+     * The file is written as <fileName>.tmp, and renamed, when it is complete.
+     *
+     * @param i_fileName output file name.
+     * @param i_nx field size x axis.
+     * @param i_ny field size y axis.
+     * @param i_cellSizeMeters cell size in meters.
+     * @param i_cflFactor cfl factor for 2d simulations.
+     * @param i_simulationTime current simulation time in seconds.
+     * @param i_timeStepIndex n for the n-th time step.
+     * @param i_stations stations.
+     * @param i_waveProp wave propagation instance; see isSupported().
+     * @param i_aggregates aggregates, which shall survive a restart; nullptr if there are none.
+     * @param i_delta position in a chain and the changed blocks; nullptr for a full checkpoint without chain.
+     * @return 0 if successful, -1 else.
+     **/
+    static int store( std::string                             i_fileName,
+                      t_idx                                   i_nx,
+                      t_idx                                   i_ny,
+                      t_real                                  i_cellSizeMeters,
+                      t_real                                  i_cflFactor,
+                      double                                  i_simulationTime,
+                      t_idx                                   i_timeStepIndex,
+                      std::vector<tsunami_lab::io::Station> & i_stations,
+                      tsunami_lab::patches::WavePropagation * i_waveProp,
+                      tsunami_lab::io::Aggregates     const * i_aggregates = nullptr,
+                      Delta                           const * i_delta = nullptr );
+
+    /**
+     * Reads the sizes, the time and the stations of a raw checkpoint; the patch is read by loadPatch() afterwards.
+     * With deltas, they are the ones of the last delta.
+     *
+     * @param i_fileName input file name of the full checkpoint.
+     * @param o_nx cells in x-direction without the ghost cells.
+     * @param o_ny cells in y-direction without the ghost cells; 1 in 1d.
+     * @param o_cellSizeMeters cell size in meters.
+     * @param o_cflFactor cfl factor for 2d simulations.
+     * @param o_simulationTime last computed simulation time in seconds.
+     * @param o_timeStepIndex last time step index.
+     * @param o_stations stations with their file state.
+     * @return 0 if successful, -1 else.
+     **/
+    static int load( std::string                             i_fileName,
+                     t_idx                                 & o_nx,
+                     t_idx                                 & o_ny,
+                     t_real                                & o_cellSizeMeters,
+                     t_real                                & o_cflFactor,
+                     double                                & o_simulationTime,
+                     t_idx                                 & o_timeStepIndex,
+                     std::vector<tsunami_lab::io::Station> & o_stations );
+
+    /**
+     * Reads the arrays of a raw checkpoint directly into the storage of a patch of the same size, and verifies their checksums.
+     * Deltas are applied afterwards.
+     *
+     * @param i_fileName input file name of the full checkpoint.
+     * @param io_waveProp patch; see isSupported().
+     * @return 0 if successful, -1 else.
+     **/
+    static int loadPatch( std::string                             i_fileName,
+                          tsunami_lab::patches::WavePropagation * io_waveProp );
+
+    /**
+     * Reads the aggregates of a raw checkpoint and its deltas; keeps them, if the checkpoint has none.
+     *
+     * @param i_fileName input file name of the full checkpoint.
+     * @param io_aggregates aggregates of the same size as the checkpoint.
+     * @return 0 if successful or if there are no aggregates, -1 else.
+     **/
+    static int loadAggregates( std::string                   i_fileName,
+                               tsunami_lab::io::Aggregates & io_aggregates );
+};
+
+#endif
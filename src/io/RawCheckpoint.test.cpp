@@ -0,0 +1,158 @@
+/**
+ * @author Antonio Noack
+ *
+ * @section DESCRIPTION
+ * Unit tests for the raw checkpoints.
+ **/
+#include <catch2/catch.hpp>
+#include "../constants.h"
+#include "../patches/WavePropagation1d.h"
+#include "../patches/WavePropagation2d.h"
+#include "../patches/WavePropagation2dCompact.h"
+#include "../setups/DamBreak2d.h"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "RawCheckpoint.h"
+
+#define t_idx  tsunami_lab::t_idx
+#define t_real tsunami_lab::t_real
+
+TEST_CASE( "Test that raw checkpoints restore the patch, the stations and the aggregates.", "[RawCheckpoint]" ) {
+
+  t_idx l_nx = 13, l_ny = 7;
+  tsunami_lab::setups::DamBreak2d l_setup( 10, 5, 6, 3, 2, -10 );
+  tsunami_lab::patches::WavePropagation2d l_waveProp( l_nx, l_ny, &l_setup, 1, 1 );
+  tsunami_lab::io::Aggregates l_aggregates( l_nx, l_ny, 0.1 );
+  for( t_idx l_it = 0; l_it < 3; l_it++ ) {
+    l_aggregates.update( &l_waveProp, l_it * 0.1 );
+    l_waveProp.setGhostOutflow();
+    l_waveProp.timeStep( 0.1 );
+  }
+
+  std::vector<tsunami_lab::io::Station> l_stations;
+  l_stations.push_back( tsunami_lab::io::Station( 2, 5, "Bikini Bottom", 0.17 ) );
+  l_stations[0].setSubcellOffset( 0.25, 0.5 );
+  l_stations[0].recordState( 4, 5, 6, 7 );
+  l_stations[0].setStreamState( 1234, 0.5 );
+  l_stations.push_back( tsunami_lab::io::Station( 9, 1, "Atlantis", 2 ) );
+
+  std::string l_fileName = "tmp-cp.raw";
+  REQUIRE( tsunami_lab::io::RawCheckpoint::store( l_fileName, l_nx, l_ny, 0.5, 0.25, 0.3, 3, l_stations, &l_waveProp, &l_aggregates ) == 0 );
+  REQUIRE( tsunami_lab::io::RawCheckpoint::isRawCheckpoint( l_fileName ) );
+
+  t_idx l_nx2, l_ny2, l_timeStepIndex2;
+  t_real l_cellSizeMeters2, l_cflFactor2;
+  double l_simulationTime2;
+  std::vector<tsunami_lab::io::Station> l_stations2;
+  REQUIRE( tsunami_lab::io::RawCheckpoint::load( l_fileName, l_nx2, l_ny2, l_cellSizeMeters2, l_cflFactor2, l_simulationTime2, l_timeStepIndex2, l_stations2 ) == 0 );
+  REQUIRE( l_nx2 == l_nx );
+  REQUIRE( l_ny2 == l_ny );
+  REQUIRE( l_cellSizeMeters2 == 0.5 );
+  REQUIRE( l_cflFactor2 == 0.25 );
+  REQUIRE( l_simulationTime2 == Approx( 0.3 ) );
+  REQUIRE( l_timeStepIndex2 == 3 );
+
+  REQUIRE( l_stations2.size() == 2 );
+  REQUIRE( l_stations2[0].getName() == "Bikini Bottom" );
+  t_idx l_x, l_y;
+  t_real l_offsetX, l_offsetY;
+  l_stations2[0].getPosition( l_x, l_y );
+  l_stations2[0].getSubcellOffset( l_offsetX, l_offsetY );
+  REQUIRE( l_x == 2 );
+  REQUIRE( l_y == 5 );
+  REQUIRE( l_offsetX == 0.25 );
+  REQUIRE( l_offsetY == 0.5 );
+  REQUIRE( l_stations2[0].getDelayBetweenRecords() == Approx( 0.17 ) );
+  REQUIRE( l_stations2[0].getFileOffset() == 1234 );
+  REQUIRE( l_stations2[0].getNextRecordTime() == 0.5 );
+  REQUIRE( l_stations2[0].getRecords().size() == 1 );
+  REQUIRE( l_stations2[0].getRecords()[0].momentumY == 7 );
+  REQUIRE( l_stations2[1].getName() == "Atlantis" );
+  REQUIRE( l_stations2[1].getRecords().empty() );
+
+  // the arrays are read including the ghost cells
+  tsunami_lab::patches::WavePropagation2d l_restored( l_nx, l_ny );
+  REQUIRE( tsunami_lab::io::RawCheckpoint::loadPatch( l_fileName, &l_restored ) == 0 );
+  t_real * l_arrays[4], * l_restoredArrays[4];
+  t_idx l_nValues = l_waveProp.getRawStorage( l_arrays );
+  REQUIRE( l_restored.getRawStorage( l_restoredArrays ) == l_nValues );
+  for( unsigned short l_qu = 0; l_qu < 4; l_qu++ ) {
+    for( t_idx l_ce = 0; l_ce < l_nValues; l_ce++ ) {
+      REQUIRE( l_restoredArrays[l_qu][l_ce] == l_arrays[l_qu][l_ce] );
+    }
+  }
+
+  // both continue the same way
+  l_waveProp.setGhostOutflow();
+  l_waveProp.timeStep( 0.1 );
+  l_restored.setGhostOutflow();
+  l_restored.timeStep( 0.1 );
+  for( t_idx l_ce = 0; l_ce < l_nx * l_ny; l_ce++ ) {
+    REQUIRE( l_restored.getHeight()[l_ce] == l_waveProp.getHeight()[l_ce] );
+  }
+
+  tsunami_lab::io::Aggregates l_restoredAggregates( l_nx, l_ny, 0.1 );
+  REQUIRE( tsunami_lab::io::RawCheckpoint::loadAggregates( l_fileName, l_restoredAggregates ) == 0 );
+  for( unsigned short l_fi = 0; l_fi < tsunami_lab::io::Aggregates::m_nFields; l_fi++ ) {
+    for( t_idx l_ce = 0; l_ce < l_nx * l_ny; l_ce++ ) {
+      REQUIRE( l_restoredAggregates.getField( l_fi )[l_ce] == l_aggregates.getField( l_fi )[l_ce] );
+    }
+  }
+
+  // a patch of another size is rejected
+  tsunami_lab::patches::WavePropagation2d l_other( l_nx + 1, l_ny );
+  REQUIRE( tsunami_lab::io::RawCheckpoint::loadPatch( l_fileName, &l_other ) != 0 );
+  tsunami_lab::io::Aggregates l_otherAggregates( l_nx, l_ny + 1, 0.1 );
+  REQUIRE( tsunami_lab::io::RawCheckpoint::loadAggregates( l_fileName, l_otherAggregates ) != 0 );
+
+  // a damaged value is detected by the checksum
+  {
+    std::fstream l_file( l_fileName, std::ios::in | std::ios::out | std::ios::binary );
+    l_file.seekp( tsunami_lab::io::RawCheckpoint::m_pageSize + 40 );
+    l_file.put( 'x' );
+  }
+  REQUIRE( tsunami_lab::io::RawCheckpoint::loadPatch( l_fileName, &l_restored ) != 0 );
+
+  std::remove( l_fileName.c_str() );
+  REQUIRE( !tsunami_lab::io::RawCheckpoint::isRawCheckpoint( l_fileName ) );
+}
+
+TEST_CASE( "Test raw checkpoints of 1d patches and patches without t_real arrays.", "[RawCheckpoint]" ) {
+
+  tsunami_lab::patches::WavePropagation1d l_waveProp( 50 );
+  for( t_idx l_ce = 0; l_ce < 50; l_ce++ ) {
+    l_waveProp.setHeight( l_ce, 0, l_ce < 25 ? 10 : 8 );
+    l_waveProp.setMomentumX( l_ce, 0, 0 );
+  }
+  l_waveProp.setGhostOutflow();
+  l_waveProp.timeStep( 0.1 );
+
+  std::vector<tsunami_lab::io::Station> l_stations;
+  std::string l_fileName = "tmp-cp-1d.raw";
+  REQUIRE( tsunami_lab::io::RawCheckpoint::store( l_fileName, 50, 1, 1, 0.5, 0.1, 1, l_stations, &l_waveProp ) == 0 );
+
+  // the stored file is replaced
+  REQUIRE( tsunami_lab::io::RawCheckpoint::store( l_fileName, 50, 1, 1, 0.5, 0.1, 1, l_stations, &l_waveProp ) == 0 );
+
+  tsunami_lab::patches::WavePropagation1d l_restored( 50 );
+  REQUIRE( tsunami_lab::io::RawCheckpoint::loadPatch( l_fileName, &l_restored ) == 0 );
+  for( t_idx l_ce = 0; l_ce < 50; l_ce++ ) {
+    REQUIRE( l_restored.getHeight()[l_ce]    == l_waveProp.getHeight()[l_ce] );
+    REQUIRE( l_restored.getMomentumX()[l_ce] == l_waveProp.getMomentumX()[l_ce] );
+  }
+
+  // without aggregates in the file, the aggregates are kept
+  tsunami_lab::io::Aggregates l_aggregates( 50, 1, 0.1 );
+  REQUIRE( tsunami_lab::io::RawCheckpoint::loadAggregates( l_fileName, l_aggregates ) == 0 );
+  REQUIRE( l_aggregates.getField( 2 )[0] == -1 );
+  std::remove( l_fileName.c_str() );
+
+  // compact storage has no t_real arrays
+  tsunami_lab::patches::WavePropagation2dCompact l_compact( 4, 4, false );
+  REQUIRE( !tsunami_lab::io::RawCheckpoint::isSupported( &l_compact ) );
+  REQUIRE( tsunami_lab::io::RawCheckpoint::store( l_fileName, 4, 4, 1, 0.5, 0, 0, l_stations, &l_compact ) != 0 );
+}
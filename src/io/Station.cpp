@@ -7,19 +7,15 @@
 #include "Station.h"
 #include <sstream>
 #include <fstream> // file streams
+#include <unistd.h> // truncate
 
 bool tsunami_lab::io::Station::needsUpdate( t_real i_time ) {
   return m_nextRecordTime <= i_time;
 }
 
 void tsunami_lab::io::Station::recordState( tsunami_lab::patches::WavePropagation &i_waveProp, t_real i_time ) {
-  t_idx l_index = m_positionX + m_positionY * i_waveProp.getStride();
-  auto l_hPtr = i_waveProp.getHeight();// somehow in the sanitizer this has become null... how?
-  t_real l_h  = l_hPtr ? l_hPtr[l_index] : 0;
-  auto l_huPtr = i_waveProp.getMomentumX();
-  auto l_hvPtr = i_waveProp.getMomentumY();
-  t_real l_hu = l_huPtr ? l_huPtr[l_index] : 0;
-  t_real l_hv = l_hvPtr ? l_hvPtr[l_index] : 0;
+  t_real l_h, l_hu, l_hv;
+  i_waveProp.getCellState( m_positionX, m_positionY, l_h, l_hu, l_hv );
   recordState( i_time, l_h, l_hu, l_hv );
 }
 
@@ -30,29 +26,41 @@ void tsunami_lab::io::Station::recordState( t_real i_time, t_real i_h, t_real i_
 
 void tsunami_lab::io::Station::write( bool i_withComment ) {
   
-  std::string l_fileName = m_name.find('/') == std::string::npos ? "station_" + m_name + ".csv" : m_name + ".csv";
+  std::string l_fileName = getFileName();
+  
+  // after a restart, the records behind the checkpoint are written again
+  if(!m_hasOpenedFile && m_fileOffset > 0 && truncate( l_fileName.c_str(), m_fileOffset ) != 0){
+    std::cerr << "Cannot continue " << l_fileName << " at byte " << m_fileOffset << ", starting a new file" << std::endl;
+    m_fileOffset = 0;
+  }
+  bool l_isNewFile = m_fileOffset == 0 && !m_hasOpenedFile;
   
   std::ofstream l_stream;
-  l_stream.open( l_fileName );
+  l_stream.open( l_fileName, l_isNewFile ? std::ios::out | std::ios::trunc : std::ios::out | std::ios::app );
   if(!l_stream.is_open()) {
     std::cerr << "Error opening file " << l_fileName << std::endl;
     return;
   }
+  m_hasOpenedFile = true;
   
-  // print information about the station in some comments in the header
-  if(i_withComment){
-    l_stream << "# Station " << m_name << "\n";
-    l_stream << "# Location (Grid) " << m_positionX << "," << m_positionY << "\n";
+  if(l_isNewFile){
+    // print information about the station in some comments in the header
+    if(i_withComment){
+      l_stream << "# Station " << m_name << "\n";
+      l_stream << "# Location (Grid) " << m_positionX << "," << m_positionY << "\n";
+    }
+    
+    // write the CSV table header
+    l_stream << "time,height,momentumX,momentumY\n";
   }
-  
-  // write the CSV table header
-  l_stream << "time,height,momentumX,momentumY\n";
 
-  // iterate over all records
+  // iterate over all buffered records
   for(auto &l_record : m_records) {
     l_stream << l_record.time << "," << l_record.height << "," << l_record.momentumX << "," << l_record.momentumY << "\n";
   }
   l_stream << std::flush;
+  m_fileOffset = l_stream.tellp();
   l_stream.close();
+  m_records.clear();
   
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
  *
  * @section DESCRIPTION
  * Wave-recording station, which watches height and momentum.
+ * The records are buffered, and appended to the CSV file of the station by write(), so the memory doesn't grow with the run time.
  **/
 #ifndef TSUNAMI_LAB_IO_STATION
 #define TSUNAMI_LAB_IO_STATION
@@ -31,15 +32,24 @@ class tsunami_lab::io::Station {
     t_idx m_positionX;
     t_idx m_positionY;
     
+    //! position inside of the cell in [0, 1); StationSet interpolates towards the right and upper neighbours by it
+    t_real m_offsetX = 0, m_offsetY = 0;
+    
     //! station name, e.g. for saving the recorded data
     std::string m_name;
     
     t_real m_nextRecordTime = 0;
     t_real m_delayBetweenRecords = 0;
     
-    //! all recorded values
+    //! recorded values, which weren't written yet
     std::vector<RecordedValue> m_records;
     
+    //! size of the CSV file in bytes after the last write; after a restart, everything behind it is discarded
+    t_idx m_fileOffset = 0;
+    
+    //! true, if this run has written to the file already
+    bool m_hasOpenedFile = false;
+    
   public:
   
     /**
@@ -82,12 +92,24 @@ class tsunami_lab::io::Station {
     void recordState( t_real i_time, t_real i_height, t_real i_momentumX, t_real i_momentumY );
     
     /**
-     * Writes all recorded data to a csv file.
+     * Appends the buffered records to the CSV file, and clears them.
+     * The first call of a run creates the file, or, after a restart, cuts it to the size at the checkpoint.
      *
-     * @param i_withComment whether the comment should be printed.
+     * @param i_withComment whether the comment should be printed, when the file is created.
      **/
     void write( bool i_withComment );
     
+    /**
+     * Restores the state of the CSV file from a checkpoint.
+     *
+     * @param i_fileOffset size of the file in bytes at the checkpoint.
+     * @param i_nextRecordTime time in seconds of the next record.
+     **/
+    void setStreamState( t_idx i_fileOffset, t_real i_nextRecordTime ) {
+      m_fileOffset = i_fileOffset;
+      m_nextRecordTime = i_nextRecordTime;
+    }
+    
 	// just a few getters; is there a better way in C++? (besided making the properties public)
     /** self explanatory */
     std::string getName(){
@@ -100,11 +122,33 @@ class tsunami_lab::io::Station {
 	  o_y = m_positionY;
     }
     
+    /** self explanatory */
+    void setSubcellOffset(t_real i_offsetX, t_real i_offsetY){
+      m_offsetX = i_offsetX;
+      m_offsetY = i_offsetY;
+    }
+    
+    /** self explanatory */
+    void getSubcellOffset(t_real &o_offsetX, t_real &o_offsetY){
+      o_offsetX = m_offsetX;
+      o_offsetY = m_offsetY;
+    }
+    
     /** self explanatory */
     std::vector<RecordedValue>& getRecords(){
       return m_records;
     }
     
+    /** self explanatory */
+    std::string getFileName(){
+      return m_name.find('/') == std::string::npos ? "station_" + m_name + ".csv" : m_name + ".csv";
+    }
+    
+    /** self explanatory */
+    t_idx getFileOffset(){
+      return m_fileOffset;
+    }
+    
     /** self explanatory */
     t_real getNextRecordTime(){
       return m_nextRecordTime;
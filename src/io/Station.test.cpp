@@ -6,9 +6,16 @@
  **/
 #include <catch2/catch.hpp>
 #include "../constants.h"
+#include "../patches/WavePropagation1d.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
 #define private public
 #include "Station.h"
 #undef public
+#include "NetCdf.h"
 
 #define t_idx  tsunami_lab::t_idx
 #define t_real tsunami_lab::t_real
@@ -19,3 +26,63 @@ TEST_CASE( "Test the stations.", "[Station]" ) {
   REQUIRE( station.needsUpdate(10 + 1.4) == false );
   REQUIRE( station.needsUpdate(10 + 1.6) == true );
 }
+
+/**
+ * Reads a whole file.
+ *
+ * @param i_fileName file name.
+ * @return content of the file.
+ **/
+static std::string readFile( std::string i_fileName ) {
+  std::ifstream l_stream( i_fileName );
+  std::stringstream l_content;
+  l_content << l_stream.rdbuf();
+  return l_content.str();
+}
+
+TEST_CASE( "Test that the stations append their records, and continue after a restart.", "[Station]" ) {
+  tsunami_lab::io::Station l_station( 3, 4, "tmp-stream", 1 );
+  std::string l_fileName = l_station.getFileName();
+  REQUIRE( l_fileName == "station_tmp-stream.csv" );
+
+  l_station.recordState( 0, 1, 2, 3 );
+  l_station.recordState( 1, 4, 5, 6 );
+  l_station.write( true );
+  REQUIRE( l_station.getRecords().empty() );
+  std::string l_expected = "# Station tmp-stream\n# Location (Grid) 3,4\ntime,height,momentumX,momentumY\n0,1,2,3\n1,4,5,6\n";
+  REQUIRE( readFile( l_fileName ) == l_expected );
+  REQUIRE( l_station.getFileOffset() == l_expected.size() );
+
+  // checkpoint with the file offset in a NetCDF file
+  tsunami_lab::patches::WavePropagation1d l_waveProp( 10 );
+  std::vector<tsunami_lab::io::Station> l_stations( 1, l_station );
+  std::string l_checkpointName = "tmp-station-cp.nc";
+  REQUIRE( tsunami_lab::io::NetCDF::storeCheckpoint( l_checkpointName, 10, 1, 1, 0.5, 1.5, 2, l_stations, &l_waveProp ) == 0 );
+
+  // records after the checkpoint, which are lost by a crash
+  l_station.recordState( 2, 7, 8, 9 );
+  l_station.write( true );
+  REQUIRE( readFile( l_fileName ) == l_expected + "2,7,8,9\n" );
+
+  // the restarted run continues at the checkpoint
+  t_idx  l_nx, l_ny, l_timeStepIndex;
+  t_real l_cellSizeMeters, l_cflFactor;
+  double l_simulationTime;
+  std::vector<tsunami_lab::io::Station> l_restored;
+  tsunami_lab::setups::Setup * l_setup = tsunami_lab::io::NetCDF::loadCheckpoint( l_checkpointName, l_nx, l_ny, l_cellSizeMeters, l_cflFactor, l_simulationTime, l_timeStepIndex, l_restored );
+  REQUIRE( l_setup != nullptr );
+  delete l_setup;
+  REQUIRE( l_restored.size() == 1 );
+  REQUIRE( l_restored[0].getFileOffset() == l_expected.size() );
+  REQUIRE( l_restored[0].getNextRecordTime() == 2 );
+  REQUIRE( l_restored[0].getRecords().empty() );
+
+  l_restored[0].recordState( 2, 10, 11, 12 );
+  l_restored[0].write( true );
+  l_restored[0].recordState( 3, 13, 14, 15 );
+  l_restored[0].write( true );
+  REQUIRE( readFile( l_fileName ) == l_expected + "2,10,11,12\n3,13,14,15\n" );
+
+  std::remove( l_fileName.c_str() );
+  std::remove( l_checkpointName.c_str() );
+}
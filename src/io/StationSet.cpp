@@ -0,0 +1,118 @@
+/**
+ * @author Antonio Noack
+ *
+ * @section DESCRIPTION
+ * Set of wave-recording stations, which are sampled together.
+ **/
+#include "StationSet.h"
+
+tsunami_lab::io::StationSet::StationSet( std::vector<Station> i_stations,
+                                         t_idx                i_nx,
+                                         t_idx                i_ny ):
+  m_stations(i_stations) {
+  t_idx l_nStations = m_stations.size();
+  m_x.resize(l_nStations);
+  m_y.resize(l_nStations);
+  m_stepX.resize(l_nStations);
+  m_stepY.resize(l_nStations);
+  m_weightX.resize(l_nStations);
+  m_weightY.resize(l_nStations);
+  m_delay.resize(l_nStations);
+  m_nextRecordTime.resize(l_nStations);
+  for(t_idx l_st = 0; l_st < l_nStations; l_st++){
+    Station & l_station = m_stations[l_st];
+    t_real l_offsetX, l_offsetY;
+    l_station.getPosition(m_x[l_st], m_y[l_st]);
+    l_station.getSubcellOffset(l_offsetX, l_offsetY);
+    // the last cell has no neighbour; 1d has a single row
+    m_stepX[l_st]   = l_offsetX > 0 && m_x[l_st] + 1 < i_nx ? 1 : 0;
+    m_stepY[l_st]   = l_offsetY > 0 && m_y[l_st] + 1 < i_ny ? 1 : 0;
+    m_weightX[l_st] = m_stepX[l_st] ? l_offsetX : 0;
+    m_weightY[l_st] = m_stepY[l_st] ? l_offsetY : 0;
+    m_delay[l_st]   = l_station.getDelayBetweenRecords();
+    m_nextRecordTime[l_st] = l_station.getNextRecordTime();
+    // buffered records of a checkpoint go first
+    for(RecordedValue const & l_record : l_station.getRecords()){
+      m_sampleStation.push_back(l_st);
+      m_sampleTime.push_back(l_record.time);
+      m_sampleValues[0].push_back(l_record.height);
+      m_sampleValues[1].push_back(l_record.momentumX);
+      m_sampleValues[2].push_back(l_record.momentumY);
+    }
+    l_station.getRecords().clear();
+  }
+}
+
+tsunami_lab::t_idx tsunami_lab::io::StationSet::sample( tsunami_lab::patches::WavePropagation * i_waveProp,
+                                                        double                                  i_time ) {
+  m_due.clear();
+  for(t_idx l_st = 0; l_st < m_stations.size(); l_st++){
+    if(m_nextRecordTime[l_st] <= i_time){
+      m_due.push_back(l_st);
+      m_nextRecordTime[l_st] = i_time + m_delay[l_st];
+    }
+  }
+  t_idx l_nDue = m_due.size();
+  if(l_nDue == 0) return 0;
+
+  t_idx l_base = m_sampleStation.size();
+  m_sampleStation.resize(l_base + l_nDue);
+  m_sampleTime.resize(l_base + l_nDue, (t_real) i_time);
+  for(unsigned short l_qu = 0; l_qu < 3; l_qu++) m_sampleValues[l_qu].resize(l_base + l_nDue);
+
+  // patches without dense storage decode a cell at a time, which isn't necessarily thread safe
+  bool  l_isDense = i_waveProp->hasDenseStorage();
+  t_idx l_stride  = i_waveProp->getStride();
+  t_real const * l_dataIn[3] = { nullptr, nullptr, nullptr };
+  if(l_isDense){
+    l_dataIn[0] = i_waveProp->getHeight();
+    l_dataIn[1] = i_waveProp->getMomentumX();
+    l_dataIn[2] = i_waveProp->getMomentumY();// nullptr in 1d
+  }
+
+  #pragma omp parallel for if(l_isDense && l_nDue >= 256)
+  for(t_idx l_sa = 0; l_sa < l_nDue; l_sa++){
+    t_idx  l_st = m_due[l_sa];
+    t_real l_wx = m_weightX[l_st], l_wy = m_weightY[l_st];
+    t_real l_weights[4] = { (1-l_wx) * (1-l_wy), l_wx * (1-l_wy), (1-l_wx) * l_wy, l_wx * l_wy };
+    t_idx  l_dx[4] = { 0, m_stepX[l_st], 0, m_stepX[l_st] };
+    t_idx  l_dy[4] = { 0, 0, m_stepY[l_st], m_stepY[l_st] };
+
+    t_real l_sum[3] = { 0, 0, 0 }, l_first[3] = { 0, 0, 0 };
+    t_real l_weightSum = 0;
+    for(unsigned short l_ce = 0; l_ce < 4; l_ce++){
+      if(l_ce > 0 && l_weights[l_ce] == 0) continue;
+      t_idx  l_ix = m_x[l_st] + l_dx[l_ce], l_iy = m_y[l_st] + l_dy[l_ce];
+      t_real l_state[3];
+      if(l_isDense){
+        t_idx l_index = l_ix + l_iy * l_stride;
+        for(unsigned short l_qu = 0; l_qu < 3; l_qu++) l_state[l_qu] = l_dataIn[l_qu] ? l_dataIn[l_qu][l_index] : 0;
+      } else {
+        i_waveProp->getCellState(l_ix, l_iy, l_state[0], l_state[1], l_state[2]);
+      }
+      if(l_ce == 0) for(unsigned short l_qu = 0; l_qu < 3; l_qu++) l_first[l_qu] = l_state[l_qu];
+      if(l_state[0] <= 0) continue;// dry
+      for(unsigned short l_qu = 0; l_qu < 3; l_qu++) l_sum[l_qu] += l_weights[l_ce] * l_state[l_qu];
+      l_weightSum += l_weights[l_ce];
+    }
+
+    t_idx l_index = l_base + l_sa;
+    m_sampleStation[l_index] = l_st;
+    for(unsigned short l_qu = 0; l_qu < 3; l_qu++){
+      m_sampleValues[l_qu][l_index] = l_weightSum > 0 ? l_sum[l_qu] / l_weightSum : l_first[l_qu];
+    }
+  }
+  return l_nDue;
+}
+
+void tsunami_lab::io::StationSet::write( bool i_withComment ) {
+  // the samples are ordered by time, so each station gets its records in order
+  for(t_idx l_sa = 0; l_sa < m_sampleStation.size(); l_sa++){
+    m_stations[m_sampleStation[l_sa]].recordState(m_sampleTime[l_sa], m_sampleValues[0][l_sa], m_sampleValues[1][l_sa], m_sampleValues[2][l_sa]);
+  }
+  for(Station & l_station : m_stations) l_station.write(i_withComment);
+
+  m_sampleStation.clear();
+  m_sampleTime.clear();
+  for(unsigned short l_qu = 0; l_qu < 3; l_qu++) m_sampleValues[l_qu].clear();
+}
@@ -0,0 +1,100 @@
+/**
+ * @author Antonio Noack
+ *
+ * @section DESCRIPTION
+ * Set of wave-recording stations, which are sampled together.
+ * The positions, interpolation weights and sampling times are stored as arrays (structure of arrays),
+ * so thousands of stations are sampled in one parallel gather, and the samples are collected in columns,
+ * until they are appended to the CSV files of the stations.
+ **/
+#ifndef TSUNAMI_LAB_IO_STATION_SET
+#define TSUNAMI_LAB_IO_STATION_SET
+
+#include "../constants.h"
+#include "../patches/WavePropagation.h"
+#include "Station.h"
+
+#include <vector>
+
+namespace tsunami_lab {
+  namespace io {
+    class StationSet;
+  }
+}
+
+class tsunami_lab::io::StationSet {
+  private:
+    //! stations with name, sampling period and CSV file state
+    std::vector<Station> m_stations;
+
+    //! lower left cell of the interpolation stencil of each station
+    std::vector<t_idx> m_x, m_y;
+
+    //! 1, if the stencil includes the right/upper neighbour, 0 at the border of the domain or for integer positions
+    std::vector<t_idx> m_stepX, m_stepY;
+
+    //! bilinear weights of the right/upper neighbours
+    std::vector<t_real> m_weightX, m_weightY;
+
+    //! sampling period and time of the next sample of each station in seconds
+    std::vector<t_real> m_delay;
+    std::vector<double> m_nextRecordTime;
+
+    //! ids of the stations, which are sampled in the current step
+    std::vector<t_idx> m_due;
+
+    //! columns of the buffered samples: station id, time, height, momentum x, momentum y
+    std::vector<t_idx> m_sampleStation;
+    std::vector<t_real> m_sampleTime, m_sampleValues[3];
+
+  public:
+    /**
+     * Constructor; precomputes the interpolation stencils.
+     *
+     * @param i_stations stations; their buffered records are written by the first write().
+     * @param i_nx number of cells in x-direction.
+     * @param i_ny number of cells in y-direction.
+     **/
+    StationSet( std::vector<Station> i_stations,
+                t_idx                i_nx,
+                t_idx                i_ny );
+
+    /**
+     * Samples all stations, whose next record is due, by bilinear interpolation of their stencil.
+     * Dry cells are left out of the interpolation; if all cells of a stencil are dry, its lower left cell is recorded.
+     *
+     * @param i_waveProp patch.
+     * @param i_time current simulation time in seconds.
+     * @return number of sampled stations.
+     **/
+    t_idx sample( tsunami_lab::patches::WavePropagation * i_waveProp,
+                  double                                  i_time );
+
+    /**
+     * Appends the buffered samples to the CSV files of the stations, and clears the buffer.
+     *
+     * @param i_withComment whether the comment should be printed, when a file is created.
+     **/
+    void write( bool i_withComment );
+
+    /** self explanatory */
+    t_idx getBufferedSamples() const {
+      return m_sampleStation.size();
+    }
+
+    /** self explanatory */
+    t_idx size() const {
+      return m_stations.size();
+    }
+
+    /**
+     * Gets the stations, e.g. for checkpoints; samples since the last write() aren't part of their records.
+     *
+     * @return stations.
+     **/
+    std::vector<Station> & getStations() {
+      return m_stations;
+    }
+};
+
+#endif
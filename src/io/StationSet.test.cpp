@@ -0,0 +1,149 @@
+/**
+ * @author Antonio Noack
+ *
+ * @section DESCRIPTION
+ * Unit tests for the set of stations.
+ **/
+#include <catch2/catch.hpp>
+#include "../constants.h"
+#include "../patches/WavePropagation2d.h"
+#include "../patches/WavePropagation2dSparse.h"
+#include "../setups/DamBreak2d.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "StationSet.h"
+
+#define t_idx  tsunami_lab::t_idx
+#define t_real tsunami_lab::t_real
+
+TEST_CASE( "Test that the station set interpolates bilinearly.", "[StationSet]" ) {
+
+  tsunami_lab::setups::DamBreak2d l_setup( 10, 5, 100, 100, 1, -10 );
+  tsunami_lab::patches::WavePropagation2d l_waveProp( 6, 5, &l_setup, 1, 1 );
+  for( t_idx l_iy = 0; l_iy < 5; l_iy++ ) {
+    for( t_idx l_ix = 0; l_ix < 6; l_ix++ ) {
+      l_waveProp.setHeight( l_ix, l_iy, 1 + l_ix + 10 * l_iy );
+      l_waveProp.setMomentumX( l_ix, l_iy, 2 * l_ix );
+      l_waveProp.setMomentumY( l_ix, l_iy, 3 * l_iy );
+    }
+  }
+  // a dry cell
+  l_waveProp.setHeight( 4, 3, 0 );
+
+  std::vector<tsunami_lab::io::Station> l_stations;
+  // cell center
+  l_stations.push_back( tsunami_lab::io::Station( 1, 2, "tmp-center", 1 ) );
+  // between four cells
+  l_stations.push_back( tsunami_lab::io::Station( 2, 1, "tmp-between", 1 ) );
+  l_stations.back().setSubcellOffset( 0.25, 0.5 );
+  // at the border of the domain, there is no right neighbour
+  l_stations.push_back( tsunami_lab::io::Station( 5, 0, "tmp-border", 1 ) );
+  l_stations.back().setSubcellOffset( 0.5, 0.5 );
+  // next to the dry cell (4, 3), which is left out
+  l_stations.push_back( tsunami_lab::io::Station( 3, 3, "tmp-dry", 1 ) );
+  l_stations.back().setSubcellOffset( 0.5, 0 );
+  // samples twice as often
+  l_stations.push_back( tsunami_lab::io::Station( 0, 0, "tmp-fast", 0.5 ) );
+
+  tsunami_lab::io::StationSet l_set( l_stations, 6, 5 );
+  REQUIRE( l_set.size() == 5 );
+  REQUIRE( l_set.sample( &l_waveProp, 0 ) == 5 );
+  REQUIRE( l_set.sample( &l_waveProp, 0.5 ) == 1 );
+  REQUIRE( l_set.sample( &l_waveProp, 0.7 ) == 0 );
+  REQUIRE( l_set.getBufferedSamples() == 6 );
+  REQUIRE( l_set.getStations()[0].getRecords().empty() );
+
+  l_set.write( false );
+  REQUIRE( l_set.getBufferedSamples() == 0 );
+  REQUIRE( l_set.getStations()[0].getNextRecordTime() == 1 );
+  REQUIRE( l_set.getStations()[4].getNextRecordTime() == 1 );
+
+  // time, height, momentum x, momentum y of the first record
+  t_real l_expected[5][4] = {
+    { 0, 22, 2, 6 },
+    { 0, 0.375f * 13 + 0.125f * 14 + 0.375f * 23 + 0.125f * 24, 4.5, 4.5 },
+    { 0, 11, 10, 1.5 },
+    { 0, 34, 6, 9 },
+    { 0, 1, 0, 0 }
+  };
+  t_idx l_nRecords[5] = { 1, 1, 1, 1, 2 };
+  for( t_idx l_st = 0; l_st < 5; l_st++ ) {
+    tsunami_lab::io::Station & l_station = l_set.getStations()[l_st];
+    std::ifstream l_file( l_station.getFileName() );
+    std::string l_line;
+    std::getline( l_file, l_line );
+    REQUIRE( l_line == "time,height,momentumX,momentumY" );
+    t_idx l_nLines = 0;
+    while( std::getline( l_file, l_line ) ) {
+      float l_values[4];
+      REQUIRE( std::sscanf( l_line.c_str(), "%f,%f,%f,%f", &l_values[0], &l_values[1], &l_values[2], &l_values[3] ) == 4 );
+      if( l_nLines == 0 ) {
+        for( t_idx l_va = 0; l_va < 4; l_va++ ) REQUIRE( l_values[l_va] == Approx( l_expected[l_st][l_va] ) );
+      } else {
+        REQUIRE( l_values[0] == Approx( 0.5 ) );
+      }
+      l_nLines++;
+    }
+    REQUIRE( l_nLines == l_nRecords[l_st] );
+    l_file.close();
+    std::remove( l_station.getFileName().c_str() );
+  }
+}
+
+TEST_CASE( "Test that the station set samples patches without dense storage like dense ones.", "[StationSet]" ) {
+
+  t_idx l_nx = 12, l_ny = 10;
+  tsunami_lab::setups::DamBreak2d l_setup( 10, 5, 6, 5, 3, -10 );
+  tsunami_lab::patches::WavePropagation2d       l_dense ( l_nx, l_ny, &l_setup, 1, 1 );
+  tsunami_lab::patches::WavePropagation2dSparse l_sparse( l_nx, l_ny, &l_setup, 1, 1, 4 );
+  for( t_idx l_it = 0; l_it < 3; l_it++ ) {
+    l_dense.setGhostOutflow();
+    l_dense.timeStep( 0.1 );
+    l_sparse.setGhostOutflow();
+    l_sparse.timeStep( 0.1 );
+  }
+
+  // a grid of virtual gauges
+  std::vector<tsunami_lab::io::Station> l_stations;
+  for( t_idx l_iy = 0; l_iy < 9; l_iy++ ) {
+    for( t_idx l_ix = 0; l_ix < 11; l_ix++ ) {
+      l_stations.push_back( tsunami_lab::io::Station( l_ix, l_iy, "tmp-gauge-" + std::to_string( l_ix + l_iy * 11 ), 1 ) );
+      l_stations.back().setSubcellOffset( 0.1 * ( l_ix % 10 ), 0.3 );
+    }
+  }
+  tsunami_lab::io::StationSet l_denseSet ( l_stations, l_nx, l_ny );
+  tsunami_lab::io::StationSet l_sparseSet( l_stations, l_nx, l_ny );
+  REQUIRE( l_denseSet.sample ( &l_dense,  0 ) == l_stations.size() );
+  REQUIRE( l_sparseSet.sample( &l_sparse, 0 ) == l_stations.size() );
+
+  // write() hands the samples to the stations, before they are written
+  l_denseSet.write( false );
+  std::vector<std::string> l_denseFiles;
+  for( tsunami_lab::io::Station & l_station : l_denseSet.getStations() ) {
+    std::ifstream l_file( l_station.getFileName() );
+    std::stringstream l_content;
+    l_content << l_file.rdbuf();
+    l_denseFiles.push_back( l_content.str() );
+  }
+  l_sparseSet.write( false );
+  for( t_idx l_st = 0; l_st < l_stations.size(); l_st++ ) {
+    tsunami_lab::io::Station & l_station = l_sparseSet.getStations()[l_st];
+    std::ifstream l_file( l_station.getFileName() );
+    std::string l_line, l_denseLine;
+    std::stringstream l_dense( l_denseFiles[l_st] );
+    while( std::getline( l_file, l_line ) ) {
+      REQUIRE( std::getline( l_dense, l_denseLine ) );
+      float l_values[4], l_denseValues[4];
+      if( std::sscanf( l_line.c_str(), "%f,%f,%f,%f", &l_values[0], &l_values[1], &l_values[2], &l_values[3] ) != 4 ) continue;
+      REQUIRE( std::sscanf( l_denseLine.c_str(), "%f,%f,%f,%f", &l_denseValues[0], &l_denseValues[1], &l_denseValues[2], &l_denseValues[3] ) == 4 );
+      for( t_idx l_va = 0; l_va < 4; l_va++ ) REQUIRE( l_values[l_va] == Approx( l_denseValues[l_va] ).margin( 1e-4 ) );
+    }
+    l_file.close();
+    std::remove( l_station.getFileName().c_str() );
+  }
+}
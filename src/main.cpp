@@ -18,23 +18,37 @@
  
 #include <vector>
 #include <map>
+#include <memory> // std::unique_ptr
 #include <fstream>
 #include <limits> // infinity, max int
 #include <chrono> // measuring performance
 #include <sys/stat.h> // check whether a file exists
+#include <sys/resource.h> // peak memory
+#include <unistd.h> // page size
 #include <omp.h> // for max threads
 #include <cmath> // std::sqrt
+#include <algorithm> // std::find
 
 #include <yaml-cpp/yaml.h>
 
+#include "io/Aggregates.h"
 #include "io/Csv.h"
+#include "io/GridCache.h"
 #include "io/NetCdf.h"
+#include "io/NetCdfWriter.h"
+#include "io/CheckpointChain.h"
+#include "io/RawCheckpoint.h"
 #include "io/Station.h"
+#include "io/StationSet.h"
 #include "patches/WavePropagation1d.h"
 #include "patches/WavePropagation2d.h"
+#include "patches/WavePropagation2dCompact.h"
+#include "patches/WavePropagation2dSparse.h"
+#include "patches/WavePropagation2dMuscl.h"
 #include "setups/ArtificialTsunami2d.h"
 #include "setups/DamBreak1d.h"
 #include "setups/DamBreak2d.h"
+#include "setups/PreparedGrid2d.h"
 #include "setups/Discontinuity1d.h"
 #include "setups/SubcriticalFlow1d.h"
 #include "setups/SupercriticalFlow1d.h"
@@ -75,6 +89,40 @@ std::string readFileAsString(std::string i_fileName){
   return buffer.str();
 }
 
+// resident memory of this process in MB: the current one, or the peak of the whole run
+double residentMegabytes(bool i_peak){
+  if(i_peak){
+    struct rusage l_usage;
+    if(getrusage(RUSAGE_SELF, &l_usage)) return 0;
+    return l_usage.ru_maxrss / 1024.0;// in kB on Linux
+  }
+  std::ifstream l_statm("/proc/self/statm");
+  double l_size = 0, l_resident = 0;
+  l_statm >> l_size >> l_resident;
+  return l_resident * sysconf(_SC_PAGESIZE) / (1024.0 * 1024.0);
+}
+
+// writes a frame for exportCSV as solution_<index>.csv, as its binary alternative solution_<index>.bin, or both
+int exportFrame( std::string const                     & i_format,
+                 t_idx                                   i_index,
+                 t_real                                  i_cellSizeMeters,
+                 t_idx                                   i_nx,
+                 t_idx                                   i_ny,
+                 t_idx                                   i_step,
+                 tsunami_lab::patches::WavePropagation * i_waveProp ){
+  std::string l_path = "solution_" + std::to_string(i_index);
+  t_real const * l_arrays[4] = { i_waveProp->getHeight(), i_waveProp->getMomentumX(), i_waveProp->getMomentumY(), i_waveProp->getBathymetry() };
+  if(i_format != "binary"){
+    std::cout << "  writing wave field to " << l_path << ".csv" << std::endl;
+    if(tsunami_lab::io::Csv::write(l_path + ".csv", i_cellSizeMeters, i_nx, i_ny, i_step, i_waveProp->getStride(), l_arrays[0], l_arrays[1], l_arrays[2], l_arrays[3])) return -1;
+  }
+  if(i_format != "text"){
+    std::cout << "  writing wave field to " << l_path << ".bin" << std::endl;
+    if(tsunami_lab::io::Csv::writeBinary(l_path + ".bin", i_cellSizeMeters, i_nx, i_ny, i_step, i_waveProp->getStride(), l_arrays[0], l_arrays[1], l_arrays[2], l_arrays[3])) return -1;
+  }
+  return 0;
+}
+
 int main( int i_argc, char *i_argv[] ) {
   
   std::cout << "####################################" << std::endl;
@@ -126,39 +174,74 @@ int main( int i_argc, char *i_argv[] ) {
   size_t l_configHash = std::hash<std::string>{}(readFileAsString(l_configPath));
   std::string l_configPathStr(l_configPath);
   std::string l_configPathName = l_configPathStr.substr(l_configPathStr.find_last_of("/\\") + 1);
-  std::string l_checkpointPathDefault = "checkpoint-" + l_configPathName + "." + std::to_string(l_configHash) + ".nc";
+  // netcdf = compressed, portable checkpoints; raw = arrays in the memory layout of the patch, which are written and restored at the speed of the disk
+  std::string l_checkpointFormat = readOrDefault<std::string>(l_config, "checkpointFormat", "netcdf");
+  if(l_checkpointFormat != "netcdf" && l_checkpointFormat != "raw"){
+    std::cerr << "unknown checkpoint format \"" << l_checkpointFormat << "\", using netcdf" << std::endl;
+    l_checkpointFormat = "netcdf";
+  }
+  bool l_rawCheckpoints = l_checkpointFormat == "raw";
+  std::string l_checkpointPathDefault = "checkpoint-" + l_configPathName + "." + std::to_string(l_configHash) + (l_rawCheckpoints ? ".raw" : ".nc");
   std::string l_checkpointPath = readOrDefault<std::string>(l_config, "checkpointFile", l_checkpointPathDefault);
   t_idx l_checkpointingPeriod = readOrDefault<t_real>(l_config, "checkpointPeriod", 10 * 60);// default: create a checkpoint every 10 mins
   
-  std::cout << "checkpoint file: " << l_checkpointPath << ", interval: " << l_checkpointingPeriod << "s" << std::endl;
+  // a forked child writes the checkpoint, while the simulation continues
+  bool l_asyncCheckpoints = readOrDefault(l_config, "asyncCheckpoints", false);
+  pid_t l_checkpointChild = 0;
+  
+  // raw checkpoints only: deltas of the changed blocks between two full checkpoints, and the number of chains of a full checkpoint and its deltas, which are kept
+  t_idx l_checkpointDeltas = readOrDefault<t_idx>(l_config, "checkpointDeltas", 0);
+  t_idx l_checkpointRetention = readOrDefault<t_idx>(l_config, "checkpointRetention", 1);
+  if(!l_rawCheckpoints && (l_checkpointDeltas > 0 || l_checkpointRetention > 1)){
+    std::cerr << "checkpointDeltas and checkpointRetention need checkpointFormat: raw, writing full checkpoints" << std::endl;
+  }
+  tsunami_lab::io::CheckpointChain l_checkpointChain(l_checkpointPath, l_checkpointDeltas, l_checkpointRetention);
+  
+  std::cout << "checkpoint file: " << l_checkpointPath << ", interval: " << l_checkpointingPeriod << "s, format: " << l_checkpointFormat << (l_asyncCheckpoints ? ", async" : "") << std::endl;
+  if(l_rawCheckpoints && l_checkpointDeltas > 0) std::cout << "  full checkpoint after " << l_checkpointDeltas << " deltas, chains kept: " << l_checkpointRetention << std::endl;
   
   bool l_printStationComments = readOrDefault(l_config, "printStationComments", true);
+  // records per station, which are buffered before they are appended to the station files
+  t_idx l_stationBufferSize = std::max(readOrDefault<t_idx>(l_config, "stationBufferSize", 1000), (t_idx) 1);
+  bool l_restoredCheckpoint = false;
+  // raw checkpoints are read by RawCheckpoint, else they are NetCDF files
+  bool l_rawCheckpointFile = false;
   
   if(readOrDefault(l_config, "readCheckpoints", true) && fileExists(l_checkpointPath)){
-    // h, hu, hv, b
+    // the fields are read after the construction of the patch
     l_scale = 1;
-    // todo create setup
-    l_setup = tsunami_lab::io::NetCDF::loadCheckpoint(l_checkpointPath, l_nx, l_ny, l_cellSizeMeters, l_cflFactor, l_simulationTime, l_timeStepIndex, l_stations);
     // only required for the first frame
     l_gridOffsetX = 0;
     l_gridOffsetY = 0;
-	// remove ghost cells
-	l_nx -= 2;
-	if(l_ny > 2) l_ny -= 2;
-    if(l_setup == nullptr){
+    l_rawCheckpointFile = tsunami_lab::io::RawCheckpoint::isRawCheckpoint(l_checkpointPath);
+    int l_err;
+    if(l_rawCheckpointFile){
+      l_err = tsunami_lab::io::RawCheckpoint::load(l_checkpointPath, l_nx, l_ny, l_cellSizeMeters, l_cflFactor, l_simulationTime, l_timeStepIndex, l_stations);
+    } else {
+      l_err = tsunami_lab::io::NetCDF::loadCheckpointInfo(l_checkpointPath, l_nx, l_ny, l_cellSizeMeters, l_cflFactor, l_simulationTime, l_timeStepIndex, l_stations);
+      // remove ghost cells
+      l_nx -= 2;
+      if(l_ny > 2) l_ny -= 2;
+    }
+    if(l_err){
       std::cerr << "warn: checkpoint could not be loaded!, starting from zero!" << std::endl;
+      l_stations.clear();
     } else {
       std::cout << "loaded checkpoint: " << l_simulationTime << "s, frameIndex: " << l_timeStepIndex << std::endl;
+      l_restoredCheckpoint = true;
     }
   }
   
-  // must stay in scope; I don't have a better solution currently; maybe the value could be moved into setup
-  // a copy shouldn't be expensive compared to our simulation and writing the results to disk
+  // inputs of the setup; they are freed together with the setup before the time loop,
+  // because the writers sample the displacement at their resolution before
   std::vector<t_real> l_bathymetry;
   std::vector<t_real> l_displacement;
+  // grids of the Tsunami2d setup at the resolution of the simulation, from earlier runs with the same inputs, e.g. gridCache: cache;
+  // a cached grid is mapped from its file until the setup is freed
+  tsunami_lab::io::GridCache l_gridCache(readOrDefault<std::string>(l_config, "gridCache", ""));
   
   // setup is null if no checkpoint was found or it could not be loaded
-  if(l_setup == nullptr){
+  if(!l_restoredCheckpoint){
     
     std::cout << "loading setup from config file" << std::endl;
     
@@ -177,7 +260,7 @@ int main( int i_argc, char *i_argv[] ) {
     t_real l_splitPositionX  = readOrDefault<t_real>(l_config, "splitPositionX", l_nx * 0.5);
     t_real l_splitPositionY  = readOrDefault<t_real>(l_config, "splitPositionY", l_ny * 0.5);
     t_real l_damRadius       = readOrDefault<t_real>(l_config, "damRadius", l_nx / 4);
-           l_cellSizeMeters  = readOrDefault<t_real>(l_config, "cellSize", 1);// size of a single cell in meters
+           l_cellSizeMeters  = readOrDefault<t_real>(l_config, "cellSize", readOrDefault<t_real>(l_config, "cellSizeMeters", 1));// size of a single cell in meters
            l_scale           = readOrDefault<t_real>(l_config, "scale", 1);// scales the setup for accuracy or performance
            l_cflFactor       = readOrDefault<t_real>(l_config, "cflFactor", 0.45);
            l_simulationTime  = 0;
@@ -250,9 +333,9 @@ int main( int i_argc, char *i_argv[] ) {
       
         auto l_loadedData = tsunami_lab::io::Csv::read(l_fileName);
       
-        // here we probably copy; this potentially could be optimized
-        auto l_xs = tsunami_lab::io::Csv::findColumn(l_loadedData, "track_location");
-        l_bathymetry = tsunami_lab::io::Csv::findColumn(l_loadedData, "height");
+        // the columns are moved out of the data, not copied
+        auto l_xs = tsunami_lab::io::Csv::takeColumn(l_loadedData, "track_location");
+        l_bathymetry = tsunami_lab::io::Csv::takeColumn(l_loadedData, "height");
       
         if(l_xs.size() < 1){
           std::cerr << "did not find position data in track file" << std::endl;
@@ -307,33 +390,95 @@ int main( int i_argc, char *i_argv[] ) {
         return EXIT_FAILURE;
       }
     
+      // part of the bathymetry, e.g. region: { x0: 100, y0: 50, x1: 900, y1: 450, unit: cells }, unit: cells or meters;
+      // coarsen: n loads n x n cells of both files as one, coarsenMode: average or pick (every n-th cell)
+      tsunami_lab::io::NetCDF::Region l_region;
+      bool l_hasRegion = false;
+      if(l_config["region"]){
+        l_hasRegion = true;
+        YAML::Node l_regionConfig = l_config["region"];
+        l_region.x0 = readOrDefault<double>(l_regionConfig, "x0", 0);
+        l_region.y0 = readOrDefault<double>(l_regionConfig, "y0", 0);
+        l_region.x1 = readOrDefault<double>(l_regionConfig, "x1", 0);
+        l_region.y1 = readOrDefault<double>(l_regionConfig, "y1", 0);
+        l_region.inMeters = readOrDefault<std::string>(l_regionConfig, "unit", "cells") == "meters";
+      }
+      l_region.stride  = std::max(readOrDefault<t_idx>(l_config, "coarsen", 1), (t_idx) 1);
+      l_region.average = readOrDefault<std::string>(l_config, "coarsenMode", "average") != "pick";
+      
+      // the key covers the size and modification time of both files, and the parameters, which change the grid
+      uint64_t l_gridKey = 0;
+      bool l_cacheGrid = l_gridCache.isEnabled();
+      if(l_cacheGrid){
+        std::string l_parameters;
+        for(char const * l_key : { "region", "coarsen", "coarsenMode", "scale", "areaAverages" }){
+          l_parameters += std::string(l_key) + ": " + (l_config[l_key] ? YAML::Dump(l_config[l_key]) : "") + "\n";
+        }
+        l_cacheGrid = tsunami_lab::io::GridCache::key({ l_bathymetryFileName, l_displacementFileName }, l_parameters, l_gridKey) == 0;
+      }
+      
       // load data
       t_idx l_nx2, l_ny2;
       t_real l_cellSizeMeters2;
       t_real l_tmp;
-      tsunami_lab::io::NetCDF::load2dArray(l_bathymetryFileName, "z", l_nx, l_ny, l_cellSizeMeters2, l_gridOffsetX, l_gridOffsetY, l_bathymetry);
-      tsunami_lab::io::NetCDF::load2dArray(l_displacementFileName, "z", l_nx2, l_ny2, l_cellSizeMeters2, l_tmp, l_tmp, l_displacement);
+      tsunami_lab::setups::PreparedGrid2d* l_cachedGrid = nullptr;
+      if(l_cacheGrid) l_cachedGrid = l_gridCache.load(l_gridKey, l_nx, l_ny, l_cellSizeMeters2, l_gridOffsetX, l_gridOffsetY);
+      if(l_cachedGrid){
+        std::cout << "using the prepared grid " << l_gridCache.fileName(l_gridKey) << std::endl;
+        l_setup = l_cachedGrid;
+      } else {
+        if(tsunami_lab::io::NetCDF::load2dArray(l_bathymetryFileName, "z", l_nx, l_ny, l_cellSizeMeters2, l_gridOffsetX, l_gridOffsetY, l_bathymetry, l_region)) return EXIT_FAILURE;
+        // the displacement is read for the same area in meters, because its resolution may differ
+        tsunami_lab::io::NetCDF::Region l_displacementRegion = l_region;
+        if(l_hasRegion){
+          l_displacementRegion.inMeters = true;
+          l_displacementRegion.x0 = l_gridOffsetX - 1.5 * l_cellSizeMeters2;
+          l_displacementRegion.y0 = l_gridOffsetY - 1.5 * l_cellSizeMeters2;
+          l_displacementRegion.x1 = l_displacementRegion.x0 + l_nx * l_cellSizeMeters2;
+          l_displacementRegion.y1 = l_displacementRegion.y0 + l_ny * l_cellSizeMeters2;
+        }
+        if(tsunami_lab::io::NetCDF::load2dArray(l_displacementFileName, "z", l_nx2, l_ny2, l_tmp, l_tmp, l_tmp, l_displacement, l_displacementRegion)) return EXIT_FAILURE;
+        if(l_hasRegion || l_region.stride > 1){
+          std::cout << "loaded " << l_nx << " x " << l_ny << " cells of the bathymetry, " << l_nx2 << " x " << l_ny2 << " cells of the displacement" << std::endl;
+        }
+        t_real l_sideRatio = (l_nx2 * l_ny) / (t_real) (l_ny2 * l_nx); // ideally 1
+        if(l_sideRatio < 0.99 || l_sideRatio > 1.01){
+          std::cerr << "warning: aspect ratio from bathymetry and displacement are different!" << std::endl;
+        }
+        if(l_nx < 2 || l_ny < 2 || l_nx2 < 2 || l_ny2 < 2){
+          std::cerr << "data must have at least 2 x 2 fields, read " << l_nx << " x " << l_ny << ", " << l_nx2 << " x " << l_ny2 << std::endl;
+          return EXIT_FAILURE;
+        }
+        // create setup
+        t_real l_scaleBath = 1.0 / (l_scale * l_scale);
+        t_real l_scaleDisp = 1.0 / (l_scale * l_scale) * std::sqrt((l_nx2 * l_ny2)/(t_real)(l_nx * l_ny));
+        auto l_tsunamiEvent = new tsunami_lab::setups::TsunamiEvent2d(
+          l_bathymetry.data(), l_nx, l_ny, l_nx, l_scaleBath,
+          l_displacement.data(), l_nx2, l_ny2, l_nx2, l_scaleDisp
+        );
+        // scale < 1: a cell covers several values of the inputs, so they are averaged instead of interpolated
+        if(readOrDefault<bool>(l_config, "areaAverages", true)) l_tsunamiEvent->useAreaAverages(l_scale);
+        l_setup = l_tsunamiEvent;
+        // scale it up
+        l_nx = (l_nx-2) * l_scale;// 2 for ghost cells; those cannot be scaled, and are re-added by the WavePropagation class
+        l_ny = (l_ny-2) * l_scale;
+        if(l_cacheGrid){
+          // the patches sample the grid instead of interpolating the inputs, so a later run with the cached grid has the same start
+          auto l_performanceTime2 = std::chrono::high_resolution_clock::now();
+          auto l_grid = new tsunami_lab::setups::PreparedGrid2d(l_setup, l_nx, l_ny, l_scale, l_scale);
+          delete l_setup;
+          l_setup = l_grid;
+          std::vector<t_real>().swap(l_bathymetry);
+          std::vector<t_real>().swap(l_displacement);
+          if(l_gridCache.store(l_gridKey, *l_grid, l_cellSizeMeters2, l_gridOffsetX, l_gridOffsetY) == 0){
+            auto l_performanceTime3 = std::chrono::high_resolution_clock::now();
+            std::cout << "prepared the grid " << l_gridCache.fileName(l_gridKey) << " in " << std::chrono::duration<double>(l_performanceTime3-l_performanceTime2).count() << "s" << std::endl;
+          }
+        }
+      }
       if(l_cellSizeMeters == 1.0){
         l_cellSizeMeters = l_cellSizeMeters2 / l_scale;// cell size depends on data & applied scale
       } else std::cout << "used cell size override from config. Cell size from file: " << l_cellSizeMeters2 << std::endl;
-      t_real l_sideRatio = (l_nx2 * l_ny) / (t_real) (l_ny2 * l_nx); // ideally 1
-      if(l_sideRatio < 0.99 || l_sideRatio > 1.01){
-        std::cerr << "warning: aspect ratio from bathymetry and displacement are different!" << std::endl;
-      }
-      if(l_nx < 2 || l_ny < 2 || l_nx2 < 2 || l_ny2 < 2){
-        std::cerr << "data must have at least 2 x 2 fields, read " << l_nx << " x " << l_ny << ", " << l_nx2 << " x " << l_ny2 << std::endl;
-        return EXIT_FAILURE;
-      }
-      // create setup
-	  t_real l_scaleBath = 1.0 / (l_scale * l_scale);
-	  t_real l_scaleDisp = 1.0 / (l_scale * l_scale) * std::sqrt((l_nx2 * l_ny2)/(t_real)(l_nx * l_ny));
-      l_setup = new tsunami_lab::setups::TsunamiEvent2d(
-        l_bathymetry.data(), l_nx, l_ny, l_nx, l_scaleBath,
-        l_displacement.data(), l_nx2, l_ny2, l_nx2, l_scaleDisp
-      );
-      // scale it up
-      l_nx = (l_nx-2) * l_scale;// 2 for ghost cells; those cannot be scaled, and are re-added by the WavePropagation class
-      l_ny = (l_ny-2) * l_scale;
     } else if( 
       l_setupName == "Subcritical" ||
       l_setupName == "SubcriticalFlow" ||
@@ -364,17 +509,18 @@ int main( int i_argc, char *i_argv[] ) {
     ///////////////////
     if(l_config["stations"]) {
       auto   l_stationData = l_config["stations"].as<std::vector<YAML::Node>>();
-      t_real l_delayBetweenRecords = readOrDefault(l_config, "delayBetweenRecords", 1);
+      t_real l_delayBetweenRecords = readOrDefault<t_real>(l_config, "delayBetweenRecords", 1);
       for(t_idx i=0;i<l_stationData.size();i++){
         
         auto l_station = l_stationData[i];
         std::string l_name = l_station["name"].as<std::string>();
         
-        int64_t l_x, l_y;
+        // positions between cell centers are interpolated bilinearly
+        double l_x, l_y;
         if(l_station["x"]){
           
-          l_x = l_station["x"].as<int64_t>();
-          l_y = l_station["y"].as<int64_t>();
+          l_x = l_station["x"].as<double>();
+          l_y = l_station["y"].as<double>();
           
         } else if(l_station["gridX"]){
           
@@ -394,9 +540,13 @@ int main( int i_argc, char *i_argv[] ) {
         }
         
         if(l_x >= 0 && (t_idx) l_x < l_nx && l_y >= 0 && (t_idx) l_y < l_ny){
-          t_real l_stationBathymetry = l_setup->getBathymetry(l_x * l_scale, l_y * l_scale);
+          t_idx  l_ix = (t_idx) l_x, l_iy = (t_idx) l_y;
+          // the center of the cell, where the patches are sampled; the same with and without the grid cache
+          t_real l_stationBathymetry = l_setup->getBathymetry((l_ix + (t_real) 0.5) * l_scale, (l_iy + (t_real) 0.5) * l_scale);
           if(l_stationBathymetry <= 0){
-            tsunami_lab::io::Station l_station1((t_idx) l_x, (t_idx) l_y, l_name, l_delayBetweenRecords);
+            // each station may have its own sampling period
+            tsunami_lab::io::Station l_station1(l_ix, l_iy, l_name, readOrDefault<t_real>(l_station, "delay", l_delayBetweenRecords));
+            l_station1.setSubcellOffset(l_x - l_ix, l_y - l_iy);
             l_stations.push_back(l_station1);
             std::cout << "Station " << i << ", '" << l_name << "' was placed on bathymetry " << l_stationBathymetry << std::endl;
           } else {
@@ -434,18 +584,127 @@ int main( int i_argc, char *i_argv[] ) {
   
   auto l_performanceTime1 = std::chrono::high_resolution_clock::now();
   
+  // storage format of the 2d state: float = t_real arrays, compact = 16 bit values, which are decoded for computation,
+  // sparse = t_real tiles, where tiles without water aren't allocated
+  std::string l_storage = readOrDefault<std::string>(l_config, "storage", "float");
+  std::string l_compactMomentum = readOrDefault<std::string>(l_config, "compactMomentum", "fp16");// fp16 or bf16
+  t_idx l_sparseTileSize = readOrDefault<t_idx>(l_config, "sparseTileSize", 32);
+  bool l_storageAccuracyReport = readOrDefault(l_config, "storageAccuracyReport", false);
+  // compact storage: minimum distance in meters, which the surface may move away from its initial range (0 = automatic),
+  // and the number of saturated values, after which the simulation is stopped
+  t_real l_compactSurfaceRange = readOrDefault<t_real>(l_config, "compactSurfaceRange", 0);
+  t_idx l_compactSaturationLimit = readOrDefault<t_idx>(l_config, "compactSaturationLimit", 0);
+  if(l_storage != "float" && l_storage != "compact" && l_storage != "sparse"){
+    std::cerr << "unknown storage format \"" << l_storage << "\", using float" << std::endl;
+    l_storage = "float";
+  }
+  if(l_storage != "float" && l_ny <= 1){
+    std::cerr << l_storage << " storage is only supported in 2d, using float" << std::endl;
+    l_storage = "float";
+  }
+  bool l_useCompactStorage = l_storage == "compact";
+  
+  // order of the 2d scheme: 1 = first order, 2 = MUSCL reconstruction with a two stage Runge-Kutta method; limiter: minmod or mc
+  t_idx l_order = readOrDefault<t_idx>(l_config, "order", 1);
+  std::string l_limiterName = readOrDefault<std::string>(l_config, "limiter", "minmod");
+  tsunami_lab::patches::WavePropagation2dMuscl::Limiter l_limiter = tsunami_lab::patches::WavePropagation2dMuscl::MINMOD;
+  if(l_order != 1 && l_order != 2){
+    std::cerr << "unsupported order " << l_order << ", using 1" << std::endl;
+    l_order = 1;
+  }
+  if(l_order == 2 && (l_storage != "float" || l_ny <= 1)){
+    std::cerr << "the second order scheme is only supported in 2d with float storage, using 1" << std::endl;
+    l_order = 1;
+  }
+  if(l_order == 2 && !tsunami_lab::patches::WavePropagation2dMuscl::parseLimiter(l_limiterName, l_limiter)){
+    std::cerr << "unknown limiter \"" << l_limiterName << "\", using minmod" << std::endl;
+    l_limiterName = "minmod";
+  }
+  
+  if(l_restoredCheckpoint && l_storage != "float"){
+    if(l_rawCheckpointFile){
+      std::cerr << "raw checkpoints can only be restored with float storage" << std::endl;
+      return EXIT_FAILURE;
+    }
+    // patches without t_real arrays are initialized from a copy of the fields
+    l_setup = tsunami_lab::io::NetCDF::loadCheckpointSetup(l_checkpointPath);
+    if(l_setup == nullptr) return EXIT_FAILURE;
+  }
+  
   // construct solver
   tsunami_lab::patches::WavePropagation* l_waveProp;
-  if(l_ny <= 1){
+  tsunami_lab::patches::WavePropagation* l_referenceProp = nullptr;
+  if(l_restoredCheckpoint && l_setup == nullptr){
+    // the arrays are zero, and the checkpoint is read into them without a copy
+    if(l_ny <= 1){
+      l_waveProp = new tsunami_lab::patches::WavePropagation1d(l_nx);
+    } else if(l_order == 2){
+      auto l_waveProp2 = new tsunami_lab::patches::WavePropagation2dMuscl(l_nx, l_ny, l_limiter);
+      l_waveProp2->setCflFactor(l_cflFactor);
+      l_waveProp = l_waveProp2;
+    } else {
+      auto l_waveProp2 = new tsunami_lab::patches::WavePropagation2d(l_nx, l_ny);
+      l_waveProp2->setCflFactor(l_cflFactor);
+      l_waveProp = l_waveProp2;
+    }
+    auto l_restoreTime0 = std::chrono::high_resolution_clock::now();
+    int l_err = l_rawCheckpointFile ? tsunami_lab::io::RawCheckpoint::loadPatch(l_checkpointPath, l_waveProp)
+                                    : tsunami_lab::io::NetCDF::loadCheckpointFields(l_checkpointPath, l_waveProp);
+    if(l_err) return EXIT_FAILURE;
+    auto l_restoreTime1 = std::chrono::high_resolution_clock::now();
+    std::cout << "used " << std::chrono::duration<double>(l_restoreTime1-l_restoreTime0).count() << "s to read the fields of the checkpoint into the patch" << std::endl;
+  } else if(l_ny <= 1){
     l_waveProp = new tsunami_lab::patches::WavePropagation1d(l_nx, l_setup, l_scale);
+  } else if(l_useCompactStorage){
+    auto l_waveProp2 = new tsunami_lab::patches::WavePropagation2dCompact(l_nx, l_ny, l_setup, l_scale, l_scale, l_compactMomentum == "bf16", l_compactSurfaceRange);
+	l_waveProp2->setCflFactor(l_cflFactor);
+	l_waveProp = l_waveProp2;
+  } else if(l_storage == "sparse"){
+    auto l_waveProp2 = new tsunami_lab::patches::WavePropagation2dSparse(l_nx, l_ny, l_setup, l_scale, l_scale, l_sparseTileSize);
+	l_waveProp2->setCflFactor(l_cflFactor);
+	l_waveProp = l_waveProp2;
+  } else if(l_order == 2){
+    auto l_waveProp2 = new tsunami_lab::patches::WavePropagation2dMuscl(l_nx, l_ny, l_setup, l_scale, l_scale, l_limiter);
+	l_waveProp2->setCflFactor(l_cflFactor);
+	l_waveProp = l_waveProp2;
   } else {
     auto l_waveProp2 = new tsunami_lab::patches::WavePropagation2d(l_nx, l_ny, l_setup, l_scale, l_scale);
 	l_waveProp2->setCflFactor(l_cflFactor);
 	l_waveProp = l_waveProp2;
   }
+  if(l_storage != "float" && l_storageAccuracyReport){
+    // run with float storage and the same time steps, which the stations are compared against
+    auto l_referenceProp2 = new tsunami_lab::patches::WavePropagation2d(l_nx, l_ny, l_setup, l_scale, l_scale);
+    l_referenceProp2->setCflFactor(l_cflFactor);
+    l_referenceProp = l_referenceProp2;
+  }
+  if(l_rawCheckpoints && !tsunami_lab::io::RawCheckpoint::isSupported(l_waveProp)){
+    std::cerr << "raw checkpoints need float storage, using netcdf" << std::endl;
+    l_rawCheckpoints = false;
+  }
+  std::cout << "  storage:                        " << (l_useCompactStorage ? "compact, momenta as " + l_compactMomentum : l_storage) << std::endl;
+  std::cout << "  order:                          " << (l_order == 2 ? "2, " + l_limiterName + " limiter" : "1") << std::endl;
+  
+  // number of threads per loop: adaptive = from a cost model, which is calibrated on startup, such that small grids run serially;
+  // all = every loop uses all OpenMP threads
+  std::string l_threadPolicy = readOrDefault<std::string>(l_config, "threadPolicy", "adaptive");
+  if(l_threadPolicy == "adaptive"){
+    auto l_executionPolicy = tsunami_lab::patches::ExecutionPolicy::calibrate(omp_get_max_threads());
+    l_executionPolicy.print(l_nx, l_ny, std::cout);
+    l_waveProp->setExecutionPolicy(l_executionPolicy);
+    if(l_referenceProp) l_referenceProp->setExecutionPolicy(l_executionPolicy);
+  } else if(l_threadPolicy != "all"){
+    std::cerr << "unknown thread policy \"" << l_threadPolicy << "\", using all threads" << std::endl;
+  }
   
-  // no longer needed
-  // l_bathymetry.resize(0);
+  // the stations are sampled together
+  tsunami_lab::io::StationSet l_stationSet(l_stations, l_nx, l_ny);
+  l_stations.clear();
+  
+  // storage accuracy report: max and squared sum of the errors of h, hu, hv per station
+  std::vector<t_real> l_accuracyMax(l_stationSet.size() * 3, 0);
+  std::vector<double> l_accuracySumSq(l_stationSet.size() * 3, 0);
+  t_idx l_accuracySamples = 0;
   
   // set up print control
   t_idx  l_nOut = 0;
@@ -455,9 +714,110 @@ int main( int i_argc, char *i_argv[] ) {
   
   std::string l_netCdfPath = readOrDefault<std::string>(l_config, "outputFile", "solution.nc");
   int    l_deflateLevel = readOrDefault<int>(l_config, "outputCompression", 5);
+  std::string l_codecName = readOrDefault<std::string>(l_config, "outputCodec", "deflate");
+  tsunami_lab::io::NetCDF::Codec l_codec = tsunami_lab::io::NetCDF::DEFLATE;
+  if(!tsunami_lab::io::NetCDF::parseCodec(l_codecName, l_codec)){
+    std::cerr << "unknown output codec \"" << l_codecName << "\", using deflate" << std::endl;
+  }
+  // rows per chunk of the output and checkpoint variables; 0 = NetCDF default
+  tsunami_lab::io::NetCDF::setCompression(l_codec, readOrDefault<t_idx>(l_config, "outputChunkRows", 0));
+  // lossy output frames: significant bits per quantity, e.g. outputSignificantBits: { height: 16, momentumX: 10, momentumY: 10 }; checkpoints stay lossless
+  if(l_config["outputSignificantBits"]){
+    YAML::Node l_bits = l_config["outputSignificantBits"];
+    std::string l_quantities[3] = { "height", "momentumX", "momentumY" };
+    for(unsigned short l_qu = 0; l_qu < 3; l_qu++){
+      int l_nBits = readOrDefault<int>(l_bits, l_quantities[l_qu], 0);
+      tsunami_lab::io::NetCDF::setSignificantBits(l_qu, l_nBits);
+      if(l_nBits > 0) std::cout << "  " << l_quantities[l_qu] << " is written with " << std::min(l_nBits, 23) << " significant bits" << std::endl;
+    }
+  }
   bool   l_exportCSV = readOrDefault(l_config, "exportCSV", false);
+  // text, binary or both
+  std::string l_exportFormat = readOrDefault<std::string>(l_config, "exportCSVFormat", "text");
+  if(l_exportFormat != "text" && l_exportFormat != "binary" && l_exportFormat != "both"){
+    std::cerr << "unknown exportCSVFormat '" << l_exportFormat << "', it must be text, binary or both" << std::endl;
+    return EXIT_FAILURE;
+  }
   double l_debugPrintPerformanceInterval = readOrDefault<double>(l_config, "debugPrintPerformanceInterval", 1.0);
   
+  // number of frames, which are buffered for the NetCDF writer thread; 0 writes synchronously
+  t_idx  l_outputQueueDepth = readOrDefault<t_idx>(l_config, "outputQueueDepth", 2);
+  // output streams; each file stays open for the whole run
+  std::vector<std::unique_ptr<tsunami_lab::io::NetCDFWriter>> l_writers;
+  if(!l_exportCSV && l_config["outputs"]){
+    // e.g. outputs: [ { file: preview.nc, period: 60, step: 8 }, { file: coast.nc, period: 5, gridX0: ..., gridY0: ..., gridX1: ..., gridY1: ..., variables: [ height ] } ]
+    auto l_outputData = l_config["outputs"].as<std::vector<YAML::Node>>();
+    for(t_idx i=0;i<l_outputData.size();i++){
+      
+      auto l_output = l_outputData[i];
+      std::string l_fileName = readOrDefault<std::string>(l_output, "file", "output_" + std::to_string(i) + ".nc");
+      
+      // region in cells, or in coordinates of the input grid like stations; the end is exclusive
+      int64_t l_x0 = 0, l_y0 = 0, l_x1 = l_nx, l_y1 = l_ny;
+      if(l_output["gridX0"]){
+        l_x0 = (readOrDefault<t_real>(l_output, "gridX0", 0) - l_gridOffsetX) / l_cellSizeMeters;
+        l_y0 = (readOrDefault<t_real>(l_output, "gridY0", 0) - l_gridOffsetY) / l_cellSizeMeters;
+        l_x1 = std::ceil((readOrDefault<t_real>(l_output, "gridX1", 0) - l_gridOffsetX) / l_cellSizeMeters);
+        l_y1 = std::ceil((readOrDefault<t_real>(l_output, "gridY1", 0) - l_gridOffsetY) / l_cellSizeMeters);
+      } else {
+        l_x0 = readOrDefault<int64_t>(l_output, "x0", l_x0);
+        l_y0 = readOrDefault<int64_t>(l_output, "y0", l_y0);
+        l_x1 = readOrDefault<int64_t>(l_output, "x1", l_x1);
+        l_y1 = readOrDefault<int64_t>(l_output, "y1", l_y1);
+      }
+      l_x0 = std::max(l_x0, (int64_t) 0);
+      l_y0 = std::max(l_y0, (int64_t) 0);
+      if(l_x1 <= l_x0 || l_y1 <= l_y0 || (t_idx) l_x0 >= l_nx || (t_idx) l_y0 >= l_ny){
+        std::cerr << "Output " << i << ", '" << l_fileName << "' doesn't overlap the domain" << std::endl;
+        return EXIT_FAILURE;
+      }
+      
+      unsigned short l_quantities = tsunami_lab::io::NetCDFWriter::m_allQuantities;
+      if(l_output["variables"]){
+        std::string l_names[4] = { "height", "momentumX", "momentumY", "bathymetry" };
+        l_quantities = 0;
+        for(std::string const & l_variable : l_output["variables"].as<std::vector<std::string>>()){
+          t_idx l_qu = std::find(l_names, l_names + 4, l_variable) - l_names;
+          if(l_qu == 4){
+            std::cerr << "Output " << i << ", '" << l_fileName << "' has unknown variable '" << l_variable << "'" << std::endl;
+            return EXIT_FAILURE;
+          }
+          l_quantities |= 1 << l_qu;
+        }
+      }
+      
+      t_idx l_step = std::max(readOrDefault<t_idx>(l_output, "step", 1), (t_idx) 1);
+      l_writers.emplace_back(new tsunami_lab::io::NetCDFWriter(l_cellSizeMeters, l_nx, l_ny, l_gridOffsetX, l_gridOffsetY, l_x0, l_y0, l_x1, l_y1, l_step, l_quantities,
+                             readOrDefault<int>(l_output, "compression", l_deflateLevel), l_fileName, l_outputQueueDepth));
+      l_writers.back()->setPeriod(readOrDefault<t_real>(l_output, "period", l_outputPeriod));
+      std::cout << "Output " << i << ", '" << l_fileName << "': cells [" << l_x0 << ", " << std::min((t_idx) l_x1, l_nx) << ") x [" << l_y0 << ", " << std::min((t_idx) l_y1, l_ny) << "), step " << l_step << std::endl;
+    }
+  } else if(!l_exportCSV){
+    l_writers.emplace_back(new tsunami_lab::io::NetCDFWriter(l_cellSizeMeters, l_nx, l_ny, l_gridOffsetX, l_gridOffsetY, l_outputStepSize, l_deflateLevel, l_netCdfPath, l_outputQueueDepth));
+    l_writers.back()->setPeriod(l_outputPeriod);
+  }
+  
+  // per-cell maxima and arrival times for hazard maps, e.g. aggregates: { file: hazard.nc, arrivalThreshold: 0.1 }
+  std::unique_ptr<tsunami_lab::io::Aggregates> l_aggregates;
+  std::string l_aggregatesPath;
+  if(l_config["aggregates"]){
+    YAML::Node l_aggregateConfig = l_config["aggregates"];
+    l_aggregatesPath = readOrDefault<std::string>(l_aggregateConfig, "file", "aggregates.nc");
+    l_aggregates.reset(new tsunami_lab::io::Aggregates(l_nx, l_ny, readOrDefault<t_real>(l_aggregateConfig, "arrivalThreshold", 0.1)));
+    if(l_restoredCheckpoint && l_rawCheckpointFile){
+      if(tsunami_lab::io::RawCheckpoint::loadAggregates(l_checkpointPath, *l_aggregates)) return EXIT_FAILURE;
+    } else if(l_restoredCheckpoint && tsunami_lab::io::NetCDF::loadAggregates(l_checkpointPath, *l_aggregates)) return EXIT_FAILURE;
+  }
+  
+  // the patches are initialized, and the writers keep the displacement, so the setup and its inputs are no longer needed
+  for(auto &l_writer : l_writers) l_writer->sampleDisplacement(l_setup);
+  delete l_setup;
+  l_setup = nullptr;
+  std::vector<t_real>().swap(l_bathymetry);
+  std::vector<t_real>().swap(l_displacement);
+  l_gridCache.unload();
+  std::cout << "freed the setup, resident memory: " << residentMegabytes(false) << " MB, peak until now: " << residentMegabytes(true) << " MB" << std::endl;
+  
   auto l_performanceTimeDebug0 = std::chrono::high_resolution_clock::now();
   auto l_checkpointingTime0 = l_performanceTimeDebug0;
   
@@ -479,9 +839,34 @@ int main( int i_argc, char *i_argv[] ) {
     if(l_durI2 >= l_checkpointingPeriod){
       // create a new checkpoint
       std::cout << "  saving checkpoint" << std::endl;
-      tsunami_lab::io::NetCDF::storeCheckpoint(l_checkpointPath, l_nx, l_ny, l_cellSizeMeters, l_cflFactor, l_simulationTime, l_timeStepIndex, l_stations, l_waveProp);
-      std::cout << "  finished saving checkpoint" << std::endl;
+      // the NetCDF library isn't thread safe; the output until now shall survive a crash, too
+      for(auto &l_writer : l_writers) if(l_writer->sync()) return EXIT_FAILURE;
+      // the checkpoint only stores the sizes of the station files
+      l_stationSet.write(l_printStationComments);
+      // a delta after a failed checkpoint would miss the changes of the failed one
+      if(tsunami_lab::io::NetCDF::waitForCheckpoint(l_checkpointChild)){
+        std::cerr << "The previous checkpoint failed" << std::endl;
+        l_checkpointChain.invalidate();
+      }
+      if(l_rawCheckpoints){
+        l_checkpointChain.prepare(l_waveProp, l_aggregates.get());
+        if(l_checkpointChain.getDeltaIndex() > 0){
+          std::cout << "  delta " << l_checkpointChain.getDeltaIndex() << ": " << l_checkpointChain.getChangedBlocks() << " of "
+                    << l_checkpointChain.getTotalBlocks() << " blocks changed" << std::endl;
+        }
+      }
+      auto l_storeCheckpoint = [&]() -> int {
+        if(l_rawCheckpoints) return l_checkpointChain.store(l_nx, l_ny, l_cellSizeMeters, l_cflFactor, l_simulationTime, l_timeStepIndex, l_stationSet.getStations(), l_waveProp, l_aggregates.get());
+        return tsunami_lab::io::NetCDF::storeCheckpoint(l_checkpointPath, l_nx, l_ny, l_cellSizeMeters, l_cflFactor, l_simulationTime, l_timeStepIndex, l_stationSet.getStations(), l_waveProp, l_aggregates.get());
+      };
+      if(l_asyncCheckpoints){
+        tsunami_lab::io::NetCDF::forkCheckpoint(l_storeCheckpoint, l_checkpointChild);
+      } else if(l_storeCheckpoint()){
+        l_checkpointChain.invalidate();
+      }
       l_checkpointingTime0 = std::chrono::high_resolution_clock::now();// reset the timer for the next checkpoint
+      std::cout << "  finished saving checkpoint, the simulation was paused for " << std::chrono::duration<double>(l_checkpointingTime0-l_stepTime).count() << "s" << std::endl;
+      if(l_useCompactStorage) std::cout << "  saturated compact values: " << l_waveProp->getNumSaturated() << std::endl;
     }
     
     // index, which frame we'd need to print theoretically
@@ -494,32 +879,42 @@ int main( int i_argc, char *i_argv[] ) {
       
       if(l_exportCSV){
         
-        std::string l_path = "solution_" + std::to_string(l_nOut) + ".csv";
-        std::cout << "  writing wave field to " << l_path << std::endl;
-        
-        std::ofstream l_file(l_path, std::ios::out);
-        tsunami_lab::io::Csv::write(l_cellSizeMeters, l_nx, l_ny, l_outputStepSize, l_waveProp->getStride(), l_waveProp->getHeight(), l_waveProp->getMomentumX(), l_waveProp->getMomentumY(), l_waveProp->getBathymetry(), l_file);
-        l_file.close();
-      
+        if(exportFrame(l_exportFormat, l_nOut, l_cellSizeMeters, l_nx, l_ny, l_outputStepSize, l_waveProp)) return EXIT_FAILURE;
         l_nOut++;
         
-      } else {
-        if(tsunami_lab::io::NetCDF::appendTimeframe( l_cellSizeMeters, l_nx, l_ny, l_gridOffsetX, l_gridOffsetY, l_outputStepSize, l_waveProp->getStride(), l_waveProp->getHeight(), l_waveProp->getMomentumX(), l_waveProp->getMomentumY(), l_waveProp->getBathymetry(), l_setup, l_simulationTime, l_deflateLevel, l_netCdfPath)) return EXIT_FAILURE;
       }
-	  
-	  // only needed for file export
-	  // and we may need the memory
-	  // l_displacement.resize(0);
       
     }
     
+    // every output stream has its own period
+    for(auto &l_writer : l_writers) {
+      if(l_writer->needsOutput(l_simulationTime, l_timeStepIndex == 0) && l_writer->append(l_waveProp, l_simulationTime)) return EXIT_FAILURE;
+    }
+    
     // update recording stations, if there are any
-    if(!l_stations.empty() && l_stations[0].needsUpdate(l_simulationTime)) {
-      for(auto &l_station : l_stations) {
-        l_station.recordState(*l_waveProp, l_simulationTime);
+    if(l_stationSet.sample(l_waveProp, l_simulationTime) > 0) {
+      if(l_stationSet.getBufferedSamples() >= l_stationBufferSize * l_stationSet.size()) {
+        l_stationSet.write(l_printStationComments);
+      }
+      if(l_referenceProp != nullptr){
+        for(t_idx l_st = 0; l_st < l_stationSet.size(); l_st++){
+          t_idx  l_x, l_y;
+          t_real l_state[3], l_reference[3];
+          l_stationSet.getStations()[l_st].getPosition(l_x, l_y);
+          l_waveProp->getCellState(l_x, l_y, l_state[0], l_state[1], l_state[2]);
+          l_referenceProp->getCellState(l_x, l_y, l_reference[0], l_reference[1], l_reference[2]);
+          for(t_idx l_qu = 0; l_qu < 3; l_qu++){
+            t_real l_error = std::abs(l_state[l_qu] - l_reference[l_qu]);
+            l_accuracyMax[l_st*3+l_qu] = std::max(l_accuracyMax[l_st*3+l_qu], l_error);
+            l_accuracySumSq[l_st*3+l_qu] += (double) l_error * l_error;
+          }
+        }
+        l_accuracySamples++;
       }
     }
 
+    if(l_aggregates) l_aggregates->update(l_waveProp, l_simulationTime);
+    
     l_waveProp->setGhostOutflow();
     l_timestep = l_waveProp->computeMaxTimestep(l_cellSizeMeters);
     if(!std::isfinite(l_timestep)){
@@ -529,6 +924,14 @@ int main( int i_argc, char *i_argv[] ) {
     
     t_real l_scaling = l_timestep / l_cellSizeMeters;
     l_waveProp->timeStep(l_scaling);
+    if(l_waveProp->getNumSaturated() > l_compactSaturationLimit){
+      std::cerr << "  " << l_waveProp->getNumSaturated() << " values exceeded the range of the compact storage, more than compactSaturationLimit = " << l_compactSaturationLimit << "; increase compactSurfaceRange. Stopping." << std::endl;
+      return EXIT_FAILURE;
+    }
+    if(l_referenceProp != nullptr){
+      l_referenceProp->setGhostOutflow();
+      l_referenceProp->timeStep(l_scaling);
+    }
 
     l_simulationTime += l_timestep;
   }
@@ -537,6 +940,7 @@ int main( int i_argc, char *i_argv[] ) {
   
   // print last state
   std::cout << "  simulation end time: " << l_simulationTime << ", #total time steps: "<< l_timeStepIndex << std::endl;
+  if(l_useCompactStorage) std::cout << "  saturated compact values: " << l_waveProp->getNumSaturated() << std::endl;
   
   auto l_performanceTimeN = std::chrono::high_resolution_clock::now();
   double l_durN = std::chrono::duration<double>(l_performanceTimeN-l_performanceTime1).count();
@@ -544,28 +948,44 @@ int main( int i_argc, char *i_argv[] ) {
   std::cout << "average steps per second: " << l_stepsPerSecond << ", total simulation time: " << l_durN << std::endl;
   
   if(l_exportCSV){
-      
-    std::string l_path = "solution_" + std::to_string(l_nOut) + ".csv";
-    std::cout << "  writing wave field to " << l_path << std::endl;
     
-    std::ofstream l_file(l_path, std::ios::out);
-    tsunami_lab::io::Csv::write( l_cellSizeMeters, l_nx, l_ny, l_outputStepSize, l_waveProp->getStride(), l_waveProp->getHeight(), l_waveProp->getMomentumX(), l_waveProp->getMomentumY(), l_waveProp->getBathymetry(), l_file );
-    l_file.close();
+    if(exportFrame(l_exportFormat, l_nOut, l_cellSizeMeters, l_nx, l_ny, l_outputStepSize, l_waveProp)) return EXIT_FAILURE;
     
-  } else {
-    if(tsunami_lab::io::NetCDF::appendTimeframe( l_cellSizeMeters, l_nx, l_ny, l_gridOffsetX, l_gridOffsetY, l_outputStepSize, l_waveProp->getStride(), l_waveProp->getHeight(), l_waveProp->getMomentumX(), l_waveProp->getMomentumY(), l_waveProp->getBathymetry(), l_setup, l_simulationTime, l_deflateLevel, l_netCdfPath)) return EXIT_FAILURE;
+  }
+  for(auto &l_writer : l_writers) {
+    if(l_writer->append(l_waveProp, l_simulationTime)) return EXIT_FAILURE;
+    if(l_writer->sync()) return EXIT_FAILURE;
+    l_writer->printStatistics(std::cout);
   }
   
-  // todo init files once, then only append the measurements
-  for(auto &l_station : l_stations){
-    l_station.write(l_printStationComments);
+  // the writers are synced, so the NetCDF library is free
+  if(l_aggregates){
+    l_aggregates->update(l_waveProp, l_simulationTime);
+    std::cout << "  writing aggregates to " << l_aggregatesPath << std::endl;
+    if(tsunami_lab::io::NetCDF::storeAggregates(l_aggregatesPath, l_cellSizeMeters, l_gridOffsetX, l_gridOffsetY, l_deflateLevel, *l_aggregates)) return EXIT_FAILURE;
   }
   
+  // append the remaining records
+  l_stationSet.write(l_printStationComments);
+  
+  if(tsunami_lab::io::NetCDF::waitForCheckpoint(l_checkpointChild)) std::cerr << "The last checkpoint failed" << std::endl;
+  
   std::cout << "finished writing last state" << std::endl;
+  std::cout << "peak resident memory: " << residentMegabytes(true) << " MB" << std::endl;
+  
+  if(l_referenceProp != nullptr && l_accuracySamples > 0){
+    std::cout << "storage accuracy compared to float storage (" << l_accuracySamples << " samples; max / rms error of height, momentumX, momentumY)" << std::endl;
+    for(t_idx l_st = 0; l_st < l_stationSet.size(); l_st++){
+      std::cout << "  station " << l_stationSet.getStations()[l_st].getName() << ":";
+      for(t_idx l_qu = 0; l_qu < 3; l_qu++){
+        std::cout << " " << l_accuracyMax[l_st*3+l_qu] << " / " << std::sqrt(l_accuracySumSq[l_st*3+l_qu] / l_accuracySamples);
+      }
+      std::cout << std::endl;
+    }
+  }
   
   delete l_waveProp;
-  
-  delete l_setup;
+  delete l_referenceProp;
   
   return EXIT_SUCCESS;
 }
@@ -0,0 +1,124 @@
+/**
+ * @author Antonio Noack
+ *
+ * @section DESCRIPTION
+ * Size-aware choice of the number of OpenMP threads per loop.
+ **/
+#include "ExecutionPolicy.h"
+#include "../solvers/FWave.h"
+
+#include <algorithm> // std::max, std::min
+#include <chrono> // measure time
+#include <cmath> // std::sqrt
+#include <omp.h> // max threads
+#include <vector>
+
+tsunami_lab::patches::ExecutionPolicy::ExecutionPolicy() {
+  m_maxThreads = omp_get_max_threads();
+  m_threadCost = 0;
+}
+
+tsunami_lab::patches::ExecutionPolicy::ExecutionPolicy( int    i_maxThreads,
+                                                        double i_threadCost,
+                                                        double i_solverCost,
+                                                        double i_copyCost ) {
+  m_maxThreads = std::max( i_maxThreads, 1 );
+  m_threadCost = i_threadCost;
+  m_solverCost = i_solverCost;
+  m_copyCost   = i_copyCost;
+}
+
+tsunami_lab::patches::ExecutionPolicy tsunami_lab::patches::ExecutionPolicy::calibrate( int i_maxThreads ) {
+
+  using namespace std::chrono;
+  i_maxThreads = std::max( i_maxThreads, 1 );
+
+  // start-up and barrier of a parallel region, like at the end of every parallel loop;
+  // the first region creates the thread pool, and isn't measured
+  double l_threadCost = 0;
+  if( i_maxThreads > 1 ) {
+    t_idx l_regions = 200;
+    t_idx l_counter = 0;// stored to a volatile below, such that the compiler can't remove the regions
+    #pragma omp parallel num_threads(i_maxThreads)
+    {
+      #pragma omp atomic
+      l_counter++;
+    }
+    auto l_start = high_resolution_clock::now();
+    for( t_idx l_re = 0; l_re < l_regions; l_re++ ) {
+      #pragma omp parallel num_threads(i_maxThreads)
+      {
+        #pragma omp atomic
+        l_counter++;
+      }
+    }
+    l_threadCost = duration<double>( high_resolution_clock::now() - l_start ).count() / (double) (l_regions * i_maxThreads);
+    volatile t_idx l_sink = l_counter;
+    (void) l_sink;
+  }
+
+  // Riemann solver; a wave, such that all branches of the solver are used
+  t_idx l_nCells = 1 << 14;
+  std::vector<t_real> l_h( l_nCells + 1 ), l_hu( l_nCells + 1 ), l_b( l_nCells + 1 );
+  for( t_idx l_ce = 0; l_ce <= l_nCells; l_ce++ ) {
+    l_h [l_ce] = 10 + (t_real) (l_ce % 7);
+    l_hu[l_ce] = (t_real) (l_ce % 5) - 2;
+    l_b [l_ce] = -10 - (t_real) (l_ce % 3);
+  }
+  t_real l_sum = 0;
+  auto l_start = high_resolution_clock::now();
+  for( t_idx l_ce = 0; l_ce < l_nCells; l_ce++ ) {
+    t_real l_netUpdatesL[2], l_netUpdatesR[2];
+    solvers::FWave::netUpdates( l_h[l_ce], l_h[l_ce+1], l_hu[l_ce], l_hu[l_ce+1], l_b[l_ce], l_b[l_ce+1], l_netUpdatesL, l_netUpdatesR );
+    l_sum += l_netUpdatesL[0] + l_netUpdatesR[1];
+  }
+  double l_solverCost = duration<double>( high_resolution_clock::now() - l_start ).count() / (double) l_nCells;
+
+  // copy of the two buffers, like the initialization of the next time step; vectorized like the patches
+  l_start = high_resolution_clock::now();
+  #pragma omp simd
+  for( t_idx l_ce = 0; l_ce < l_nCells; l_ce++ ) {
+    l_hu[l_ce] = l_h[l_ce];
+    l_b [l_ce] = l_h[l_ce+1];
+  }
+  l_sum += l_hu[l_nCells / 2] + l_b[l_nCells / 3];
+  double l_copyCost = duration<double>( high_resolution_clock::now() - l_start ).count() / (double) l_nCells;
+
+  // keep the results, such that the compiler doesn't remove the loops
+  volatile t_real l_sink = l_sum;
+  (void) l_sink;
+
+  // the clock may have a resolution of microseconds
+  l_solverCost = std::max( l_solverCost, 1e-10 );
+  l_copyCost   = std::max( l_copyCost,   1e-11 );
+
+  return ExecutionPolicy( i_maxThreads, l_threadCost, l_solverCost, l_copyCost );
+}
+
+int tsunami_lab::patches::ExecutionPolicy::getThreads( t_idx  i_numItems,
+                                                       double i_itemCost ) const {
+  if( m_maxThreads <= 1 ) return 1;
+  if( m_threadCost <= 0 ) return m_maxThreads;
+
+  double l_serial = (double) i_numItems * i_itemCost;
+  double l_threads = std::min( std::sqrt( l_serial / m_threadCost ), (double) m_maxThreads );
+  int    l_numThreads = (int) (l_threads + 0.5);
+  if( l_numThreads < 2 ) return 1;
+  if( l_serial / l_numThreads + l_numThreads * m_threadCost >= l_serial ) return 1;
+  return l_numThreads;
+}
+
+void tsunami_lab::patches::ExecutionPolicy::print( t_idx          i_nCellsX,
+                                                   t_idx          i_nCellsY,
+                                                   std::ostream & io_stream ) const {
+  t_idx l_cells = (i_nCellsX + 2) * (i_nCellsY + 2);
+  io_stream << "  execution policy:               up to " << m_maxThreads << " threads";
+  if( m_threadCost > 0 && m_maxThreads > 1 ) {
+    // two threads are faster, if n * cost / 2 + 2 * threadCost < n * cost
+    io_stream << ", loops with less than " << (t_idx) (4 * m_threadCost / m_solverCost) << " solver calls or "
+              << (t_idx) (4 * m_threadCost / m_copyCost) << " copies run serially";
+  }
+  io_stream << std::endl;
+  io_stream << "                                  time step: " << getSolverThreads( l_cells ) << " threads, copies: "
+            << getCopyThreads( l_cells ) << " threads, ghost cells: " << getCopyThreads( std::max( i_nCellsX, i_nCellsY ) + 2 ) << " threads" << std::endl;
+}
@@ -0,0 +1,117 @@
+/**
+ * @author Antonio Noack
+ *
+ * @section DESCRIPTION
+ * Size-aware choice of the number of OpenMP threads per loop.
+ *
+ * A parallel loop over n items with p threads is modelled to take
+ *   n * itemCost / p + p * threadCost,
+ * where threadCost is the start-up and barrier cost of one thread in a parallel region.
+ * The minimum lies at p = sqrt(n * itemCost / threadCost); loops, where this doesn't beat the serial time n * itemCost,
+ * run serially without opening a parallel region.
+ **/
+#ifndef TSUNAMI_LAB_PATCHES_EXECUTION_POLICY
+#define TSUNAMI_LAB_PATCHES_EXECUTION_POLICY
+
+#include "../constants.h"
+#include <iostream>
+
+namespace tsunami_lab {
+  namespace patches {
+    class ExecutionPolicy;
+  }
+}
+
+class tsunami_lab::patches::ExecutionPolicy {
+  private:
+    //! maximum number of threads
+    int m_maxThreads = 1;
+
+    //! seconds of a parallel region per participating thread
+    double m_threadCost = 0;
+
+    //! seconds per cell of a loop, which calls the Riemann solver
+    double m_solverCost = 1;
+
+    //! seconds per cell of a loop, which only copies or reduces values
+    double m_copyCost = 1;
+
+  public:
+    /**
+     * Constructs the policy, which always uses all threads, as if parallel regions were free.
+     **/
+    ExecutionPolicy();
+
+    /**
+     * Constructs a policy with the given costs.
+     *
+     * @param i_maxThreads maximum number of threads.
+     * @param i_threadCost seconds of a parallel region per participating thread.
+     * @param i_solverCost seconds per cell of a loop, which calls the Riemann solver.
+     * @param i_copyCost seconds per cell of a loop, which only copies or reduces values.
+     **/
+    ExecutionPolicy( int    i_maxThreads,
+                     double i_threadCost,
+                     double i_solverCost,
+                     double i_copyCost );
+
+    /**
+     * Measures the costs of the model on this machine; takes a few milliseconds.
+     *
+     * @param i_maxThreads maximum number of threads; usually omp_get_max_threads().
+     * @return calibrated policy.
+     **/
+    static ExecutionPolicy calibrate( int i_maxThreads );
+
+    /**
+     * Gets the number of threads for a loop.
+     *
+     * @param i_numItems number of loop iterations.
+     * @param i_itemCost seconds per iteration.
+     * @return number of threads; 1 means serial.
+     **/
+    int getThreads( t_idx  i_numItems,
+                    double i_itemCost ) const;
+
+    /**
+     * Gets the number of threads for a loop, which calls the Riemann solver for every cell.
+     *
+     * @param i_numCells number of cells of the loop.
+     * @return number of threads; 1 means serial.
+     **/
+    int getSolverThreads( t_idx i_numCells ) const {
+      return getThreads( i_numCells, m_solverCost );
+    }
+
+    /**
+     * Gets the number of threads for a loop, which only copies or reduces values.
+     *
+     * @param i_numCells number of cells of the loop.
+     * @return number of threads; 1 means serial.
+     **/
+    int getCopyThreads( t_idx i_numCells ) const {
+      return getThreads( i_numCells, m_copyCost );
+    }
+
+    /**
+     * Gets the maximum number of threads.
+     *
+     * @return maximum number of threads.
+     **/
+    int getMaxThreads() const {
+      return m_maxThreads;
+    }
+
+    /**
+     * Prints the policy for a grid.
+     *
+     * @param i_nCellsX number of cells on the x axis.
+     * @param i_nCellsY number of cells on the y axis.
+     * @param io_stream stream to print to.
+     **/
+    void print( t_idx          i_nCellsX,
+                t_idx          i_nCellsY,
+                std::ostream & io_stream ) const;
+};
+
+#endif
@@ -0,0 +1,49 @@
+/**
+ * @author Antonio Noack
+ *
+ * @section DESCRIPTION
+ * Unit tests for the size-aware thread count.
+ **/
+#include <catch2/catch.hpp>
+#include "ExecutionPolicy.h"
+
+TEST_CASE( "Test the choice of the number of threads.", "[ExecutionPolicy]" ) {
+
+  // 1us per thread and parallel region, 100ns per solver call, 1ns per copied cell
+  tsunami_lab::patches::ExecutionPolicy l_policy( 8, 1e-6, 1e-7, 1e-9 );
+
+  // small loops run serially
+  REQUIRE( l_policy.getSolverThreads( 1 ) == 1 );
+  REQUIRE( l_policy.getSolverThreads( 30 ) == 1 );
+  REQUIRE( l_policy.getCopyThreads( 53 * 53 ) == 1 );
+
+  // optimum of n * cost / p + p * threadCost at p = sqrt(n * cost / threadCost)
+  REQUIRE( l_policy.getSolverThreads( 90 ) == 3 );
+  REQUIRE( l_policy.getSolverThreads( 160 ) == 4 );
+  REQUIRE( l_policy.getCopyThreads( 16000 ) == 4 );
+
+  // large loops use all threads
+  REQUIRE( l_policy.getSolverThreads( 53 * 53 ) == 8 );
+  REQUIRE( l_policy.getCopyThreads( 54000 * 30000 ) == 8 );
+
+  // more threads never pay off for fewer cells
+  int l_last = 1;
+  for( tsunami_lab::t_idx l_ce = 1; l_ce < 100000; l_ce += 37 ) {
+    int l_threads = l_policy.getSolverThreads( l_ce );
+    REQUIRE( l_threads >= l_last );
+    REQUIRE( l_threads <= 8 );
+    l_last = l_threads;
+  }
+
+  // without a cost model, all threads are used, and with a single thread, everything is serial
+  tsunami_lab::patches::ExecutionPolicy l_all;
+  REQUIRE( l_all.getSolverThreads( 1 ) == l_all.getMaxThreads() );
+  tsunami_lab::patches::ExecutionPolicy l_single( 1, 1e-6, 1e-7, 1e-9 );
+  REQUIRE( l_single.getSolverThreads( 54000 * 30000 ) == 1 );
+
+  // the calibration measures positive costs
+  tsunami_lab::patches::ExecutionPolicy l_calibrated = tsunami_lab::patches::ExecutionPolicy::calibrate( 2 );
+  REQUIRE( l_calibrated.getMaxThreads() == 2 );
+  REQUIRE( l_calibrated.getSolverThreads( 1 ) == 1 );
+  REQUIRE( l_calibrated.getSolverThreads( 100000000 ) == 2 );
+}
@@ -0,0 +1,143 @@
+/**
+ * @author Antonio Noack
+ *
+ * @section DESCRIPTION
+ * Conversions between t_real and compact 16 bit storage formats.
+ **/
+#ifndef TSUNAMI_LAB_PATCHES_QUANTIZATION
+#define TSUNAMI_LAB_PATCHES_QUANTIZATION
+
+#include "../constants.h"
+
+#include <cmath> // std::lrint
+#include <cstdint>
+#include <cstring> // memcpy
+
+namespace tsunami_lab {
+  namespace patches {
+    class Quantization;
+  }
+}
+
+class tsunami_lab::patches::Quantization {
+  public:
+
+    /**
+     * Converts a float into an IEEE 754 half precision float, rounding to the nearest even value.
+     * Values beyond 65504 become infinity.
+     *
+     * @param i_value value.
+     * @return bits of the half precision float.
+     **/
+    static inline uint16_t floatToHalf( float i_value ) {
+      uint32_t l_bits;
+      std::memcpy( &l_bits, &i_value, sizeof(l_bits) );
+      uint16_t l_sign = (l_bits >> 16) & 0x8000;
+      uint32_t l_abs = l_bits & 0x7fffffff;
+      if( l_abs >= 0x7f800000 ) return l_sign | 0x7c00 | (l_abs > 0x7f800000 ? 0x200 : 0);// inf, NaN
+      if( l_abs >= 0x477ff000 ) return l_sign | 0x7c00;// would round to more than 65504
+      if( l_abs <  0x38800000 ) {
+        // subnormal: value / 2^-24, rounded to the nearest even integer
+        float l_abs2;
+        std::memcpy( &l_abs2, &l_abs, sizeof(l_abs2) );
+        return l_sign | (uint16_t) std::lrint( l_abs2 * 16777216.0f );
+      }
+      // rebias the exponent from 127 to 15, and round the mantissa to the nearest even value
+      return l_sign | (uint16_t) ((l_abs + 0xc8000fff + ((l_abs >> 13) & 1)) >> 13);
+    }
+
+    /**
+     * Converts an IEEE 754 half precision float into a float.
+     *
+     * @param i_half bits of the half precision float.
+     * @return value.
+     **/
+    static inline float halfToFloat( uint16_t i_half ) {
+      uint32_t l_sign     = (uint32_t) (i_half & 0x8000) << 16;
+      uint32_t l_exponent = (i_half >> 10) & 0x1f;
+      uint32_t l_mantissa = i_half & 0x3ff;
+      if( l_exponent == 0 ) {// zero and subnormals
+        float l_value = l_mantissa * (1.0f / 16777216.0f);
+        return l_sign ? -l_value : l_value;
+      }
+      uint32_t l_bits = l_exponent == 31 ?
+        l_sign | 0x7f800000 | (l_mantissa << 13) :
+        l_sign | ((l_exponent + 112) << 23) | (l_mantissa << 13);
+      float l_value;
+      std::memcpy( &l_value, &l_bits, sizeof(l_value) );
+      return l_value;
+    }
+
+    /**
+     * Converts a float into a bfloat16 (upper half of a float), rounding to the nearest even value.
+     *
+     * @param i_value value.
+     * @return bits of the bfloat16.
+     **/
+    static inline uint16_t floatToBFloat16( float i_value ) {
+      uint32_t l_bits;
+      std::memcpy( &l_bits, &i_value, sizeof(l_bits) );
+      if( (l_bits & 0x7fffffff) > 0x7f800000 ) return (l_bits >> 16) | 0x40;// keep NaN a NaN
+      return (l_bits + 0x7fff + ((l_bits >> 16) & 1)) >> 16;
+    }
+
+    /**
+     * Converts a bfloat16 into a float.
+     *
+     * @param i_bfloat bits of the bfloat16.
+     * @return value.
+     **/
+    static inline float bfloat16ToFloat( uint16_t i_bfloat ) {
+      uint32_t l_bits = (uint32_t) i_bfloat << 16;
+      float l_value;
+      std::memcpy( &l_value, &l_bits, sizeof(l_value) );
+      return l_value;
+    }
+
+    /**
+     * Converts a value into a 16 bit integer with value = offset + integer * scale.
+     * Values outside of the representable range are clamped.
+     *
+     * @param i_value value.
+     * @param i_inverseScale 1 / scale.
+     * @param i_offset offset, which is represented by the integer 0.
+     * @return the integer.
+     **/
+    static inline int16_t encodeInt16( t_real i_value, t_real i_inverseScale, t_real i_offset ) {
+      t_real l_scaled = (i_value - i_offset) * i_inverseScale;
+      l_scaled = l_scaled < -32767 ? -32767 : l_scaled > 32767 ? 32767 : l_scaled;
+      return (int16_t) std::lrint( l_scaled );
+    }
+
+    /**
+     * Converts a value into a 16 bit integer like encodeInt16(), and counts it, if it is clamped.
+     *
+     * @param i_value value.
+     * @param i_inverseScale 1 / scale.
+     * @param i_offset offset, which is represented by the integer 0.
+     * @param io_numSaturated incremented, if the value is outside of the representable range, or NaN.
+     * @return the integer.
+     **/
+    static inline int16_t encodeInt16( t_real    i_value,
+                                       t_real    i_inverseScale,
+                                       t_real    i_offset,
+                                       t_idx   & io_numSaturated ) {
+      t_real l_scaled = (i_value - i_offset) * i_inverseScale;
+      if( !(l_scaled >= (t_real) -32767.5 && l_scaled <= (t_real) 32767.5) ) io_numSaturated++;
+      return encodeInt16( i_value, i_inverseScale, i_offset );
+    }
+
+    /**
+     * Converts a 16 bit integer back into value = offset + integer * scale.
+     *
+     * @param i_int the integer.
+     * @param i_scale scale.
+     * @param i_offset offset, which is represented by the integer 0.
+     * @return value.
+     **/
+    static inline t_real decodeInt16( int16_t i_int, t_real i_scale, t_real i_offset ) {
+      return i_offset + i_int * i_scale;
+    }
+};
+
+#endif
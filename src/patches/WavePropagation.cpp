@@ -0,0 +1,62 @@
+/**
+ * @author Antonio Noack
+ *
+ * @section DESCRIPTION
+ * Functions, which are shared by the wave propagation patches.
+ **/
+#include "WavePropagation.h"
+#include "../solvers/FWave.h"
+#include "../solvers/Roe.h"
+
+void tsunami_lab::patches::WavePropagation::edgeUpdate( t_real   i_scaling,
+                                                         t_real   i_hL,
+                                                         t_real   i_hR,
+                                                         t_real   i_huL,
+                                                         t_real   i_huR,
+                                                         t_real   i_bL,
+                                                         t_real   i_bR,
+                                                         t_real & io_hL,
+                                                         t_real & io_hR,
+                                                         t_real & io_huL,
+                                                         t_real & io_huR ) {
+
+  t_real l_netUpdatesL[2];
+  t_real l_netUpdatesR[2];
+
+  t_real l_bL0 = i_bL;
+  t_real l_bR0 = i_bR;
+
+  if(i_bL > 0 || i_bR > 0){
+    // one cell is dry -> reflecting boundary condition
+    if(i_bR > 0){
+      // right cell is dry
+      i_hR = i_hL;
+      i_bR = i_bL;
+      i_huR = -i_huL;
+    } else {
+      // left cell is dry
+      i_hL = i_hR;
+      i_bL = i_bR;
+      i_huL = -i_huR;
+    }
+  }
+
+  // compute net-updates
+#ifndef USE_ROE_SOLVER
+  solvers::FWave::netUpdates( i_hL, i_hR, i_huL, i_huR, i_bL, i_bR, l_netUpdatesL, l_netUpdatesR );
+#else
+  solvers::Roe::netUpdates( i_hL, i_hR, i_huL, i_huR, l_netUpdatesL, l_netUpdatesR );
+#endif
+
+  // update the cells' quantities
+  if(l_bL0 <= 0){
+    io_hL  -= i_scaling * l_netUpdatesL[0];
+    io_huL -= i_scaling * l_netUpdatesL[1];
+  } else io_huL = io_hL = 0;
+
+  if(l_bR0 <= 0){
+    io_hR  -= i_scaling * l_netUpdatesR[0];
+    io_huR -= i_scaling * l_netUpdatesR[1];
+  } else io_huR = io_hR = 0;
+
+}
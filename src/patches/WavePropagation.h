@@ -19,6 +19,7 @@
 #define TSUNAMI_LAB_PATCHES_WAVE_PROPAGATION
 
 #include "../constants.h"
+#include "ExecutionPolicy.h"
 
 namespace tsunami_lab {
   namespace patches {
@@ -27,6 +28,38 @@ namespace tsunami_lab {
 }
 
 class tsunami_lab::patches::WavePropagation {
+  protected:
+    /**
+     * Computes the net-updates between two cells, and applies them.
+     * Dry cells (bathymetry > 0) act as a reflecting boundary.
+     *
+     * @param i_scaling scaling of the time step (dt / dx).
+     * @param i_hL height of the left cell.
+     * @param i_hR height of the right cell.
+     * @param i_huL momentum of the left cell.
+     * @param i_huR momentum of the right cell.
+     * @param i_bL bathymetry of the left cell.
+     * @param i_bR bathymetry of the right cell.
+     * @param io_hL updated height of the left cell.
+     * @param io_hR updated height of the right cell.
+     * @param io_huL updated momentum of the left cell.
+     * @param io_huR updated momentum of the right cell.
+     **/
+    static void edgeUpdate( t_real   i_scaling,
+                            t_real   i_hL,
+                            t_real   i_hR,
+                            t_real   i_huL,
+                            t_real   i_huR,
+                            t_real   i_bL,
+                            t_real   i_bR,
+                            t_real & io_hL,
+                            t_real & io_hR,
+                            t_real & io_huL,
+                            t_real & io_huR );
+
+    //! number of threads per loop; uses all threads by default
+    ExecutionPolicy m_executionPolicy;
+
   public:
     /**
      * Virtual destructor for base class.
@@ -85,6 +118,80 @@ class tsunami_lab::patches::WavePropagation {
      **/
     virtual t_real const * getBathymetry() = 0;
 
+    /**
+     * Copies a row of a quantity including its ghost cells into a buffer of getStride() values.
+     *
+     * @param i_quantity 0 = height, 1 = momentum x, 2 = momentum y, 3 = bathymetry.
+     * @param i_iy id of the row including the ghost cells, 0 for the ghost row at the bottom; 0 in 1d.
+     * @param o_row buffer for the values; zeros, if the patch doesn't have the quantity.
+     **/
+    virtual void getRow( unsigned short i_quantity,
+                         t_idx          i_iy,
+                         t_real       * o_row ) = 0;
+
+    /**
+     * Gets the arrays of the patch in their in-memory layout including the ghost cells, e.g. for raw checkpoints, which are read directly into them.
+     *
+     * @param o_arrays height, momentum x, momentum y, bathymetry; nullptr, if the patch doesn't have the quantity.
+     * @return number of values per array; 0, if the patch doesn't store its state as t_real arrays.
+     **/
+    virtual t_idx getRawStorage( t_real * o_arrays[4] ) {
+      o_arrays[0] = o_arrays[1] = o_arrays[2] = o_arrays[3] = nullptr;
+      return 0;
+    }
+
+    /**
+     * Whether the getters return the storage of the patch directly.
+     * If not, they decode a full copy on demand, and large exports should use getRow() instead.
+     *
+     * @return true, if the getters are free.
+     **/
+    virtual bool hasDenseStorage() {
+      return true;
+    }
+
+    /**
+     * Gets the water height and momenta of a single cell.
+     * Patches, which don't store t_real arrays, override this to avoid decoding the whole field.
+     *
+     * @param i_ix id of the cell in x-direction.
+     * @param i_iy id of the cell in y-direction.
+     * @param o_h water height.
+     * @param o_hu momentum in x-direction.
+     * @param o_hv momentum in y-direction; 0 if the patch has no y-momentum.
+     **/
+    virtual void getCellState( t_idx    i_ix,
+                               t_idx    i_iy,
+                               t_real & o_h,
+                               t_real & o_hu,
+                               t_real & o_hv ) {
+      t_idx l_index = i_ix + i_iy * getStride();
+      t_real const * l_h  = getHeight();
+      t_real const * l_hu = getMomentumX();
+      t_real const * l_hv = getMomentumY();
+      o_h  = l_h  ? l_h [l_index] : 0;
+      o_hu = l_hu ? l_hu[l_index] : 0;
+      o_hv = l_hv ? l_hv[l_index] : 0;
+    }
+
+    /**
+     * Gets the number of values, which didn't fit into the storage format of the patch, and were clamped.
+     *
+     * @return number of saturated values; 0 for patches, which store t_real values.
+     **/
+    virtual t_idx getNumSaturated() {
+      return 0;
+    }
+
+    /**
+     * Sets the policy, which decides the number of threads of each loop of the time step.
+     *
+     * @param i_policy execution policy.
+     **/
+    void setExecutionPolicy( ExecutionPolicy const & i_policy ) {
+      m_executionPolicy = i_policy;
+    }
+
     /**
      * Sets the height of the cell to the given value.
      *
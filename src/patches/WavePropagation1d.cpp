@@ -64,19 +64,10 @@ tsunami_lab::patches::WavePropagation1d::WavePropagation1d( t_idx i_nCells, tsun
 }
 
 void tsunami_lab::patches::WavePropagation1d::initWithSetup( tsunami_lab::setups::Setup* i_setup, t_real i_scale ) {
-  for( unsigned short l_st = 0; l_st < 2; l_st++ ) {
-    t_real* l_h  = m_h [l_st];
-    t_real* l_hu = m_hu[l_st];
-    for( t_idx l_ce = 0; l_ce < m_nCells + 2; l_ce++ ) {
-      t_real l_x = (l_ce - (t_real) 0.5) * i_scale;
-      l_h [l_ce] = i_setup->getHeight(l_x, 0);
-      l_hu[l_ce] = i_setup->getMomentumX(l_x, 0);
-    }
-  }
-  for( t_idx l_ce = 0; l_ce < m_nCells + 2; l_ce++ ) {
-    t_real l_x = (l_ce - (t_real) 0.5) * i_scale;
-    m_bathymetry[l_ce] = i_setup->getBathymetry(l_x, 0) + i_setup->getDisplacement(l_x, 0);
-  }
+  // row 1 with a scale of 0 samples y = 0
+  i_setup->fillRows( 1, 2, 0, m_nCells + 2, i_scale, 0, m_h[0], m_hu[0], nullptr, m_bathymetry, m_nCells + 2 );
+  std::copy( m_h [0], m_h [0] + m_nCells + 2, m_h [1] );
+  std::copy( m_hu[0], m_hu[0] + m_nCells + 2, m_hu[1] );
 }
 
 tsunami_lab::patches::WavePropagation1d::~WavePropagation1d() {
@@ -182,7 +173,8 @@ tsunami_lab::t_real tsunami_lab::patches::WavePropagation1d::computeMaxTimestep(
   t_real l_maxVelocity = 0;
   t_real l_gravity = tsunami_lab::solvers::FWave::m_gravity;
   
-  #pragma omp parallel for reduction(max: l_maxVelocity)
+  int l_threads = m_executionPolicy.getCopyThreads( l_endIndex - l_startIndex );
+  #pragma omp parallel for simd reduction(max: l_maxVelocity) num_threads(l_threads) if(l_threads > 1)
   for(t_idx l_x=l_startIndex;l_x<l_endIndex;l_x++){
     t_real l_height = l_h[l_x];
     // worst case consideration for height; alternatively, we could look at the worst case velocity
@@ -150,6 +150,35 @@ class tsunami_lab::patches::WavePropagation1d: public WavePropagation {
       return m_bathymetry+1;
     }
     
+    /**
+     * Copies the cells of a quantity including the ghost cells; there is a single row in 1d.
+     *
+     * @param i_quantity 0 = height, 1 = momentum x, 2 = momentum y, 3 = bathymetry.
+     * @param o_row buffer for getStride() values.
+     **/
+    void getRow( unsigned short i_quantity,
+                 t_idx,
+                 t_real       * o_row ){
+      t_real const * l_data = i_quantity == 0 ? m_h[m_step] : i_quantity == 1 ? m_hu[m_step] : i_quantity == 3 ? m_bathymetry : nullptr;
+      for( t_idx l_ix = 0; l_ix < m_nCells+2; l_ix++ ) {
+        o_row[l_ix] = l_data ? l_data[l_ix] : 0;
+      }
+    }
+    
+    /**
+     * Gets the arrays of the current step including the ghost cells; there is no momentum in y-direction.
+     *
+     * @param o_arrays height, momentum x, nullptr, bathymetry.
+     * @return number of values per array.
+     **/
+    t_idx getRawStorage( t_real * o_arrays[4] ){
+      o_arrays[0] = m_h[m_step];
+      o_arrays[1] = m_hu[m_step];
+      o_arrays[2] = nullptr;
+      o_arrays[3] = m_bathymetry;
+      return m_nCells+2;
+    }
+    
     /**
      * Sets the bathymetry of the cell to the given value.
      *
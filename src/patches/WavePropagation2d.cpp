@@ -91,27 +91,14 @@ void tsunami_lab::patches::WavePropagation2d::initWithSetup( tsunami_lab::setups
   t_idx l_nCellsX = m_nCellsX;
   t_idx l_nCellsY = m_nCellsY;
   
-  #pragma omp parallel for
-  for( t_idx l_iy = 0; l_iy < l_nCellsY + 2; l_iy++ ) {
-    t_real l_y = (l_iy - (t_real) 0.5) * i_scaleY;// -0.5 = -1 (ghost zone) + 0.5 (center of cell)
-    t_idx  l_i = l_iy * (l_nCellsX + 2);
-    for( t_idx l_ix = 0; l_ix < l_nCellsX + 2; l_ix++, l_i++ ) {
-      t_real l_x = (l_ix - (t_real) 0.5) * i_scaleX;
-      l_h [l_i] = i_setup->getHeight(    l_x, l_y );
-      l_hu[l_i] = i_setup->getMomentumX( l_x, l_y );
-      l_hv[l_i] = i_setup->getMomentumY( l_x, l_y );
-    }
-  }
-  
   t_real* l_bathymetry = m_bathymetry;
+  
+  // one call per row, so the setup can share work between the cells and quantities of a row
   #pragma omp parallel for
   for( t_idx l_iy = 0; l_iy < l_nCellsY + 2; l_iy++ ) {
-    t_real l_y = (l_iy - (t_real) 0.5) * i_scaleY;
-    t_idx  l_i = l_iy * (l_nCellsX + 2);
-    for( t_idx l_ix = 0; l_ix < l_nCellsX + 2; l_ix++, l_i++ ) {
-      t_real l_x = (l_ix - (t_real) 0.5) * i_scaleX;
-      l_bathymetry[l_i] = i_setup->getBathymetry( l_x, l_y ) + i_setup->getDisplacement( l_x, l_y );
-    }
+    t_idx l_i = l_iy * (l_nCellsX + 2);
+    i_setup->fillRows( l_iy, l_iy + 1, 0, l_nCellsX + 2, i_scaleX, i_scaleY,
+                       l_h + l_i, l_hu + l_i, l_hv + l_i, l_bathymetry + l_i, l_nCellsX + 2 );
   }
   
   auto end = high_resolution_clock::now();
@@ -233,6 +220,9 @@ void tsunami_lab::patches::WavePropagation2d::timeStep( t_real i_scaling ) {
   using namespace std::chrono;
   auto start = high_resolution_clock::now();
   
+  // the number of threads depends on the grid size; small grids run serially
+  int l_solverThreads = m_executionPolicy.getSolverThreads( m_nCells );
+  
   // pointers to old and new data
   t_real* l_hOld  = m_h[0];
   t_real* l_huOld = m_hu[m_step];
@@ -244,14 +234,16 @@ void tsunami_lab::patches::WavePropagation2d::timeStep( t_real i_scaling ) {
   t_real* l_hvNew = m_hv[1-m_step];
   
   m_step = !m_step;
+  
+  int l_copyThreads = m_executionPolicy.getCopyThreads( m_nCells );
 
   // init new cell quantities
   t_idx l_nCells = m_nCells;
-  #pragma omp parallel for
+  #pragma omp parallel for simd num_threads(l_copyThreads) if(l_copyThreads > 1)
   for(t_idx i=0;i<l_nCells;i++){
     l_hNew[i] = l_hOld[i];
   }
-  #pragma omp parallel for
+  #pragma omp parallel for simd num_threads(l_copyThreads) if(l_copyThreads > 1)
   for(t_idx i=0;i<l_nCells;i++){
     l_huNew[i] = l_huOld[i];
   }
@@ -267,7 +259,7 @@ void tsunami_lab::patches::WavePropagation2d::timeStep( t_real i_scaling ) {
   t_idx l_nCellsY = m_nCellsY;
 
   // iterate over edges and update with Riemann solutions
-  #pragma omp parallel for
+  #pragma omp parallel for num_threads(l_solverThreads) if(l_solverThreads > 1)
   for( t_idx l_iy = 0; l_iy < l_nCellsY + 2; l_iy++ ) {
     t_idx l_ceStart = l_iy * l_stride;
     t_idx l_ceEnd = l_ceStart + l_nCellsX + 2 - 1;
@@ -322,11 +314,11 @@ void tsunami_lab::patches::WavePropagation2d::timeStep( t_real i_scaling ) {
   l_hNew = m_h[0];
   
   // init new cell quantities
-  #pragma omp parallel for
+  #pragma omp parallel for simd num_threads(l_copyThreads) if(l_copyThreads > 1)
   for(t_idx i=0;i<l_nCells;i++){
     l_hNew[i] = l_hOld[i];
   }
-  #pragma omp parallel for
+  #pragma omp parallel for simd num_threads(l_copyThreads) if(l_copyThreads > 1)
   for(t_idx i=0;i<l_nCells;i++){
     l_hvNew[i] = l_hvOld[i];
   }
@@ -338,7 +330,7 @@ void tsunami_lab::patches::WavePropagation2d::timeStep( t_real i_scaling ) {
   
   // iterate over edges and update with Riemann solutions
   #ifdef MEMORY_IS_SCARCE
-  #pragma omp parallel for
+  #pragma omp parallel for num_threads(l_solverThreads) if(l_solverThreads > 1)
   for(t_idx l_ix = 0; l_ix < l_nCellsX + 2; l_ix++) {
     t_real hOld[2];
     t_real hNew[2];
@@ -371,7 +363,7 @@ void tsunami_lab::patches::WavePropagation2d::timeStep( t_real i_scaling ) {
     
   }
   #else
-  #pragma omp parallel for
+  #pragma omp parallel for num_threads(l_solverThreads) if(l_solverThreads > 1)
   for(t_idx l_iy = 0; l_iy < l_nCellsY + 2 - 1; l_iy++) {
     t_idx l_ceStart = l_iy * l_stride;
     t_idx l_ceEnd = l_ceStart + l_nCellsX + 2;
@@ -397,8 +389,8 @@ tsunami_lab::t_real tsunami_lab::patches::WavePropagation2d::computeMaxTimestep(
   auto start = high_resolution_clock::now();
   
   t_real* l_h  = m_h [0];
-  t_real* l_hu = m_hu[0];
-  t_real* l_hv = m_hv[0];
+  t_real* l_hu = m_hu[m_step];
+  t_real* l_hv = m_hv[m_step];
   
   t_real l_maxVelocity = 0;
   t_real l_gravity = tsunami_lab::solvers::FWave::m_gravity;
@@ -408,11 +400,12 @@ tsunami_lab::t_real tsunami_lab::patches::WavePropagation2d::computeMaxTimestep(
   t_idx  l_nCellsX = m_nCellsX;
   t_idx  l_nCellsY = m_nCellsY;
   
-  #pragma omp parallel for reduction(max: l_maxVelocity)
+  int l_threads = m_executionPolicy.getCopyThreads( m_nCells );
+  #pragma omp parallel for reduction(max: l_maxVelocity) num_threads(l_threads) if(l_threads > 1)
   for( t_idx l_iy = 1; l_iy <= l_nCellsY; l_iy++){
     t_idx l_iStart = l_iy * l_stride + 1;// +1, because we start iterating at l_ix = 1
     t_idx l_iEnd = l_iStart + l_nCellsX + 1;
-    // #pragma omp simd
+    #pragma omp simd reduction(max: l_maxVelocity)
     for(t_idx l_i = l_iStart; l_i < l_iEnd; l_i++){
       t_real l_height = l_h[l_i];
       t_real l_impulse = std::max(std::abs(l_hu[l_i]), std::abs(l_hv[l_i]));
@@ -437,13 +430,15 @@ void tsunami_lab::patches::WavePropagation2d::setGhostOutflow() {
   
   t_real* l_b  = m_bathymetry;
   t_real* l_h  = m_h [0];
-  t_real* l_hu = m_hu[0];
-  t_real* l_hv = m_hv[0];
+  t_real* l_hu = m_hu[m_step];
+  t_real* l_hv = m_hv[m_step];
   
   t_idx l_stride = getStride();
+  int   l_threadsX = m_executionPolicy.getCopyThreads( m_nCellsX + 2 );
+  int   l_threadsY = m_executionPolicy.getCopyThreads( m_nCellsY + 2 );
   
   // set left boundary
-  #pragma omp parallel for
+  #pragma omp parallel for num_threads(l_threadsY) if(l_threadsY > 1)
   for(t_idx l_y = 0; l_y < m_nCellsY+2; l_y++){
     t_idx l_i0 = l_y * l_stride;
     t_idx l_i1 = l_i0 + 1;
@@ -454,7 +449,7 @@ void tsunami_lab::patches::WavePropagation2d::setGhostOutflow() {
   }
   
   // set right boundary
-  #pragma omp parallel for
+  #pragma omp parallel for num_threads(l_threadsY) if(l_threadsY > 1)
   for(t_idx l_y = 0; l_y < m_nCellsY+2; l_y++){
     t_idx l_i0 = m_nCellsX + 1 + l_y * l_stride;
     t_idx l_i1 = l_i0 - 1;
@@ -465,7 +460,7 @@ void tsunami_lab::patches::WavePropagation2d::setGhostOutflow() {
   }
   
   // set top boundary
-  #pragma omp parallel for
+  #pragma omp parallel for num_threads(l_threadsX) if(l_threadsX > 1)
   for(t_idx l_x = 0; l_x < m_nCellsX+2; l_x++){
     t_idx l_i0 = l_x;
     t_idx l_i1 = l_i0 + l_stride;
@@ -476,7 +471,7 @@ void tsunami_lab::patches::WavePropagation2d::setGhostOutflow() {
   }
   
   // set bottom boundary
-  #pragma omp parallel for
+  #pragma omp parallel for num_threads(l_threadsX) if(l_threadsX > 1)
   for(t_idx l_x = 0; l_x < m_nCellsX+2; l_x++){
     t_idx l_i0 = l_x + (m_nCellsY + 1) * l_stride;
     t_idx l_i1 = l_i0 - l_stride;
@@ -180,6 +180,37 @@ class tsunami_lab::patches::WavePropagation2d: public WavePropagation {
       return m_bathymetry+1+(m_nCellsX+2);
     }
     
+    /**
+     * Copies a row of a quantity including the ghost cells.
+     *
+     * @param i_quantity 0 = height, 1 = momentum x, 2 = momentum y, 3 = bathymetry.
+     * @param i_iy id of the row including the ghost cells.
+     * @param o_row buffer for getStride() values.
+     **/
+    void getRow( unsigned short i_quantity,
+                 t_idx          i_iy,
+                 t_real       * o_row ){
+      t_real const * l_data = i_quantity == 0 ? m_h[0] : i_quantity == 1 ? m_hu[m_step] : i_quantity == 2 ? m_hv[m_step] : m_bathymetry;
+      l_data += i_iy * (m_nCellsX+2);
+      for( t_idx l_ix = 0; l_ix < m_nCellsX+2; l_ix++ ) {
+        o_row[l_ix] = l_data[l_ix];
+      }
+    }
+    
+    /**
+     * Gets the arrays of the current step including the ghost cells.
+     *
+     * @param o_arrays height, momentum x, momentum y, bathymetry.
+     * @return number of values per array.
+     **/
+    t_idx getRawStorage( t_real * o_arrays[4] ){
+      o_arrays[0] = m_h[0];
+      o_arrays[1] = m_hu[m_step];
+      o_arrays[2] = m_hv[m_step];
+      o_arrays[3] = m_bathymetry;
+      return m_nCells;
+    }
+    
     /**
      * Sets the bathymetry of the cell to the given value.
      *
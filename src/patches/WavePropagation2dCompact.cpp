@@ -0,0 +1,427 @@
+/**
+ * @author Antonio Noack
+ *
+ * @section DESCRIPTION
+ * Two-dimensional wave propagation patch, which stores its state in 16 bit formats.
+ **/
+#include <algorithm> // std::max
+#include <cmath> // std::sqrt
+#include <iostream>
+#include <limits>
+#include <vector>
+#include <chrono> // measure time
+#include "WavePropagation2dCompact.h"
+#include "../setups/Setup.h"
+#include "../solvers/FWave.h"
+
+tsunami_lab::patches::WavePropagation2dCompact::WavePropagation2dCompact( t_idx i_nCellsX, t_idx i_nCellsY, bool i_useBFloat16 ) {
+
+  m_nCellsX = i_nCellsX;
+  m_nCellsY = i_nCellsY;
+  m_useBFloat16 = i_useBFloat16;
+
+  allocate();
+
+  // init to zero
+  int16_t  l_zeroSurface = encodeHeight( 0, 0, m_numSaturated );
+  uint16_t l_zeroMomentum = encodeMomentum( 0, m_numSaturated );
+  int16_t  l_zeroBathymetry = Quantization::encodeInt16( 0, 1 / m_bathymetryScale, m_bathymetryOffset );
+  t_idx l_nCells = m_nCells;
+  #pragma omp parallel for
+  for( t_idx l_ce = 0; l_ce < l_nCells; l_ce++ ) {
+    m_surface   [l_ce] = l_zeroSurface;
+    m_hu        [l_ce] = l_zeroMomentum;
+    m_hv        [l_ce] = l_zeroMomentum;
+    m_bathymetry[l_ce] = l_zeroBathymetry;
+  }
+
+}
+
+tsunami_lab::patches::WavePropagation2dCompact::WavePropagation2dCompact( t_idx i_nCellsX, t_idx i_nCellsY, tsunami_lab::setups::Setup* i_setup, t_real i_scaleX, t_real i_scaleY, bool i_useBFloat16, t_real i_surfaceRange ) {
+
+  m_nCellsX = i_nCellsX;
+  m_nCellsY = i_nCellsY;
+  m_useBFloat16 = i_useBFloat16;
+  m_surfaceRange = i_surfaceRange;
+
+  allocate();
+
+  initWithSetup( i_setup, i_scaleX, i_scaleY );
+}
+
+void tsunami_lab::patches::WavePropagation2dCompact::allocate() {
+
+  m_nCells = (m_nCellsX+2) * (m_nCellsY+2);
+
+  size_t dataSize = m_nCells * 4 * sizeof(int16_t);
+  if( dataSize > 100 * 1000 * 1000 ) {
+    std::cout << "allocating " << m_nCells << " * 4 * " << sizeof(int16_t) << "B = " << (dataSize/1e9) << "GB (compact storage)" << std::endl;
+  }
+
+  // allocate memory including a single ghost cell on all sides
+  m_surface    = new int16_t [m_nCells];
+  m_hu         = new uint16_t[m_nCells];
+  m_hv         = new uint16_t[m_nCells];
+  m_bathymetry = new int16_t [m_nCells];
+
+}
+
+void tsunami_lab::patches::WavePropagation2dCompact::initWithSetup( tsunami_lab::setups::Setup* i_setup, t_real i_scaleX, t_real i_scaleY ) {
+  i_setup->setInitScale(i_scaleX, i_scaleY);
+
+  using namespace std::chrono;
+  auto start = high_resolution_clock::now();
+
+  t_idx l_nCellsX = m_nCellsX;
+  t_idx l_nCellsY = m_nCellsY;
+
+  // first pass: find the value ranges, so we can choose the scales of the integer formats;
+  // the rows are sampled twice instead of being kept as t_real, which would double the memory of the compact storage
+  t_real l_bMin = std::numeric_limits<t_real>::infinity(), l_bMax = -l_bMin;
+  t_real l_surfaceMin = l_bMin, l_surfaceMax = l_bMax;
+  #pragma omp parallel reduction(min: l_bMin, l_surfaceMin) reduction(max: l_bMax, l_surfaceMax)
+  {
+    std::vector<t_real> l_h(l_nCellsX + 2), l_b(l_nCellsX + 2);
+
+    #pragma omp for
+    for( t_idx l_iy = 0; l_iy < l_nCellsY + 2; l_iy++ ) {
+      i_setup->fillRows( l_iy, l_iy + 1, 0, l_nCellsX + 2, i_scaleX, i_scaleY,
+                         l_h.data(), nullptr, nullptr, l_b.data(), l_nCellsX + 2 );
+      for( t_idx l_ix = 0; l_ix < l_nCellsX + 2; l_ix++ ) {
+        l_bMin = std::min( l_bMin, l_b[l_ix] );
+        l_bMax = std::max( l_bMax, l_b[l_ix] );
+        if( l_b[l_ix] <= 0 ) {
+          l_surfaceMin = std::min( l_surfaceMin, l_h[l_ix] + l_b[l_ix] );
+          l_surfaceMax = std::max( l_surfaceMax, l_h[l_ix] + l_b[l_ix] );
+        }
+      }
+    }
+  }
+
+  // the bathymetry is static, so its range is covered exactly
+  m_bathymetryOffset = (l_bMin + l_bMax) * (t_real) 0.5;
+  m_bathymetryScale  = std::max( (l_bMax - l_bMin) * (t_real) 0.5, (t_real) 1 ) / 32767;
+
+  // waves change the surface, so leave some headroom
+  if( l_surfaceMin > l_surfaceMax ) l_surfaceMin = l_surfaceMax = 0;// everything is dry
+  m_surfaceOffset = (l_surfaceMin + l_surfaceMax) * (t_real) 0.5;
+  m_surfaceScale  = std::max( { (l_surfaceMax - l_surfaceMin) * 2, (t_real) 1, m_surfaceRange } ) / 32767;
+
+  // second pass: encode the values
+  t_idx l_numSaturated = 0;
+  #pragma omp parallel reduction(+: l_numSaturated)
+  {
+    std::vector<t_real> l_h(l_nCellsX + 2), l_hu(l_nCellsX + 2), l_hv(l_nCellsX + 2), l_b(l_nCellsX + 2);
+
+    #pragma omp for
+    for( t_idx l_iy = 0; l_iy < l_nCellsY + 2; l_iy++ ) {
+      i_setup->fillRows( l_iy, l_iy + 1, 0, l_nCellsX + 2, i_scaleX, i_scaleY,
+                         l_h.data(), l_hu.data(), l_hv.data(), l_b.data(), l_nCellsX + 2 );
+      t_idx l_i = l_iy * (l_nCellsX + 2);
+      for( t_idx l_ix = 0; l_ix < l_nCellsX + 2; l_ix++, l_i++ ) {
+        m_bathymetry[l_i] = Quantization::encodeInt16( l_b[l_ix], 1 / m_bathymetryScale, m_bathymetryOffset );
+        // the decoded bathymetry shall stay on the same side of the shore line
+        t_real l_bDecoded = decodeBathymetry( m_bathymetry[l_i] );
+        if( (l_b[l_ix] > 0) != (l_bDecoded > 0) ) m_bathymetry[l_i] += l_b[l_ix] > 0 ? 1 : -1;
+        l_bDecoded = decodeBathymetry( m_bathymetry[l_i] );
+        m_surface[l_i] = encodeHeight( l_h[l_ix], l_bDecoded, l_numSaturated );
+        m_hu[l_i] = encodeMomentum( l_hu[l_ix], l_numSaturated );
+        m_hv[l_i] = encodeMomentum( l_hv[l_ix], l_numSaturated );
+      }
+    }
+  }
+
+  m_numSaturated += l_numSaturated;
+  m_version++;
+
+  auto end = high_resolution_clock::now();
+  if(l_nCellsX * l_nCellsY > 1e5) std::cout << "inited compact field of size " << l_nCellsX << " x " << l_nCellsY << " in " << duration<double>(end-start).count() << "s" << std::endl;
+  std::cout << "compact storage: surface = " << m_surfaceOffset << " + i * " << m_surfaceScale << ", bathymetry = " << m_bathymetryOffset << " + i * " << m_bathymetryScale << ", momenta as " << (m_useBFloat16 ? "bfloat16" : "fp16") << std::endl;
+
+}
+
+tsunami_lab::patches::WavePropagation2dCompact::~WavePropagation2dCompact() {
+  delete[] m_surface;
+  delete[] m_hu;
+  delete[] m_hv;
+  delete[] m_bathymetry;
+  for( unsigned short l_qu = 0; l_qu < 4; l_qu++ ) {
+    delete[] m_export[l_qu];
+  }
+}
+
+void tsunami_lab::patches::WavePropagation2dCompact::timeStep( t_real i_scaling ) {
+
+  using namespace std::chrono;
+  auto start = high_resolution_clock::now();
+
+  t_idx l_stride = getStride();
+
+  t_idx l_nCellsX = m_nCellsX;
+  t_idx l_nCellsY = m_nCellsY;
+
+  // the number of threads depends on the grid size; small grids run serially
+  int l_threads = m_executionPolicy.getSolverThreads( m_nCells );
+
+  // values, which don't fit into their format in this step
+  t_idx l_numSaturated = 0;
+
+  //////////////////////////////
+  // half step in x direction //
+  //////////////////////////////
+
+  // every row is decoded, updated and encoded again in place
+  #pragma omp parallel num_threads(l_threads) if(l_threads > 1) reduction(+: l_numSaturated)
+  {
+    std::vector<t_real> l_hOld(l_stride), l_huOld(l_stride), l_b(l_stride);
+    std::vector<t_real> l_hNew(l_stride), l_huNew(l_stride);
+
+    #pragma omp for
+    for( t_idx l_iy = 0; l_iy < l_nCellsY + 2; l_iy++ ) {
+      t_idx l_i0 = l_iy * l_stride;
+      for( t_idx l_ix = 0; l_ix < l_stride; l_ix++ ) {
+        l_b[l_ix] = decodeBathymetry( m_bathymetry[l_i0 + l_ix] );
+        l_hNew [l_ix] = l_hOld [l_ix] = decodeHeight( m_surface[l_i0 + l_ix], l_b[l_ix] );
+        l_huNew[l_ix] = l_huOld[l_ix] = decodeMomentum( m_hu[l_i0 + l_ix] );
+      }
+      for( t_idx l_ix = 0; l_ix + 1 < l_stride; l_ix++ ) {
+        edgeUpdate( i_scaling,
+                    l_hOld [l_ix], l_hOld [l_ix+1],
+                    l_huOld[l_ix], l_huOld[l_ix+1],
+                    l_b    [l_ix], l_b    [l_ix+1],
+                    l_hNew [l_ix], l_hNew [l_ix+1],
+                    l_huNew[l_ix], l_huNew[l_ix+1] );
+      }
+      for( t_idx l_ix = 0; l_ix < l_stride; l_ix++ ) {
+        m_surface[l_i0 + l_ix] = encodeHeight( l_hNew[l_ix], l_b[l_ix], l_numSaturated );
+        m_hu     [l_i0 + l_ix] = encodeMomentum( l_huNew[l_ix], l_numSaturated );
+      }
+    }
+  }
+
+  auto middle = high_resolution_clock::now();
+
+  //////////////////////////////
+  // half step in y direction //
+  //////////////////////////////
+
+  // blocks of columns are walked from top to bottom with a window of two rows;
+  // a row is encoded, when the updates of both of its edges have been applied
+  t_idx l_blockSize = m_blockSizeY;
+  t_idx l_numBlocks = (l_stride + l_blockSize - 1) / l_blockSize;
+  #pragma omp parallel num_threads(l_threads) if(l_threads > 1) reduction(+: l_numSaturated)
+  {
+    std::vector<t_real> l_hOld[2], l_hvOld[2], l_b[2], l_hNew[2], l_hvNew[2];
+    for( unsigned short l_ro = 0; l_ro < 2; l_ro++ ) {
+      l_hOld [l_ro].resize( l_blockSize );
+      l_hvOld[l_ro].resize( l_blockSize );
+      l_b    [l_ro].resize( l_blockSize );
+      l_hNew [l_ro].resize( l_blockSize );
+      l_hvNew[l_ro].resize( l_blockSize );
+    }
+
+    #pragma omp for
+    for( t_idx l_bl = 0; l_bl < l_numBlocks; l_bl++ ) {
+      t_idx l_x0 = l_bl * l_blockSize;
+      t_idx l_nx = std::min( l_blockSize, l_stride - l_x0 );
+
+      // load the first row
+      unsigned short l_top = 0;
+      for( t_idx l_ix = 0; l_ix < l_nx; l_ix++ ) {
+        t_idx l_i = l_x0 + l_ix;
+        l_b[l_top][l_ix] = decodeBathymetry( m_bathymetry[l_i] );
+        l_hNew [l_top][l_ix] = l_hOld [l_top][l_ix] = decodeHeight( m_surface[l_i], l_b[l_top][l_ix] );
+        l_hvNew[l_top][l_ix] = l_hvOld[l_top][l_ix] = decodeMomentum( m_hv[l_i] );
+      }
+
+      for( t_idx l_iy = 0; l_iy + 1 < l_nCellsY + 2; l_iy++ ) {
+        unsigned short l_bottom = 1 - l_top;
+        t_idx l_iTop    = l_x0 + l_iy * l_stride;
+        t_idx l_iBottom = l_iTop + l_stride;
+
+        // load the next row
+        for( t_idx l_ix = 0; l_ix < l_nx; l_ix++ ) {
+          t_idx l_i = l_iBottom + l_ix;
+          l_b[l_bottom][l_ix] = decodeBathymetry( m_bathymetry[l_i] );
+          l_hNew [l_bottom][l_ix] = l_hOld [l_bottom][l_ix] = decodeHeight( m_surface[l_i], l_b[l_bottom][l_ix] );
+          l_hvNew[l_bottom][l_ix] = l_hvOld[l_bottom][l_ix] = decodeMomentum( m_hv[l_i] );
+        }
+
+        for( t_idx l_ix = 0; l_ix < l_nx; l_ix++ ) {
+          edgeUpdate( i_scaling,
+                      l_hOld [l_top][l_ix], l_hOld [l_bottom][l_ix],
+                      l_hvOld[l_top][l_ix], l_hvOld[l_bottom][l_ix],
+                      l_b    [l_top][l_ix], l_b    [l_bottom][l_ix],
+                      l_hNew [l_top][l_ix], l_hNew [l_bottom][l_ix],
+                      l_hvNew[l_top][l_ix], l_hvNew[l_bottom][l_ix] );
+        }
+
+        // the top row is complete
+        for( t_idx l_ix = 0; l_ix < l_nx; l_ix++ ) {
+          m_surface[l_iTop + l_ix] = encodeHeight( l_hNew[l_top][l_ix], l_b[l_top][l_ix], l_numSaturated );
+          m_hv     [l_iTop + l_ix] = encodeMomentum( l_hvNew[l_top][l_ix], l_numSaturated );
+        }
+
+        l_top = l_bottom;
+      }
+
+      // save the last row
+      t_idx l_iLast = l_x0 + (l_nCellsY + 1) * l_stride;
+      for( t_idx l_ix = 0; l_ix < l_nx; l_ix++ ) {
+        m_surface[l_iLast + l_ix] = encodeHeight( l_hNew[l_top][l_ix], l_b[l_top][l_ix], l_numSaturated );
+        m_hv     [l_iLast + l_ix] = encodeMomentum( l_hvNew[l_top][l_ix], l_numSaturated );
+      }
+    }
+  }
+
+  m_numSaturated += l_numSaturated;
+  m_version++;
+
+  auto end = high_resolution_clock::now();
+  if(l_nCellsX * l_nCellsY > 1e5) std::cout << "      computed timeStep in " << duration<double>(end-start).count() << "s, " << duration<double>(end-middle).count()/duration<double>(middle-start).count() << "x slower for y" << std::endl;
+
+}
+
+tsunami_lab::t_real tsunami_lab::patches::WavePropagation2dCompact::computeMaxTimestep( t_real i_cellSizeMeters ){
+
+  t_real l_maxVelocity = 0;
+  t_real l_gravity = tsunami_lab::solvers::FWave::m_gravity;
+
+  t_idx  l_stride = getStride();
+
+  t_idx  l_nCellsX = m_nCellsX;
+  t_idx  l_nCellsY = m_nCellsY;
+
+  int l_threads = m_executionPolicy.getCopyThreads( m_nCells );
+  #pragma omp parallel for reduction(max: l_maxVelocity) num_threads(l_threads) if(l_threads > 1)
+  for( t_idx l_iy = 1; l_iy <= l_nCellsY; l_iy++){
+    t_idx l_iStart = l_iy * l_stride + 1;// +1, because we start iterating at l_ix = 1
+    t_idx l_iEnd = l_iStart + l_nCellsX + 1;
+    for(t_idx l_i = l_iStart; l_i < l_iEnd; l_i++){
+      t_real l_height = decodeHeight( m_surface[l_i], decodeBathymetry( m_bathymetry[l_i] ) );
+      t_real l_impulse = std::max(std::abs(decodeMomentum(m_hu[l_i])), std::abs(decodeMomentum(m_hv[l_i])));
+      t_real l_velocity = l_impulse / l_height;
+      t_real l_expectedVelocity = l_velocity + std::sqrt(l_gravity * l_height);
+      if(l_expectedVelocity > l_maxVelocity) l_maxVelocity = l_expectedVelocity;
+    }
+  }
+
+  return m_cflFactor * i_cellSizeMeters / l_maxVelocity;
+
+}
+
+void tsunami_lab::patches::WavePropagation2dCompact::setGhostOutflow() {
+
+  // the encoded values can be copied directly
+  int16_t*  l_b  = m_bathymetry;
+  int16_t*  l_s  = m_surface;
+  uint16_t* l_hu = m_hu;
+  uint16_t* l_hv = m_hv;
+
+  t_idx l_stride = getStride();
+  int   l_threadsX = m_executionPolicy.getCopyThreads( m_nCellsX + 2 );
+  int   l_threadsY = m_executionPolicy.getCopyThreads( m_nCellsY + 2 );
+
+  // set left and right boundary
+  #pragma omp parallel for num_threads(l_threadsY) if(l_threadsY > 1)
+  for(t_idx l_y = 0; l_y < m_nCellsY+2; l_y++){
+    t_idx l_i0 = l_y * l_stride;
+    t_idx l_i1 = l_i0 + 1;
+    l_b [l_i0] = l_b [l_i1];
+    l_s [l_i0] = l_s [l_i1];
+    l_hu[l_i0] = l_hu[l_i1];
+    l_hv[l_i0] = l_hv[l_i1];
+    l_i0 = m_nCellsX + 1 + l_y * l_stride;
+    l_i1 = l_i0 - 1;
+    l_b [l_i0] = l_b [l_i1];
+    l_s [l_i0] = l_s [l_i1];
+    l_hu[l_i0] = l_hu[l_i1];
+    l_hv[l_i0] = l_hv[l_i1];
+  }
+
+  // set top and bottom boundary
+  #pragma omp parallel for num_threads(l_threadsX) if(l_threadsX > 1)
+  for(t_idx l_x = 0; l_x < m_nCellsX+2; l_x++){
+    t_idx l_i0 = l_x;
+    t_idx l_i1 = l_i0 + l_stride;
+    l_b [l_i0] = l_b [l_i1];
+    l_s [l_i0] = l_s [l_i1];
+    l_hu[l_i0] = l_hu[l_i1];
+    l_hv[l_i0] = l_hv[l_i1];
+    l_i0 = l_x + (m_nCellsY + 1) * l_stride;
+    l_i1 = l_i0 - l_stride;
+    l_b [l_i0] = l_b [l_i1];
+    l_s [l_i0] = l_s [l_i1];
+    l_hu[l_i0] = l_hu[l_i1];
+    l_hv[l_i0] = l_hv[l_i1];
+  }
+
+  m_version++;
+
+}
+
+tsunami_lab::t_real const * tsunami_lab::patches::WavePropagation2dCompact::getExport( unsigned short i_quantity ) {
+
+  if( m_export[i_quantity] == nullptr ) m_export[i_quantity] = new t_real[m_nCells];
+  t_real* l_data = m_export[i_quantity];
+
+  if( m_exportVersion[i_quantity] != m_version ) {
+    t_idx l_nCells = m_nCells;
+    #pragma omp parallel for
+    for( t_idx l_i = 0; l_i < l_nCells; l_i++ ) {
+      switch( i_quantity ) {
+        case 0:  l_data[l_i] = decodeHeight( m_surface[l_i], decodeBathymetry( m_bathymetry[l_i] ) ); break;
+        case 1:  l_data[l_i] = decodeMomentum( m_hu[l_i] ); break;
+        case 2:  l_data[l_i] = decodeMomentum( m_hv[l_i] ); break;
+        default: l_data[l_i] = decodeBathymetry( m_bathymetry[l_i] ); break;
+      }
+    }
+    m_exportVersion[i_quantity] = m_version;
+  }
+
+  return l_data;
+}
+
+void tsunami_lab::patches::WavePropagation2dCompact::getRow( unsigned short i_quantity,
+                                                             t_idx          i_iy,
+                                                             t_real       * o_row ) {
+  t_idx l_i0 = i_iy * getStride();
+  for( t_idx l_ix = 0; l_ix < m_nCellsX + 2; l_ix++ ) {
+    t_idx l_i = l_i0 + l_ix;
+    switch( i_quantity ) {
+      case 0:  o_row[l_ix] = decodeHeight( m_surface[l_i], decodeBathymetry( m_bathymetry[l_i] ) ); break;
+      case 1:  o_row[l_ix] = decodeMomentum( m_hu[l_i] ); break;
+      case 2:  o_row[l_ix] = decodeMomentum( m_hv[l_i] ); break;
+      default: o_row[l_ix] = decodeBathymetry( m_bathymetry[l_i] ); break;
+    }
+  }
+}
+
+void tsunami_lab::patches::WavePropagation2dCompact::getCellState( t_idx    i_ix,
+                                                                   t_idx    i_iy,
+                                                                   t_real & o_h,
+                                                                   t_real & o_hu,
+                                                                   t_real & o_hv ) {
+  t_idx l_i = (i_ix+1) + (i_iy+1) * (m_nCellsX+2);
+  o_h  = decodeHeight( m_surface[l_i], decodeBathymetry( m_bathymetry[l_i] ) );
+  o_hu = decodeMomentum( m_hu[l_i] );
+  o_hv = decodeMomentum( m_hv[l_i] );
+}
+
+void tsunami_lab::patches::WavePropagation2dCompact::setBathymetry( t_idx  i_ix,
+                                                                    t_idx  i_iy,
+                                                                    t_real i_b ) {
+  t_idx  l_i = (i_ix+1) + (i_iy+1) * (m_nCellsX+2);
+  t_real l_h = decodeHeight( m_surface[l_i], decodeBathymetry( m_bathymetry[l_i] ) );
+  m_bathymetry[l_i] = Quantization::encodeInt16( i_b, 1 / m_bathymetryScale, m_bathymetryOffset );
+  m_surface[l_i] = encodeHeight( l_h, decodeBathymetry( m_bathymetry[l_i] ), m_numSaturated );
+  m_version++;
+}
+
+void tsunami_lab::patches::WavePropagation2dCompact::setHeight( t_idx  i_ix,
+                                                                t_idx  i_iy,
+                                                                t_real i_h ) {
+  t_idx l_i = (i_ix+1) + (i_iy+1) * (m_nCellsX+2);
+  m_surface[l_i] = encodeHeight( i_h, decodeBathymetry( m_bathymetry[l_i] ), m_numSaturated );
+  m_version++;
+}
@@ -0,0 +1,322 @@
+/**
+ * @author Antonio Noack
+ *
+ * @section DESCRIPTION
+ * Two-dimensional wave propagation patch, which stores its state in 16 bit formats.
+ * The surface elevation (height + bathymetry) and the bathymetry are stored as scaled 16 bit integers,
+ * the momenta as half precision floats or bfloat16. The sweeps decode the values to t_real, and work in place,
+ * so a cell needs 8 bytes instead of 28 bytes in WavePropagation2d.
+ **/
+#ifndef TSUNAMI_LAB_PATCHES_WAVE_PROPAGATION_2D_COMPACT
+#define TSUNAMI_LAB_PATCHES_WAVE_PROPAGATION_2D_COMPACT
+
+#include "WavePropagation.h"
+#include "Quantization.h"
+#include "../setups/Setup.h"
+
+#include <cstdint>
+
+namespace tsunami_lab {
+  namespace patches {
+    class WavePropagation2dCompact;
+  }
+}
+
+class tsunami_lab::patches::WavePropagation2dCompact: public WavePropagation {
+  private:
+
+    //! number of cells discretizing the computational domain, including ghost cells
+    t_idx m_nCells = 0;
+
+    //! number of cells on the x and y axis
+    t_idx m_nCellsX = 0, m_nCellsY = 0;
+
+    //! surface elevation (height + bathymetry) as scaled integers; unused for dry cells
+    int16_t * m_surface = nullptr;
+
+    //! momenta in x direction as half precision floats or bfloat16
+    uint16_t * m_hu = nullptr;
+
+    //! momenta in y direction as half precision floats or bfloat16
+    uint16_t * m_hv = nullptr;
+
+    //! bathymetry in meters as scaled integers
+    int16_t * m_bathymetry = nullptr;
+
+    //! surface elevation = offset + integer * scale; default: +/- 32m with millimeter resolution
+    t_real m_surfaceScale = 0.001, m_surfaceOffset = 0;
+
+    //! minimum distance in meters, which the surface elevation may move away from the center of its initial range; 0 = automatic
+    t_real m_surfaceRange = 0;
+
+    //! number of encoded values, which didn't fit into their format: surface elevations, which were clamped, and momenta, which became infinite
+    t_idx m_numSaturated = 0;
+
+    //! bathymetry = offset + integer * scale; default: +/- 16km with 0.5m resolution
+    t_real m_bathymetryScale = 0.5, m_bathymetryOffset = 0;
+
+    //! if true, the momenta are stored as bfloat16, else as half precision floats
+    bool m_useBFloat16 = false;
+
+    //! cfl factor for the 2d case; should be less than 0.5, such that a velocity increase does not violate the cfl condition
+    t_real m_cflFactor = 0.45;
+
+    //! decoded copies of height, momentum x, momentum y and bathymetry for the getters; allocated on first use
+    t_real * m_export[4] = { nullptr, nullptr, nullptr, nullptr };
+
+    //! state version, which was decoded into m_export
+    t_idx m_exportVersion[4] = { 0, 0, 0, 0 };
+
+    //! state version; incremented by every change
+    t_idx m_version = 1;
+
+    //! number of columns, which are processed together in the sweep in y direction
+    static t_idx constexpr m_blockSizeY = 256;
+
+    /**
+     * Allocates the compact arrays for m_nCellsX x m_nCellsY cells and their ghost cells.
+     **/
+    void allocate();
+
+    //! decodes a bathymetry value
+    inline t_real decodeBathymetry( int16_t i_b ) const {
+      return Quantization::decodeInt16( i_b, m_bathymetryScale, m_bathymetryOffset );
+    }
+
+    //! decodes the water height from the surface elevation and the decoded bathymetry
+    inline t_real decodeHeight( int16_t i_surface, t_real i_b ) const {
+      if( i_b > 0 ) return 0;
+      t_real l_h = Quantization::decodeInt16( i_surface, m_surfaceScale, m_surfaceOffset ) - i_b;
+      return l_h > 0 ? l_h : 0;
+    }
+
+    //! encodes the water height as surface elevation; counts the value in io_numSaturated, if it is clamped
+    inline int16_t encodeHeight( t_real i_h, t_real i_b, t_idx & io_numSaturated ) const {
+      if( i_b > 0 ) return 0;
+      return Quantization::encodeInt16( i_h + i_b, 1 / m_surfaceScale, m_surfaceOffset, io_numSaturated );
+    }
+
+    //! decodes a momentum value
+    inline t_real decodeMomentum( uint16_t i_hu ) const {
+      return m_useBFloat16 ? Quantization::bfloat16ToFloat( i_hu ) : Quantization::halfToFloat( i_hu );
+    }
+
+    //! encodes a momentum value; counts the value in io_numSaturated, if it becomes infinite
+    inline uint16_t encodeMomentum( t_real i_hu, t_idx & io_numSaturated ) const {
+      uint16_t l_bits = m_useBFloat16 ? Quantization::floatToBFloat16( i_hu ) : Quantization::floatToHalf( i_hu );
+      if( (l_bits & 0x7fff) == (m_useBFloat16 ? 0x7f80 : 0x7c00) ) io_numSaturated++;
+      return l_bits;
+    }
+
+    /**
+     * Returns the decoded copy of a quantity, and refreshes it if the state has changed.
+     *
+     * @param i_quantity 0 = height, 1 = momentum x, 2 = momentum y, 3 = bathymetry.
+     * @return decoded values, including the ghost cells.
+     **/
+    t_real const * getExport( unsigned short i_quantity );
+
+  public:
+    /**
+     * Constructs the compact 2d wave propagation solver.
+     *
+     * @param i_nCellsX number of cells on the x axis.
+     * @param i_nCellsY number of cells on the y axis.
+     * @param i_useBFloat16 store the momenta as bfloat16 instead of half precision floats.
+     **/
+    WavePropagation2dCompact( t_idx i_nCellsX, t_idx i_nCellsY, bool i_useBFloat16 );
+
+    /**
+     * Constructs the compact 2d wave propagation solver and applies the setup.
+     *
+     * @param i_nCellsX number of cells on the x axis.
+     * @param i_nCellsY number of cells on the y axis.
+     * @param i_setup setup for cell initialization.
+     * @param i_scaleX scale for the scene in x direction; e.g. you can multiply the number of cells by x, and set the scale to 1/x, and your setup will still work.
+     * @param i_scaleY scale for the scene in y direction.
+     * @param i_useBFloat16 store the momenta as bfloat16 instead of half precision floats.
+     * @param i_surfaceRange minimum distance in meters, which the surface elevation may move away from the center of its initial range; 0 = automatic.
+     **/
+    WavePropagation2dCompact( t_idx i_nCellsX, t_idx i_nCellsY, tsunami_lab::setups::Setup* i_setup, t_real i_scaleX, t_real i_scaleY, bool i_useBFloat16, t_real i_surfaceRange );
+
+    /**
+     * Destructor which frees all allocated memory.
+     **/
+    ~WavePropagation2dCompact();
+
+    /**
+     * Initializes the internal state with a setup.
+     * The scales of the integer formats are derived from the value ranges of the setup:
+     * the bathymetry range is covered exactly, the surface elevation range of wet cells with a headroom of 4x, but at least +/- 1m,
+     * or the surface range of the constructor, if it is larger. Surface elevations beyond it are clamped and counted, see getNumSaturated().
+     *
+     * @param i_setup setup for cell initialization.
+     * @param i_scaleX scale for the scene in x direction; e.g. you can multiply the number of cells by x, and set the scale to 1/x, and your setup will still work.
+     * @param i_scaleY scale for the scene in y direction
+     **/
+    void initWithSetup( tsunami_lab::setups::Setup* i_setup, t_real i_scaleX, t_real i_scaleY );
+
+    /**
+     * Computes the maximum time step that is allowed without breaking the CFL condition.
+     **/
+    t_real computeMaxTimestep( t_real i_cellSizeMeters );
+
+    /**
+     * Performs a time step.
+     *
+     * @param i_scaling scaling of the time step (dt / dx).
+     **/
+    void timeStep( t_real i_scaling );
+
+    /**
+     * Sets the values of the ghost cells according to outflow boundary conditions.
+     **/
+    void setGhostOutflow();
+
+    /**
+     * Gets the stride in y-direction. x-direction is stride-1.
+     *
+     * @return stride in y-direction.
+     **/
+    t_idx getStride(){
+      return m_nCellsX+2;
+    }
+
+    /**
+     * Gets cells' water heights; decoded on demand.
+     *
+     * @return water heights.
+     */
+    t_real const * getHeight(){
+      return getExport(0)+1+(m_nCellsX+2);
+    }
+
+    /**
+     * Gets the cells' momenta in x-direction; decoded on demand.
+     *
+     * @return momenta in x-direction.
+     **/
+    t_real const * getMomentumX(){
+      return getExport(1)+1+(m_nCellsX+2);
+    }
+
+    /**
+     * Gets the cells' momenta in y-direction; decoded on demand.
+     *
+     * @return momenta in y-direction.
+     **/
+    t_real const * getMomentumY(){
+      return getExport(2)+1+(m_nCellsX+2);
+    }
+
+    /**
+     * Gets the cells' bathymetry; decoded on demand.
+     *
+     * @return bathymetry.
+     **/
+    t_real const * getBathymetry(){
+      return getExport(3)+1+(m_nCellsX+2);
+    }
+
+    /**
+     * Decodes a row of a quantity including the ghost cells.
+     *
+     * @param i_quantity 0 = height, 1 = momentum x, 2 = momentum y, 3 = bathymetry.
+     * @param i_iy id of the row including the ghost cells.
+     * @param o_row buffer for getStride() values.
+     **/
+    void getRow( unsigned short i_quantity,
+                 t_idx          i_iy,
+                 t_real       * o_row );
+
+    /**
+     * The getters decode a full copy of the field.
+     *
+     * @return false.
+     **/
+    bool hasDenseStorage() {
+      return false;
+    }
+
+    /**
+     * Gets the water height and momenta of a single cell.
+     *
+     * @param i_ix id of the cell in x-direction.
+     * @param i_iy id of the cell in y-direction.
+     * @param o_h water height.
+     * @param o_hu momentum in x-direction.
+     * @param o_hv momentum in y-direction.
+     **/
+    void getCellState( t_idx    i_ix,
+                       t_idx    i_iy,
+                       t_real & o_h,
+                       t_real & o_hu,
+                       t_real & o_hv );
+
+    /**
+     * Sets the bathymetry of the cell to the given value; the water height of the cell is kept.
+     *
+     * @param i_ix id of the cell in x-direction.
+     * @param i_iy id of the cell in y-direction.
+     * @param i_b bathymetry.
+     **/
+    void setBathymetry( t_idx  i_ix,
+                        t_idx  i_iy,
+                        t_real i_b );
+
+    /**
+     * Sets the height of the cell to the given value.
+     *
+     * @param i_ix id of the cell in x-direction.
+     * @param i_iy id of the cell in y-direction.
+     * @param i_h water height.
+     **/
+    void setHeight( t_idx  i_ix,
+                    t_idx  i_iy,
+                    t_real i_h );
+
+    /**
+     * Sets the momentum in x-direction to the given value.
+     *
+     * @param i_ix id of the cell in x-direction.
+     * @param i_iy id of the cell in y-direction.
+     * @param i_hu momentum in x-direction.
+     **/
+    void setMomentumX( t_idx  i_ix,
+                       t_idx  i_iy,
+                       t_real i_hu ) {
+      m_hu[(i_ix+1) + (i_iy+1) * (m_nCellsX+2)] = encodeMomentum( i_hu, m_numSaturated );
+      m_version++;
+    }
+
+    /**
+     * Sets the momentum in y-direction to the given value.
+     *
+     * @param i_ix id of the cell in x-direction.
+     * @param i_iy id of the cell in y-direction.
+     * @param i_hv momentum in y-direction.
+     **/
+    void setMomentumY( t_idx  i_ix,
+                       t_idx  i_iy,
+                       t_real i_hv ) {
+      m_hv[(i_ix+1) + (i_iy+1) * (m_nCellsX+2)] = encodeMomentum( i_hv, m_numSaturated );
+      m_version++;
+    }
+
+    /**
+     * Gets the number of encoded values since the construction, which didn't fit into their format:
+     * surface elevations, which were clamped to the range of the integers, and momenta, which became infinite.
+     *
+     * @return number of saturated values.
+     **/
+    t_idx getNumSaturated() {
+      return m_numSaturated;
+    }
+
+    /** Sets the cfl factor */
+    void setCflFactor(t_real i_value){
+      m_cflFactor = i_value;
+    }
+};
+
+#endif
@@ -0,0 +1,193 @@
+/**
+ * @author Antonio Noack
+ *
+ * @section DESCRIPTION
+ * Unit tests for the 16 bit storage formats and the compact two-dimensional wave propagation patch.
+ **/
+#include <catch2/catch.hpp>
+#include <algorithm> // std::max
+#include <cmath> // std::abs, std::isinf
+
+#define private public
+
+#include "WavePropagation2d.h"
+#include "WavePropagation2dCompact.h"
+#include "Quantization.h"
+#include "../constants.h"
+#include "../setups/DamBreak2d.h"
+
+#define t_real tsunami_lab::t_real
+#define t_idx tsunami_lab::t_idx
+
+TEST_CASE( "Test the 16 bit storage formats.", "[Quantization]" ) {
+
+  using tsunami_lab::patches::Quantization;
+
+  // half precision floats
+  REQUIRE( Quantization::floatToHalf( 0.0f )     == 0x0000 );
+  REQUIRE( Quantization::floatToHalf( 1.0f )     == 0x3c00 );
+  REQUIRE( Quantization::floatToHalf( -2.0f )    == 0xc000 );
+  REQUIRE( Quantization::floatToHalf( 65504.0f ) == 0x7bff );
+  REQUIRE( Quantization::floatToHalf( 1e6f )     == 0x7c00 );
+  REQUIRE( Quantization::halfToFloat( 0x0001 )   == std::ldexp( 1.0f, -24 ) );
+  REQUIRE( Quantization::halfToFloat( 0x3c00 )   == 1.0f );
+  REQUIRE( Quantization::halfToFloat( 0xc000 )   == -2.0f );
+
+  // all finite half precision floats survive a round trip
+  for( uint32_t l_bits = 0; l_bits < 0x10000; l_bits++ ) {
+    if( (l_bits & 0x7c00) == 0x7c00 ) continue;// inf, NaN
+    uint16_t l_half = (uint16_t) l_bits;
+    REQUIRE( Quantization::floatToHalf( Quantization::halfToFloat( l_half ) ) == l_half );
+  }
+
+  // rounding to the nearest even value: 1 + 2^-11 is exactly between 1 and 1 + 2^-10
+  REQUIRE( Quantization::floatToHalf( 1.0f + std::ldexp( 1.0f, -11 ) ) == 0x3c00 );
+  REQUIRE( Quantization::floatToHalf( 1.0f + 3 * std::ldexp( 1.0f, -11 ) ) == 0x3c02 );
+
+  // bfloat16
+  REQUIRE( Quantization::floatToBFloat16( 1.0f )  == 0x3f80 );
+  REQUIRE( Quantization::floatToBFloat16( -2.0f ) == 0xc000 );
+  REQUIRE( Quantization::bfloat16ToFloat( 0x3f80 ) == 1.0f );
+  REQUIRE( Quantization::bfloat16ToFloat( Quantization::floatToBFloat16( 100.0f ) ) == 100.0f );
+
+  // scaled integers
+  REQUIRE( Quantization::encodeInt16( 0.5, 1000, 0 ) == 500 );
+  REQUIRE( Quantization::encodeInt16( 1e9, 1000, 0 ) == 32767 );
+  REQUIRE( Quantization::encodeInt16( -1e9, 1000, 0 ) == -32767 );
+  REQUIRE( Quantization::decodeInt16( 500, 0.001, 0 ) == Approx( 0.5 ) );
+  REQUIRE( Quantization::decodeInt16( Quantization::encodeInt16( -3.21, 100, -4 ), 0.01, -4 ) == Approx( -3.21 ) );
+
+  // clamped values are counted
+  t_idx l_numSaturated = 0;
+  REQUIRE( Quantization::encodeInt16( 32.767, 1000, 0, l_numSaturated ) == 32767 );
+  REQUIRE( Quantization::encodeInt16( -32.767, 1000, 0, l_numSaturated ) == -32767 );
+  REQUIRE( l_numSaturated == 0 );
+  REQUIRE( Quantization::encodeInt16( 1e9, 1000, 0, l_numSaturated ) == 32767 );
+  REQUIRE( Quantization::encodeInt16( -33, 1000, 0, l_numSaturated ) == -32767 );
+  Quantization::encodeInt16( std::nan( "" ), 1000, 0, l_numSaturated );
+  REQUIRE( l_numSaturated == 3 );
+}
+
+TEST_CASE( "Test the compact 2d wave propagation solver.", "[WaveProp2dCompact]" ) {
+
+  // circular dam break on a flat bathymetry
+  tsunami_lab::setups::DamBreak2d l_setup( 15, 10, 25, 25, 10, -5 );
+
+  tsunami_lab::patches::WavePropagation2d        l_reference( 50, 50, &l_setup, 1, 1 );
+  tsunami_lab::patches::WavePropagation2dCompact l_compact  ( 50, 50, &l_setup, 1, 1, false, 0 );
+  tsunami_lab::patches::WavePropagation2dCompact l_compactBF( 50, 50, &l_setup, 1, 1, true, 0 );
+
+  // the initial state is represented well
+  for( t_idx l_iy = 0; l_iy < 50; l_iy++ ) {
+    for( t_idx l_ix = 0; l_ix < 50; l_ix++ ) {
+      t_idx l_i = l_ix + l_iy * l_reference.getStride();
+      REQUIRE( l_compact.getHeight()[l_i]     == Approx( l_reference.getHeight()[l_i] ).margin( 0.001 ) );
+      REQUIRE( l_compact.getBathymetry()[l_i] == Approx( l_reference.getBathymetry()[l_i] ).margin( 0.001 ) );
+    }
+  }
+
+  // run both with the same time steps
+  for( t_idx l_st = 0; l_st < 20; l_st++ ) {
+    l_reference.setGhostOutflow();
+    l_compact.setGhostOutflow();
+    l_compactBF.setGhostOutflow();
+    t_real l_scaling = l_reference.computeMaxTimestep( 1 );
+    REQUIRE( l_compact.computeMaxTimestep( 1 ) == Approx( l_scaling ).epsilon( 0.01 ) );
+    l_reference.timeStep( l_scaling );
+    l_compact.timeStep( l_scaling );
+    l_compactBF.timeStep( l_scaling );
+  }
+
+  for( t_idx l_iy = 0; l_iy < 50; l_iy++ ) {
+    for( t_idx l_ix = 0; l_ix < 50; l_ix++ ) {
+      t_idx l_i = l_ix + l_iy * l_reference.getStride();
+      t_real l_h, l_hu, l_hv;
+      l_compact.getCellState( l_ix, l_iy, l_h, l_hu, l_hv );
+      REQUIRE( l_h  == Approx( l_reference.getHeight()[l_i] ).margin( 0.01 ) );
+      REQUIRE( l_hu == Approx( l_reference.getMomentumX()[l_i] ).margin( 0.1 ) );
+      REQUIRE( l_hv == Approx( l_reference.getMomentumY()[l_i] ).margin( 0.1 ) );
+      REQUIRE( l_compact.getHeight()[l_i] == l_h );
+      // bfloat16 has 8 bits of mantissa only
+      l_compactBF.getCellState( l_ix, l_iy, l_h, l_hu, l_hv );
+      REQUIRE( l_h  == Approx( l_reference.getHeight()[l_i] ).margin( 0.05 ) );
+      REQUIRE( l_hu == Approx( l_reference.getMomentumX()[l_i] ).margin( 0.5 ) );
+    }
+  }
+}
+
+TEST_CASE( "Test the compact 2d wave propagation solver with a lake at rest.", "[WaveProp2dCompact]" ) {
+
+  // a lake with varying depth and an island
+  tsunami_lab::patches::WavePropagation2dCompact l_waveProp( 20, 300, false );
+  for( t_idx l_iy = 0; l_iy < 300; l_iy++ ) {
+    for( t_idx l_ix = 0; l_ix < 20; l_ix++ ) {
+      t_real l_b = l_ix > 8 && l_ix < 12 && l_iy > 100 && l_iy < 110 ? 5 : -(t_real) (1 + l_ix + l_iy % 7);
+      l_waveProp.setBathymetry( l_ix, l_iy, l_b );
+      l_waveProp.setHeight( l_ix, l_iy, l_b > 0 ? 0 : -l_b );
+      l_waveProp.setMomentumX( l_ix, l_iy, 0 );
+      l_waveProp.setMomentumY( l_ix, l_iy, 0 );
+    }
+  }
+
+  for( t_idx l_st = 0; l_st < 10; l_st++ ) {
+    l_waveProp.setGhostOutflow();
+    l_waveProp.timeStep( l_waveProp.computeMaxTimestep( 1 ) );
+  }
+
+  for( t_idx l_iy = 0; l_iy < 300; l_iy++ ) {
+    for( t_idx l_ix = 0; l_ix < 20; l_ix++ ) {
+      t_idx l_i = l_ix + l_iy * l_waveProp.getStride();
+      t_real l_b = l_waveProp.getBathymetry()[l_i];
+      REQUIRE( l_waveProp.getHeight()[l_i] + std::min( l_b, (t_real) 0 ) == Approx( 0 ).margin( 0.002 ) );
+      REQUIRE( l_waveProp.getMomentumX()[l_i] == Approx( 0 ).margin( 0.01 ) );
+      REQUIRE( l_waveProp.getMomentumY()[l_i] == Approx( 0 ).margin( 0.01 ) );
+    }
+  }
+}
+
+TEST_CASE( "Test the saturation of the compact 2d wave propagation solver.", "[WaveProp2dCompact]" ) {
+
+  // a flat lake at rest: the surface range is +/- 1m by default
+  tsunami_lab::setups::DamBreak2d l_setup( 10, 10, 25, 25, 10, -10 );
+
+  tsunami_lab::patches::WavePropagation2dCompact l_default( 50, 50, &l_setup, 1, 1, false, 0 );
+  tsunami_lab::patches::WavePropagation2dCompact l_wide   ( 50, 50, &l_setup, 1, 1, false, 20 );
+  REQUIRE( l_default.m_surfaceScale * 32767 == Approx( 1 ) );
+  REQUIRE( l_wide.m_surfaceScale * 32767 == Approx( 20 ) );
+  REQUIRE( l_default.getNumSaturated() == 0 );
+
+  // two currents collide in the middle and pile up the water by several meters
+  for( t_idx l_iy = 0; l_iy < 50; l_iy++ ) {
+    for( t_idx l_ix = 0; l_ix < 50; l_ix++ ) {
+      t_real l_hu = l_ix < 25 ? 50 : -50;
+      l_default.setMomentumX( l_ix, l_iy, l_hu );
+      l_wide.setMomentumX( l_ix, l_iy, l_hu );
+    }
+  }
+  REQUIRE( l_default.getNumSaturated() == 0 );
+
+  t_real l_maxSurface = 0;
+  for( t_idx l_st = 0; l_st < 20; l_st++ ) {
+    l_default.setGhostOutflow();
+    l_wide.setGhostOutflow();
+    t_real l_scaling = l_wide.computeMaxTimestep( 1 );
+    l_default.timeStep( l_scaling );
+    l_wide.timeStep( l_scaling );
+    for( t_idx l_ix = 0; l_ix < 50; l_ix++ ) {
+      t_real l_h, l_hu, l_hv;
+      l_wide.getCellState( l_ix, 25, l_h, l_hu, l_hv );
+      l_maxSurface = std::max( l_maxSurface, l_h - 10 );
+    }
+  }
+
+  // the surface left the default range, which was detected; the wide range holds it
+  REQUIRE( l_maxSurface > 2 );
+  REQUIRE( l_default.getNumSaturated() > 0 );
+  REQUIRE( l_wide.getNumSaturated() == 0 );
+
+  // momenta beyond the range of half precision floats become infinite, and are counted as well
+  t_idx l_numSaturated = l_wide.getNumSaturated();
+  l_wide.setMomentumY( 3, 4, 1e5 );
+  REQUIRE( std::isinf( l_wide.getMomentumY()[3 + 4 * l_wide.getStride()] ) );
+  REQUIRE( l_wide.getNumSaturated() == l_numSaturated + 1 );
+}
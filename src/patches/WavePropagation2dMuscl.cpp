@@ -0,0 +1,373 @@
+/**
+ * @author Antonio Noack
+ *
+ * @section DESCRIPTION
+ * Two-dimensional wave propagation patch with second order accuracy in space and time.
+ **/
+#include <algorithm> // std::max, std::min
+#include <cmath> // std::sqrt, std::abs
+#include <iostream>
+#include <chrono> // measure time
+#include "WavePropagation2dMuscl.h"
+#include "../setups/Setup.h"
+#include "../solvers/FWave.h"
+
+tsunami_lab::patches::WavePropagation2dMuscl::WavePropagation2dMuscl( t_idx i_nCellsX, t_idx i_nCellsY, Limiter i_limiter ) {
+
+  m_nCellsX = i_nCellsX;
+  m_nCellsY = i_nCellsY;
+  m_limiter = i_limiter;
+
+  allocate();
+
+}
+
+tsunami_lab::patches::WavePropagation2dMuscl::WavePropagation2dMuscl( t_idx i_nCellsX, t_idx i_nCellsY, tsunami_lab::setups::Setup* i_setup, t_real i_scaleX, t_real i_scaleY, Limiter i_limiter ) {
+
+  m_nCellsX = i_nCellsX;
+  m_nCellsY = i_nCellsY;
+  m_limiter = i_limiter;
+
+  allocate();
+  initWithSetup( i_setup, i_scaleX, i_scaleY );
+}
+
+void tsunami_lab::patches::WavePropagation2dMuscl::allocate() {
+
+  m_nCells = (m_nCellsX+2) * (m_nCellsY+2);
+
+  size_t dataSize = m_nCells * 8 * sizeof(t_real);
+  if( dataSize > 1e8 ) {
+    std::cout << "allocating " << m_nCells << " * 8 * " << sizeof(t_real) << "B = " << (dataSize/1e9) << "GB (second order)" << std::endl;
+  }
+
+  // allocate memory including a single ghost cell on each side
+  t_idx l_cellCount = m_nCells;
+  m_h  = new t_real[l_cellCount];
+  m_hu = new t_real[l_cellCount];
+  m_hv = new t_real[l_cellCount];
+  m_bathymetry = new t_real[l_cellCount];
+  m_h0 = new t_real[l_cellCount];
+  m_q0 = new t_real[l_cellCount];
+  m_dh = new t_real[l_cellCount];
+  m_dq = new t_real[l_cellCount];
+
+  // init to zero
+  #pragma omp parallel for
+  for( t_idx l_ce = 0; l_ce < l_cellCount; l_ce++ ) {
+    m_h [l_ce] = 0;
+    m_hu[l_ce] = 0;
+    m_hv[l_ce] = 0;
+    m_bathymetry[l_ce] = 0;
+  }
+
+}
+
+tsunami_lab::patches::WavePropagation2dMuscl::~WavePropagation2dMuscl() {
+  delete[] m_h;
+  delete[] m_hu;
+  delete[] m_hv;
+  delete[] m_bathymetry;
+  delete[] m_h0;
+  delete[] m_q0;
+  delete[] m_dh;
+  delete[] m_dq;
+}
+
+bool tsunami_lab::patches::WavePropagation2dMuscl::parseLimiter( std::string const & i_name,
+                                                                 Limiter           & o_limiter ) {
+  if( i_name == "minmod" ) {
+    o_limiter = MINMOD;
+    return true;
+  }
+  if( i_name == "mc" ) {
+    o_limiter = MC;
+    return true;
+  }
+  return false;
+}
+
+void tsunami_lab::patches::WavePropagation2dMuscl::initWithSetup( tsunami_lab::setups::Setup* i_setup, t_real i_scaleX, t_real i_scaleY ) {
+  i_setup->setInitScale(i_scaleX, i_scaleY);
+
+  using namespace std::chrono;
+  auto start = high_resolution_clock::now();
+
+  t_real* l_h  = m_h;
+  t_real* l_hu = m_hu;
+  t_real* l_hv = m_hv;
+  t_real* l_b  = m_bathymetry;
+
+  t_idx l_nCellsX = m_nCellsX;
+  t_idx l_nCellsY = m_nCellsY;
+
+  #pragma omp parallel for
+  for( t_idx l_iy = 0; l_iy < l_nCellsY + 2; l_iy++ ) {
+    t_idx l_i = l_iy * (l_nCellsX + 2);
+    i_setup->fillRows( l_iy, l_iy + 1, 0, l_nCellsX + 2, i_scaleX, i_scaleY,
+                       l_h + l_i, l_hu + l_i, l_hv + l_i, l_b + l_i, l_nCellsX + 2 );
+  }
+
+  auto end = high_resolution_clock::now();
+  if(l_nCellsX * l_nCellsY > 1e5) std::cout << "inited second order field of size " << l_nCellsX << " x " << l_nCellsY << " in " << duration<double>(end-start).count() << "s" << std::endl;
+
+}
+
+tsunami_lab::t_real tsunami_lab::patches::WavePropagation2dMuscl::limit( Limiter i_limiter,
+                                                                         t_real  i_left,
+                                                                         t_real  i_right ) {
+  // extrema and constant regions aren't sloped
+  if( i_left * i_right <= 0 ) return 0;
+  t_real l_abs;
+  if( i_limiter == MINMOD ) {
+    l_abs = std::min( std::abs( i_left ), std::abs( i_right ) );
+  } else {
+    l_abs = std::min( std::min( 2 * std::abs( i_left ), 2 * std::abs( i_right ) ), std::abs( i_left + i_right ) * (t_real) 0.5 );
+  }
+  return i_left > 0 ? l_abs : -l_abs;
+}
+
+bool tsunami_lab::patches::WavePropagation2dMuscl::reconstruct( t_real const * i_q,
+                                                                t_idx          i_ce,
+                                                                t_idx          i_stride,
+                                                                bool           i_hasNeighbors,
+                                                                t_real         o_h[2],
+                                                                t_real         o_q[2],
+                                                                t_real         o_b[2] ) const {
+
+  t_real l_h = m_h[i_ce], l_q = i_q[i_ce], l_b = m_bathymetry[i_ce];
+  o_h[0] = o_h[1] = l_h;
+  o_q[0] = o_q[1] = l_q;
+  o_b[0] = o_b[1] = l_b;
+
+  // first order at the boundary and next to dry cells
+  if( !i_hasNeighbors || l_b > 0 ) return false;
+  t_idx  l_ceP = i_ce - i_stride, l_ceN = i_ce + i_stride;
+  t_real l_bP = m_bathymetry[l_ceP], l_bN = m_bathymetry[l_ceN];
+  if( l_bP > 0 || l_bN > 0 ) return false;
+
+  // the surface elevation is reconstructed instead of the height, such that a lake at rest stays at rest
+  t_real l_eta = l_h + l_b;
+  t_real l_slopeEta = limit( m_limiter, l_eta - (m_h[l_ceP] + l_bP), (m_h[l_ceN] + l_bN) - l_eta );
+  t_real l_slopeQ   = limit( m_limiter, l_q - i_q[l_ceP], i_q[l_ceN] - l_q );
+  t_real l_slopeB   = limit( m_limiter, l_b - l_bP, l_bN - l_b );
+  if( l_slopeEta == 0 && l_slopeQ == 0 && l_slopeB == 0 ) return false;
+
+  t_real l_bL = l_b - (t_real) 0.5 * l_slopeB, l_bR = l_b + (t_real) 0.5 * l_slopeB;
+  t_real l_hL = l_eta - (t_real) 0.5 * l_slopeEta - l_bL;
+  t_real l_hR = l_eta + (t_real) 0.5 * l_slopeEta - l_bR;
+
+  // the edges must stay wet
+  if( l_hL <= 0 || l_hR <= 0 || l_bL > 0 || l_bR > 0 ) return false;
+
+  o_h[0] = l_hL;
+  o_h[1] = l_hR;
+  o_q[0] = l_q - (t_real) 0.5 * l_slopeQ;
+  o_q[1] = l_q + (t_real) 0.5 * l_slopeQ;
+  o_b[0] = l_bL;
+  o_b[1] = l_bR;
+  return true;
+}
+
+void tsunami_lab::patches::WavePropagation2dMuscl::computeUpdates( t_real const * i_q,
+                                                                   bool           i_yDirection ) {
+
+  t_idx l_nx = m_nCellsX + 2;
+  t_idx l_ny = m_nCellsY + 2;
+  t_idx l_nCells = m_nCells;
+  t_real * l_dh = m_dh;
+  t_real * l_dq = m_dq;
+
+  int l_copyThreads   = m_executionPolicy.getCopyThreads( l_nCells );
+  int l_solverThreads = m_executionPolicy.getSolverThreads( l_nCells );
+
+  #pragma omp parallel for simd num_threads(l_copyThreads) if(l_copyThreads > 1)
+  for( t_idx l_ce = 0; l_ce < l_nCells; l_ce++ ) {
+    l_dh[l_ce] = 0;
+    l_dq[l_ce] = 0;
+  }
+
+  // edgeUpdate() with a scaling of 1 subtracts the net-updates from the accumulators;
+  // the fluctuation inside a sloped cell is the sum of both net-updates of the Riemann problem between its edges
+  if( !i_yDirection ) {
+    // every row is walked from left to right, and the reconstruction of the right cell is reused for the next edge
+    #pragma omp parallel for num_threads(l_solverThreads) if(l_solverThreads > 1)
+    for( t_idx l_iy = 0; l_iy < l_ny; l_iy++ ) {
+      t_real l_hA[2], l_qA[2], l_bA[2], l_hC[2], l_qC[2], l_bC[2];
+      t_idx  l_ceA = l_iy * l_nx;
+      reconstruct( i_q, l_ceA, 1, false, l_hA, l_qA, l_bA );
+      for( t_idx l_ix = 0; l_ix + 1 < l_nx; l_ix++, l_ceA++ ) {
+        t_idx l_ceC = l_ceA + 1;
+        bool  l_sloped = reconstruct( i_q, l_ceC, 1, l_ix + 2 < l_nx, l_hC, l_qC, l_bC );
+        edgeUpdate( 1, l_hA[1], l_hC[0], l_qA[1], l_qC[0], l_bA[1], l_bC[0], l_dh[l_ceA], l_dh[l_ceC], l_dq[l_ceA], l_dq[l_ceC] );
+        if( l_sloped ) {
+          edgeUpdate( 1, l_hC[0], l_hC[1], l_qC[0], l_qC[1], l_bC[0], l_bC[1], l_dh[l_ceC], l_dh[l_ceC], l_dq[l_ceC], l_dq[l_ceC] );
+        }
+        for( unsigned short l_si = 0; l_si < 2; l_si++ ) {
+          l_hA[l_si] = l_hC[l_si];
+          l_qA[l_si] = l_qC[l_si];
+          l_bA[l_si] = l_bC[l_si];
+        }
+      }
+    }
+  } else {
+    // an edge between two rows updates both of them, so the even and odd edges are processed one after another;
+    // the inner loop runs along the rows, such that the memory is accessed contiguously
+    for( t_idx l_parity = 0; l_parity < 2; l_parity++ ) {
+      #pragma omp parallel for num_threads(l_solverThreads) if(l_solverThreads > 1)
+      for( t_idx l_iy = l_parity; l_iy < l_ny - 1; l_iy += 2 ) {
+        t_real l_hA[2], l_qA[2], l_bA[2], l_hC[2], l_qC[2], l_bC[2];
+        for( t_idx l_ix = 0; l_ix < l_nx; l_ix++ ) {
+          t_idx l_ceA = l_ix + l_iy * l_nx;
+          t_idx l_ceC = l_ceA + l_nx;
+          reconstruct( i_q, l_ceA, l_nx, l_iy > 0, l_hA, l_qA, l_bA );
+          bool l_sloped = reconstruct( i_q, l_ceC, l_nx, l_iy + 2 < l_ny, l_hC, l_qC, l_bC );
+          edgeUpdate( 1, l_hA[1], l_hC[0], l_qA[1], l_qC[0], l_bA[1], l_bC[0], l_dh[l_ceA], l_dh[l_ceC], l_dq[l_ceA], l_dq[l_ceC] );
+          if( l_sloped ) {
+            edgeUpdate( 1, l_hC[0], l_hC[1], l_qC[0], l_qC[1], l_bC[0], l_bC[1], l_dh[l_ceC], l_dh[l_ceC], l_dq[l_ceC], l_dq[l_ceC] );
+          }
+        }
+      }
+    }
+  }
+
+}
+
+void tsunami_lab::patches::WavePropagation2dMuscl::halfStep( t_real   i_scaling,
+                                                             t_real * io_q,
+                                                             bool     i_yDirection ) {
+
+  t_idx    l_nCells = m_nCells;
+  t_real * l_h  = m_h;
+  t_real * l_h0 = m_h0;
+  t_real * l_q0 = m_q0;
+  t_real * l_dh = m_dh;
+  t_real * l_dq = m_dq;
+  int l_threads = m_executionPolicy.getCopyThreads( l_nCells );
+
+  // first stage: forward Euler step
+  computeUpdates( io_q, i_yDirection );
+  #pragma omp parallel for simd num_threads(l_threads) if(l_threads > 1)
+  for( t_idx l_ce = 0; l_ce < l_nCells; l_ce++ ) {
+    l_h0[l_ce] = l_h[l_ce];
+    l_q0[l_ce] = io_q[l_ce];
+    l_h [l_ce] += i_scaling * l_dh[l_ce];
+    io_q[l_ce] += i_scaling * l_dq[l_ce];
+  }
+
+  // second stage: average of the start and a second Euler step
+  computeUpdates( io_q, i_yDirection );
+  #pragma omp parallel for simd num_threads(l_threads) if(l_threads > 1)
+  for( t_idx l_ce = 0; l_ce < l_nCells; l_ce++ ) {
+    l_h [l_ce] = (t_real) 0.5 * (l_h0[l_ce] + l_h [l_ce] + i_scaling * l_dh[l_ce]);
+    io_q[l_ce] = (t_real) 0.5 * (l_q0[l_ce] + io_q[l_ce] + i_scaling * l_dq[l_ce]);
+  }
+
+}
+
+void tsunami_lab::patches::WavePropagation2dMuscl::timeStep( t_real i_scaling ) {
+
+  using namespace std::chrono;
+  auto start = high_resolution_clock::now();
+
+  ///////////////////////////////////////
+  // half steps in x and y direction;  //
+  // the order alternates between steps //
+  ///////////////////////////////////////
+
+  bool l_yFirst = m_yFirst;
+  m_yFirst = !m_yFirst;
+
+  halfStep( i_scaling, l_yFirst ? m_hv : m_hu, l_yFirst );
+
+  auto middle = high_resolution_clock::now();
+
+  halfStep( i_scaling, l_yFirst ? m_hu : m_hv, !l_yFirst );
+
+  auto end = high_resolution_clock::now();
+  if(m_nCellsX * m_nCellsY > 1e5) {
+    double l_ratio = duration<double>(end-middle).count()/duration<double>(middle-start).count();
+    std::cout << "      computed timeStep in " << duration<double>(end-start).count() << "s, " << (l_yFirst ? 1 / l_ratio : l_ratio) << "x slower for y" << std::endl;
+  }
+
+}
+
+tsunami_lab::t_real tsunami_lab::patches::WavePropagation2dMuscl::computeMaxTimestep( t_real i_cellSizeMeters ){
+
+  t_real* l_h  = m_h;
+  t_real* l_hu = m_hu;
+  t_real* l_hv = m_hv;
+
+  t_real l_maxVelocity = 0;
+  t_real l_gravity = tsunami_lab::solvers::FWave::m_gravity;
+
+  t_idx  l_stride = getStride();
+
+  t_idx  l_nCellsX = m_nCellsX;
+  t_idx  l_nCellsY = m_nCellsY;
+
+  int l_threads = m_executionPolicy.getCopyThreads( m_nCells );
+  #pragma omp parallel for reduction(max: l_maxVelocity) num_threads(l_threads) if(l_threads > 1)
+  for( t_idx l_iy = 1; l_iy <= l_nCellsY; l_iy++){
+    t_idx l_iStart = l_iy * l_stride + 1;// +1, because we start iterating at l_ix = 1
+    t_idx l_iEnd = l_iStart + l_nCellsX + 1;
+    #pragma omp simd reduction(max: l_maxVelocity)
+    for(t_idx l_i = l_iStart; l_i < l_iEnd; l_i++){
+      t_real l_height = l_h[l_i];
+      t_real l_impulse = std::max(std::abs(l_hu[l_i]), std::abs(l_hv[l_i]));
+      t_real l_velocity = l_impulse / l_height;
+      t_real l_expectedVelocity = l_velocity + std::sqrt(l_gravity * l_height);
+      if(l_expectedVelocity > l_maxVelocity) l_maxVelocity = l_expectedVelocity;
+    }
+  }
+
+  return m_cflFactor * i_cellSizeMeters / l_maxVelocity;
+
+}
+
+void tsunami_lab::patches::WavePropagation2dMuscl::setGhostOutflow() {
+
+  t_real* l_b  = m_bathymetry;
+  t_real* l_h  = m_h;
+  t_real* l_hu = m_hu;
+  t_real* l_hv = m_hv;
+
+  t_idx l_stride = getStride();
+  int   l_threadsX = m_executionPolicy.getCopyThreads( m_nCellsX + 2 );
+  int   l_threadsY = m_executionPolicy.getCopyThreads( m_nCellsY + 2 );
+
+  // set left and right boundary
+  #pragma omp parallel for num_threads(l_threadsY) if(l_threadsY > 1)
+  for(t_idx l_y = 0; l_y < m_nCellsY+2; l_y++){
+    t_idx l_i0 = l_y * l_stride;
+    t_idx l_i1 = l_i0 + 1;
+    l_b [l_i0] = l_b [l_i1];
+    l_h [l_i0] = l_h [l_i1];
+    l_hu[l_i0] = l_hu[l_i1];
+    l_hv[l_i0] = l_hv[l_i1];
+    l_i0 = m_nCellsX + 1 + l_y * l_stride;
+    l_i1 = l_i0 - 1;
+    l_b [l_i0] = l_b [l_i1];
+    l_h [l_i0] = l_h [l_i1];
+    l_hu[l_i0] = l_hu[l_i1];
+    l_hv[l_i0] = l_hv[l_i1];
+  }
+
+  // set top and bottom boundary
+  #pragma omp parallel for num_threads(l_threadsX) if(l_threadsX > 1)
+  for(t_idx l_x = 0; l_x < m_nCellsX+2; l_x++){
+    t_idx l_i0 = l_x;
+    t_idx l_i1 = l_i0 + l_stride;
+    l_b [l_i0] = l_b [l_i1];
+    l_h [l_i0] = l_h [l_i1];
+    l_hu[l_i0] = l_hu[l_i1];
+    l_hv[l_i0] = l_hv[l_i1];
+    l_i0 = l_x + (m_nCellsY + 1) * l_stride;
+    l_i1 = l_i0 - l_stride;
+    l_b [l_i0] = l_b [l_i1];
+    l_h [l_i0] = l_h [l_i1];
+    l_hu[l_i0] = l_hu[l_i1];
+    l_hv[l_i0] = l_hv[l_i1];
+  }
+
+}
@@ -0,0 +1,326 @@
+/**
+ * @author Antonio Noack
+ *
+ * @section DESCRIPTION
+ * Two-dimensional wave propagation patch with second order accuracy in space and time.
+ * Each dimensionally split half step reconstructs the surface elevation, the momentum and the bathymetry
+ * with limited slopes (MUSCL), solves the Riemann problems at the edges between the reconstructed values,
+ * and integrates with the two stage strong stability preserving Runge-Kutta method (Heun).
+ * Cells next to dry cells, at the boundary and with a reconstructed height <= 0 fall back to first order.
+ **/
+#ifndef TSUNAMI_LAB_PATCHES_WAVE_PROPAGATION_2D_MUSCL
+#define TSUNAMI_LAB_PATCHES_WAVE_PROPAGATION_2D_MUSCL
+
+#include "WavePropagation.h"
+#include "../setups/Setup.h"
+
+#include <string>
+
+namespace tsunami_lab {
+  namespace patches {
+    class WavePropagation2dMuscl;
+  }
+}
+
+class tsunami_lab::patches::WavePropagation2dMuscl: public WavePropagation {
+  public:
+    //! slope limiters
+    enum Limiter {
+      //! minimum modulus; most diffusive, never overshoots
+      MINMOD = 0,
+      //! monotonized central; sharper, still total variation diminishing
+      MC = 1
+    };
+
+  private:
+
+    //! number of cells discretizing the computational domain, including ghost cells
+    t_idx m_nCells = 0;
+
+    //! number of cells on the x and y axis
+    t_idx m_nCellsX = 0, m_nCellsY = 0;
+
+    //! water heights
+    t_real * m_h = nullptr;
+
+    //! momenta in x direction
+    t_real * m_hu = nullptr;
+
+    //! momenta in y direction
+    t_real * m_hv = nullptr;
+
+    //! bathymetry in meters
+    t_real * m_bathymetry = nullptr;
+
+    //! heights and momenta at the start of the half step, for the second stage
+    t_real * m_h0 = nullptr, * m_q0 = nullptr;
+
+    //! accumulated updates of the height and momentum of the current stage
+    t_real * m_dh = nullptr, * m_dq = nullptr;
+
+    //! slope limiter
+    Limiter m_limiter = MINMOD;
+
+    //! true if the next time step starts with the sweep in y direction
+    bool m_yFirst = false;
+
+    //! cfl factor for the 2d case; should be less than 0.5, such that a velocity increase does not violate the cfl condition
+    t_real m_cflFactor = 0.45;
+
+    /**
+     * Allocates the arrays; the values are zero.
+     **/
+    void allocate();
+
+    /**
+     * Limits the slope of a cell.
+     *
+     * @param i_limiter slope limiter.
+     * @param i_left difference to the previous cell.
+     * @param i_right difference to the next cell.
+     * @return limited slope.
+     **/
+    static t_real limit( Limiter i_limiter,
+                         t_real  i_left,
+                         t_real  i_right );
+
+    /**
+     * Reconstructs the values of a cell at its lower and upper edge along the sweep direction.
+     * Without a wet previous and next cell, or if the height would become <= 0, the slope is zero.
+     *
+     * @param i_q momenta along the sweep direction.
+     * @param i_ce id of the cell.
+     * @param i_stride distance to the next cell along the sweep direction.
+     * @param i_hasNeighbors true, if the cell has a previous and a next cell.
+     * @param o_h heights at the lower and upper edge.
+     * @param o_q momenta at the lower and upper edge.
+     * @param o_b bathymetry at the lower and upper edge.
+     * @return true, if the slopes aren't zero.
+     **/
+    bool reconstruct( t_real const * i_q,
+                      t_idx          i_ce,
+                      t_idx          i_stride,
+                      bool           i_hasNeighbors,
+                      t_real         o_h[2],
+                      t_real         o_q[2],
+                      t_real         o_b[2] ) const;
+
+    /**
+     * Computes the updates of a stage: the sum of the negative fluctuations of the edges and inside the cells; not scaled by dt/dx.
+     *
+     * @param i_q momenta along the sweep direction.
+     * @param i_yDirection true for the sweep in y direction.
+     **/
+    void computeUpdates( t_real const * i_q,
+                         bool           i_yDirection );
+
+    /**
+     * Performs a half step with two stages in one direction.
+     *
+     * @param i_scaling scaling of the time step (dt / dx).
+     * @param io_q momenta along the sweep direction.
+     * @param i_yDirection true for the sweep in y direction.
+     **/
+    void halfStep( t_real   i_scaling,
+                   t_real * io_q,
+                   bool     i_yDirection );
+
+  public:
+    /**
+     * Constructs the second order 2d wave propagation solver.
+     *
+     * @param i_nCellsX number of cells on the x axis.
+     * @param i_nCellsY number of cells on the y axis.
+     * @param i_limiter slope limiter.
+     **/
+    WavePropagation2dMuscl( t_idx i_nCellsX, t_idx i_nCellsY, Limiter i_limiter );
+
+    /**
+     * Constructs the second order 2d wave propagation solver and applies the setup.
+     *
+     * @param i_nCellsX number of cells on the x axis.
+     * @param i_nCellsY number of cells on the y axis.
+     * @param i_setup setup for cell initialization.
+     * @param i_scaleX scale for the scene in x direction; e.g. you can multiply the number of cells by x, and set the scale to 1/x, and your setup will still work.
+     * @param i_scaleY scale for the scene in y direction.
+     * @param i_limiter slope limiter.
+     **/
+    WavePropagation2dMuscl( t_idx i_nCellsX, t_idx i_nCellsY, tsunami_lab::setups::Setup* i_setup, t_real i_scaleX, t_real i_scaleY, Limiter i_limiter );
+
+    /**
+     * Destructor which frees all allocated memory.
+     **/
+    ~WavePropagation2dMuscl();
+
+    /**
+     * Parses the name of a limiter.
+     *
+     * @param i_name minmod or mc.
+     * @param o_limiter parsed limiter.
+     * @return true, if the name is known.
+     **/
+    static bool parseLimiter( std::string const & i_name,
+                              Limiter           & o_limiter );
+
+    /**
+     * Initializes the internal state with a setup.
+     *
+     * @param i_setup setup for cell initialization.
+     * @param i_scaleX scale for the scene in x direction; e.g. you can multiply the number of cells by x, and set the scale to 1/x, and your setup will still work.
+     * @param i_scaleY scale for the scene in y direction
+     **/
+    void initWithSetup( tsunami_lab::setups::Setup* i_setup, t_real i_scaleX, t_real i_scaleY );
+
+    /**
+     * Computes the maximum time step that is allowed without breaking the CFL condition.
+     **/
+    t_real computeMaxTimestep( t_real i_cellSizeMeters );
+
+    /**
+     * Performs a time step.
+     * The order of the sweeps in x and y direction alternates from step to step, such that the splitting error of two consecutive steps cancels to second order.
+     *
+     * @param i_scaling scaling of the time step (dt / dx).
+     **/
+    void timeStep( t_real i_scaling );
+
+    /**
+     * Sets the values of the ghost cells according to outflow boundary conditions.
+     **/
+    void setGhostOutflow();
+
+    /**
+     * Gets the stride in y-direction. x-direction is stride-1.
+     *
+     * @return stride in y-direction.
+     **/
+    t_idx getStride(){
+      return m_nCellsX+2;
+    }
+
+    /**
+     * Gets cells' water heights.
+     *
+     * @return water heights.
+     */
+    t_real const * getHeight(){
+      return m_h+1+(m_nCellsX+2);
+    }
+
+    /**
+     * Gets the cells' momenta in x-direction.
+     *
+     * @return momenta in x-direction.
+     **/
+    t_real const * getMomentumX(){
+      return m_hu+1+(m_nCellsX+2);
+    }
+
+    /**
+     * Gets the cells' momenta in y-direction.
+     *
+     * @return momenta in y-direction.
+     **/
+    t_real const * getMomentumY(){
+      return m_hv+1+(m_nCellsX+2);
+    }
+
+    /**
+     * Gets the cells' bathymetry.
+     *
+     * @return bathymetry.
+     **/
+    t_real const * getBathymetry(){
+      return m_bathymetry+1+(m_nCellsX+2);
+    }
+
+    /**
+     * Copies a row of a quantity including the ghost cells.
+     *
+     * @param i_quantity 0 = height, 1 = momentum x, 2 = momentum y, 3 = bathymetry.
+     * @param i_iy id of the row including the ghost cells.
+     * @param o_row buffer for getStride() values.
+     **/
+    void getRow( unsigned short i_quantity,
+                 t_idx          i_iy,
+                 t_real       * o_row ){
+      t_real const * l_data = i_quantity == 0 ? m_h : i_quantity == 1 ? m_hu : i_quantity == 2 ? m_hv : m_bathymetry;
+      l_data += i_iy * (m_nCellsX+2);
+      for( t_idx l_ix = 0; l_ix < m_nCellsX+2; l_ix++ ) {
+        o_row[l_ix] = l_data[l_ix];
+      }
+    }
+
+    /**
+     * Gets the arrays including the ghost cells.
+     *
+     * @param o_arrays height, momentum x, momentum y, bathymetry.
+     * @return number of values per array.
+     **/
+    t_idx getRawStorage( t_real * o_arrays[4] ){
+      o_arrays[0] = m_h;
+      o_arrays[1] = m_hu;
+      o_arrays[2] = m_hv;
+      o_arrays[3] = m_bathymetry;
+      return m_nCells;
+    }
+
+    /**
+     * Sets the bathymetry of the cell to the given value.
+     *
+     * @param i_ix id of the cell in x-direction.
+     * @param i_iy id of the cell in y-direction.
+     * @param i_b bathymetry.
+     **/
+    void setBathymetry( t_idx  i_ix,
+                        t_idx  i_iy,
+                        t_real i_b ) {
+      m_bathymetry[(i_ix+1) + (i_iy+1) * (m_nCellsX+2)] = i_b;
+    }
+
+    /**
+     * Sets the height of the cell to the given value.
+     *
+     * @param i_ix id of the cell in x-direction.
+     * @param i_iy id of the cell in y-direction.
+     * @param i_h water height.
+     **/
+    void setHeight( t_idx  i_ix,
+                    t_idx  i_iy,
+                    t_real i_h ) {
+      m_h[(i_ix+1) + (i_iy+1) * (m_nCellsX+2)] = i_h;
+    }
+
+    /**
+     * Sets the momentum in x-direction to the given value.
+     *
+     * @param i_ix id of the cell in x-direction.
+     * @param i_iy id of the cell in y-direction.
+     * @param i_hu momentum in x-direction.
+     **/
+    void setMomentumX( t_idx  i_ix,
+                       t_idx  i_iy,
+                       t_real i_hu ) {
+      m_hu[(i_ix+1) + (i_iy+1) * (m_nCellsX+2)] = i_hu;
+    }
+
+    /**
+     * Sets the momentum in y-direction to the given value.
+     *
+     * @param i_ix id of the cell in x-direction.
+     * @param i_iy id of the cell in y-direction.
+     * @param i_hv momentum in y-direction.
+     **/
+    void setMomentumY( t_idx  i_ix,
+                       t_idx  i_iy,
+                       t_real i_hv ) {
+      m_hv[(i_ix+1) + (i_iy+1) * (m_nCellsX+2)] = i_hv;
+    }
+
+    /** Sets the cfl factor */
+    void setCflFactor(t_real i_value){
+      m_cflFactor = i_value;
+    }
+};
+
+#endif
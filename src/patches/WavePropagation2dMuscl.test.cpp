@@ -0,0 +1,240 @@
+/**
+ * @author Antonio Noack
+ *
+ * @section DESCRIPTION
+ * Unit tests for the second order two-dimensional wave propagation patch.
+ **/
+#include <catch2/catch.hpp>
+#include <cmath> // std::exp, std::abs
+#include <vector>
+
+#define private public
+
+#include "WavePropagation2d.h"
+#include "WavePropagation2dMuscl.h"
+#include "../constants.h"
+#include "../setups/DamBreak2d.h"
+
+#undef private
+
+#define t_real tsunami_lab::t_real
+#define t_idx tsunami_lab::t_idx
+
+/**
+ * Simulates a smooth wave on a flat sea floor in x direction, and computes the L1 error of the height.
+ *
+ * @param io_waveProp patch with i_nx x 1 cells.
+ * @param i_nx number of cells.
+ * @param io_reference height of the reference solution with a multiple of i_nx cells; empty to store the result instead.
+ * @return L1 error of the height per meter.
+ **/
+template <typename T>
+static double simulateWave( T                   & io_waveProp,
+                            t_idx                 i_nx,
+                            std::vector<t_real> & io_reference ) {
+  t_real l_length = 100, l_endTime = 2;
+  t_real l_dx = l_length / i_nx;
+  for( t_idx l_ix = 0; l_ix < i_nx; l_ix++ ) {
+    t_real l_x = (l_ix + (t_real) 0.5) * l_dx - l_length / 2;
+    io_waveProp.setBathymetry( l_ix, 0, -10 );
+    io_waveProp.setHeight( l_ix, 0, 10 + std::exp( -l_x * l_x / 64 ) );
+    io_waveProp.setMomentumX( l_ix, 0, 0 );
+    io_waveProp.setMomentumY( l_ix, 0, 0 );
+  }
+
+  t_real l_time = 0;
+  while( l_time < l_endTime ) {
+    io_waveProp.setGhostOutflow();
+    t_real l_dt = std::min( io_waveProp.computeMaxTimestep( l_dx ), l_endTime - l_time );
+    io_waveProp.timeStep( l_dt / l_dx );
+    l_time += l_dt;
+  }
+
+  t_real const * l_h = io_waveProp.getHeight();
+  if( io_reference.empty() ) {
+    io_reference.assign( l_h, l_h + i_nx );
+    return 0;
+  }
+
+  // average the reference to the coarse cells
+  t_idx  l_factor = io_reference.size() / i_nx;
+  double l_error = 0;
+  for( t_idx l_ix = 0; l_ix < i_nx; l_ix++ ) {
+    double l_sum = 0;
+    for( t_idx l_fi = 0; l_fi < l_factor; l_fi++ ) l_sum += io_reference[l_ix * l_factor + l_fi];
+    l_error += std::abs( l_h[l_ix] - l_sum / l_factor ) * l_dx;
+  }
+  return l_error / l_length;
+}
+
+/**
+ * Simulates a smooth, radially symmetric wave on a flat sea floor, and computes the L1 error of the height.
+ * The wave isn't aligned with the axes and is carried by a diagonal current, so it is only accurate, if the dimensional splitting is.
+ *
+ * @param io_waveProp patch with i_n x i_n cells.
+ * @param i_n number of cells per side.
+ * @param io_reference height of the reference solution with a multiple of i_n cells per side; empty to store the result instead.
+ * @return L1 error of the height per square meter.
+ **/
+template <typename T>
+static double simulateWave2d( T                   & io_waveProp,
+                              t_idx                 i_n,
+                              std::vector<t_real> & io_reference ) {
+  t_real l_length = 100, l_endTime = 2;
+  t_real l_dx = l_length / i_n;
+  for( t_idx l_iy = 0; l_iy < i_n; l_iy++ ) {
+    for( t_idx l_ix = 0; l_ix < i_n; l_ix++ ) {
+      t_real l_x = (l_ix + (t_real) 0.5) * l_dx - l_length * (t_real) 0.45;
+      t_real l_y = (l_iy + (t_real) 0.5) * l_dx - l_length * (t_real) 0.55;
+      io_waveProp.setBathymetry( l_ix, l_iy, -10 );
+      io_waveProp.setHeight( l_ix, l_iy, 10 + 2 * std::exp( -(l_x * l_x + l_y * l_y) / 64 ) );
+      io_waveProp.setMomentumX( l_ix, l_iy, 30 );
+      io_waveProp.setMomentumY( l_ix, l_iy, 30 );
+    }
+  }
+
+  t_real l_time = 0;
+  while( l_time < l_endTime ) {
+    io_waveProp.setGhostOutflow();
+    t_real l_dt = std::min( io_waveProp.computeMaxTimestep( l_dx ), l_endTime - l_time );
+    io_waveProp.timeStep( l_dt / l_dx );
+    l_time += l_dt;
+  }
+
+  t_real const * l_h = io_waveProp.getHeight();
+  t_idx l_stride = io_waveProp.getStride();
+  if( io_reference.empty() ) {
+    for( t_idx l_iy = 0; l_iy < i_n; l_iy++ ) io_reference.insert( io_reference.end(), l_h + l_iy * l_stride, l_h + l_iy * l_stride + i_n );
+    return 0;
+  }
+
+  // average the reference to the coarse cells
+  t_idx  l_nFine = (t_idx) std::sqrt( (double) io_reference.size() );
+  t_idx  l_factor = l_nFine / i_n;
+  double l_error = 0;
+  for( t_idx l_iy = 0; l_iy < i_n; l_iy++ ) {
+    for( t_idx l_ix = 0; l_ix < i_n; l_ix++ ) {
+      double l_sum = 0;
+      for( t_idx l_fy = 0; l_fy < l_factor; l_fy++ ) {
+        for( t_idx l_fx = 0; l_fx < l_factor; l_fx++ ) l_sum += io_reference[(l_iy * l_factor + l_fy) * l_nFine + l_ix * l_factor + l_fx];
+      }
+      l_error += std::abs( l_h[l_ix + l_iy * l_stride] - l_sum / (l_factor * l_factor) ) * l_dx * l_dx;
+    }
+  }
+  return l_error / (l_length * l_length);
+}
+
+TEST_CASE( "Test the slope limiters.", "[WaveProp2dMuscl]" ) {
+
+  using tsunami_lab::patches::WavePropagation2dMuscl;
+
+  // extrema aren't sloped
+  REQUIRE( WavePropagation2dMuscl::limit( WavePropagation2dMuscl::MINMOD, 1, -1 ) == 0 );
+  REQUIRE( WavePropagation2dMuscl::limit( WavePropagation2dMuscl::MC,    -2,  0 ) == 0 );
+
+  // minmod: the smaller slope
+  REQUIRE( WavePropagation2dMuscl::limit( WavePropagation2dMuscl::MINMOD,  1,  3 ) ==  1 );
+  REQUIRE( WavePropagation2dMuscl::limit( WavePropagation2dMuscl::MINMOD, -4, -2 ) == -2 );
+
+  // mc: the central slope, at most twice the one-sided slopes
+  REQUIRE( WavePropagation2dMuscl::limit( WavePropagation2dMuscl::MC,  1,  3 ) ==  2 );
+  REQUIRE( WavePropagation2dMuscl::limit( WavePropagation2dMuscl::MC,  1,  9 ) ==  2 );
+  REQUIRE( WavePropagation2dMuscl::limit( WavePropagation2dMuscl::MC, -4, -2 ) == -3 );
+
+  WavePropagation2dMuscl::Limiter l_limiter = WavePropagation2dMuscl::MINMOD;
+  REQUIRE( WavePropagation2dMuscl::parseLimiter( "mc", l_limiter ) );
+  REQUIRE( l_limiter == WavePropagation2dMuscl::MC );
+  REQUIRE_FALSE( WavePropagation2dMuscl::parseLimiter( "superbee", l_limiter ) );
+}
+
+TEST_CASE( "Test the second order 2d wave propagation solver with a lake at rest.", "[WaveProp2dMuscl]" ) {
+
+  // a lake with varying depth and an island
+  tsunami_lab::patches::WavePropagation2dMuscl l_waveProp( 30, 40, tsunami_lab::patches::WavePropagation2dMuscl::MC );
+  for( t_idx l_iy = 0; l_iy < 40; l_iy++ ) {
+    for( t_idx l_ix = 0; l_ix < 30; l_ix++ ) {
+      t_real l_b = l_ix > 10 && l_ix < 15 && l_iy > 20 && l_iy < 25 ? 5 : -(t_real) (1 + l_ix + (l_iy * l_iy) % 7);
+      l_waveProp.setBathymetry( l_ix, l_iy, l_b );
+      l_waveProp.setHeight( l_ix, l_iy, l_b > 0 ? 0 : -l_b );
+      l_waveProp.setMomentumX( l_ix, l_iy, 0 );
+      l_waveProp.setMomentumY( l_ix, l_iy, 0 );
+    }
+  }
+
+  for( t_idx l_st = 0; l_st < 20; l_st++ ) {
+    l_waveProp.setGhostOutflow();
+    l_waveProp.timeStep( l_waveProp.computeMaxTimestep( 1 ) );
+  }
+
+  for( t_idx l_iy = 0; l_iy < 40; l_iy++ ) {
+    for( t_idx l_ix = 0; l_ix < 30; l_ix++ ) {
+      t_idx l_i = l_ix + l_iy * l_waveProp.getStride();
+      t_real l_b = l_waveProp.getBathymetry()[l_i];
+      REQUIRE( l_waveProp.getHeight()[l_i] + std::min( l_b, (t_real) 0 ) == Approx( 0 ).margin( 1e-4 ) );
+      REQUIRE( l_waveProp.getMomentumX()[l_i] == Approx( 0 ).margin( 1e-4 ) );
+      REQUIRE( l_waveProp.getMomentumY()[l_i] == Approx( 0 ).margin( 1e-4 ) );
+    }
+  }
+}
+
+TEST_CASE( "Test the convergence of the second order 2d wave propagation solver.", "[WaveProp2dMuscl]" ) {
+
+  using tsunami_lab::patches::WavePropagation2dMuscl;
+
+  std::vector<t_real> l_reference;
+  WavePropagation2dMuscl l_fine( 1600, 1, WavePropagation2dMuscl::MC );
+  simulateWave( l_fine, 1600, l_reference );
+
+  tsunami_lab::patches::WavePropagation2d l_first50( 50, 1 ), l_first100( 100, 1 );
+  WavePropagation2dMuscl l_minmod50( 50, 1, WavePropagation2dMuscl::MINMOD ), l_minmod100( 100, 1, WavePropagation2dMuscl::MINMOD );
+  WavePropagation2dMuscl l_mc50( 50, 1, WavePropagation2dMuscl::MC ), l_mc100( 100, 1, WavePropagation2dMuscl::MC );
+
+  double l_errorFirst50   = simulateWave( l_first50,   50,  l_reference );
+  double l_errorFirst100  = simulateWave( l_first100,  100, l_reference );
+  double l_errorMinmod50  = simulateWave( l_minmod50,  50,  l_reference );
+  double l_errorMinmod100 = simulateWave( l_minmod100, 100, l_reference );
+  double l_errorMc50      = simulateWave( l_mc50,      50,  l_reference );
+  double l_errorMc100     = simulateWave( l_mc100,     100, l_reference );
+
+  // the first order scheme converges with about first order
+  REQUIRE( l_errorFirst50 / l_errorFirst100 > 1.5 );
+  REQUIRE( l_errorFirst50 / l_errorFirst100 < 2.5 );
+
+  // the second order scheme is more accurate on the coarser grid than the first order scheme on the finer one, and converges faster
+  REQUIRE( l_errorMinmod50 < l_errorFirst100 );
+  REQUIRE( l_errorMc50 < l_errorFirst100 );
+  REQUIRE( l_errorMinmod50 / l_errorMinmod100 > 2.5 );
+  REQUIRE( l_errorMc50 / l_errorMc100 > 2.5 );
+}
+
+TEST_CASE( "Test the convergence of the second order 2d wave propagation solver in 2d.", "[WaveProp2dMuscl]" ) {
+
+  using tsunami_lab::patches::WavePropagation2dMuscl;
+
+  // in space: reference on a finer grid
+  std::vector<t_real> l_reference;
+  WavePropagation2dMuscl l_fine( 320, 320, WavePropagation2dMuscl::MC );
+  simulateWave2d( l_fine, 320, l_reference );
+
+  WavePropagation2dMuscl l_mc40( 40, 40, WavePropagation2dMuscl::MC ), l_mc80( 80, 80, WavePropagation2dMuscl::MC );
+  double l_errorMc40 = simulateWave2d( l_mc40, 40, l_reference );
+  double l_errorMc80 = simulateWave2d( l_mc80, 80, l_reference );
+
+  REQUIRE( l_errorMc40 / l_errorMc80 > 3 );
+
+  // in time: same grid, reference with much smaller time steps;
+  // the spatial error cancels, and only the error of the time stepping and the dimensional splitting remains
+  std::vector<t_real> l_referenceTime;
+  WavePropagation2dMuscl l_fineTime( 80, 80, WavePropagation2dMuscl::MC );
+  l_fineTime.setCflFactor( 0.45 / 16 );
+  simulateWave2d( l_fineTime, 80, l_referenceTime );
+
+  WavePropagation2dMuscl l_cfl1( 80, 80, WavePropagation2dMuscl::MC ), l_cfl2( 80, 80, WavePropagation2dMuscl::MC );
+  l_cfl1.setCflFactor( 0.4 );
+  l_cfl2.setCflFactor( 0.2 );
+  double l_errorCfl1 = simulateWave2d( l_cfl1, 80, l_referenceTime );
+  double l_errorCfl2 = simulateWave2d( l_cfl2, 80, l_referenceTime );
+
+  // alternating the sweep order gives ~3.9, a fixed order (x, then y) ~3.4
+  REQUIRE( l_errorCfl1 / l_errorCfl2 > 3.7 );
+}
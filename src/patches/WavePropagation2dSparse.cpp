@@ -0,0 +1,527 @@
+/**
+ * @author Antonio Noack
+ *
+ * @section DESCRIPTION
+ * Two-dimensional wave propagation patch, which only allocates tiles containing water.
+ **/
+#include <algorithm> // std::max, std::min
+#include <cmath> // std::sqrt
+#include <iostream>
+#include <chrono> // measure time
+#include "WavePropagation2dSparse.h"
+#include "WavePropagation2d.h" // CELLS_MAX
+#include "../setups/Setup.h"
+#include "../solvers/FWave.h"
+
+tsunami_lab::t_idx constexpr tsunami_lab::patches::WavePropagation2dSparse::m_landTile;
+
+tsunami_lab::patches::WavePropagation2dSparse::WavePropagation2dSparse( t_idx i_nCellsX, t_idx i_nCellsY, t_idx i_tileSize ) {
+
+  m_nCellsX = i_nCellsX;
+  m_nCellsY = i_nCellsY;
+  m_tileSize = std::max( i_tileSize, (t_idx) 2 );
+
+  initTiles();
+
+  // all tiles contain water
+  for( t_idx l_ti = 0; l_ti < m_tiles.size(); l_ti++ ) {
+    allocateTile( l_ti, 0 );
+  }
+
+}
+
+tsunami_lab::patches::WavePropagation2dSparse::WavePropagation2dSparse( t_idx i_nCellsX, t_idx i_nCellsY, tsunami_lab::setups::Setup* i_setup, t_real i_scaleX, t_real i_scaleY, t_idx i_tileSize ) {
+
+  m_nCellsX = i_nCellsX;
+  m_nCellsY = i_nCellsY;
+  m_tileSize = std::max( i_tileSize, (t_idx) 2 );
+
+  initWithSetup( i_setup, i_scaleX, i_scaleY );
+}
+
+tsunami_lab::patches::WavePropagation2dSparse::~WavePropagation2dSparse() {
+  for( unsigned short l_qu = 0; l_qu < 4; l_qu++ ) {
+    delete[] m_export[l_qu];
+  }
+}
+
+void tsunami_lab::patches::WavePropagation2dSparse::initTiles() {
+  m_nTilesX = (m_nCellsX + 2 + m_tileSize - 1) / m_tileSize;
+  m_nTilesY = (m_nCellsY + 2 + m_tileSize - 1) / m_tileSize;
+  m_tiles.assign( m_nTilesX * m_nTilesY, m_landTile );
+  m_landBathymetry.assign( m_nTilesX * m_nTilesY, 0 );
+  m_poolTiles.clear();
+  m_h.clear();
+  m_hu.clear();
+  m_hv.clear();
+  m_bathymetry.clear();
+  m_version++;
+}
+
+void tsunami_lab::patches::WavePropagation2dSparse::allocateTile( t_idx i_tile, t_real i_b ) {
+  t_idx l_tileCells = m_tileSize * m_tileSize;
+  m_tiles[i_tile] = m_poolTiles.size();
+  m_poolTiles.push_back( i_tile );
+  m_h.resize( m_h.size() + l_tileCells, 0 );
+  m_hu.resize( m_hu.size() + l_tileCells, 0 );
+  m_hv.resize( m_hv.size() + l_tileCells, 0 );
+  m_bathymetry.resize( m_bathymetry.size() + l_tileCells, i_b );
+  m_version++;
+}
+
+void tsunami_lab::patches::WavePropagation2dSparse::initWithSetup( tsunami_lab::setups::Setup* i_setup, t_real i_scaleX, t_real i_scaleY ) {
+  i_setup->setInitScale(i_scaleX, i_scaleY);
+
+  using namespace std::chrono;
+  auto start = high_resolution_clock::now();
+
+  initTiles();
+
+  t_idx l_nCellsX = m_nCellsX;
+  t_idx l_nCellsY = m_nCellsY;
+  t_idx l_tileSize = m_tileSize;
+  t_idx l_nTilesX = m_nTilesX;
+  t_idx l_nTiles = m_tiles.size();
+
+  // first pass: find the tiles with water;
+  // a ghost cell is wet, if the cell it copies from is wet, so setGhostOutflow() never writes into a land tile
+  std::vector<char> l_isWet( l_nTiles, 0 );
+  t_real* l_landBathymetry = m_landBathymetry.data();
+  #pragma omp parallel for schedule(dynamic)
+  for( t_idx l_ti = 0; l_ti < l_nTiles; l_ti++ ) {
+    t_idx l_x0 = (l_ti % l_nTilesX) * l_tileSize, l_x1 = std::min( l_x0 + l_tileSize, l_nCellsX + 2 );
+    t_idx l_y0 = (l_ti / l_nTilesX) * l_tileSize, l_y1 = std::min( l_y0 + l_tileSize, l_nCellsY + 2 );
+    bool   l_wet = false;
+    t_real l_sum = 0;
+    for( t_idx l_iy = l_y0; l_iy < l_y1; l_iy++ ) {
+      t_real l_y = (l_iy - (t_real) 0.5) * i_scaleY;// -0.5 = -1 (ghost zone) + 0.5 (center of cell)
+      t_idx  l_iy1 = std::min( std::max( l_iy, (t_idx) 1 ), l_nCellsY );
+      for( t_idx l_ix = l_x0; l_ix < l_x1; l_ix++ ) {
+        t_real l_x = (l_ix - (t_real) 0.5) * i_scaleX;
+        t_real l_b = i_setup->getBathymetry( l_x, l_y ) + i_setup->getDisplacement( l_x, l_y );
+        l_sum += l_b;
+        if( l_b <= 0 ) l_wet = true;
+        t_idx l_ix1 = std::min( std::max( l_ix, (t_idx) 1 ), l_nCellsX );
+        if( !l_wet && (l_ix1 != l_ix || l_iy1 != l_iy) ) {
+          t_real l_x1 = (l_ix1 - (t_real) 0.5) * i_scaleX;
+          t_real l_y1 = (l_iy1 - (t_real) 0.5) * i_scaleY;
+          if( i_setup->getBathymetry( l_x1, l_y1 ) + i_setup->getDisplacement( l_x1, l_y1 ) <= 0 ) l_wet = true;
+        }
+      }
+    }
+    l_isWet[l_ti] = l_wet;
+    l_landBathymetry[l_ti] = l_sum / (t_real) ((l_x1 - l_x0) * (l_y1 - l_y0));
+  }
+
+  // assign the wet tiles to the pool
+  for( t_idx l_ti = 0; l_ti < l_nTiles; l_ti++ ) {
+    if( l_isWet[l_ti] ) {
+      m_tiles[l_ti] = m_poolTiles.size();
+      m_poolTiles.push_back( l_ti );
+    }
+  }
+
+  t_idx l_nPool = m_poolTiles.size();
+  t_idx l_tileCells = l_tileSize * l_tileSize;
+  size_t l_dataSize = l_nPool * l_tileCells * 4 * sizeof(t_real);
+  size_t l_denseSize = (l_nCellsX + 2) * (l_nCellsY + 2) * (CELLS_MAX * 3 + 1) * sizeof(t_real);
+  std::cout << "sparse storage: " << l_nPool << " of " << l_nTiles << " tiles of " << l_tileSize << " x " << l_tileSize << " cells contain water, allocating "
+            << (l_dataSize/1e9) << "GB instead of " << (l_denseSize/1e9) << "GB" << std::endl;
+
+  m_h.assign( l_nPool * l_tileCells, 0 );
+  m_hu.assign( l_nPool * l_tileCells, 0 );
+  m_hv.assign( l_nPool * l_tileCells, 0 );
+  m_bathymetry.assign( l_nPool * l_tileCells, 0 );
+
+  // second pass: fill the wet tiles
+  t_real* l_h  = m_h.data();
+  t_real* l_hu = m_hu.data();
+  t_real* l_hv = m_hv.data();
+  t_real* l_b  = m_bathymetry.data();
+  t_idx const * l_poolTiles = m_poolTiles.data();
+  #pragma omp parallel for schedule(dynamic)
+  for( t_idx l_sl = 0; l_sl < l_nPool; l_sl++ ) {
+    t_idx l_ti = l_poolTiles[l_sl];
+    t_idx l_x0 = (l_ti % l_nTilesX) * l_tileSize, l_x1 = std::min( l_x0 + l_tileSize, l_nCellsX + 2 );
+    t_idx l_y0 = (l_ti / l_nTilesX) * l_tileSize, l_y1 = std::min( l_y0 + l_tileSize, l_nCellsY + 2 );
+    t_idx l_i = l_sl * l_tileSize * l_tileSize;
+    i_setup->fillRows( l_y0, l_y1, l_x0, l_x1 - l_x0, i_scaleX, i_scaleY,
+                       l_h + l_i, l_hu + l_i, l_hv + l_i, l_b + l_i, l_tileSize );
+  }
+
+  m_version++;
+
+  auto end = high_resolution_clock::now();
+  if(l_nCellsX * l_nCellsY > 1e5) std::cout << "inited sparse field of size " << l_nCellsX << " x " << l_nCellsY << " in " << duration<double>(end-start).count() << "s" << std::endl;
+
+}
+
+void tsunami_lab::patches::WavePropagation2dSparse::timeStep( t_real i_scaling ) {
+
+  using namespace std::chrono;
+  auto start = high_resolution_clock::now();
+
+  t_idx l_nCellsX = m_nCellsX;
+  t_idx l_nCellsY = m_nCellsY;
+  t_idx l_tileSize = m_tileSize;
+  t_idx l_nTilesX = m_nTilesX;
+  t_idx l_nTilesY = m_nTilesY;
+
+  // the number of threads depends on the number of allocated cells; small grids run serially
+  int l_threads = m_executionPolicy.getSolverThreads( m_h.size() );
+
+  t_idx  const * l_tiles = m_tiles.data();
+  t_real const * l_landBathymetry = m_landBathymetry.data();
+  t_real * l_h  = m_h.data();
+  t_real * l_hu = m_hu.data();
+  t_real * l_hv = m_hv.data();
+  t_real const * l_b = m_bathymetry.data();
+
+  //////////////////////////////
+  // half step in x direction //
+  //////////////////////////////
+
+  // every row is updated in place; the left cell of the current edge is kept in registers,
+  // and written back, when both of its edges have been applied; land tiles are skipped
+  #pragma omp parallel for num_threads(l_threads) if(l_threads > 1)
+  for( t_idx l_iy = 0; l_iy < l_nCellsY + 2; l_iy++ ) {
+    t_idx l_ty = l_iy / l_tileSize;
+    t_idx l_ry = l_iy % l_tileSize;
+
+    bool   l_hasLeft = false, l_landLeft = false;
+    t_real l_hL = 0, l_huL = 0, l_bL = 0, l_hNewL = 0, l_huNewL = 0;
+    t_idx  l_iL = 0;
+
+    for( t_idx l_tx = 0; l_tx < l_nTilesX; l_tx++ ) {
+      t_idx l_ti = l_ty * l_nTilesX + l_tx;
+      t_idx l_sl = l_tiles[l_ti];
+
+      if( l_sl == m_landTile ) {
+        if( l_hasLeft && !l_landLeft ) {
+          t_real l_hNewR = 0, l_huNewR = 0;
+          edgeUpdate( i_scaling, l_hL, 0, l_huL, 0, l_bL, l_landBathymetry[l_ti], l_hNewL, l_hNewR, l_huNewL, l_huNewR );
+          l_h [l_iL] = l_hNewL;
+          l_hu[l_iL] = l_huNewL;
+        }
+        l_hasLeft = l_landLeft = true;
+        l_hL = l_huL = 0;
+        l_bL = l_landBathymetry[l_ti];
+        continue;
+      }
+
+      t_idx l_x0 = l_tx * l_tileSize;
+      t_idx l_x1 = std::min( l_x0 + l_tileSize, l_nCellsX + 2 );
+      t_idx l_i  = (l_sl * l_tileSize + l_ry) * l_tileSize;
+      for( t_idx l_ix = l_x0; l_ix < l_x1; l_ix++, l_i++ ) {
+        t_real l_hR = l_h[l_i], l_huR = l_hu[l_i], l_bR = l_b[l_i];
+        t_real l_hNewR = l_hR, l_huNewR = l_huR;
+        if( l_hasLeft ) {
+          edgeUpdate( i_scaling, l_hL, l_hR, l_huL, l_huR, l_bL, l_bR, l_hNewL, l_hNewR, l_huNewL, l_huNewR );
+          if( !l_landLeft ) {
+            l_h [l_iL] = l_hNewL;
+            l_hu[l_iL] = l_huNewL;
+          }
+        }
+        l_hL = l_hR;
+        l_huL = l_huR;
+        l_bL = l_bR;
+        l_hNewL = l_hNewR;
+        l_huNewL = l_huNewR;
+        l_iL = l_i;
+        l_hasLeft = true;
+        l_landLeft = false;
+      }
+    }
+
+    if( l_hasLeft && !l_landLeft ) {
+      l_h [l_iL] = l_hNewL;
+      l_hu[l_iL] = l_huNewL;
+    }
+  }
+
+  auto middle = high_resolution_clock::now();
+
+  //////////////////////////////
+  // half step in y direction //
+  //////////////////////////////
+
+  // every column of tiles is walked from top to bottom with a window of two rows
+  #pragma omp parallel num_threads(l_threads) if(l_threads > 1)
+  {
+    std::vector<t_real> l_hOldU(l_tileSize), l_hvOldU(l_tileSize), l_bU(l_tileSize), l_hNewU(l_tileSize), l_hvNewU(l_tileSize);
+    std::vector<t_real> l_hOldC(l_tileSize), l_hvOldC(l_tileSize), l_bC(l_tileSize), l_hNewC(l_tileSize), l_hvNewC(l_tileSize);
+
+    #pragma omp for schedule(dynamic)
+    for( t_idx l_tx = 0; l_tx < l_nTilesX; l_tx++ ) {
+      t_idx l_x0 = l_tx * l_tileSize;
+      t_idx l_nx = std::min( l_tileSize, l_nCellsX + 2 - l_x0 );
+
+      bool   l_hasUp = false, l_landUp = false;
+      t_real l_bLandUp = 0;
+      t_idx  l_iUp = 0;
+
+      for( t_idx l_ty = 0; l_ty < l_nTilesY; l_ty++ ) {
+        t_idx l_ti = l_ty * l_nTilesX + l_tx;
+        t_idx l_sl = l_tiles[l_ti];
+
+        if( l_sl == m_landTile ) {
+          if( l_hasUp && !l_landUp ) {
+            for( t_idx l_c = 0; l_c < l_nx; l_c++ ) {
+              t_real l_hNewR = 0, l_hvNewR = 0;
+              edgeUpdate( i_scaling, l_hOldU[l_c], 0, l_hvOldU[l_c], 0, l_bU[l_c], l_landBathymetry[l_ti], l_hNewU[l_c], l_hNewR, l_hvNewU[l_c], l_hvNewR );
+              l_h [l_iUp + l_c] = l_hNewU[l_c];
+              l_hv[l_iUp + l_c] = l_hvNewU[l_c];
+            }
+          }
+          l_hasUp = l_landUp = true;
+          l_bLandUp = l_landBathymetry[l_ti];
+          continue;
+        }
+
+        t_idx l_y0 = l_ty * l_tileSize;
+        t_idx l_y1 = std::min( l_y0 + l_tileSize, l_nCellsY + 2 );
+        for( t_idx l_iy = l_y0; l_iy < l_y1; l_iy++ ) {
+          t_idx l_iC = (l_sl * l_tileSize + (l_iy - l_y0)) * l_tileSize;
+
+          // load the next row
+          for( t_idx l_c = 0; l_c < l_nx; l_c++ ) {
+            l_hNewC [l_c] = l_hOldC [l_c] = l_h [l_iC + l_c];
+            l_hvNewC[l_c] = l_hvOldC[l_c] = l_hv[l_iC + l_c];
+            l_bC[l_c] = l_b[l_iC + l_c];
+          }
+
+          if( l_hasUp ) {
+            if( l_landUp ) {
+              for( t_idx l_c = 0; l_c < l_nx; l_c++ ) {
+                t_real l_hNewL = 0, l_hvNewL = 0;
+                edgeUpdate( i_scaling, 0, l_hOldC[l_c], 0, l_hvOldC[l_c], l_bLandUp, l_bC[l_c], l_hNewL, l_hNewC[l_c], l_hvNewL, l_hvNewC[l_c] );
+              }
+            } else {
+              for( t_idx l_c = 0; l_c < l_nx; l_c++ ) {
+                edgeUpdate( i_scaling, l_hOldU[l_c], l_hOldC[l_c], l_hvOldU[l_c], l_hvOldC[l_c], l_bU[l_c], l_bC[l_c], l_hNewU[l_c], l_hNewC[l_c], l_hvNewU[l_c], l_hvNewC[l_c] );
+              }
+              // the upper row is complete
+              for( t_idx l_c = 0; l_c < l_nx; l_c++ ) {
+                l_h [l_iUp + l_c] = l_hNewU[l_c];
+                l_hv[l_iUp + l_c] = l_hvNewU[l_c];
+              }
+            }
+          }
+
+          l_hOldU.swap( l_hOldC );
+          l_hvOldU.swap( l_hvOldC );
+          l_bU.swap( l_bC );
+          l_hNewU.swap( l_hNewC );
+          l_hvNewU.swap( l_hvNewC );
+          l_iUp = l_iC;
+          l_hasUp = true;
+          l_landUp = false;
+        }
+      }
+
+      // save the last row
+      if( l_hasUp && !l_landUp ) {
+        for( t_idx l_c = 0; l_c < l_nx; l_c++ ) {
+          l_h [l_iUp + l_c] = l_hNewU[l_c];
+          l_hv[l_iUp + l_c] = l_hvNewU[l_c];
+        }
+      }
+    }
+  }
+
+  m_version++;
+
+  auto end = high_resolution_clock::now();
+  if(l_nCellsX * l_nCellsY > 1e5) std::cout << "      computed timeStep in " << duration<double>(end-start).count() << "s, " << duration<double>(end-middle).count()/duration<double>(middle-start).count() << "x slower for y" << std::endl;
+
+}
+
+tsunami_lab::t_real tsunami_lab::patches::WavePropagation2dSparse::computeMaxTimestep( t_real i_cellSizeMeters ){
+
+  t_real l_maxVelocity = 0;
+  t_real l_gravity = tsunami_lab::solvers::FWave::m_gravity;
+
+  t_idx l_nCellsX = m_nCellsX;
+  t_idx l_nCellsY = m_nCellsY;
+  t_idx l_tileSize = m_tileSize;
+  t_idx l_nTilesX = m_nTilesX;
+  t_idx l_nPool = m_poolTiles.size();
+
+  t_idx  const * l_poolTiles = m_poolTiles.data();
+  t_real const * l_h  = m_h.data();
+  t_real const * l_hu = m_hu.data();
+  t_real const * l_hv = m_hv.data();
+
+  // only inner cells of the wet tiles
+  int l_threads = m_executionPolicy.getCopyThreads( m_h.size() );
+  #pragma omp parallel for reduction(max: l_maxVelocity) num_threads(l_threads) if(l_threads > 1)
+  for( t_idx l_sl = 0; l_sl < l_nPool; l_sl++ ) {
+    t_idx l_ti = l_poolTiles[l_sl];
+    t_idx l_x0 = (l_ti % l_nTilesX) * l_tileSize, l_y0 = (l_ti / l_nTilesX) * l_tileSize;
+    t_idx l_ix0 = std::max( l_x0, (t_idx) 1 ), l_ix1 = std::min( l_x0 + l_tileSize, l_nCellsX + 1 );
+    t_idx l_iy0 = std::max( l_y0, (t_idx) 1 ), l_iy1 = std::min( l_y0 + l_tileSize, l_nCellsY + 1 );
+    for( t_idx l_iy = l_iy0; l_iy < l_iy1; l_iy++ ) {
+      t_idx l_i = (l_sl * l_tileSize + (l_iy - l_y0)) * l_tileSize + (l_ix0 - l_x0);
+      #pragma omp simd reduction(max: l_maxVelocity)
+      for( t_idx l_ix = l_ix0; l_ix < l_ix1; l_ix++ ) {
+        t_idx  l_ic = l_i + (l_ix - l_ix0);
+        t_real l_height = l_h[l_ic];
+        t_real l_impulse = std::max(std::abs(l_hu[l_ic]), std::abs(l_hv[l_ic]));
+        t_real l_velocity = l_impulse / l_height;
+        t_real l_expectedVelocity = l_velocity + std::sqrt(l_gravity * l_height);
+        if(l_expectedVelocity > l_maxVelocity) l_maxVelocity = l_expectedVelocity;
+      }
+    }
+  }
+
+  return m_cflFactor * i_cellSizeMeters / l_maxVelocity;
+
+}
+
+void tsunami_lab::patches::WavePropagation2dSparse::setGhostOutflow() {
+
+  t_idx l_nCellsX = m_nCellsX;
+  t_idx l_nCellsY = m_nCellsY;
+  int   l_threadsX = m_executionPolicy.getCopyThreads( l_nCellsX + 2 );
+  int   l_threadsY = m_executionPolicy.getCopyThreads( l_nCellsY + 2 );
+
+  // copies the source cell into the ghost cell; ghost cells next to land tiles become land
+  auto l_copy = [this]( t_idx i_ixDst, t_idx i_iyDst, t_idx i_ixSrc, t_idx i_iySrc ) {
+    t_idx l_dst = getPoolIndex( i_ixDst, i_iyDst );
+    if( l_dst == m_landTile ) return;
+    t_idx l_src = getPoolIndex( i_ixSrc, i_iySrc );
+    if( l_src == m_landTile ) {
+      m_bathymetry[l_dst] = m_landBathymetry[(i_iySrc / m_tileSize) * m_nTilesX + i_ixSrc / m_tileSize];
+      m_h [l_dst] = 0;
+      m_hu[l_dst] = 0;
+      m_hv[l_dst] = 0;
+    } else {
+      m_bathymetry[l_dst] = m_bathymetry[l_src];
+      m_h [l_dst] = m_h [l_src];
+      m_hu[l_dst] = m_hu[l_src];
+      m_hv[l_dst] = m_hv[l_src];
+    }
+  };
+
+  // set left and right boundary
+  #pragma omp parallel for num_threads(l_threadsY) if(l_threadsY > 1)
+  for(t_idx l_y = 0; l_y < l_nCellsY+2; l_y++){
+    l_copy( 0, l_y, 1, l_y );
+    l_copy( l_nCellsX + 1, l_y, l_nCellsX, l_y );
+  }
+
+  // set top and bottom boundary
+  #pragma omp parallel for num_threads(l_threadsX) if(l_threadsX > 1)
+  for(t_idx l_x = 0; l_x < l_nCellsX+2; l_x++){
+    l_copy( l_x, 0, l_x, 1 );
+    l_copy( l_x, l_nCellsY + 1, l_x, l_nCellsY );
+  }
+
+  m_version++;
+
+}
+
+void tsunami_lab::patches::WavePropagation2dSparse::getRow( unsigned short i_quantity,
+                                                            t_idx          i_iy,
+                                                            t_real       * o_row ) {
+
+  t_real const * l_data = i_quantity == 0 ? m_h.data() : i_quantity == 1 ? m_hu.data() : i_quantity == 2 ? m_hv.data() : m_bathymetry.data();
+  t_idx l_ty = i_iy / m_tileSize;
+  t_idx l_ry = i_iy % m_tileSize;
+
+  for( t_idx l_tx = 0; l_tx < m_nTilesX; l_tx++ ) {
+    t_idx l_ti = l_ty * m_nTilesX + l_tx;
+    t_idx l_sl = m_tiles[l_ti];
+    t_idx l_x0 = l_tx * m_tileSize;
+    t_idx l_x1 = std::min( l_x0 + m_tileSize, m_nCellsX + 2 );
+    if( l_sl == m_landTile ) {
+      t_real l_value = i_quantity == 3 ? m_landBathymetry[l_ti] : 0;
+      for( t_idx l_ix = l_x0; l_ix < l_x1; l_ix++ ) o_row[l_ix] = l_value;
+    } else {
+      t_real const * l_src = l_data + (l_sl * m_tileSize + l_ry) * m_tileSize - l_x0;
+      for( t_idx l_ix = l_x0; l_ix < l_x1; l_ix++ ) o_row[l_ix] = l_src[l_ix];
+    }
+  }
+
+}
+
+tsunami_lab::t_real const * tsunami_lab::patches::WavePropagation2dSparse::getExport( unsigned short i_quantity ) {
+
+  t_idx l_stride = getStride();
+  if( m_export[i_quantity] == nullptr ) m_export[i_quantity] = new t_real[l_stride * (m_nCellsY + 2)];
+  t_real* l_data = m_export[i_quantity];
+
+  if( m_exportVersion[i_quantity] != m_version ) {
+    t_idx l_nRows = m_nCellsY + 2;
+    #pragma omp parallel for
+    for( t_idx l_iy = 0; l_iy < l_nRows; l_iy++ ) {
+      getRow( i_quantity, l_iy, l_data + l_iy * l_stride );
+    }
+    m_exportVersion[i_quantity] = m_version;
+  }
+
+  return l_data;
+}
+
+void tsunami_lab::patches::WavePropagation2dSparse::getCellState( t_idx    i_ix,
+                                                                  t_idx    i_iy,
+                                                                  t_real & o_h,
+                                                                  t_real & o_hu,
+                                                                  t_real & o_hv ) {
+  t_idx l_i = getPoolIndex( i_ix + 1, i_iy + 1 );
+  if( l_i == m_landTile ) {
+    o_h = o_hu = o_hv = 0;
+  } else {
+    o_h  = m_h [l_i];
+    o_hu = m_hu[l_i];
+    o_hv = m_hv[l_i];
+  }
+}
+
+void tsunami_lab::patches::WavePropagation2dSparse::setBathymetry( t_idx  i_ix,
+                                                                   t_idx  i_iy,
+                                                                   t_real i_b ) {
+  t_idx l_ix = i_ix + 1, l_iy = i_iy + 1;
+  if( getPoolIndex( l_ix, l_iy ) == m_landTile ) {
+    if( i_b > 0 ) return;// stays land
+    // the tile gets water; ghost cells, which copy this cell, need their tiles as well
+    for( t_idx l_ny = l_iy - 1; l_ny <= l_iy + 1; l_ny++ ) {
+      for( t_idx l_nx = l_ix - 1; l_nx <= l_ix + 1; l_nx++ ) {
+        bool l_isGhost = l_nx == 0 || l_ny == 0 || l_nx == m_nCellsX + 1 || l_ny == m_nCellsY + 1;
+        if( (l_nx == l_ix && l_ny == l_iy) || l_isGhost ) {
+          t_idx l_ti = (l_ny / m_tileSize) * m_nTilesX + l_nx / m_tileSize;
+          if( m_tiles[l_ti] == m_landTile ) allocateTile( l_ti, m_landBathymetry[l_ti] );
+        }
+      }
+    }
+  }
+  m_bathymetry[getPoolIndex( l_ix, l_iy )] = i_b;
+  m_version++;
+}
+
+void tsunami_lab::patches::WavePropagation2dSparse::setHeight( t_idx  i_ix,
+                                                               t_idx  i_iy,
+                                                               t_real i_h ) {
+  t_idx l_i = getPoolIndex( i_ix + 1, i_iy + 1 );
+  if( l_i == m_landTile ) return;
+  m_h[l_i] = i_h;
+  m_version++;
+}
+
+void tsunami_lab::patches::WavePropagation2dSparse::setMomentumX( t_idx  i_ix,
+                                                                  t_idx  i_iy,
+                                                                  t_real i_hu ) {
+  t_idx l_i = getPoolIndex( i_ix + 1, i_iy + 1 );
+  if( l_i == m_landTile ) return;
+  m_hu[l_i] = i_hu;
+  m_version++;
+}
+
+void tsunami_lab::patches::WavePropagation2dSparse::setMomentumY( t_idx  i_ix,
+                                                                  t_idx  i_iy,
+                                                                  t_real i_hv ) {
+  t_idx l_i = getPoolIndex( i_ix + 1, i_iy + 1 );
+  if( l_i == m_landTile ) return;
+  m_hv[l_i] = i_hv;
+  m_version++;
+}
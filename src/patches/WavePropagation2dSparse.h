@@ -0,0 +1,309 @@
+/**
+ * @author Antonio Noack
+ *
+ * @section DESCRIPTION
+ * Two-dimensional wave propagation patch, which only allocates tiles containing water.
+ * The domain including the ghost cells is split into square tiles. A tile index table maps each tile to a dense
+ * tile in a pool, or to the shared land sentinel, if all of its cells are dry (bathymetry > 0).
+ * Dry cells never get water in this solver, so land tiles stay land for the whole simulation.
+ * Of a land tile, only the average elevation is kept for the output.
+ **/
+#ifndef TSUNAMI_LAB_PATCHES_WAVE_PROPAGATION_2D_SPARSE
+#define TSUNAMI_LAB_PATCHES_WAVE_PROPAGATION_2D_SPARSE
+
+#include "WavePropagation.h"
+#include "../setups/Setup.h"
+
+#include <vector>
+
+namespace tsunami_lab {
+  namespace patches {
+    class WavePropagation2dSparse;
+  }
+}
+
+class tsunami_lab::patches::WavePropagation2dSparse: public WavePropagation {
+  private:
+
+    //! tile index of tiles, which only contain land
+    static t_idx constexpr m_landTile = (t_idx) -1;
+
+    //! number of cells on the x and y axis
+    t_idx m_nCellsX = 0, m_nCellsY = 0;
+
+    //! number of cells per tile side
+    t_idx m_tileSize = 32;
+
+    //! number of tiles on the x and y axis, including the ghost cells
+    t_idx m_nTilesX = 0, m_nTilesY = 0;
+
+    //! index of each tile in the pool, or m_landTile
+    std::vector<t_idx> m_tiles;
+
+    //! average bathymetry of each land tile; used for the output
+    std::vector<t_real> m_landBathymetry;
+
+    //! tile id (in m_tiles) of each tile in the pool
+    std::vector<t_idx> m_poolTiles;
+
+    //! water heights of all tiles in the pool, m_tileSize x m_tileSize values per tile
+    std::vector<t_real> m_h;
+
+    //! momenta in x direction of all tiles in the pool
+    std::vector<t_real> m_hu;
+
+    //! momenta in y direction of all tiles in the pool
+    std::vector<t_real> m_hv;
+
+    //! bathymetry of all tiles in the pool
+    std::vector<t_real> m_bathymetry;
+
+    //! cfl factor for the 2d case; should be less than 0.5, such that a velocity increase does not violate the cfl condition
+    t_real m_cflFactor = 0.45;
+
+    //! dense copies of height, momentum x, momentum y and bathymetry for the getters; allocated on first use
+    t_real * m_export[4] = { nullptr, nullptr, nullptr, nullptr };
+
+    //! state version, which was copied into m_export
+    t_idx m_exportVersion[4] = { 0, 0, 0, 0 };
+
+    //! state version; incremented by every change
+    t_idx m_version = 1;
+
+    /**
+     * Creates the tile table, where all tiles are land.
+     **/
+    void initTiles();
+
+    /**
+     * Adds a tile to the pool, which is filled with zero momenta, zero height and the given bathymetry.
+     *
+     * @param i_tile id of the tile.
+     * @param i_b bathymetry of all cells.
+     **/
+    void allocateTile( t_idx i_tile, t_real i_b );
+
+    /**
+     * Finds the index of a cell in the pool.
+     *
+     * @param i_ix id of the cell in x-direction, including the ghost cells.
+     * @param i_iy id of the cell in y-direction, including the ghost cells.
+     * @return index in the pool, or m_landTile, if the cell is part of a land tile.
+     **/
+    t_idx getPoolIndex( t_idx i_ix, t_idx i_iy ) const {
+      t_idx l_tile = (i_iy / m_tileSize) * m_nTilesX + i_ix / m_tileSize;
+      t_idx l_slot = m_tiles[l_tile];
+      if( l_slot == m_landTile ) return m_landTile;
+      return (l_slot * m_tileSize + i_iy % m_tileSize) * m_tileSize + i_ix % m_tileSize;
+    }
+
+    /**
+     * Returns the dense copy of a quantity, and refreshes it if the state has changed.
+     *
+     * @param i_quantity 0 = height, 1 = momentum x, 2 = momentum y, 3 = bathymetry.
+     * @return values, including the ghost cells.
+     **/
+    t_real const * getExport( unsigned short i_quantity );
+
+  public:
+    /**
+     * Constructs the sparse 2d wave propagation solver; all tiles are allocated and contain still water with a height of zero.
+     *
+     * @param i_nCellsX number of cells on the x axis.
+     * @param i_nCellsY number of cells on the y axis.
+     * @param i_tileSize number of cells per tile side; at least 2.
+     **/
+    WavePropagation2dSparse( t_idx i_nCellsX, t_idx i_nCellsY, t_idx i_tileSize );
+
+    /**
+     * Constructs the sparse 2d wave propagation solver and applies the setup; only tiles with water are allocated.
+     *
+     * @param i_nCellsX number of cells on the x axis.
+     * @param i_nCellsY number of cells on the y axis.
+     * @param i_setup setup for cell initialization.
+     * @param i_scaleX scale for the scene in x direction; e.g. you can multiply the number of cells by x, and set the scale to 1/x, and your setup will still work.
+     * @param i_scaleY scale for the scene in y direction.
+     * @param i_tileSize number of cells per tile side; at least 2.
+     **/
+    WavePropagation2dSparse( t_idx i_nCellsX, t_idx i_nCellsY, tsunami_lab::setups::Setup* i_setup, t_real i_scaleX, t_real i_scaleY, t_idx i_tileSize );
+
+    /**
+     * Destructor which frees all allocated memory.
+     **/
+    ~WavePropagation2dSparse();
+
+    /**
+     * Initializes the internal state with a setup, and allocates the tiles, which contain water.
+     *
+     * @param i_setup setup for cell initialization.
+     * @param i_scaleX scale for the scene in x direction; e.g. you can multiply the number of cells by x, and set the scale to 1/x, and your setup will still work.
+     * @param i_scaleY scale for the scene in y direction
+     **/
+    void initWithSetup( tsunami_lab::setups::Setup* i_setup, t_real i_scaleX, t_real i_scaleY );
+
+    /**
+     * Computes the maximum time step that is allowed without breaking the CFL condition.
+     **/
+    t_real computeMaxTimestep( t_real i_cellSizeMeters );
+
+    /**
+     * Performs a time step.
+     *
+     * @param i_scaling scaling of the time step (dt / dx).
+     **/
+    void timeStep( t_real i_scaling );
+
+    /**
+     * Sets the values of the ghost cells according to outflow boundary conditions.
+     **/
+    void setGhostOutflow();
+
+    /**
+     * Gets the stride in y-direction. x-direction is stride-1.
+     *
+     * @return stride in y-direction.
+     **/
+    t_idx getStride(){
+      return m_nCellsX+2;
+    }
+
+    /**
+     * Gets the number of tiles, which contain water.
+     *
+     * @return number of allocated tiles.
+     **/
+    t_idx getNumAllocatedTiles(){
+      return m_poolTiles.size();
+    }
+
+    /**
+     * Gets the number of tiles including the land tiles.
+     *
+     * @return number of tiles.
+     **/
+    t_idx getNumTiles(){
+      return m_tiles.size();
+    }
+
+    /**
+     * Gets cells' water heights; copied into a dense array on demand.
+     *
+     * @return water heights.
+     */
+    t_real const * getHeight(){
+      return getExport(0)+1+(m_nCellsX+2);
+    }
+
+    /**
+     * Gets the cells' momenta in x-direction; copied into a dense array on demand.
+     *
+     * @return momenta in x-direction.
+     **/
+    t_real const * getMomentumX(){
+      return getExport(1)+1+(m_nCellsX+2);
+    }
+
+    /**
+     * Gets the cells' momenta in y-direction; copied into a dense array on demand.
+     *
+     * @return momenta in y-direction.
+     **/
+    t_real const * getMomentumY(){
+      return getExport(2)+1+(m_nCellsX+2);
+    }
+
+    /**
+     * Gets the cells' bathymetry; copied into a dense array on demand.
+     *
+     * @return bathymetry.
+     **/
+    t_real const * getBathymetry(){
+      return getExport(3)+1+(m_nCellsX+2);
+    }
+
+    /**
+     * Copies a row of a quantity including the ghost cells; land tiles are filled with their average elevation and no water.
+     *
+     * @param i_quantity 0 = height, 1 = momentum x, 2 = momentum y, 3 = bathymetry.
+     * @param i_iy id of the row including the ghost cells.
+     * @param o_row buffer for getStride() values.
+     **/
+    void getRow( unsigned short i_quantity,
+                 t_idx          i_iy,
+                 t_real       * o_row );
+
+    /**
+     * The getters copy the whole field into a dense array.
+     *
+     * @return false.
+     **/
+    bool hasDenseStorage() {
+      return false;
+    }
+
+    /**
+     * Gets the water height and momenta of a single cell.
+     *
+     * @param i_ix id of the cell in x-direction.
+     * @param i_iy id of the cell in y-direction.
+     * @param o_h water height.
+     * @param o_hu momentum in x-direction.
+     * @param o_hv momentum in y-direction.
+     **/
+    void getCellState( t_idx    i_ix,
+                       t_idx    i_iy,
+                       t_real & o_h,
+                       t_real & o_hu,
+                       t_real & o_hv );
+
+    /**
+     * Sets the bathymetry of the cell to the given value; land tiles are allocated, when they get a wet cell.
+     *
+     * @param i_ix id of the cell in x-direction.
+     * @param i_iy id of the cell in y-direction.
+     * @param i_b bathymetry.
+     **/
+    void setBathymetry( t_idx  i_ix,
+                        t_idx  i_iy,
+                        t_real i_b );
+
+    /**
+     * Sets the height of the cell to the given value; ignored for cells of land tiles.
+     *
+     * @param i_ix id of the cell in x-direction.
+     * @param i_iy id of the cell in y-direction.
+     * @param i_h water height.
+     **/
+    void setHeight( t_idx  i_ix,
+                    t_idx  i_iy,
+                    t_real i_h );
+
+    /**
+     * Sets the momentum in x-direction to the given value; ignored for cells of land tiles.
+     *
+     * @param i_ix id of the cell in x-direction.
+     * @param i_iy id of the cell in y-direction.
+     * @param i_hu momentum in x-direction.
+     **/
+    void setMomentumX( t_idx  i_ix,
+                       t_idx  i_iy,
+                       t_real i_hu );
+
+    /**
+     * Sets the momentum in y-direction to the given value; ignored for cells of land tiles.
+     *
+     * @param i_ix id of the cell in x-direction.
+     * @param i_iy id of the cell in y-direction.
+     * @param i_hv momentum in y-direction.
+     **/
+    void setMomentumY( t_idx  i_ix,
+                       t_idx  i_iy,
+                       t_real i_hv );
+
+    /** Sets the cfl factor */
+    void setCflFactor(t_real i_value){
+      m_cflFactor = i_value;
+    }
+};
+
+#endif
@@ -0,0 +1,154 @@
+/**
+ * @author Antonio Noack
+ *
+ * @section DESCRIPTION
+ * Unit tests for the sparse two-dimensional wave propagation patch.
+ **/
+#include <catch2/catch.hpp>
+#include <cstdio> // std::remove
+#include <vector>
+
+#define private public
+
+#include "WavePropagation2d.h"
+#include "WavePropagation2dSparse.h"
+#include "../constants.h"
+#include "../io/NetCdf.h"
+#include "../setups/DamBreak2d.h"
+
+#undef private
+
+#define t_real tsunami_lab::t_real
+#define t_idx tsunami_lab::t_idx
+
+TEST_CASE( "Test the sparse 2d wave propagation solver.", "[WaveProp2dSparse]" ) {
+
+  // circular dam break next to a block of land, which covers the lower left corner including the ghost cells
+  tsunami_lab::setups::DamBreak2d l_setup( 15, 10, 70, 40, 10, -5 );
+  l_setup.setObstacle( -10, 40, -10, 25, 5 );
+
+  tsunami_lab::patches::WavePropagation2d       l_dense ( 100, 60, &l_setup, 1, 1 );
+  tsunami_lab::patches::WavePropagation2dSparse l_sparse( 100, 60, &l_setup, 1, 1, 8 );
+
+  // 13 x 8 tiles, of which 5 x 3 are land
+  REQUIRE( l_sparse.getNumTiles() == 13 * 8 );
+  REQUIRE( l_sparse.getNumAllocatedTiles() == 13 * 8 - 5 * 3 );
+
+  for( t_idx l_st = 0; l_st < 30; l_st++ ) {
+    l_dense.setGhostOutflow();
+    l_sparse.setGhostOutflow();
+    t_real l_scaling = l_dense.computeMaxTimestep( 1 );
+    if( l_st > 0 ) REQUIRE( l_sparse.computeMaxTimestep( 1 ) == Approx( l_scaling ) );
+    l_dense.timeStep( l_scaling );
+    l_sparse.timeStep( l_scaling );
+  }
+
+  // the same results as the dense patch, including the ghost cells
+  std::vector<t_real> l_rowDense( l_dense.getStride() ), l_rowSparse( l_sparse.getStride() );
+  for( unsigned short l_qu = 0; l_qu < 3; l_qu++ ) {
+    for( t_idx l_iy = 0; l_iy < 62; l_iy++ ) {
+      l_dense.getRow( l_qu, l_iy, l_rowDense.data() );
+      l_sparse.getRow( l_qu, l_iy, l_rowSparse.data() );
+      for( t_idx l_ix = 0; l_ix < 102; l_ix++ ) {
+        REQUIRE( l_rowSparse[l_ix] == Approx( l_rowDense[l_ix] ).margin( 1e-5 ) );
+      }
+    }
+  }
+
+  // the getters and single cells agree with the rows
+  for( t_idx l_iy = 0; l_iy < 60; l_iy++ ) {
+    for( t_idx l_ix = 0; l_ix < 100; l_ix++ ) {
+      t_idx  l_i = l_ix + l_iy * l_sparse.getStride();
+      t_real l_h, l_hu, l_hv;
+      l_sparse.getCellState( l_ix, l_iy, l_h, l_hu, l_hv );
+      REQUIRE( l_sparse.getHeight()[l_i]    == l_h );
+      REQUIRE( l_sparse.getMomentumX()[l_i] == l_hu );
+      REQUIRE( l_sparse.getMomentumY()[l_i] == l_hv );
+      REQUIRE( l_h == Approx( l_dense.getHeight()[l_i] ).margin( 1e-5 ) );
+    }
+  }
+
+  // land tiles report their elevation
+  REQUIRE( l_sparse.getBathymetry()[5 + 5 * l_sparse.getStride()] == Approx( 5 ) );
+  REQUIRE( l_sparse.getHeight()[5 + 5 * l_sparse.getStride()] == 0 );
+
+  // a land tile gets allocated, when it gets water
+  l_sparse.setBathymetry( 5, 5, -1 );
+  l_sparse.setHeight( 5, 5, 1 );
+  REQUIRE( l_sparse.getNumAllocatedTiles() == 13 * 8 - 5 * 3 + 1 );
+  REQUIRE( l_sparse.getBathymetry()[5 + 5 * l_sparse.getStride()] == -1 );
+  REQUIRE( l_sparse.getBathymetry()[6 + 5 * l_sparse.getStride()] == Approx( 5 ) );
+  REQUIRE( l_sparse.getHeight()[5 + 5 * l_sparse.getStride()] == 1 );
+}
+
+TEST_CASE( "Test the sparse 2d wave propagation solver with tiles, which don't fit into the domain.", "[WaveProp2dSparse]" ) {
+
+  // the last tiles of each band are cut off, and the land tiles are skipped
+  tsunami_lab::setups::DamBreak2d l_setup( 15, 10, 30, 20, 8, -5 );
+  l_setup.setObstacle( -10, 12, -10, 30, 5 );
+
+  tsunami_lab::patches::WavePropagation2d       l_dense( 45, 37, &l_setup, 1, 1 );
+  tsunami_lab::patches::WavePropagation2dSparse l_sparse( 45, 37, &l_setup, 1, 1, 5 );
+  REQUIRE( l_sparse.getNumTiles() == 10 * 8 );
+  REQUIRE( l_sparse.getNumAllocatedTiles() < l_sparse.getNumTiles() );
+
+  for( t_idx l_st = 0; l_st < 20; l_st++ ) {
+    l_dense.setGhostOutflow();
+    l_sparse.setGhostOutflow();
+    t_real l_scaling = l_dense.computeMaxTimestep( 1 );
+    l_dense.timeStep( l_scaling );
+    l_sparse.timeStep( l_scaling );
+  }
+
+  for( t_idx l_iy = 0; l_iy < 37; l_iy++ ) {
+    for( t_idx l_ix = 0; l_ix < 45; l_ix++ ) {
+      t_idx l_i = l_ix + l_iy * l_dense.getStride();
+      REQUIRE( l_sparse.getHeight()[l_i]     == Approx( l_dense.getHeight()[l_i] ).margin( 1e-5 ) );
+      REQUIRE( l_sparse.getMomentumX()[l_i]  == Approx( l_dense.getMomentumX()[l_i] ).margin( 1e-5 ) );
+      REQUIRE( l_sparse.getMomentumY()[l_i]  == Approx( l_dense.getMomentumY()[l_i] ).margin( 1e-5 ) );
+      REQUIRE( l_sparse.getBathymetry()[l_i] == l_dense.getBathymetry()[l_i] );
+    }
+  }
+}
+
+TEST_CASE( "Test checkpointing the sparse 2d wave propagation solver.", "[WaveProp2dSparse]" ) {
+
+  tsunami_lab::setups::DamBreak2d l_setup( 15, 10, 30, 20, 5, -5 );
+  l_setup.setObstacle( -10, 20, -10, 12, 5 );
+
+  tsunami_lab::patches::WavePropagation2dSparse l_sparse( 40, 30, &l_setup, 1, 1, 4 );
+  for( t_idx l_st = 0; l_st < 10; l_st++ ) {
+    l_sparse.setGhostOutflow();
+    l_sparse.timeStep( l_sparse.computeMaxTimestep( 1 ) );
+  }
+
+  std::string l_fileName = "tmp-sparse-cp.nc";
+  std::remove( l_fileName.c_str() );
+  std::vector<tsunami_lab::io::Station> l_stations;
+  REQUIRE( tsunami_lab::io::NetCDF::storeCheckpoint( l_fileName, 40, 30, 1, 0.45, 1, 10, l_stations, &l_sparse ) == 0 );
+
+  t_idx  l_nx, l_ny, l_timeStepIndex;
+  t_real l_cellSizeMeters, l_cflFactor;
+  double l_simulationTime;
+  auto l_checkpoint = tsunami_lab::io::NetCDF::loadCheckpoint( l_fileName, l_nx, l_ny, l_cellSizeMeters, l_cflFactor, l_simulationTime, l_timeStepIndex, l_stations );
+  REQUIRE( l_checkpoint != nullptr );
+  REQUIRE( l_nx == 42 );
+  REQUIRE( l_ny == 32 );
+
+  // the restored patch has the same tiles and values
+  tsunami_lab::patches::WavePropagation2dSparse l_restored( 40, 30, l_checkpoint, 1, 1, 4 );
+  REQUIRE( l_restored.getNumAllocatedTiles() == l_sparse.getNumAllocatedTiles() );
+  for( t_idx l_iy = 0; l_iy < 30; l_iy++ ) {
+    for( t_idx l_ix = 0; l_ix < 40; l_ix++ ) {
+      t_real l_h0, l_hu0, l_hv0, l_h1, l_hu1, l_hv1;
+      l_sparse.getCellState( l_ix, l_iy, l_h0, l_hu0, l_hv0 );
+      l_restored.getCellState( l_ix, l_iy, l_h1, l_hu1, l_hv1 );
+      REQUIRE( l_h1  == l_h0 );
+      REQUIRE( l_hu1 == l_hu0 );
+      REQUIRE( l_hv1 == l_hv0 );
+    }
+  }
+
+  delete l_checkpoint;
+  std::remove( l_fileName.c_str() );
+}
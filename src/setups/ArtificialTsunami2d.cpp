@@ -35,3 +35,40 @@ tsunami_lab::t_real tsunami_lab::setups::ArtificialTsunami2d::getMomentumX( t_re
 tsunami_lab::t_real tsunami_lab::setups::ArtificialTsunami2d::getMomentumY( t_real, t_real ) const {
   return 0;
 }
+
+void tsunami_lab::setups::ArtificialTsunami2d::fillRows( t_idx    i_y0,
+                                                         t_idx    i_y1,
+                                                         t_idx    i_x0,
+                                                         t_idx    i_nx,
+                                                         t_real   i_scaleX,
+                                                         t_real   i_scaleY,
+                                                         t_real * o_h,
+                                                         t_real * o_hu,
+                                                         t_real * o_hv,
+                                                         t_real * o_b,
+                                                         t_idx    i_stride ) const {
+  for( t_idx l_iy = i_y0; l_iy < i_y1; l_iy++ ) {
+    t_idx l_i = (l_iy - i_y0) * i_stride;
+    for( t_idx l_ix = 0; l_ix < i_nx; l_ix++ ) {
+      if( o_h  ) o_h [l_i + l_ix] = +100;
+      if( o_hu ) o_hu[l_i + l_ix] = 0;
+      if( o_hv ) o_hv[l_i + l_ix] = 0;
+    }
+    if( !o_b ) continue;
+    // see getDisplacement(); the factor of y is shared by the row
+    t_real l_y = (l_iy - (t_real) 0.5) * i_scaleY;
+    t_real l_yn = (l_y - 500)/500 + m_offsetY;
+    bool l_rowInside = l_yn >= -1 && l_yn <= +1;
+    t_real l_g = 1 - l_yn * l_yn;
+    for( t_idx l_ix = 0; l_ix < i_nx; l_ix++ ) {
+      t_real l_x = ((i_x0 + l_ix) - (t_real) 0.5) * i_scaleX;
+      t_real l_xn = (l_x - 500)/500 + m_offsetX;
+      t_real l_displacement = 0;
+      if( l_rowInside && l_xn >= -1 && l_xn <= +1 ) {
+        t_real l_f = -std::sin(l_xn * M_PI);
+        l_displacement = 5 * l_f * l_g;
+      }
+      o_b[l_i + l_ix] = -100 + l_displacement;
+    }
+  }
+}
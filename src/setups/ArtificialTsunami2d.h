@@ -68,6 +68,21 @@ class tsunami_lab::setups::ArtificialTsunami2d: public Setup {
      * @return momentum in y-direction.
      **/
     t_real getMomentumY( t_real, t_real ) const;
+
+    /**
+     * Samples whole rows of cells, see Setup::fillRows(); rows outside of the displacement are not evaluated per cell.
+     **/
+    void fillRows( t_idx    i_y0,
+                   t_idx    i_y1,
+                   t_idx    i_x0,
+                   t_idx    i_nx,
+                   t_real   i_scaleX,
+                   t_real   i_scaleY,
+                   t_real * o_h,
+                   t_real * o_hu,
+                   t_real * o_hv,
+                   t_real * o_b,
+                   t_idx    i_stride ) const;
     
 };
 
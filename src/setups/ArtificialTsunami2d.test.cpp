@@ -0,0 +1,17 @@
+/**
+ * @author Antonio Noack
+ *
+ * @section DESCRIPTION
+ * Tests the artificial tsunami setup.
+ **/
+#include <catch2/catch.hpp>
+#include "ArtificialTsunami2d.h"
+#include "Setup.test.h"
+
+TEST_CASE( "Test that the rows of the artificial tsunami match its getters.", "[ArtificialTsunami2d]" ) {
+
+  // the displacement covers [0, 1000]^2
+  tsunami_lab::setups::ArtificialTsunami2d l_setup;
+
+  requireRowsMatchGetters( l_setup, 40, 120 );
+}
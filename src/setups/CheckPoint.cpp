@@ -38,3 +38,27 @@ tsunami_lab::t_real tsunami_lab::setups::CheckPoint::getMomentumX( t_real i_x, t
 tsunami_lab::t_real tsunami_lab::setups::CheckPoint::getMomentumY( t_real i_x, t_real i_y ) const {
   return m_momentumY[getIndex(i_x, i_y)];
 }
+
+void tsunami_lab::setups::CheckPoint::fillRows( t_idx    i_y0,
+                                                t_idx    i_y1,
+                                                t_idx    i_x0,
+                                                t_idx    i_nx,
+                                                t_real   i_scaleX,
+                                                t_real   i_scaleY,
+                                                t_real * o_h,
+                                                t_real * o_hu,
+                                                t_real * o_hv,
+                                                t_real * o_b,
+                                                t_idx    i_stride ) const {
+  for( t_idx l_iy = i_y0; l_iy < i_y1; l_iy++ ) {
+    t_real l_y = (l_iy - (t_real) 0.5) * i_scaleY;
+    t_idx  l_i = (l_iy - i_y0) * i_stride;
+    for( t_idx l_ix = i_x0; l_ix < i_x0 + i_nx; l_ix++, l_i++ ) {
+      t_idx l_id = getIndex( (l_ix - (t_real) 0.5) * i_scaleX, l_y );
+      if( o_h  ) o_h [l_i] = m_height[l_id];
+      if( o_hu ) o_hu[l_i] = m_momentumX[l_id];
+      if( o_hv ) o_hv[l_i] = m_momentumY[l_id];
+      if( o_b  ) o_b [l_i] = m_bathymetry[l_id];
+    }
+  }
+}
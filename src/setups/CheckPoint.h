@@ -118,6 +118,21 @@ class tsunami_lab::setups::CheckPoint: public Setup {
      * @return displacement in meters at the given point.
      **/
     t_real getDisplacement( t_real, t_real ) const;
+
+    /**
+     * Copies whole rows of cells, see Setup::fillRows().
+     **/
+    void fillRows( t_idx    i_y0,
+                   t_idx    i_y1,
+                   t_idx    i_x0,
+                   t_idx    i_nx,
+                   t_real   i_scaleX,
+                   t_real   i_scaleY,
+                   t_real * o_h,
+                   t_real * o_hu,
+                   t_real * o_hv,
+                   t_real * o_b,
+                   t_idx    i_stride ) const;
     
 };
 
@@ -6,11 +6,14 @@
 #include <catch2/catch.hpp>
 
 #include "CheckPoint.h"
+#include "Setup.test.h"
 #include "ArtificialTsunami2d.h"
 #include "../constants.h"
 #include "../patches/WavePropagation2d.h"
 #include "../io/NetCdf.h"
 
+#include <vector>
+
 #define t_real tsunami_lab::t_real
 #define t_idx  tsunami_lab::t_idx
 
@@ -52,3 +55,18 @@
   }
   
 }*/
+
+
+TEST_CASE( "Test that the rows of a checkpoint match its getters.", "[CheckPoint]" ) {
+
+  // 25 x 12 cells including the ghost cells, with a stride of 26
+  t_idx l_sizeX = 25, l_sizeY = 12, l_strideIn = 26;
+  t_real * l_arrays[4];
+  for( unsigned short l_qu = 0; l_qu < 4; l_qu++ ) {
+    l_arrays[l_qu] = new t_real[l_strideIn * l_sizeY];
+    for( t_idx l_ce = 0; l_ce < l_strideIn * l_sizeY; l_ce++ ) l_arrays[l_qu][l_ce] = (t_real) ( l_ce * ( l_qu + 1 ) % 37 ) - 10;
+  }
+  tsunami_lab::setups::CheckPoint l_setup( l_arrays[0], l_arrays[1], l_arrays[2], l_arrays[3], l_sizeX, l_sizeY, l_strideIn );
+
+  requireRowsMatchGetters( l_setup, 1, 1 );
+}
@@ -32,4 +32,39 @@ tsunami_lab::t_real tsunami_lab::setups::DamBreak2d::getMomentumX( t_real, t_rea
 
 tsunami_lab::t_real tsunami_lab::setups::DamBreak2d::getMomentumY( t_real, t_real ) const {
   return 0;
-}
\ No newline at end of file
+}
+
+void tsunami_lab::setups::DamBreak2d::fillRows( t_idx    i_y0,
+                                                t_idx    i_y1,
+                                                t_idx    i_x0,
+                                                t_idx    i_nx,
+                                                t_real   i_scaleX,
+                                                t_real   i_scaleY,
+                                                t_real * o_h,
+                                                t_real * o_hu,
+                                                t_real * o_hv,
+                                                t_real * o_b,
+                                                t_idx    i_stride ) const {
+  for( t_idx l_iy = i_y0; l_iy < i_y1; l_iy++ ) {
+    t_real l_y = (l_iy - (t_real) 0.5) * i_scaleY;
+    t_real l_deltaY = l_y - m_locationY;
+    t_real l_deltaY2 = l_deltaY * l_deltaY;
+    bool l_rowInObstacle = l_y >= m_obstacle.y0 && l_y < m_obstacle.y1;
+    t_idx l_i = (l_iy - i_y0) * i_stride;
+    for( t_idx l_ix = i_x0; l_ix < i_x0 + i_nx; l_ix++, l_i++ ) {
+      t_real l_x = (l_ix - (t_real) 0.5) * i_scaleX;
+      bool l_isInObstacle = l_rowInObstacle && l_x >= m_obstacle.x0 && l_x < m_obstacle.x1;
+      if( o_h ) {
+        // see getHeight()
+        t_real l_deltaX = l_x - m_locationX;
+        t_real l_f = std::min(std::max(std::sqrt(l_deltaX * l_deltaX + l_deltaY2) - m_radius + (t_real) 0.5, (t_real) 0.0), (t_real) 1.0);
+        t_real l_fluidHeight = m_heightInner * (1-l_f) + m_heightOuter * l_f;
+        if( l_isInObstacle ) l_fluidHeight -= (m_obstacle.bathymetryOverride - m_bathymetry);
+        o_h[l_i] = std::max(l_fluidHeight, (t_real) 0.0);
+      }
+      if( o_hu ) o_hu[l_i] = 0;
+      if( o_hv ) o_hv[l_i] = 0;
+      if( o_b  ) o_b [l_i] = l_isInObstacle ? m_obstacle.bathymetryOverride : m_bathymetry;
+    }
+  }
+}
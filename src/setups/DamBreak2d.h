@@ -130,6 +130,21 @@ class tsunami_lab::setups::DamBreak2d: public Setup {
       return 0;
     }
 
+    /**
+     * Samples whole rows of cells, see Setup::fillRows(); the distance to the center and the obstacle test are split into row and column parts.
+     **/
+    void fillRows( t_idx    i_y0,
+                   t_idx    i_y1,
+                   t_idx    i_x0,
+                   t_idx    i_nx,
+                   t_real   i_scaleX,
+                   t_real   i_scaleY,
+                   t_real * o_h,
+                   t_real * o_hu,
+                   t_real * o_hv,
+                   t_real * o_b,
+                   t_idx    i_stride ) const;
+
 };
 
 #endif
\ No newline at end of file
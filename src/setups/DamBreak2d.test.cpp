@@ -6,6 +6,7 @@
  **/
 #include <catch2/catch.hpp>
 #include "DamBreak2d.h"
+#include "Setup.test.h"
 
 TEST_CASE( "Test the two-dimensional dam break setup.", "[DamBreak2d]" ) {
   
@@ -37,3 +38,11 @@ TEST_CASE( "Test the two-dimensional dam break setup.", "[DamBreak2d]" ) {
 
   REQUIRE( l_setup.getMomentumY( 2.5, 2.5 ) == 0 );  
 }
+
+TEST_CASE( "Test that the rows of the two-dimensional dam break match its getters.", "[DamBreak2d]" ) {
+
+  tsunami_lab::setups::DamBreak2d l_setup( 10, 5, 8, 4, 3, -10 );
+  l_setup.setObstacle( 10, 14, 3, 5, -2 );
+
+  requireRowsMatchGetters( l_setup, 0.75, 0.75 );
+}
@@ -0,0 +1,100 @@
+/**
+ * @author Antonio Noack
+ * @section DESCRIPTION
+ * Setup, which was sampled at the cell centers of the simulation.
+ **/
+#include "PreparedGrid2d.h"
+
+// std::max, std::min
+#include <algorithm>
+#include <cmath>
+
+tsunami_lab::setups::PreparedGrid2d::PreparedGrid2d( Setup const* i_setup,
+                                                     t_idx        i_nCellsX,
+                                                     t_idx        i_nCellsY,
+                                                     t_real       i_scaleX,
+                                                     t_real       i_scaleY ) :
+  m_sizeX(i_nCellsX + 2), m_sizeY(i_nCellsY + 2),
+  m_scaleX(i_scaleX), m_scaleY(i_scaleY),
+  m_values(3 * m_sizeX * m_sizeY) {
+
+  assert(i_setup != nullptr);
+  assert(i_scaleX > 0 && i_scaleY > 0);
+
+  t_idx l_size = m_sizeX * m_sizeY;
+  t_real* l_h = m_values.data();
+  t_real* l_b = l_h + l_size;
+  t_real* l_d = l_b + l_size;
+  m_height       = l_h;
+  m_bathymetry   = l_b;
+  m_displacement = l_d;
+
+  // the same positions as in WavePropagation2d::initWithSetup()
+  #pragma omp parallel for
+  for( t_idx l_iy = 0; l_iy < m_sizeY; l_iy++ ) {
+    t_real l_y = (l_iy - (t_real) 0.5) * i_scaleY;
+    t_idx  l_i = l_iy * m_sizeX;
+    for( t_idx l_ix = 0; l_ix < m_sizeX; l_ix++, l_i++ ) {
+      t_real l_x = (l_ix - (t_real) 0.5) * i_scaleX;
+      l_h[l_i] = i_setup->getHeight(       l_x, l_y );
+      l_b[l_i] = i_setup->getBathymetry(   l_x, l_y );
+      l_d[l_i] = i_setup->getDisplacement( l_x, l_y );
+    }
+  }
+}
+
+tsunami_lab::t_idx tsunami_lab::setups::PreparedGrid2d::getIndex( t_real i_x, t_real i_y ) const {
+
+  // cell i has its center at (i - 0.5) * scale; +1 for the ghost cells
+  t_real l_x = std::floor(i_x / m_scaleX + 1);
+  t_real l_y = std::floor(i_y / m_scaleY + 1);
+  t_idx l_indexX = (t_idx) std::min(std::max(l_x, (t_real) 0), (t_real) (m_sizeX-1));
+  t_idx l_indexY = (t_idx) std::min(std::max(l_y, (t_real) 0), (t_real) (m_sizeY-1));
+
+  return l_indexX + l_indexY * m_sizeX;
+
+}
+
+tsunami_lab::t_real tsunami_lab::setups::PreparedGrid2d::getHeight( t_real i_x, t_real i_y ) const {
+  return m_height[getIndex(i_x, i_y)];
+}
+
+tsunami_lab::t_real tsunami_lab::setups::PreparedGrid2d::getBathymetry( t_real i_x, t_real i_y ) const {
+  return m_bathymetry[getIndex(i_x, i_y)];
+}
+
+tsunami_lab::t_real tsunami_lab::setups::PreparedGrid2d::getDisplacement( t_real i_x, t_real i_y ) const {
+  return m_displacement[getIndex(i_x, i_y)];
+}
+
+tsunami_lab::t_real tsunami_lab::setups::PreparedGrid2d::getMomentumX( t_real, t_real ) const {
+  return 0;
+}
+
+tsunami_lab::t_real tsunami_lab::setups::PreparedGrid2d::getMomentumY( t_real, t_real ) const {
+  return 0;
+}
+
+void tsunami_lab::setups::PreparedGrid2d::fillRows( t_idx    i_y0,
+                                                    t_idx    i_y1,
+                                                    t_idx    i_x0,
+                                                    t_idx    i_nx,
+                                                    t_real   i_scaleX,
+                                                    t_real   i_scaleY,
+                                                    t_real * o_h,
+                                                    t_real * o_hu,
+                                                    t_real * o_hv,
+                                                    t_real * o_b,
+                                                    t_idx    i_stride ) const {
+  for( t_idx l_iy = i_y0; l_iy < i_y1; l_iy++ ) {
+    t_real l_y = (l_iy - (t_real) 0.5) * i_scaleY;
+    t_idx  l_i = (l_iy - i_y0) * i_stride;
+    for( t_idx l_ix = i_x0; l_ix < i_x0 + i_nx; l_ix++, l_i++ ) {
+      t_idx l_id = getIndex( (l_ix - (t_real) 0.5) * i_scaleX, l_y );
+      if( o_h  ) o_h [l_i] = m_height[l_id];
+      if( o_hu ) o_hu[l_i] = 0;
+      if( o_hv ) o_hv[l_i] = 0;
+      if( o_b  ) o_b [l_i] = m_bathymetry[l_id] + m_displacement[l_id];
+    }
+  }
+}
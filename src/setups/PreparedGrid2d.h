@@ -0,0 +1,169 @@
+/**
+ * @author Antonio Noack
+ * @section DESCRIPTION
+ * Setup, which was sampled at the cell centers of the simulation, e.g. to cache the resampled input files.
+ **/
+#ifndef TSUNAMI_LAB_SETUPS_PREPARED_GRID_2D_H
+#define TSUNAMI_LAB_SETUPS_PREPARED_GRID_2D_H
+
+#include "Setup.h"
+
+// assert
+#include <cassert>
+#include <vector>
+
+namespace tsunami_lab {
+  namespace setups {
+    class PreparedGrid2d;
+  }
+}
+
+/**
+ * 2d setup with a height, bathymetry and displacement value per cell, including the ghost cells.
+ * The momenta are zero, like in the tsunami events.
+ **/
+class tsunami_lab::setups::PreparedGrid2d: public Setup {
+  private:
+
+    //! cells including the ghost cells
+    t_idx m_sizeX, m_sizeY;
+
+    //! scale, with which the cells were sampled
+    t_real m_scaleX, m_scaleY;
+
+    //! values, if they were sampled by this instance
+    std::vector<t_real> m_values;
+
+    t_real const* m_height;
+    t_real const* m_bathymetry;
+    t_real const* m_displacement;
+
+    /**
+     * Get the index of the cell, whose center is closest; clamped to the ghost cells.
+     *
+     * @param i_x x-coordinate of the queried point.
+     * @param i_y y-coordinate of the queried point.
+     * @return index for the queried point.
+     **/
+    t_idx getIndex( t_real i_x, t_real i_y ) const;
+
+  public:
+    /**
+     * Samples a setup at the cell centers, in the same way as the patches do.
+     *
+     * @param i_setup setup, which is sampled.
+     * @param i_nCellsX, i_nCellsY number of cells without ghost cells.
+     * @param i_scaleX, i_scaleY scale of the setup, see WavePropagation2d.
+     **/
+    PreparedGrid2d( Setup const* i_setup,
+                    t_idx        i_nCellsX,
+                    t_idx        i_nCellsY,
+                    t_real       i_scaleX,
+                    t_real       i_scaleY );
+
+    /**
+     * Uses values, which were sampled before, without a copy.
+     *
+     * @param i_values height, bathymetry and displacement arrays of getNumValues() values in total; must stay valid for the lifetime of this setup.
+     * @param i_nCellsX, i_nCellsY number of cells without ghost cells.
+     * @param i_scaleX, i_scaleY scale, with which the values were sampled.
+     **/
+    PreparedGrid2d( t_real const* i_values,
+                    t_idx         i_nCellsX,
+                    t_idx         i_nCellsY,
+                    t_real        i_scaleX,
+                    t_real        i_scaleY ) :
+      m_sizeX(i_nCellsX + 2), m_sizeY(i_nCellsY + 2),
+      m_scaleX(i_scaleX), m_scaleY(i_scaleY),
+      m_height(i_values),
+      m_bathymetry(i_values + m_sizeX * m_sizeY),
+      m_displacement(i_values + 2 * m_sizeX * m_sizeY) {
+
+      assert(i_values != nullptr);
+      assert(i_scaleX > 0 && i_scaleY > 0);
+
+    }
+
+    /**
+     * Gets the height, bathymetry and displacement arrays, which follow each other.
+     *
+     * @return values, row by row, including the ghost cells.
+     **/
+    t_real const* getValues() const { return m_height; }
+
+    /** self explanatory */
+    t_idx getNumValues() const { return 3 * m_sizeX * m_sizeY; }
+
+    /** self explanatory */
+    t_idx getNx() const { return m_sizeX - 2; }
+
+    /** self explanatory */
+    t_idx getNy() const { return m_sizeY - 2; }
+
+    /** self explanatory */
+    t_real getScaleX() const { return m_scaleX; }
+
+    /** self explanatory */
+    t_real getScaleY() const { return m_scaleY; }
+
+    /**
+     * Gets the water height at a given point.
+     *
+     * @param i_x x-coordinate of the queried point.
+     * @param i_y y-coordinate of the queried point.
+     * @return height at the given point.
+     **/
+    t_real getHeight( t_real i_x, t_real i_y ) const;
+
+    /**
+     * Gets the water depth at a given point.
+     * Positive values mean above sea level, negative values mean below sea level.
+     *
+     * @param i_x x-coordinate of the queried point.
+     * @param i_y y-coordinate of the queried point.
+     * @return water depth at the given point.
+     **/
+    t_real getBathymetry( t_real i_x, t_real i_y ) const;
+
+    /**
+     * Gets the earth quake displacement.
+     * Positive values mean the ground moved upwards.
+     *
+     * @param i_x x-coordinate of the queried point.
+     * @param i_y y-coordinate of the queried point.
+     * @return displacement in meters at the given point.
+     **/
+    t_real getDisplacement( t_real i_x, t_real i_y ) const;
+
+    /**
+     * Gets the momentum in x-direction.
+     *
+     * @return momentum in x-direction.
+     **/
+    t_real getMomentumX( t_real, t_real ) const;
+
+    /**
+     * Gets the momentum in y-direction.
+     *
+     * @return momentum in y-direction.
+     **/
+    t_real getMomentumY( t_real, t_real ) const;
+
+    /**
+     * Copies whole rows of cells, see Setup::fillRows().
+     **/
+    void fillRows( t_idx    i_y0,
+                   t_idx    i_y1,
+                   t_idx    i_x0,
+                   t_idx    i_nx,
+                   t_real   i_scaleX,
+                   t_real   i_scaleY,
+                   t_real * o_h,
+                   t_real * o_hu,
+                   t_real * o_hv,
+                   t_real * o_b,
+                   t_idx    i_stride ) const;
+
+};
+
+#endif // TSUNAMI_LAB_SETUPS_PREPARED_GRID_2D_H
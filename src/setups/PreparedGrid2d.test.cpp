@@ -0,0 +1,75 @@
+/**
+ * @author Antonio Noack
+ * @section DESCRIPTION
+ * Tests the setup, which was sampled at the cell centers.
+ **/
+#include <catch2/catch.hpp>
+
+#include "PreparedGrid2d.h"
+#include "Setup.test.h"
+#include "DamBreak2d.h"
+#include "TsunamiEvent2d.h"
+#include "../constants.h"
+#include "../patches/WavePropagation2d.h"
+
+#include <vector>
+
+#define t_real tsunami_lab::t_real
+#define t_idx  tsunami_lab::t_idx
+
+TEST_CASE( "Test that a prepared grid initializes the patch like its setup.", "[PreparedGrid2d]" ) {
+
+  // 5 x 4 input cells, which are scaled up by 3: 9 x 6 cells
+  t_idx l_nxIn = 5, l_nyIn = 4;
+  t_real l_scale = 3;
+  std::vector<t_real> l_bath( l_nxIn * l_nyIn ), l_disp( l_nxIn * l_nyIn );
+  for( t_idx l_ce = 0; l_ce < l_bath.size(); l_ce++ ) {
+    l_bath[l_ce] = -100 + 13 * (t_real) ( l_ce % 7 ) + 2 * (t_real) l_ce;
+    l_disp[l_ce] = (t_real) ( l_ce % 3 ) - 1;
+  }
+  t_real l_scaleInput = 1 / ( l_scale * l_scale );
+  tsunami_lab::setups::TsunamiEvent2d l_setup( l_bath.data(), l_nxIn, l_nyIn, l_nxIn, l_scaleInput,
+                                               l_disp.data(), l_nxIn, l_nyIn, l_nxIn, l_scaleInput );
+  t_idx l_nx = ( l_nxIn - 2 ) * l_scale, l_ny = ( l_nyIn - 2 ) * l_scale;
+
+  tsunami_lab::setups::PreparedGrid2d l_grid( &l_setup, l_nx, l_ny, l_scale, l_scale );
+  REQUIRE( l_grid.getNx() == l_nx );
+  REQUIRE( l_grid.getNy() == l_ny );
+  REQUIRE( l_grid.getNumValues() == 3 * ( l_nx + 2 ) * ( l_ny + 2 ) );
+
+  // a view of the values behaves the same
+  tsunami_lab::setups::PreparedGrid2d l_view( l_grid.getValues(), l_nx, l_ny, l_scale, l_scale );
+
+  tsunami_lab::patches::WavePropagation2d l_expected( l_nx, l_ny, &l_setup, l_scale, l_scale );
+  tsunami_lab::patches::WavePropagation2d l_prepared( l_nx, l_ny, &l_view, l_scale, l_scale );
+  t_real * l_expectedArrays[4], * l_preparedArrays[4];
+  t_idx l_nValues = l_expected.getRawStorage( l_expectedArrays );
+  REQUIRE( l_prepared.getRawStorage( l_preparedArrays ) == l_nValues );
+  for( unsigned short l_qu = 0; l_qu < 4; l_qu++ ) {
+    for( t_idx l_ce = 0; l_ce < l_nValues; l_ce++ ) {
+      REQUIRE( l_preparedArrays[l_qu][l_ce] == l_expectedArrays[l_qu][l_ce] );
+    }
+  }
+
+  // the positions, at which the writers sample the displacement
+  for( t_idx l_iy = 0; l_iy < l_ny; l_iy++ ) {
+    for( t_idx l_ix = 0; l_ix < l_nx; l_ix++ ) {
+      t_real l_x = ( l_ix + (t_real) 0.5 ) * l_scale, l_y = ( l_iy + (t_real) 0.5 ) * l_scale;
+      REQUIRE( l_view.getDisplacement( l_x, l_y ) == l_setup.getDisplacement( l_x, l_y ) );
+    }
+  }
+
+  // outside of the grid, the values of the ghost cells are used
+  REQUIRE( l_view.getBathymetry( -10, -10 ) == l_setup.getBathymetry( -0.5 * l_scale, -0.5 * l_scale ) );
+  REQUIRE( l_view.getBathymetry( 1000, 1000 ) == l_setup.getBathymetry( ( l_nx + 0.5 ) * l_scale, ( l_ny + 0.5 ) * l_scale ) );
+  REQUIRE( l_view.getMomentumX( 1, 1 ) == 0 );
+  REQUIRE( l_view.getMomentumY( 1, 1 ) == 0 );
+}
+
+TEST_CASE( "Test that the rows of a prepared grid match its getters.", "[PreparedGrid2d]" ) {
+
+  tsunami_lab::setups::DamBreak2d l_dambreak( 10, 5, 8, 4, 3, -10 );
+  tsunami_lab::setups::PreparedGrid2d l_setup( &l_dambreak, 21, 8, 1, 1 );
+
+  requireRowsMatchGetters( l_setup, 1, 1 );
+}
@@ -90,6 +90,46 @@ class tsunami_lab::setups::Setup {
      **/
     virtual t_real getMomentumY( t_real i_x,
                                  t_real i_y ) const = 0;
+
+    /**
+     * Samples whole rows of cells, e.g. to initialize a patch. Cell (ix, iy) is sampled at ((ix - 0.5) * i_scaleX, (iy - 0.5) * i_scaleY),
+     * which is its center, if index 0 is a ghost cell. This implementation calls the getters for every cell;
+     * setups can override it to share work between the cells of a row and between the quantities.
+     *
+     * @param i_y0 first row.
+     * @param i_y1 end of the rows, exclusive.
+     * @param i_x0 first column.
+     * @param i_nx number of columns.
+     * @param i_scaleX, i_scaleY scale of the setup; with i_scaleY = 0, all rows are sampled at y = 0, e.g. in 1d.
+     * @param o_h water height; nullptr if not needed.
+     * @param o_hu momentum in x-direction; nullptr if not needed.
+     * @param o_hv momentum in y-direction; nullptr if not needed.
+     * @param o_b bathymetry plus displacement; nullptr if not needed.
+     * @param i_stride distance of the rows in the outputs; cell (i_x0, i_y0) is stored at index 0.
+     **/
+    virtual void fillRows( t_idx    i_y0,
+                           t_idx    i_y1,
+                           t_idx    i_x0,
+                           t_idx    i_nx,
+                           t_real   i_scaleX,
+                           t_real   i_scaleY,
+                           t_real * o_h,
+                           t_real * o_hu,
+                           t_real * o_hv,
+                           t_real * o_b,
+                           t_idx    i_stride ) const {
+      for( t_idx l_iy = i_y0; l_iy < i_y1; l_iy++ ) {
+        t_real l_y = (l_iy - (t_real) 0.5) * i_scaleY;
+        t_idx  l_i = (l_iy - i_y0) * i_stride;
+        for( t_idx l_ix = i_x0; l_ix < i_x0 + i_nx; l_ix++, l_i++ ) {
+          t_real l_x = (l_ix - (t_real) 0.5) * i_scaleX;
+          if( o_h  ) o_h [l_i] = getHeight(    l_x, l_y );
+          if( o_hu ) o_hu[l_i] = getMomentumX( l_x, l_y );
+          if( o_hv ) o_hv[l_i] = getMomentumY( l_x, l_y );
+          if( o_b  ) o_b [l_i] = getBathymetry( l_x, l_y ) + getDisplacement( l_x, l_y );
+        }
+      }
+    }
     
     /**
      * Gets the init scales for x and y.
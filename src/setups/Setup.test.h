@@ -0,0 +1,66 @@
+/**
+ * @author Antonio Noack
+ *
+ * @section DESCRIPTION
+ * Shared checks for the unit tests of the setups.
+ **/
+#ifndef TSUNAMI_LAB_SETUPS_SETUP_TEST_H
+#define TSUNAMI_LAB_SETUPS_SETUP_TEST_H
+
+#include <catch2/catch.hpp>
+#include "Setup.h"
+
+#include <vector>
+
+/**
+ * Requires, that the rows of a setup match its getters: fillRows() of the setup has to produce
+ * the same values as the default implementation Setup::fillRows(), which calls the getters per cell.
+ * The buffers are wider than the rows, so the padding at the end of the rows must stay untouched.
+ *
+ * @param i_setup setup.
+ * @param i_scaleX scale of the setup in x-direction.
+ * @param i_scaleY scale of the setup in y-direction.
+ * @param i_x0 first column.
+ * @param i_nx number of columns.
+ * @param i_y0 first row.
+ * @param i_y1 end of the rows, exclusive.
+ * @param i_stride distance of the rows in the buffers; should be larger than i_nx.
+ **/
+inline void requireRowsMatchGetters( tsunami_lab::setups::Setup const & i_setup,
+                                     tsunami_lab::t_real                i_scaleX,
+                                     tsunami_lab::t_real                i_scaleY,
+                                     tsunami_lab::t_idx                 i_x0,
+                                     tsunami_lab::t_idx                 i_nx,
+                                     tsunami_lab::t_idx                 i_y0,
+                                     tsunami_lab::t_idx                 i_y1,
+                                     tsunami_lab::t_idx                 i_stride ) {
+  std::vector<tsunami_lab::t_real> l_rows[4], l_points[4];
+  for( unsigned short l_qu = 0; l_qu < 4; l_qu++ ) {
+    l_rows[l_qu].assign( ( i_y1 - i_y0 ) * i_stride, -1 );
+    l_points[l_qu] = l_rows[l_qu];
+  }
+  i_setup.fillRows( i_y0, i_y1, i_x0, i_nx, i_scaleX, i_scaleY,
+                    l_rows[0].data(), l_rows[1].data(), l_rows[2].data(), l_rows[3].data(), i_stride );
+  // the default implementation calls the getters
+  i_setup.tsunami_lab::setups::Setup::fillRows( i_y0, i_y1, i_x0, i_nx, i_scaleX, i_scaleY,
+                                                l_points[0].data(), l_points[1].data(), l_points[2].data(), l_points[3].data(), i_stride );
+  for( unsigned short l_qu = 0; l_qu < 4; l_qu++ ) {
+    REQUIRE( l_rows[l_qu] == l_points[l_qu] );
+  }
+}
+
+/**
+ * Requires, that the rows of a setup match its getters, see above;
+ * the rows 2 to 8 and the columns 3 to 22 are sampled into buffers with a stride of 24.
+ *
+ * @param i_setup setup.
+ * @param i_scaleX scale of the setup in x-direction.
+ * @param i_scaleY scale of the setup in y-direction.
+ **/
+inline void requireRowsMatchGetters( tsunami_lab::setups::Setup const & i_setup,
+                                     tsunami_lab::t_real                i_scaleX,
+                                     tsunami_lab::t_real                i_scaleY ) {
+  requireRowsMatchGetters( i_setup, i_scaleX, i_scaleY, 3, 20, 2, 9, 24 );
+}
+
+#endif
@@ -0,0 +1,100 @@
+/**
+ * @author Antonio Noack
+ * @section DESCRIPTION
+ * Summed-area table (integral image) of a 2d array.
+ **/
+#include "SummedAreaTable.h"
+
+// std::max, std::min
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+void tsunami_lab::setups::SummedAreaTable::build( t_real const* i_data,
+                                                  t_idx         i_sizeX,
+                                                  t_idx         i_sizeY,
+                                                  t_idx         i_stride ) {
+  assert(i_data != nullptr);
+  assert(i_sizeX > 0 && i_sizeY > 0 && i_stride >= i_sizeX);
+
+  m_sizeX = i_sizeX;
+  m_sizeY = i_sizeY;
+  t_idx l_width = m_sizeX + 1;
+  // the first row and column stay zero
+  m_sums.assign(l_width * (m_sizeY + 1), 0.0);
+
+  // prefix sums of the rows
+  #pragma omp parallel for
+  for( t_idx l_y = 0; l_y < m_sizeY; l_y++ ) {
+    t_real const* l_dataRow = i_data + l_y * i_stride;
+    double* l_sumRow = m_sums.data() + (l_y + 1) * l_width + 1;
+    double l_sum = 0;
+    for( t_idx l_x = 0; l_x < m_sizeX; l_x++ ) {
+      l_sum += l_dataRow[l_x];
+      l_sumRow[l_x] = l_sum;
+    }
+  }
+
+  // prefix sums of the columns; blocks of columns, so each thread walks along rows
+  t_idx const l_blockSize = 256;
+  t_idx l_numBlocks = (l_width + l_blockSize - 1) / l_blockSize;
+  #pragma omp parallel for
+  for( t_idx l_bl = 0; l_bl < l_numBlocks; l_bl++ ) {
+    t_idx l_x0 = l_bl * l_blockSize;
+    t_idx l_x1 = std::min(l_x0 + l_blockSize, l_width);
+    for( t_idx l_y = 2; l_y <= m_sizeY; l_y++ ) {
+      double* l_sumRow = m_sums.data() + l_y * l_width;
+      double const* l_prevRow = l_sumRow - l_width;
+      for( t_idx l_x = l_x0; l_x < l_x1; l_x++ ) {
+        l_sumRow[l_x] += l_prevRow[l_x];
+      }
+    }
+  }
+}
+
+double tsunami_lab::setups::SummedAreaTable::getSum( t_idx i_x0, t_idx i_y0, t_idx i_x1, t_idx i_y1 ) const {
+  assert(i_x0 <= i_x1 && i_x1 <= m_sizeX);
+  assert(i_y0 <= i_y1 && i_y1 <= m_sizeY);
+  t_idx l_width = m_sizeX + 1;
+  return m_sums[i_x1 + i_y1 * l_width] - m_sums[i_x0 + i_y1 * l_width]
+       - m_sums[i_x1 + i_y0 * l_width] + m_sums[i_x0 + i_y0 * l_width];
+}
+
+double tsunami_lab::setups::SummedAreaTable::getIntegral( double i_x, double i_y ) const {
+  double l_x = std::min(std::max(i_x, 0.0), (double) m_sizeX);
+  double l_y = std::min(std::max(i_y, 0.0), (double) m_sizeY);
+
+  // the last cell includes its right/bottom corner
+  t_idx l_index0X = std::min((t_idx) l_x, m_sizeX-1);
+  t_idx l_index0Y = std::min((t_idx) l_y, m_sizeY-1);
+  double l_fractX = l_x - l_index0X;
+  double l_fractY = l_y - l_index0Y;
+
+  t_idx l_width = m_sizeX + 1;
+  double const* l_row0 = m_sums.data() + l_index0Y * l_width + l_index0X;
+  double const* l_row1 = l_row0 + l_width;
+  double l_sum0 = l_row0[0] * (1 - l_fractX) + l_row0[1] * l_fractX;
+  double l_sum1 = l_row1[0] * (1 - l_fractX) + l_row1[1] * l_fractX;
+  return l_sum0 * (1 - l_fractY) + l_sum1 * l_fractY;
+}
+
+tsunami_lab::t_real tsunami_lab::setups::SummedAreaTable::getAverage( double i_x0, double i_y0, double i_x1, double i_y1 ) const {
+  double l_x0 = std::min(std::max(i_x0, 0.0), (double) m_sizeX);
+  double l_y0 = std::min(std::max(i_y0, 0.0), (double) m_sizeY);
+  double l_x1 = std::min(std::max(i_x1, 0.0), (double) m_sizeX);
+  double l_y1 = std::min(std::max(i_y1, 0.0), (double) m_sizeY);
+  double l_area = (l_x1 - l_x0) * (l_y1 - l_y0);
+
+  if( !(l_area > 0) ) {
+    // the box is outside of the data, or empty
+    double l_centerX = std::floor((i_x0 + i_x1) * 0.5);
+    double l_centerY = std::floor((i_y0 + i_y1) * 0.5);
+    t_idx l_x = (t_idx) std::min(std::max(l_centerX, 0.0), (double) (m_sizeX-1));
+    t_idx l_y = (t_idx) std::min(std::max(l_centerY, 0.0), (double) (m_sizeY-1));
+    return getSum(l_x, l_y, l_x+1, l_y+1);
+  }
+
+  double l_sum = getIntegral(l_x1, l_y1) - getIntegral(l_x0, l_y1)
+               - getIntegral(l_x1, l_y0) + getIntegral(l_x0, l_y0);
+  return l_sum / l_area;
+}
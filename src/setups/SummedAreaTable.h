@@ -0,0 +1,76 @@
+/**
+ * @author Antonio Noack
+ * @section DESCRIPTION
+ * Summed-area table (integral image) of a 2d array, for averages over arbitrary boxes in constant time.
+ **/
+#ifndef TSUNAMI_LAB_SETUPS_SUMMED_AREA_TABLE_H
+#define TSUNAMI_LAB_SETUPS_SUMMED_AREA_TABLE_H
+
+#include "../constants.h"
+
+#include <vector>
+
+namespace tsunami_lab {
+  namespace setups {
+    class SummedAreaTable;
+  }
+}
+
+/**
+ * Value (i_x, i_y) of the data covers the area [i_x, i_x+1) x [i_y, i_y+1).
+ * The sums are accumulated in double precision, because they become much larger than the values.
+ **/
+class tsunami_lab::setups::SummedAreaTable {
+  private:
+
+    //! size of the data
+    t_idx m_sizeX = 0, m_sizeY = 0;
+
+    //! sums of all values left and above of a corner; (m_sizeX+1) x (m_sizeY+1) corners
+    std::vector<double> m_sums;
+
+  public:
+    /**
+     * Builds the table.
+     *
+     * @param i_data data with size of i_sizeX x i_sizeY and stride i_stride.
+     * @param i_sizeX, i_sizeY size of the data, at least 1 x 1.
+     * @param i_stride stride of the data, typically i_sizeX.
+     **/
+    void build( t_real const* i_data,
+                t_idx         i_sizeX,
+                t_idx         i_sizeY,
+                t_idx         i_stride );
+
+    /** self explanatory */
+    bool isEmpty() const { return m_sums.empty(); }
+
+    /**
+     * Gets the sum of the data within the box of whole values [i_x0, i_x1) x [i_y0, i_y1).
+     *
+     * @param i_x0, i_y0 first value; i_x1, i_y1 end of the box, at most the size of the data.
+     * @return sum of the values.
+     **/
+    double getSum( t_idx i_x0, t_idx i_y0, t_idx i_x1, t_idx i_y1 ) const;
+
+    /**
+     * Gets the integral of the data over [0, i_x) x [0, i_y); the coordinates are clamped to the data.
+     * Between the corners, the table is interpolated bilinearly, which is exact for the constant values of the cells.
+     *
+     * @param i_x, i_y end of the integrated area.
+     * @return integral.
+     **/
+    double getIntegral( double i_x, double i_y ) const;
+
+    /**
+     * Gets the average of the data over the box [i_x0, i_x1) x [i_y0, i_y1), which is clamped to the data.
+     * Values, which are partially covered, are weighted by their covered area.
+     *
+     * @param i_x0, i_y0 start of the box; i_x1, i_y1 end of the box.
+     * @return average; the closest value, if the box does not cover any area of the data.
+     **/
+    t_real getAverage( double i_x0, double i_y0, double i_x1, double i_y1 ) const;
+
+};
+
+#endif // TSUNAMI_LAB_SETUPS_SUMMED_AREA_TABLE_H
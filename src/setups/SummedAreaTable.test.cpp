@@ -0,0 +1,67 @@
+/**
+ * @author Antonio Noack
+ * @section DESCRIPTION
+ * Tests the summed-area table.
+ **/
+#include <catch2/catch.hpp>
+
+#include "SummedAreaTable.h"
+#include "../constants.h"
+
+#include <vector>
+
+#define t_real tsunami_lab::t_real
+#define t_idx  tsunami_lab::t_idx
+
+TEST_CASE( "Test the sums and averages of the summed-area table.", "[SummedAreaTable]" ) {
+
+  // 7 x 5 values with a stride of 9
+  t_idx l_nx = 7, l_ny = 5, l_stride = 9;
+  std::vector<t_real> l_data( l_stride * l_ny, 1000 );
+  for( t_idx l_y = 0; l_y < l_ny; l_y++ ) {
+    for( t_idx l_x = 0; l_x < l_nx; l_x++ ) {
+      l_data[l_x + l_y * l_stride] = -50 + 3 * (t_real) ( ( l_x * 7 + l_y * 13 ) % 17 ) + (t_real) l_x;
+    }
+  }
+  tsunami_lab::setups::SummedAreaTable l_sums;
+  REQUIRE( l_sums.isEmpty() );
+  l_sums.build( l_data.data(), l_nx, l_ny, l_stride );
+  REQUIRE( !l_sums.isEmpty() );
+
+  // all boxes of whole values
+  for( t_idx l_y0 = 0; l_y0 <= l_ny; l_y0++ ) {
+    for( t_idx l_y1 = l_y0; l_y1 <= l_ny; l_y1++ ) {
+      for( t_idx l_x0 = 0; l_x0 <= l_nx; l_x0++ ) {
+        for( t_idx l_x1 = l_x0; l_x1 <= l_nx; l_x1++ ) {
+          double l_sum = 0;
+          for( t_idx l_y = l_y0; l_y < l_y1; l_y++ ) {
+            for( t_idx l_x = l_x0; l_x < l_x1; l_x++ ) l_sum += l_data[l_x + l_y * l_stride];
+          }
+          REQUIRE( l_sums.getSum( l_x0, l_y0, l_x1, l_y1 ) == Approx( l_sum ) );
+          if( l_x1 > l_x0 && l_y1 > l_y0 ) {
+            REQUIRE( l_sums.getAverage( l_x0, l_y0, l_x1, l_y1 ) == Approx( l_sum / ( ( l_x1 - l_x0 ) * ( l_y1 - l_y0 ) ) ) );
+          }
+        }
+      }
+    }
+  }
+
+  // values, which are partially covered, are weighted by their area
+  t_real l_expected = ( 0.5 * l_data[1 * l_stride] + l_data[1 + 1 * l_stride] + 0.5 * l_data[2 + 1 * l_stride] ) / 2;
+  REQUIRE( l_sums.getAverage( 0.5, 1, 2.5, 2 ) == Approx( l_expected ) );
+  l_expected = ( 0.25 * l_data[3 + 2 * l_stride] + l_data[3 + 3 * l_stride] ) / 1.25;
+  REQUIRE( l_sums.getAverage( 3, 2.75, 4, 4 ) == Approx( l_expected ) );
+
+  // a box of one value's width is the bilinear interpolation between the value centers
+  t_real l_fx = 0.3, l_fy = 0.6;
+  t_real l_row0 = l_data[4 + 2 * l_stride] * ( 1 - l_fx ) + l_data[5 + 2 * l_stride] * l_fx;
+  t_real l_row1 = l_data[4 + 3 * l_stride] * ( 1 - l_fx ) + l_data[5 + 3 * l_stride] * l_fx;
+  REQUIRE( l_sums.getAverage( 4 + l_fx, 2 + l_fy, 5 + l_fx, 3 + l_fy ) == Approx( l_row0 * ( 1 - l_fy ) + l_row1 * l_fy ) );
+
+  // boxes are clamped to the data
+  REQUIRE( l_sums.getAverage( -1, -1, 1, 1 ) == Approx( l_data[0] ) );
+  REQUIRE( l_sums.getAverage( 6.5, 4, 9, 6 ) == Approx( l_data[6 + 4 * l_stride] ) );
+  // the closest value, if there is no area left
+  REQUIRE( l_sums.getAverage( 8, 2.2, 10, 2.8 ) == Approx( l_data[6 + 2 * l_stride] ) );
+  REQUIRE( l_sums.getAverage( 2.5, -3, 3.5, -1 ) == Approx( l_data[3] ) );
+}
@@ -8,6 +8,7 @@
 // std::max, std::min
 #include <algorithm>
 #include <iostream>
+#include <vector>
 
 // for use of M_PI
 #define _USE_MATH_DEFINES
@@ -47,15 +48,34 @@ tsunami_lab::t_real tsunami_lab::setups::TsunamiEvent2d::getInterpolatedValue( t
   
 }
 
+tsunami_lab::t_real tsunami_lab::setups::TsunamiEvent2d::getAveragedValue( t_real i_x, t_real i_y, t_real i_footprint, SummedAreaTable const & i_sums ) const {
+  // value i is interpolated at i - m_offset, and covers [i, i+1) in the table
+  double l_x = i_x + m_offset + 0.5, l_y = i_y + m_offset + 0.5;
+  double l_radius = 0.5 * i_footprint;
+  return i_sums.getAverage(l_x - l_radius, l_y - l_radius, l_x + l_radius, l_y + l_radius);
+}
+
+void tsunami_lab::setups::TsunamiEvent2d::useAreaAverages( t_real i_cellWidth ) {
+  m_footprintBath = i_cellWidth * m_scaleBath;
+  m_footprintDisp = i_cellWidth * m_scaleDisp;
+  if( m_footprintBath > 1 ) m_bathymetrySums.build( m_bathymetry, m_sizeXBath, m_sizeYBath, m_strideBath );
+  if( m_footprintDisp > 1 ) m_displacementSums.build( m_displacement, m_sizeXDisp, m_sizeYDisp, m_strideDisp );
+}
+
+tsunami_lab::t_real tsunami_lab::setups::TsunamiEvent2d::sampleBathymetry( t_real i_x, t_real i_y ) const {
+  if( !m_bathymetrySums.isEmpty() ) return getAveragedValue(i_x * m_scaleBath, i_y * m_scaleBath, m_footprintBath, m_bathymetrySums);
+  return getInterpolatedValue(i_x * m_scaleBath, i_y * m_scaleBath, m_sizeXBath, m_sizeYBath, m_strideBath, m_bathymetry);
+}
+
 tsunami_lab::t_real tsunami_lab::setups::TsunamiEvent2d::getHeight( t_real i_x, t_real i_y ) const {
-  t_real l_bathIn = getInterpolatedValue(i_x * m_scaleBath, i_y * m_scaleBath, m_sizeXBath, m_sizeYBath, m_strideBath, m_bathymetry);
+  t_real l_bathIn = sampleBathymetry(i_x, i_y);
   t_real l_delta  = m_shoreCliffHeight;
   return l_bathIn < 0 ? std::max(-l_bathIn, l_delta) : 0;
 }
 
 tsunami_lab::t_real tsunami_lab::setups::TsunamiEvent2d::getBathymetry( t_real i_x, t_real i_y ) const {
   // if we are on the shore, clamp the value either on top of the cliff or in the cliff-deep water
-  t_real l_bathIn = getInterpolatedValue(i_x * m_scaleBath, i_y * m_scaleBath, m_sizeXBath, m_sizeYBath, m_strideBath, m_bathymetry);
+  t_real l_bathIn = sampleBathymetry(i_x, i_y);
   t_real l_delta  = m_shoreCliffHeight;
   return std::abs(l_bathIn) < l_delta ?
     l_bathIn < 0 ? -l_delta : l_delta :
@@ -63,6 +83,7 @@ tsunami_lab::t_real tsunami_lab::setups::TsunamiEvent2d::getBathymetry( t_real i
 }
 
 tsunami_lab::t_real tsunami_lab::setups::TsunamiEvent2d::getDisplacement( t_real i_x, t_real i_y ) const {
+  if( !m_displacementSums.isEmpty() ) return getAveragedValue( i_x * m_scaleDisp, i_y * m_scaleDisp, m_footprintDisp, m_displacementSums );
   return getInterpolatedValue( i_x * m_scaleDisp, i_y * m_scaleDisp, m_sizeXDisp, m_sizeYDisp, m_strideDisp, m_displacement );
 }
 
@@ -73,3 +94,66 @@ tsunami_lab::t_real tsunami_lab::setups::TsunamiEvent2d::getMomentumX( t_real, t
 tsunami_lab::t_real tsunami_lab::setups::TsunamiEvent2d::getMomentumY( t_real, t_real ) const {
   return 0;
 }
+
+void tsunami_lab::setups::TsunamiEvent2d::interpolateRow( t_real i_y, t_idx i_x0, t_idx i_nx, t_real i_scaleX, t_real i_scale,
+                                                          t_idx i_sizeX, t_idx i_sizeY, t_idx i_stride, t_real const* i_data, t_real* o_values ) const {
+
+  // same operations as getInterpolatedValue(), so the results are identical
+  t_real l_indexY  = std::min(std::max(i_y + m_offset, (t_real) 0), (t_real) i_sizeY);
+  t_idx  l_index0Y = std::min((t_idx) l_indexY, i_sizeY-2);
+  t_real l_fractY1 = l_indexY - l_index0Y;
+  t_real l_fractY2 = 1-l_fractY1;
+  t_real const* l_row0 = i_data + l_index0Y * i_stride;
+  t_real const* l_row1 = l_row0 + i_stride;
+
+  for( t_idx l_ix = 0; l_ix < i_nx; l_ix++ ) {
+    t_real l_x = ((i_x0 + l_ix) - (t_real) 0.5) * i_scaleX;
+    t_real l_indexX  = std::min(std::max(l_x * i_scale + m_offset, (t_real) 0), (t_real) i_sizeX);
+    t_idx  l_index0X = std::min((t_idx) l_indexX, i_sizeX-2);
+    t_real l_fractX1 = l_indexX - l_index0X;
+    t_real l_fractX2 = 1-l_fractX1;
+    t_real l_x0 = l_row0[l_index0X] * l_fractX2 + l_row0[l_index0X+1] * l_fractX1;
+    t_real l_x1 = l_row1[l_index0X] * l_fractX2 + l_row1[l_index0X+1] * l_fractX1;
+    o_values[l_ix] = l_x0 * l_fractY2 + l_x1 * l_fractY1;
+  }
+
+}
+
+void tsunami_lab::setups::TsunamiEvent2d::averageRow( t_real i_y, t_idx i_x0, t_idx i_nx, t_real i_scaleX, t_real i_scale,
+                                                      t_real i_footprint, SummedAreaTable const & i_sums, t_real* o_values ) const {
+  for( t_idx l_ix = 0; l_ix < i_nx; l_ix++ ) {
+    t_real l_x = ((i_x0 + l_ix) - (t_real) 0.5) * i_scaleX;
+    o_values[l_ix] = getAveragedValue( l_x * i_scale, i_y, i_footprint, i_sums );
+  }
+}
+
+void tsunami_lab::setups::TsunamiEvent2d::fillRows( t_idx    i_y0,
+                                                    t_idx    i_y1,
+                                                    t_idx    i_x0,
+                                                    t_idx    i_nx,
+                                                    t_real   i_scaleX,
+                                                    t_real   i_scaleY,
+                                                    t_real * o_h,
+                                                    t_real * o_hu,
+                                                    t_real * o_hv,
+                                                    t_real * o_b,
+                                                    t_idx    i_stride ) const {
+  std::vector<t_real> l_bathIn(i_nx), l_displacement(o_b ? i_nx : 0);
+  t_real l_delta = m_shoreCliffHeight;
+  for( t_idx l_iy = i_y0; l_iy < i_y1; l_iy++ ) {
+    t_real l_y = (l_iy - (t_real) 0.5) * i_scaleY;
+    if( !m_bathymetrySums.isEmpty() ) averageRow( l_y * m_scaleBath, i_x0, i_nx, i_scaleX, m_scaleBath, m_footprintBath, m_bathymetrySums, l_bathIn.data() );
+    else interpolateRow( l_y * m_scaleBath, i_x0, i_nx, i_scaleX, m_scaleBath, m_sizeXBath, m_sizeYBath, m_strideBath, m_bathymetry, l_bathIn.data() );
+    if( o_b && !m_displacementSums.isEmpty() ) averageRow( l_y * m_scaleDisp, i_x0, i_nx, i_scaleX, m_scaleDisp, m_footprintDisp, m_displacementSums, l_displacement.data() );
+    else if( o_b ) interpolateRow( l_y * m_scaleDisp, i_x0, i_nx, i_scaleX, m_scaleDisp, m_sizeXDisp, m_sizeYDisp, m_strideDisp, m_displacement, l_displacement.data() );
+    t_idx l_i = (l_iy - i_y0) * i_stride;
+    for( t_idx l_ix = 0; l_ix < i_nx; l_ix++ ) {
+      // see getHeight() and getBathymetry()
+      t_real l_bath = l_bathIn[l_ix];
+      if( o_h  ) o_h [l_i + l_ix] = l_bath < 0 ? std::max(-l_bath, l_delta) : 0;
+      if( o_hu ) o_hu[l_i + l_ix] = 0;
+      if( o_hv ) o_hv[l_i + l_ix] = 0;
+      if( o_b  ) o_b [l_i + l_ix] = (std::abs(l_bath) < l_delta ? l_bath < 0 ? -l_delta : l_delta : l_bath) + l_displacement[l_ix];
+    }
+  }
+}
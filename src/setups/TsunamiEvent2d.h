@@ -7,6 +7,7 @@
 #define TSUNAMI_LAB_SETUPS_TSUNAMI_EVENT_2D_H
 
 #include "Setup.h"
+#include "SummedAreaTable.h"
 
 // assert
 #include <cassert>
@@ -29,6 +30,12 @@ class tsunami_lab::setups::TsunamiEvent2d: public Setup {
      
     t_real* m_bathymetry;
     t_real* m_displacement;
+
+    //! tables for the area averages, see useAreaAverages(); empty, if the data is interpolated
+    SummedAreaTable m_bathymetrySums, m_displacementSums;
+
+    //! width of a sampled cell in values of the data
+    t_real m_footprintBath = 0, m_footprintDisp = 0;
     
     /**
      * Interpolate a value in a 2d grid.
@@ -42,6 +49,52 @@ class tsunami_lab::setups::TsunamiEvent2d: public Setup {
      * @return linearly interpolated value at the queried point.
      **/
     t_real getInterpolatedValue( t_real i_x, t_real i_y, t_idx i_sizeX, t_idx i_sizeY, t_idx i_stride, t_real* i_data ) const;
+
+    /**
+     * Interpolates the values of a row of cells like getInterpolatedValue(), but the row weights are computed once.
+     *
+     * @param i_y y-coordinate of the row times scale.
+     * @param i_x0 first column; i_nx number of columns.
+     * @param i_scaleX scale of the setup in x-direction, see fillRows().
+     * @param i_scale scale of the data.
+     * @param i_sizeX, i_sizeY, i_stride, i_data see getInterpolatedValue().
+     * @param o_values interpolated values of the row.
+     **/
+    void interpolateRow( t_real i_y, t_idx i_x0, t_idx i_nx, t_real i_scaleX, t_real i_scale,
+                         t_idx i_sizeX, t_idx i_sizeY, t_idx i_stride, t_real const* i_data, t_real* o_values ) const;
+
+    /**
+     * Averages the data over the area of a cell.
+     *
+     * @param i_x x-coordinate of the center of the cell times scale.
+     * @param i_y y-coordinate of the center of the cell times scale.
+     * @param i_footprint width of the cell in values of the data.
+     * @param i_sums summed-area table of the data.
+     * @return average of the data within the cell.
+     **/
+    t_real getAveragedValue( t_real i_x, t_real i_y, t_real i_footprint, SummedAreaTable const & i_sums ) const;
+
+    /**
+     * Averages the data over the areas of a row of cells, like getAveragedValue().
+     *
+     * @param i_y y-coordinate of the row times scale.
+     * @param i_x0 first column; i_nx number of columns.
+     * @param i_scaleX scale of the setup in x-direction, see fillRows().
+     * @param i_scale scale of the data.
+     * @param i_footprint, i_sums see getAveragedValue().
+     * @param o_values averaged values of the row.
+     **/
+    void averageRow( t_real i_y, t_idx i_x0, t_idx i_nx, t_real i_scaleX, t_real i_scale,
+                     t_real i_footprint, SummedAreaTable const & i_sums, t_real* o_values ) const;
+
+    /**
+     * Samples the bathymetry data; interpolated or averaged, see useAreaAverages().
+     *
+     * @param i_x x-coordinate of the queried point.
+     * @param i_y y-coordinate of the queried point.
+     * @return bathymetry of the data, before the shore cliff is applied.
+     **/
+    t_real sampleBathymetry( t_real i_x, t_real i_y ) const;
     
   public:
     /**
@@ -78,6 +131,15 @@ class tsunami_lab::setups::TsunamiEvent2d: public Setup {
       assert(i_displacement != nullptr);
       
     }
+
+    /**
+     * Averages the data over the area of a cell instead of interpolating it, where a cell covers more than one value of the data.
+     * Interpolation only sees the values next to the cell center, so coarse simulations would alias the data.
+     * Where a cell is at most as wide as a value, the bilinear interpolation is kept, which is the average over one value's width.
+     *
+     * @param i_cellWidth width of the simulated cells, e.g. the scale of the patch.
+     **/
+    void useAreaAverages( t_real i_cellWidth );
     
     /**
      * Gets the water height at a given point.
@@ -122,6 +184,22 @@ class tsunami_lab::setups::TsunamiEvent2d: public Setup {
      **/
     t_real getMomentumY( t_real, t_real ) const;
     
+    /**
+     * Samples whole rows of cells, see Setup::fillRows().
+     * The bathymetry is interpolated once for the height and the bathymetry, and the weights of a row are shared.
+     **/
+    void fillRows( t_idx    i_y0,
+                   t_idx    i_y1,
+                   t_idx    i_x0,
+                   t_idx    i_nx,
+                   t_real   i_scaleX,
+                   t_real   i_scaleY,
+                   t_real * o_h,
+                   t_real * o_hu,
+                   t_real * o_hv,
+                   t_real * o_b,
+                   t_idx    i_stride ) const;
+
 };
 
 #endif // TSUNAMI_LAB_SETUPS_TSUNAMI_EVENT_2D_H
\ No newline at end of file
@@ -6,11 +6,14 @@
 #include <catch2/catch.hpp>
 
 #include "TsunamiEvent2d.h"
+#include "Setup.test.h"
 #include "ArtificialTsunami2d.h"
 #include "../constants.h"
 #include "../patches/WavePropagation2d.h"
 #include "../io/NetCdf.h"
 
+#include <vector>
+
 #define t_real tsunami_lab::t_real
 #define t_idx  tsunami_lab::t_idx
 
@@ -52,3 +55,63 @@ TEST_CASE( "Tests for 2d tsunami event.", "[TsunamiEvent2d]" ) {
   }
   
 }
+
+TEST_CASE( "Test that the rows of the 2d tsunami event match its getters.", "[TsunamiEvent2d]" ) {
+
+  // a shore with cliffs, and displacement data of another resolution
+  std::vector<t_real> l_bath( 6 * 5 ), l_disp( 4 * 3 );
+  for( t_idx l_ce = 0; l_ce < l_bath.size(); l_ce++ ) l_bath[l_ce] = -60 + 7 * (t_real) ( l_ce % 11 ) + (t_real) l_ce;
+  for( t_idx l_ce = 0; l_ce < l_disp.size(); l_ce++ ) l_disp[l_ce] = (t_real) ( l_ce % 5 ) - 2;
+  tsunami_lab::setups::TsunamiEvent2d l_setup( l_bath.data(), 6, 5, 6, 0.25, l_disp.data(), 4, 3, 4, 0.125 );
+
+  requireRowsMatchGetters( l_setup, 1.5, 1.5 );
+}
+
+TEST_CASE( "Test that coarse cells of the 2d tsunami event average the data.", "[TsunamiEvent2d]" ) {
+
+  // deep water only, so the shore cliffs do not change the averages
+  t_idx l_nxIn = 18, l_nyIn = 14;
+  std::vector<t_real> l_bath( l_nxIn * l_nyIn ), l_disp( l_nxIn * l_nyIn );
+  for( t_idx l_ce = 0; l_ce < l_bath.size(); l_ce++ ) {
+    l_bath[l_ce] = -1000 + 37 * (t_real) ( l_ce % 13 ) + (t_real) l_ce;
+    l_disp[l_ce] = (t_real) ( l_ce % 5 ) - 2;
+  }
+  // a quarter of the resolution: each cell covers 4 x 4 values
+  t_real l_scale = 0.25, l_scaleInput = 1 / ( l_scale * l_scale );
+  tsunami_lab::setups::TsunamiEvent2d l_setup( l_bath.data(), l_nxIn, l_nyIn, l_nxIn, l_scaleInput,
+                                               l_disp.data(), l_nxIn, l_nyIn, l_nxIn, l_scaleInput );
+  l_setup.useAreaAverages( l_scale );
+
+  // cell i covers the values 4i-3 to 4i, because the value 0 belongs to the ghost cell at the scale of 1
+  for( t_idx l_iy = 1; l_iy <= 3; l_iy++ ) {
+    for( t_idx l_ix = 1; l_ix <= 4; l_ix++ ) {
+      t_real l_sumB = 0, l_sumD = 0;
+      for( t_idx l_y = 4 * l_iy - 3; l_y <= 4 * l_iy; l_y++ ) {
+        for( t_idx l_x = 4 * l_ix - 3; l_x <= 4 * l_ix; l_x++ ) {
+          l_sumB += l_bath[l_x + l_y * l_nxIn];
+          l_sumD += l_disp[l_x + l_y * l_nxIn];
+        }
+      }
+      t_real l_x = ( l_ix - (t_real) 0.5 ) * l_scale, l_y = ( l_iy - (t_real) 0.5 ) * l_scale;
+      REQUIRE( l_setup.getBathymetry( l_x, l_y ) == Approx( l_sumB / 16 ) );
+      REQUIRE( l_setup.getDisplacement( l_x, l_y ) == Approx( l_sumD / 16 ).margin( 1e-5 ) );
+      REQUIRE( l_setup.getHeight( l_x, l_y ) == Approx( -l_sumB / 16 ) );
+    }
+  }
+
+  // the rows use the same averages
+  requireRowsMatchGetters( l_setup, l_scale, l_scale, 0, 6, 0, 5, 7 );
+
+  // cells, which are not coarser than the data, are interpolated as before
+  tsunami_lab::setups::TsunamiEvent2d l_interpolated( l_bath.data(), l_nxIn, l_nyIn, l_nxIn, 0.5,
+                                                      l_disp.data(), l_nxIn, l_nyIn, l_nxIn, 0.5 );
+  tsunami_lab::setups::TsunamiEvent2d l_fine( l_bath.data(), l_nxIn, l_nyIn, l_nxIn, 0.5,
+                                              l_disp.data(), l_nxIn, l_nyIn, l_nxIn, 0.5 );
+  l_fine.useAreaAverages( 2 );
+  for( t_real l_y = -1; l_y < 30; l_y += 0.7 ) {
+    for( t_real l_x = -1; l_x < 38; l_x += 0.9 ) {
+      REQUIRE( l_fine.getBathymetry( l_x, l_y ) == l_interpolated.getBathymetry( l_x, l_y ) );
+      REQUIRE( l_fine.getDisplacement( l_x, l_y ) == l_interpolated.getDisplacement( l_x, l_y ) );
+    }
+  }
+}